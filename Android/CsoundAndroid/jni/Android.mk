@@ -210,6 +210,7 @@ $(CSOUND_SRC_ROOT)/Opcodes/wave-terrain.c   \
 $(CSOUND_SRC_ROOT)/Opcodes/stdopcod.c \
 $(CSOUND_SRC_ROOT)/Opcodes/socksend.c \
 $(CSOUND_SRC_ROOT)/Opcodes/sockrecv.c \
+$(CSOUND_SRC_ROOT)/Opcodes/sockaudio.c \
 $(CSOUND_SRC_ROOT)/Opcodes/ifd.c  \
 $(CSOUND_SRC_ROOT)/Opcodes/partials.c  \
 $(CSOUND_SRC_ROOT)/Opcodes/psynth.c  \
@@ -247,6 +248,7 @@ $(CSOUND_SRC_ROOT)/InOut/libmpadec/synth.c \
 $(CSOUND_SRC_ROOT)/InOut/libmpadec/tables.c \
 $(CSOUND_SRC_ROOT)/InOut/libmpadec/mpadec.c \
 $(CSOUND_SRC_ROOT)/InOut/libmpadec/mp3dec.c \
+$(CSOUND_SRC_ROOT)/InOut/sndstream.c \
 csound_orclex.c \
 csound_prelex.c \
 csound_prslex.c \
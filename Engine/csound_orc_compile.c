@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "insert.h"
+#include "interlocks.h"
 #include "oload.h"
 #include "pstream.h"
 //#include "typetabl.h"
@@ -831,6 +832,98 @@ int tree_contains_fn_p(CSOUND *csound, TREE *t) {
   return 0;
 }
 
+/* opcodes without interlock flags whose perf-time effects on other
+   instances depend on the order in which the voices run them */
+static const char *batch_unsafe_ops[] = {
+  "turnoff", "event", "schedwhen", "schedkwhen", "scoreline", "mute", NULL
+};
+
+static int arg_is_global(CSOUND *csound, ENGINE_STATE *engineState,
+                         const char *s)
+{
+  return (*s == 'g' || (*s == '#' && s[1] == 'g') ||
+          csoundFindVariableWithName(csound, engineState->varPool, s) != NULL ||
+          csoundFindVariableWithName(csound, csound->engineState.varPool, s)
+          != NULL);
+}
+
+static int args_have_global(CSOUND *csound, ENGINE_STATE *engineState,
+                            ARGLST *list)
+{
+  int i;
+  if (list == NULL)
+    return 0;
+  for (i = 0; i < list->count; i++)
+    if (arg_is_global(csound, engineState, list->arg[i]))
+      return 1;
+  return 0;
+}
+
+/**
+ * Instances of an instrument can only be run in lockstep (--voice-batch)
+ * if their perf chains are straight-line code: every jump, loop,
+ * conditional or reinit needs a label, so an instrument without labels
+ * always executes the same sequence of opcodes.
+ * Running one opcode for all the voices before the next one also changes
+ * the order of any effects the voices have on each other, so the perf
+ * chain must not write global variables, the zak space, tables, channels,
+ * the stack or the console, nor call UDOs or turn off and schedule events.
+ */
+static int instr_is_batchable(CSOUND *csound, ENGINE_STATE *engineState,
+                              INSTRTXT *ip)
+{
+  OPTXT *op = (OPTXT *)ip;
+  while ((op = op->nxtop) != NULL) {
+    OENTRY *ep = op->t.oentry;
+    const char **name;
+    if (ep == NULL)
+      continue;
+    if (strcmp(ep->opname, "$label") == 0)
+      return 0;
+    if (ep->kopadr == NULL && ep->aopadr == NULL)
+      continue;                         /* init pass only */
+    if (ep->useropinfo != NULL ||
+        (ep->flags & (ZW | TW | _CW | IW | SK | WR)))
+      return 0;
+    for (name = batch_unsafe_ops; *name != NULL; name++)
+      if (strncmp(ep->opname, *name, strlen(*name)) == 0)
+        return 0;
+    if (args_have_global(csound, engineState, op->t.outlist))
+      return 0;
+    /* opcodes writing to their inputs, such as array element assignment */
+    if (((ep->flags & WI) || strncmp(ep->opname, "##array_set", 11) == 0) &&
+        args_have_global(csound, engineState, op->t.inlist))
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * Looks up the batch kernels of the perf functions of a batchable
+ * instrument, so that kperf only searches the few the instrument uses.
+ */
+static void instr_find_batchops(CSOUND *csound, INSTRTXT *ip)
+{
+  OPTXT *op = (OPTXT *)ip;
+  int i, n = 0;
+  while ((op = op->nxtop) != NULL) {
+    OENTRY *ep = op->t.oentry;
+    BSUBR batchadr;
+    if (ep == NULL || ep->kopadr == NULL)
+      continue;
+    for (i = 0; i < n && ip->batchops[i].opadr != ep->kopadr; i++)
+      ;
+    if (i < n ||
+        (batchadr = csoundFindBatchKernel(csound, ep->kopadr)) == NULL)
+      continue;
+    ip->batchops = (BATCHENTRY *)csound->ReAlloc(csound, ip->batchops,
+                                                 (n + 1) * sizeof(BATCHENTRY));
+    ip->batchops[n].opadr = ep->kopadr;
+    ip->batchops[n++].batchadr = batchadr;
+  }
+  ip->nbatchops = n;
+}
+
 /**
  * Create an Instrument (INSTRTXT) from the AST node given. Called from
  * csound_orc_compile.
@@ -918,6 +1011,9 @@ INSTRTXT *create_instrument(CSOUND *csound, TREE *root,
     op = last_optxt(op);
     current = current->next;
   }
+  ip->batchable = instr_is_batchable(csound, engineState, ip);
+  if (ip->batchable)
+    instr_find_batchops(csound, ip);
   close_instrument(csound, engineState, ip);
   return ip;
 }
@@ -1001,6 +1097,7 @@ void free_instrtxt(CSOUND *csound, INSTRTXT *instrtxt) {
   }
 
   csoundFreeVarPool(csound, ip->varPool);
+  csound->Free(csound, ip->batchops);
   csound->Free(csound, ip);
   if (UNLIKELY(csound->oparms->odebug))
     csound->Message(csound, Str("-- deleted instr from deadpool\n"));
@@ -2320,7 +2417,6 @@ void debugPrintCsound(CSOUND *csound) {
   }
 }
 
-#include "interlocks.h"
 void query_deprecated_opcode(CSOUND *csound, ORCTOKEN *o) {
     char *name = o->lexeme;
     OENTRY *ep = find_opcode(csound, name);
@@ -284,6 +284,7 @@ OENTRY opcodlst_1[] = {
   { "dbfsamp.k",S(EVAL),0,  2,      "k",    "k",    NULL,   dbfsamp         },
   { "rtclock.i",S(EVAL),0,  1,      "i",    "",     rtclock                 },
   { "rtclock.k",S(EVAL),0,  2,      "k",    "",     NULL,   rtclock         },
+  { "overload",S(EVAL),0,   2,      "k",    "",     NULL,   overload_state  },
   { "ftlen.i",S(EVAL),0,    1,      "i",    "i",    ftlen                   },
   { "ftsr.i",S(EVAL),0,     1,      "i",    "i",    ftsr                    },
   { "ftlptim.i",S(EVAL),0,  1,      "i",    "i",    ftlptim                 },
@@ -1170,3 +1171,11 @@ OENTRY opcodlst_1[] = {
   /* terminate list */
   {  NULL, 0, 0, 0, NULL, NULL, NULL, NULL, NULL       }
 };
+
+/* multi-voice versions of perf functions, for --voice-batch */
+
+BATCHENTRY batchlst_1[] = {
+  { (SUBR) osckk,  (BSUBR) osckk_batch  },
+  { (SUBR) osckki, (BSUBR) osckki_batch },
+  { NULL, NULL }
+};
@@ -32,6 +32,7 @@
 #include "fgens.h"
 #include "pstream.h"
 #include "pvfileio.h"
+#include "sndstream.h"
 #include <stdlib.h>
 /* #undef ISSTRCOD */
 
@@ -2559,6 +2560,319 @@ FUNC *csoundFTnp2Find(CSOUND *csound, MYFLT *argp)
     return ftp;
 }
 
+/* GEN01 sound files with headers are read through the shared stream   */
+/* layer (see sndstream.h), so that loading the same file again, for   */
+/* another table or another instance, copies decoded blocks instead of */
+/* decoding the file; --gen01-cache sets the least size of the cache,  */
+/* and 0 reads every file from disk.  When GEN01 loading is deferred,  */
+/* each file is queued for decoding on a pool of threads as soon as    */
+/* its f-statement is read, and the first use of a table only waits    */
+/* for the blocks that are being decoded.  Raw sample formats, and in  */
+/* double precision files of 32 bit integers or doubles (which the     */
+/* stream layer holds as floats), are read from disk, as before.       */
+
+typedef struct GEN01JOB_ {
+    struct GEN01JOB_ *nxt;
+    char    *path;                      /* full path name of the file */
+} GEN01JOB;
+
+typedef struct {
+    CSOUND  *csound;
+    spin_lock_t lock;
+    void    *wakeup;                    /* notified when files are queued */
+    void    *threads[MAX_GEN01_THREADS];
+    int     nthreads, running;
+    GEN01JOB *head, *tail;              /* files waiting to be decoded */
+} GEN01_POOL;
+
+/* can GEN01 take the samples of the stream as they are? */
+static int gen01_stream_usable(const SNDSTREAM_INFO *info)
+{
+    if (info->type != SNDSTREAM_SNDFILE)
+      return 0;
+#ifdef USE_DOUBLE
+    switch (info->format & SF_FORMAT_SUBMASK) {
+    case SF_FORMAT_PCM_32:
+    case SF_FORMAT_DOUBLE:
+      return 0;
+    }
+#endif
+    return 1;
+}
+
+/* the stream of sound file name, or NULL if it is to be read from disk */
+static SNDSTREAM *gen01_stream(CSOUND *csound, const char *name)
+{
+    SNDSTREAM *s;
+
+    if (csound->oparms->gen01Cache <= 0)
+      return NULL;
+    sndstream_reserve((size_t) csound->oparms->gen01Cache << 20);
+    if ((s = sndstream_open(csound, name)) != NULL &&
+        !gen01_stream_usable(sndstream_info(s))) {
+      sndstream_close(s);
+      s = NULL;
+    }
+    return s;
+}
+
+/* the loader threads use no Csound services */
+static uintptr_t gen01_load_thread(void *data)
+{
+    GEN01_POOL  *pool = (GEN01_POOL*) data;
+    CSOUND      *csound = pool->csound;
+    GEN01JOB    *job;
+    SNDSTREAM   *s;
+    int         running;
+
+    do {
+      csoundSpinLock(&pool->lock);
+      if ((running = pool->running) && (job = pool->head) != NULL) {
+        if ((pool->head = job->nxt) == NULL)
+          pool->tail = NULL;
+      }
+      else job = NULL;
+      csoundSpinUnLock(&pool->lock);
+      if (job == NULL) {
+        if (running)
+          csound->WaitThreadLock(pool->wakeup, 50);
+        continue;
+      }
+      if ((s = sndstream_open_path(job->path)) != NULL) {
+        if (gen01_stream_usable(sndstream_info(s)))
+          sndstream_fetch(s);
+        sndstream_close(s);
+      }
+      free(job->path);
+      free(job);
+    } while (running);
+    return 0;
+}
+
+static int gen01_pool_reset(CSOUND *csound, void *data)
+{
+    GEN01_POOL  *pool = (GEN01_POOL*) data;
+    GEN01JOB    *job;
+    int         i;
+
+    csoundSpinLock(&pool->lock);
+    pool->running = 0;
+    csoundSpinUnLock(&pool->lock);
+    for (i = 0; i < pool->nthreads; i++)
+      csound->NotifyThreadLock(pool->wakeup);
+    for (i = 0; i < pool->nthreads; i++)
+      csound->JoinThread(pool->threads[i]);
+    pool->nthreads = 0;
+    csound->DestroyThreadLock(pool->wakeup);
+    while ((job = pool->head) != NULL) {
+      pool->head = job->nxt;
+      free(job->path);
+      free(job);
+    }
+    pool->tail = NULL;
+    return OK;
+}
+
+static GEN01_POOL *gen01_pool(CSOUND *csound)
+{
+    GEN01_POOL *pool;
+
+    pool = (GEN01_POOL*) csound->QueryGlobalVariable(csound, "GEN01_POOL");
+    if (pool == NULL) {
+      if (UNLIKELY(csound->CreateGlobalVariable(csound, "GEN01_POOL",
+                                                sizeof(GEN01_POOL)) != 0))
+        return NULL;
+      pool = (GEN01_POOL*) csound->QueryGlobalVariable(csound, "GEN01_POOL");
+      pool->csound = csound;
+      csoundSpinLockInit(&pool->lock);
+      pool->wakeup = csound->CreateThreadLock();
+      pool->running = 1;
+      csound->RegisterResetCallback(csound, pool, gen01_pool_reset);
+    }
+    return pool;
+}
+
+/* sound file name of a GEN01 f-statement */
+static void gen01_sfname(CSOUND *csound, const FGDATA *ff, char *sfname)
+{
+    int32 filno = (int32) MYFLT2LRND(ff->e.p[5]);
+
+    if (isstrcod(ff->e.p[5])) {
+      if (ff->e.strarg[0] == '"') {
+        int len = (int) strlen(ff->e.strarg) - 2;
+        strNcpy(sfname, ff->e.strarg + 1, 512);
+        if (len >= 0 && sfname[len] == '"')
+          sfname[len] = '\0';
+      }
+      else
+        strNcpy(sfname, ff->e.strarg, 512);
+    }
+    else if (filno >= 0 && filno <= csound->strsmax &&
+             csound->strsets && csound->strsets[filno])
+      strNcpy(sfname, csound->strsets[filno], 512);
+    else
+      snprintf(sfname, 512, "soundin.%d", filno);   /* soundin.filno */
+}
+
+/* queue the sound file of a deferred table for decoding */
+static void gen01_prefetch(FGDATA *ff)
+{
+    CSOUND      *csound = ff->csound;
+    GEN01_POOL  *pool;
+    GEN01JOB    *job;
+    char        sfname[MAXSNDNAME], *path;
+
+    if (csound->oparms->gen01Threads <= 0 ||
+        csound->oparms->gen01Cache <= 0 || MYFLT2LRND(ff->e.p[7]) != 0)
+      return;
+    gen01_sfname(csound, ff, sfname);
+    if ((path = csoundFindInputFile(csound, sfname, "SFDIR;SSDIR")) == NULL)
+      return;
+    if ((pool = gen01_pool(csound)) == NULL ||
+        (job = (GEN01JOB*) malloc(sizeof(GEN01JOB))) == NULL) {
+      csound->Free(csound, path);
+      return;
+    }
+    job->path = strdup(path);
+    job->nxt = NULL;
+    csound->Free(csound, path);
+    if (job->path == NULL) {
+      free(job);
+      return;
+    }
+    sndstream_reserve((size_t) csound->oparms->gen01Cache << 20);
+    csoundSpinLock(&pool->lock);
+    if (pool->tail != NULL)
+      pool->tail->nxt = job;
+    else
+      pool->head = job;
+    pool->tail = job;
+    csoundSpinUnLock(&pool->lock);
+#ifndef __EMSCRIPTEN__
+    if (pool->nthreads < csound->oparms->gen01Threads) {
+      void *t = csound->CreateThread(gen01_load_thread, pool);
+      if (t != NULL)
+        pool->threads[pool->nthreads++] = t;
+    }
+#endif
+    csound->NotifyThreadLock(pool->wakeup);
+}
+
+/* set up p to read from stream s, as sndgetset() does for a file on */
+/* disk; *skipframes is set to the number of sample frames to skip   */
+static int gen01_stream_open(CSOUND *csound, SNDSTREAM *s, SOUNDIN *p,
+                             int64_t *skipframes)
+{
+    const SNDSTREAM_INFO *info = sndstream_info(s);
+    int framesinbuf;
+
+    p->format = SF2FORMAT(info->format);
+    p->filetyp = SF2TYPE(info->format);
+    p->nchanls = info->channels;
+    p->sr = info->sr;
+    if (UNLIKELY(p->sr != (int) ((double) csound->esr + 0.5)))
+      csound->Warning(csound, "%s sr = %d, orch sr = %7.1f",
+                      info->path, p->sr, csound->esr);
+    if (UNLIKELY(p->channel != ALLCHNLS && p->channel > p->nchanls)) {
+      csound->ErrorMsg(csound, Str("error: req chan %d, file %s has only %d"),
+                       (int) p->channel, info->path, p->nchanls);
+      return NOTOK;
+    }
+    if (csound->oparms_.msglevel & 3) {
+      csound->Message(csound, Str("audio sr = %d, "), (int) p->sr);
+      switch (p->nchanls) {
+        case 1: csound->Message(csound, Str("monaural")); break;
+        case 2: csound->Message(csound, Str("stereo"));   break;
+        case 4: csound->Message(csound, Str("quad"));     break;
+        case 6: csound->Message(csound, Str("hex"));      break;
+        case 8: csound->Message(csound, Str("oct"));      break;
+        default: csound->Message(csound, Str("%d-channels"), (int) p->nchanls);
+      }
+      if (p->nchanls > 1) {
+        if (p->channel == ALLCHNLS)
+          csound->Message(csound, Str(", reading %s channels"),
+                                  (p->nchanls == 2 ? Str("both") : Str("all")));
+        else
+          csound->Message(csound, Str(", reading channel %d"),
+                                  (int) p->channel);
+      }
+      csound->Message(csound, Str("\nopening %s infile %s\n"),
+                      type2string(p->filetyp), info->path);
+    }
+    framesinbuf = (int) SNDINBUFSIZ / p->nchanls;
+    *skipframes = (int64_t) ((double) p->skiptime * (double) p->sr
+                             + (p->skiptime >= FL(0.0) ? 0.5 : -0.5));
+    if (UNLIKELY(*skipframes < -(int64_t) framesinbuf)) {
+      csound->ErrorMsg(csound, Str("soundin: invalid skip time"));
+      return NOTOK;
+    }
+    p->framesrem = info->frames - *skipframes;
+    p->audrem = (*skipframes < info->frames ?
+                 (info->frames - (*skipframes > 0 ? *skipframes : 0))
+                 * p->nchanls : 0);
+    return OK;
+}
+
+/* getsndin() for a stream: up to nlocs samples from frame skip on, */
+/* zero padded; returns the number of samples read, or -1 on error  */
+static int gen01_stream_read(CSOUND *csound, SNDSTREAM *s, MYFLT *fp,
+                             int nlocs, SOUNDIN *p, int64_t skip)
+{
+    const SNDSTREAM_INFO *info = sndstream_info(s);
+    int     nch = p->nchanls, all = (nch == 1 || p->channel == ALLCHNLS);
+    int     per = (all ? nch : 1), i, n;
+    int64_t zeros, pos, avail, want, got, m;
+    float   buf[4096];
+    MYFLT   scalefac;
+
+    if (p->format == AE_FLOAT || p->format == AE_DOUBLE) {
+      if (p->filetyp == TYP_WAV || p->filetyp == TYP_AIFF ||
+          p->filetyp == TYP_W64)
+        scalefac = csound->e0dbfs;
+      else
+        scalefac = FL(1.0);
+    }
+    else
+      scalefac = csound->e0dbfs;
+    /* a negative skip reads silence first; skipping past the end */
+    /* reads one buffer of silence, as sndgetset() does           */
+    if (skip < 0)
+      zeros = -skip, pos = 0;
+    else if (skip >= info->frames)
+      zeros = (int64_t) SNDINBUFSIZ / nch, pos = info->frames;
+    else
+      zeros = 0, pos = skip;
+    zeros *= per;
+    if (zeros > nlocs) zeros = nlocs;
+    memset(fp, 0, (size_t) zeros * sizeof(MYFLT));
+    n = (int) zeros;
+    avail = (info->frames - pos) * per;
+    if (avail > nlocs - n) avail = nlocs - n;
+    while (avail > 0) {
+      want = (avail + per - 1) / per;
+      if (want > (int64_t) (sizeof(buf) / sizeof(float)) / nch)
+        want = (int64_t) (sizeof(buf) / sizeof(float)) / nch;
+      if (UNLIKELY((got = sndstream_read(s, pos, buf, want)) <= 0))
+        return -1;
+      pos += got;
+      m = got * per;
+      if (m > avail) m = avail;
+      if (all) {
+        for (i = 0; i < (int) m; i++)
+          fp[n + i] = (MYFLT) buf[i] * scalefac;
+      }
+      else {
+        for (i = 0; i < (int) m; i++)
+          fp[n + i] = (MYFLT) buf[i * nch + p->channel - 1] * scalefac;
+      }
+      n += (int) m;
+      avail -= m;
+      p->audrem -= m * (all ? 1 : nch);
+    }
+    memset(&(fp[n]), 0, (nlocs - n) * sizeof(MYFLT)); /* if incomplete PAD */
+    return n;
+}
+
 /* read ftable values from a sound file */
 /* stops reading when table is full     */
 
@@ -2578,6 +2892,7 @@ static int gen01(FGDATA *ff, FUNC *ftp)
       ftp->gen01args.iformat = ff->e.p[7];
       ftp->gen01args.channel = ff->e.p[8];
       strNcpy(ftp->gen01args.strarg, ff->e.strarg, SSTRSIZ);
+      gen01_prefetch(ff);
       return OK;
     }
     return gen01raw(ff, ftp);
@@ -2607,7 +2922,9 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     CSOUND  *csound = ff->csound;
     SOUNDIN *p;
     SOUNDIN tmpspace;
-    SNDFILE *fd;
+    SNDFILE *fd = NULL;
+    SNDSTREAM *snd = NULL;
+    int64_t skip = 0;
     int     truncmsg = 0;
     int32   inlocs = 0;
     int     def = 0, table_length = ff->flen + 1;
@@ -2615,41 +2932,8 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     p = &tmpspace;
     memset(p, 0, sizeof(SOUNDIN));
     {
-      int32 filno = (int32) MYFLT2LRND(ff->e.p[5]);
       int   fmt = (int) MYFLT2LRND(ff->e.p[7]);
-      /* union { */
-      /*   MYFLT d; */
-      /*   int32_t i[2]; */
-      /* } xx; */
-      /* xx.d = ff->e.p[5]; */
-      /* printf("****line %d: ff->e.p[5] %f %.8x %.8x\n", __LINE__, */
-      /*        ff->e.p[5], xx.i[1], xx.i[0]); */
-      /* printf("****line %d: isstrcod=%d %d file %s\n", __LINE__, */
-      /*        isstrcod(ff->e.p[5]), isnan(ff->e.p[5]), ff->e.strarg); */
-      if (isstrcod(ff->e.p[5])) {
-        /* printf("****line %d\n" , __LINE__); */
-        if (ff->e.strarg[0] == '"') {
-          int len = (int) strlen(ff->e.strarg) - 2;
-          /* printf("****line %d\n" , __LINE__); */
-          strNcpy(p->sfname, ff->e.strarg + 1, 512);
-          if (len >= 0 && p->sfname[len] == '"')
-            p->sfname[len] = '\0';
-        }
-        else {
-          /* printf("****line %d\n" , __LINE__); */
-          strNcpy(p->sfname, ff->e.strarg, 512);
-        }
-      }
-      else if (filno >= 0 && filno <= csound->strsmax &&
-               csound->strsets && csound->strsets[filno]) {
-        /* printf("****line %d\n" , __LINE__); */
-        strNcpy(p->sfname, csound->strsets[filno], 512);
-      }
-      else {
-        /* printf("****line %d\n" , __LINE__); */
-        snprintf(p->sfname, 512, "soundin.%d", filno);   /* soundin.filno */
-      }
-      //printf("****line %d: sfname=%s\n" , __LINE__, p->sfname);
+      gen01_sfname(csound, ff, p->sfname);
       if (UNLIKELY(fmt < -9 || fmt > 9))
         return fterror(ff, Str("invalid sample format: %d"), fmt);
       if (fmt<0)
@@ -2668,13 +2952,24 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     if (UNLIKELY(ff->flen == 0 && (csound->oparms->msglevel & 7))) {
       csoundMessage(csound, Str("deferred alloc for %s\n"), p->sfname);
     }
-    if (UNLIKELY((fd = sndgetset(csound, p))==NULL)) {
+    /* a file with a header is read through the shared stream layer */
+    if (p->format == 0)
+      snd = gen01_stream(csound, p->sfname);
+    if (snd != NULL) {
+      if (UNLIKELY(gen01_stream_open(csound, snd, p, &skip) != OK)) {
+        sndstream_close(snd);
+        return fterror(ff, Str("Failed to open file %s"), p->sfname);
+      }
+    }
+    else if (UNLIKELY((fd = sndgetset(csound, p))==NULL)) {
       /* sndinset to open the file  */
       return fterror(ff, Str("Failed to open file %s"), p->sfname);
     }
     if (ff->flen == 0) {                      /* deferred ftalloc requestd: */
       if (UNLIKELY((ff->flen = p->framesrem + 1) <= 0)) {
         /*   get minsize from soundin */
+        if (snd != NULL)
+          sndstream_close(snd);
         return fterror(ff, Str("deferred size, but filesize unknown"));
       }
       if (UNLIKELY(csound->oparms->msglevel & 7))
@@ -2702,7 +2997,13 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     ftp->cvtbas = LOFACT * p->sr * csound->onedsr;
     {
       SF_INSTRUMENT lpd;
-      int ans = sf_command(fd, SFC_GET_INSTRUMENT, &lpd, sizeof(SF_INSTRUMENT));
+      int ans;
+      if (snd != NULL) {
+        if ((ans = sndstream_info(snd)->hasinstr))
+          lpd = sndstream_info(snd)->instr;
+      }
+      else
+        ans = sf_command(fd, SFC_GET_INSTRUMENT, &lpd, sizeof(SF_INSTRUMENT));
       if (ans) {
         double natcps;
 #ifdef BETA
@@ -2765,7 +3066,15 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
     }
     /* read sound with opt gain */
 
-    if (UNLIKELY((inlocs=getsndin(csound, fd, ftp->ftable, table_length, p)) < 0)) {
+    if (snd != NULL) {
+      if (UNLIKELY((inlocs = gen01_stream_read(csound, snd, ftp->ftable,
+                                               table_length, p, skip)) < 0)) {
+        sndstream_close(snd);
+        return fterror(ff, Str("GEN1 read error"));
+      }
+    }
+    else if (UNLIKELY((inlocs=getsndin(csound, fd, ftp->ftable,
+                                       table_length, p)) < 0)) {
       return fterror(ff, Str("GEN1 read error"));
     }
 
@@ -2777,7 +3086,10 @@ static int gen01raw(FGDATA *ff, FUNC *ftp)
       needsiz(csound, ff, p->framesrem);     /* ????????????  */
     }
     ftp->soundend = inlocs / ftp->nchanls;   /* record end of sound samps */
-    csound->FileClose(csound, p->fd);
+    if (snd != NULL)
+      sndstream_close(snd);
+    else
+      csound->FileClose(csound, p->fd);
     if (def) {
       MYFLT *tab = ftp->ftable;
       ftresdisp(ff, ftp);       /* VL: 11.01.05  for deferred alloc tables */
@@ -2881,6 +3193,107 @@ static int gen43(FGDATA *ff, FUNC *ftp)
 #ifndef NACL
 #include "mp3dec.h"
 
+/* With --mp3-stream, GEN49 reads through the shared stream layer, so */
+/* that the file is indexed once, skipping is exact, and a deferred    */
+/* table gets the exact, gapless length of the file.  chan 0 takes all */
+/* channels of the file interleaved, 1 their mean, 2 a stereo pair     */
+/* (duplicating a mono file), and 3 and 4 the left or the right        */
+/* channel.                                                            */
+
+static int gen49stream(FGDATA *ff, FUNC *ftp, const char *sfname, int chan)
+{
+    CSOUND  *csound        = ff->csound;
+    MYFLT   *fp            = ftp == NULL ? NULL: ftp->ftable;
+    SNDSTREAM *snd;
+    const SNDSTREAM_INFO *info;
+    float   buf[4096];
+    int64_t skip, pos, got;
+    int     nch, nchanls, p = 0, flen, def = 0, i, j, n, blk;
+    MYFLT   scale = csound->e0dbfs;
+
+    if (UNLIKELY(chan > 4)) {
+      return fterror(ff, Str("channel %d illegal"), (int) chan);
+    }
+    if (UNLIKELY((snd = sndstream_open(csound, sfname)) == NULL)) {
+      return fterror(ff, Str("mp3in: %s: failed to open file"), sfname);
+    }
+    info = sndstream_info(snd);
+    nch = info->channels;
+    if (info->type == SNDSTREAM_MP3) {
+      char temp[80];
+      if (info->sr < 16000) strcpy(temp, "MPEG-2.5 ");
+      else if (info->sr < 32000) strcpy(temp, "MPEG-2 ");
+      else strcpy(temp, "MPEG-1 ");
+      if (info->layer == 1) strcat(temp, "Layer I");
+      else if (info->layer == 2) strcat(temp, "Layer II");
+      else strcat(temp, "Layer III");
+      csound->DebugMsg(csound, "Input:  %s, %s, %d kbps, %d Hz  (%d:%02d)\n",
+              temp, ((nch > 1) ? "stereo" : "mono"), info->bitrate, info->sr,
+              (int) (info->frames / info->sr / 60),
+              (int) (info->frames / info->sr % 60));
+    }
+    nchanls = (chan == 0 ? nch : chan == 2 ? 2 : 1);
+    skip = (int64_t) (ff->e.p[6] * info->sr);
+    if (skip < 0) skip = 0;
+    if (ff->flen == 0) {    /* deferred ftalloc */
+      int64_t frames = info->frames - skip;
+      if (UNLIKELY(frames <= 0)) {
+        sndstream_close(snd);
+        return fterror(ff, Str("deferred size, but filesize unknown"));
+      }
+      if (UNLIKELY(frames * nchanls > MAXLEN)) {
+        sndstream_close(snd);
+        return fterror(ff, Str("illegal table length"));
+      }
+      ff->flen = (int32) (frames * nchanls);
+      if (UNLIKELY(csound->oparms->msglevel & 7))
+        csoundMessage(csound, Str("  defer length %d\n"), ff->flen);
+      ftp = ftalloc(ff);
+      ftp->lenmask  = 0L;
+      ftp->flenfrms = (int32) frames;
+      ftp->nchanls  = nchanls;
+      fp = ftp->ftable;
+      def = 1;
+    }
+    ftp->gen01args.sample_rate = info->sr;
+    ftp->cvtbas = LOFACT * info->sr * csound->onedsr;
+    flen = ftp->flen;
+    blk = (int) (sizeof(buf) / sizeof(float)) / nch;
+    for (pos = skip; p < flen; pos += got) {
+      if ((got = sndstream_read(snd, pos, buf, blk)) <= 0)
+        break;
+      n = (int) got;
+      for (i = 0; i < n && p < flen; i++) {
+        float *frm = &buf[i * nch];
+        switch (chan) {
+        case 0:
+          for (j = 0; j < nch && p < flen; j++)
+            fp[p++] = (MYFLT) frm[j] * scale;
+          break;
+        case 1:
+          {
+            MYFLT sum = FL(0.0);
+            for (j = 0; j < nch; j++)
+              sum += (MYFLT) frm[j];
+            fp[p++] = sum / nch * scale;
+          }
+          break;
+        case 2:
+          fp[p++] = (MYFLT) frm[0] * scale;
+          if (p < flen)
+            fp[p++] = (MYFLT) frm[nch > 1 ? 1 : 0] * scale;
+          break;
+        default:
+          fp[p++] = (MYFLT) frm[chan == 4 && nch > 1 ? 1 : 0] * scale;
+          break;
+        }
+      }
+    }
+    sndstream_close(snd);
+    if (def) ftresdisp(ff, ftp);
+    return OK;
+}
+
 static int gen49raw(FGDATA *ff, FUNC *ftp)
 {
     CSOUND  *csound        = ff->csound;
@@ -2902,7 +3315,6 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
     if (UNLIKELY(ff->e.pcnt < 7)) {
       return fterror(ff, Str("insufficient arguments"));
     }
-    /* memset(&mpainfo, 0, sizeof(mpadec_info_t)); */ /* Is this necessary? */
     {
       int32 filno = (int32) MYFLT2LRND(ff->e.p[5]);
       if (isstrcod(ff->e.p[5])) {
@@ -2926,6 +3338,8 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
     if (UNLIKELY(chan < 0)) {
       return fterror(ff, Str("channel %d illegal"), (int) chan);
     }
+    if (csound->oparms->mp3Stream)
+      return gen49stream(ff, ftp, sfname, chan);
     switch (chan) {
     case 0:
       config.mode = MPADEC_CONFIG_AUTO; break;
@@ -2944,7 +3358,7 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
     }
     if (UNLIKELY((r = mp3dec_configure(mpa, &config)) != MP3DEC_RETCODE_OK)) {
       mp3dec_uninit(mpa);
-      return fterror(ff, mp3dec_error(r));
+      return fterror(ff, "%s", mp3dec_error(r));
     }
     (void)csound->FileOpen2(csound, &fd, CSFILE_FD_R,
                                      sfname, NULL, "SFDIR;SSDIR",
@@ -2956,12 +3370,12 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
     }
     if (UNLIKELY((r = mp3dec_init_file(mpa, fd, 0, FALSE)) != MP3DEC_RETCODE_OK)) {
       mp3dec_uninit(mpa);
-      return fterror(ff, mp3dec_error(r));
+      return fterror(ff, "%s", mp3dec_error(r));
     }
     if (UNLIKELY((r = mp3dec_get_info(mpa, &mpainfo, MPADEC_INFO_STREAM)) !=
                  MP3DEC_RETCODE_OK)) {
       mp3dec_uninit(mpa);
-      return fterror(ff, mp3dec_error(r));
+      return fterror(ff, "%s", mp3dec_error(r));
     }
     /* maxsize = mpainfo.decoded_sample_size */
     /*   *mpainfo.decoded_frame_samples */
@@ -2996,10 +3410,16 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
       int fsize, frames;
       frames = mpainfo.frames * mpainfo.decoded_frame_samples;
       fsize  = frames * nchanls;
-      if (UNLIKELY((ff->flen = fsize) <= 0))
+      if (UNLIKELY((ff->flen = fsize) <= 0)) {
+        csound->Free(csound, buffer);
+        mp3dec_uninit(mpa);
         return fterror(ff, Str("deferred size, but filesize unknown"));
-      if (UNLIKELY(ff->flen > MAXLEN))
+      }
+      if (UNLIKELY(ff->flen > MAXLEN)) {
+        csound->Free(csound, buffer);
+        mp3dec_uninit(mpa);
         return fterror(ff, Str("illegal table length"));
+      }
       if (UNLIKELY(csound->oparms->msglevel & 7))
         csoundMessage(csound, Str("  defer length %d\n"), ff->flen);
       ftp = ftalloc(ff);
@@ -3021,6 +3441,7 @@ static int gen49raw(FGDATA *ff, FUNC *ftp)
         if (UNLIKELY(p>=flen)) {
           csound->Free(csound,buffer);
           //printf("gen49: i=%d p=%d exit as at end of table\n", i, p);
+          if (def) ftresdisp(ff, ftp);
           return ((mp3dec_uninit(mpa) == MP3DEC_RETCODE_OK) ? OK : NOTOK);
         }
         fp[p] = ((MYFLT)bb[i]/(MYFLT)0x7fff) * csound->e0dbfs;
@@ -3431,6 +3852,15 @@ static CS_NOINLINE FUNC *gen01_defer_load(CSOUND *csound, int fno)
     ff.e.p[6] = ftp->gen01args.iskptim;
     ff.e.p[7] = ftp->gen01args.iformat;
     ff.e.p[8] = ftp->gen01args.channel;
+#ifndef NACL
+    if ((int) MYFLT2LRND(ftp->gen01args.gen01) == 49) {
+      if (UNLIKELY(gen49raw(&ff, ftp) != 0)) {
+        csoundErrorMsg(csound, Str("Deferred load of '%s' failed"), strarg);
+        return NULL;
+      }
+      return csound->flist[fno];
+    }
+#endif
     if (UNLIKELY(gen01raw(&ff, ftp) != 0)) {
       csoundErrorMsg(csound, Str("Deferred load of '%s' failed"), strarg);
       return NULL;
@@ -798,6 +798,14 @@ int insert_midi(CSOUND *csound, int insno, MCHNBLK *chn, MEVENT *mep)
   }
   ip->tieflag = ip->reinitflag = 0;
   csound->tieflag = csound->reinitflag = 0;
+  /* a timestamped note on (csoundPushMidiMessage) starts within the */
+  /* k-period; notes taken from the alloc queue start at its edge    */
+  if (O->sampleAccurate && !O->realtime)
+    ip->ksmps_offset = csound->midiGlobals->ksmpsOffset;
+  else
+    ip->ksmps_offset = 0;
+  ip->ksmps_no_end = 0;
+  ip->no_end = 0;
 
   if (UNLIKELY(O->odebug)) {
     char *name = csound->engineState.instrtxtp[insno]->insname;
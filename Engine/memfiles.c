@@ -394,6 +394,21 @@ void rlsmemfiles(CSOUND *csound)
     csound->memfiles = NULL;
 }
 
+/* unmap the PVOC-EX files that are used in place; the rest of the */
+/* memfile chain is freed with the memory pool                     */
+
+void rlspvxmemfiles(CSOUND *csound)
+{
+    PVOCEX_MEMFILE  *pp;
+
+    for (pp = csound->pvx_memfiles; pp != NULL; pp = pp->nxt) {
+      if (pp->mapbase != NULL) {
+        pvoc_unmapframes(pp->mapbase, pp->maplen);
+        pp->mapbase = NULL;
+      }
+    }
+}
+
 int delete_memfile(CSOUND *csound, const char *filnam)
 {
     MEMFIL  *mfp, *prv;
@@ -447,9 +462,11 @@ int PVOCEX_LoadFile(CSOUND *csound, const char *fname, PVOCEX_MEMFILE *p)
     WAVEFORMATEX  fmt;
     PVOCEX_MEMFILE  *pp;
     int           i, j, rc = 0, pvx_id, hdr_size, name_size;
-    int32          mem_wanted;
+    size_t        mem_wanted;
     int32          totalframes, framelen;
-    float         *pFrame;
+    float         *pFrame, *mapped = NULL;
+    void          *mapbase = NULL;
+    size_t        maplen = 0;
 
     if (UNLIKELY(fname == NULL || fname[0] == '\0')) {
       memset(p, 0, sizeof(PVOCEX_MEMFILE));
@@ -491,30 +508,45 @@ int PVOCEX_LoadFile(CSOUND *csound, const char *fname, PVOCEX_MEMFILE *p)
     if (UNLIKELY(totalframes <= 0)) {
       return pvx_err_msg(csound, Str("pvoc-ex file %s is empty!"), fname);
     }
-    mem_wanted = totalframes * 2 * pvdata.nAnalysisBins * sizeof(float);
+    mem_wanted = (size_t) totalframes * 2 * pvdata.nAnalysisBins * sizeof(float);
+    /* with 0dbfs = 1 the frames need no rescaling, and can be used in
+       place: map them, so that memory grows with the frames actually
+       read, and the pages are shared by every instance and engine
+       using the file */
+    if (csound->e0dbfs == FL(1.0))
+      mapped = pvoc_mapframes(csound, pvx_id, (uint32) totalframes,
+                              &mapbase, &maplen);
     /* try for the big block first! */
     pp = (PVOCEX_MEMFILE*) csound->Malloc(csound, (size_t) (hdr_size + name_size)
-                                           + (size_t) mem_wanted);
+                                           + (mapped != NULL ? 0 : mem_wanted));
     memset((void*) pp, 0, (size_t) (hdr_size + name_size));
     pp->filename = (char*) ((uintptr_t) pp + (uintptr_t) hdr_size);
     pp->nxt = csound->pvx_memfiles;
     pp->data = (float*) ((uintptr_t) pp + (uintptr_t) (hdr_size + name_size));
     strcpy(pp->filename, fname);
-    /* despite using pvocex infile, and pvocex-style resynth, we ~still~
-       have to rescale to Csound's internal range! This is because all pvocex
-       calculations assume +-1 floatsam i/o.
-       It seems preferable to do this here, rather than force the user
-       to do so. Csound might change one day...
-     */
-    for (pFrame = pp->data, i = 0; i < totalframes; i++) {
-      rc = csound->PVOC_GetFrames(csound, pvx_id, pFrame, 1);
-      if (UNLIKELY(rc != 1))
-        break;          /* read error, but may still have something to use */
-      /* scale amps to Csound range, to fit fsig */
-      for (j = 0; j < framelen; j += 2) {
-        pFrame[j] *= (float) csound->e0dbfs;
+    if (mapped != NULL) {
+      pp->data = mapped;
+      pp->mapbase = mapbase;
+      pp->maplen = maplen;
+      i = totalframes;
+    }
+    else {
+      /* despite using pvocex infile, and pvocex-style resynth, we ~still~
+         have to rescale to Csound's internal range! This is because all
+         pvocex calculations assume +-1 floatsam i/o.
+         It seems preferable to do this here, rather than force the user
+         to do so. Csound might change one day...
+       */
+      for (pFrame = pp->data, i = 0; i < totalframes; i++) {
+        rc = csound->PVOC_GetFrames(csound, pvx_id, pFrame, 1);
+        if (UNLIKELY(rc != 1))
+          break;          /* read error, but may still have something to use */
+        /* scale amps to Csound range, to fit fsig */
+        for (j = 0; j < framelen; j += 2) {
+          pFrame[j] *= (float) csound->e0dbfs;
+        }
+        pFrame += framelen;
       }
-      pFrame += framelen;
     }
     csound->PVOC_CloseFile(csound, pvx_id);
     if (UNLIKELY(rc < 0)) {
@@ -555,8 +587,12 @@ int PVOCEX_LoadFile(CSOUND *csound, const char *fname, PVOCEX_MEMFILE *p)
 
     /* link into PVOC-EX memfile chain */
     csound->pvx_memfiles = pp;
-    csound->Message(csound, Str("file %s (%"PRIi32" bytes) loaded into memory\n"),
-                            fname, mem_wanted);
+    if (pp->mapbase != NULL)
+      csound->Message(csound, Str("file %s (%lu bytes) mapped into memory\n"),
+                              fname, (unsigned long) mem_wanted);
+    else
+      csound->Message(csound, Str("file %s (%lu bytes) loaded into memory\n"),
+                              fname, (unsigned long) mem_wanted);
 
     memcpy(p, pp, sizeof(PVOCEX_MEMFILE));
     return 0;
@@ -21,16 +21,13 @@
     02110-1301 USA
 */
 
+#ifdef LINUX
+#include <semaphore.h>
+#endif
+
 #define MAX_NAME_LEN    32      /* for client and port name */
 
 typedef struct RtJackBuffer_ {
-#ifdef LINUX
-    pthread_mutex_t csndLock;               /* signaled by process callback */
-    pthread_mutex_t jackLock;               /* signaled by audio thread     */
-#else
-    void    *csndLock;                      /* signaled by process callback */
-    void    *jackLock;                      /* signaled by audio thread     */
-#endif
     jack_default_audio_sample_t **inBufs;   /* 'nChannels' capture buffers  */
     jack_default_audio_sample_t **outBufs;  /* 'nChannels' playback buffers */
 } RtJackBuffer;
@@ -55,6 +52,15 @@ typedef struct RtJackGlobals_ {
     int     csndBufPos;                 /* buffer position in Csound thread */
     int     jackBufCnt;                 /* current buffer in JACK callback  */
     int     jackBufPos;                 /* buffer position in JACK callback */
+    int     jackCount;                  /* buffers done by JACK callback    */
+    int     csndCount;                  /* buffers released by Csound       */
+    int     csndWaiting;                /* non-zero if Csound thread sleeps */
+#ifdef LINUX
+    sem_t   csndWake;                   /* posted to wake up Csound thread  */
+#else
+    void    *csndWake;                  /* notified to wake up Csound       */
+#endif
+    int     wakeCreated;                /* non-zero if csndWake is valid    */
     jack_client_t   *client;            /* JACK client pointer              */
     jack_port_t     **inPorts;          /* 'nChannels' ports for capture    */
     jack_default_audio_sample_t **inPortBufs;
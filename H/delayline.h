@@ -0,0 +1,83 @@
+/*
+    delayline.h:
+
+    Copyright (C) 2026
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/*                                                      DELAYLINE.H     */
+
+/* Block helpers for the circular buffers of the delay opcodes.  A delay */
+/* line is a buffer of len samples and a position in it; rather than     */
+/* testing for the end of the buffer at every sample, the helpers split  */
+/* a block once at the wrap point, so the loops run over contiguous      */
+/* memory.                                                               */
+
+#ifndef CSOUND_DELAYLINE_H
+#define CSOUND_DELAYLINE_H
+
+/* number of samples from pos to the end of the buffer, at most n */
+static inline uint32_t dline_span(int32_t pos, int32_t len, uint32_t n)
+{
+    uint32_t room = (uint32_t) (len - pos);
+    return (room < n ? room : n);
+}
+
+/* write n samples to the buffer starting at pos; returns the new position */
+static inline int32_t dline_write(MYFLT *buf, int32_t len, int32_t pos,
+                                  const MYFLT *in, uint32_t n)
+{
+    while (n) {
+      uint32_t m = dline_span(pos, len, n);
+      memcpy(&buf[pos], in, m * sizeof(MYFLT));
+      in += m; n -= m;
+      if ((pos += m) >= len) pos = 0;
+    }
+    return pos;
+}
+
+/* read n samples from the buffer starting at pos; returns the new position */
+static inline int32_t dline_read(MYFLT *out, const MYFLT *buf, int32_t len,
+                                 int32_t pos, uint32_t n)
+{
+    while (n) {
+      uint32_t m = dline_span(pos, len, n);
+      memcpy(out, &buf[pos], m * sizeof(MYFLT));
+      out += m; n -= m;
+      if ((pos += m) >= len) pos = 0;
+    }
+    return pos;
+}
+
+/* add n samples from the buffer starting at pos, scaled by gain, to out */
+static inline int32_t dline_mix(MYFLT *out, const MYFLT *buf, int32_t len,
+                                int32_t pos, MYFLT gain, uint32_t n)
+{
+    while (n) {
+      uint32_t i, m = dline_span(pos, len, n);
+      const MYFLT *src = &buf[pos];
+      for (i = 0; i < m; i++)
+        out[i] += src[i] * gain;
+      out += m; n -= m;
+      if ((pos += m) >= len) pos = 0;
+    }
+    return pos;
+}
+
+#endif  /* CSOUND_DELAYLINE_H */
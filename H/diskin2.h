@@ -67,11 +67,11 @@ typedef struct {
     SNDFILE *sf;
     FDCH    fdch;
     AUXCH   auxData;            /* for dynamically allocated buffers */
-    AUXCH   auxData2;
     MYFLT   *aOut_buf;
     MYFLT   aOut_bufsize;
     void    *cb;
     int     async;
+    void    *stream;            /* I/O thread pool entry when async */
 } DISKIN2;
 
 typedef struct {
@@ -109,11 +109,11 @@ typedef struct {
     SNDFILE *sf;
     FDCH    fdch;
     AUXCH   auxData;            /* for dynamically allocated buffers */
-    AUXCH   auxData2;
   MYFLT *aOut_buf;
   MYFLT aOut_bufsize;
   void *cb;
   int  async;
+  void *stream;
 } DISKIN2_ARRAY;
 
 int diskin2_init(CSOUND *csound, DISKIN2 *p);
@@ -121,6 +121,7 @@ int32_t ftlen(CSOUND *, void *), ftlptim(CSOUND *, void *);
 int32_t ftchnls(CSOUND *, void *), ftcps(CSOUND *, void *);
 int32_t signum(CSOUND *, void *), asignum(CSOUND *, void *);
 int32_t rtclock(CSOUND *, void *);
+int32_t overload_state(CSOUND *, void *);
 int32_t cpsoct(CSOUND *, void *), octpch(CSOUND *, void *);
 int32_t cpspch(CSOUND *, void *), pchoct(CSOUND *, void *);
 int32_t octcps(CSOUND *, void *), acpsoct(CSOUND *, void *);
@@ -181,6 +182,8 @@ int32_t osckk(CSOUND *, void *), oscka(CSOUND *, void *);
 int32_t oscak(CSOUND *, void *), oscaa(CSOUND *, void *);
 int32_t koscli(CSOUND *, void *), osckki(CSOUND *, void *);
 int32_t osckai(CSOUND *, void *), oscaki(CSOUND *, void *);
+int32_t osckk_batch(CSOUND *, void **, int32_t);
+int32_t osckki_batch(CSOUND *, void **, int32_t);
 int32_t oscaai(CSOUND *, void *), foscset(CSOUND *, void *);
 int32_t foscil(CSOUND *, void *), foscili(CSOUND *, void *);
 int32_t losset(CSOUND *, void *), loscil(CSOUND *, void *);
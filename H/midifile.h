@@ -28,7 +28,7 @@
 extern "C" {
 #endif
 
-/* open MIDI file, read all tracks, and create event list */
+/* open MIDI file, check all tracks, and create tempo map */
 
 int csoundMIDIFileOpen(CSOUND *csound, const char *name);
 
@@ -36,7 +36,7 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name);
 
 int csoundMIDIFileRead(CSOUND *csound, unsigned char *buf, int nBytes);
 
-/* destroy MIDI file event list */
+/* close MIDI file and free its data */
 
 int csoundMIDIFileClose(CSOUND *csound);
 
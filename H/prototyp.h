@@ -91,6 +91,7 @@ int     insert_score_event(CSOUND *, EVTBLK *, double);
 MEMFIL  *ldmemfile2withCB(CSOUND *csound, const char *filnam, int csFileType,
                           int (*callback)(CSOUND*, MEMFIL*));
 void    rlsmemfiles(CSOUND *);
+void    rlspvxmemfiles(CSOUND *);
 int     delete_memfile(CSOUND *, const char *);
 char    *csoundTmpFileName(CSOUND *, const char *);
 void    *SAsndgetset(CSOUND *, char *, void *, MYFLT *, MYFLT *, MYFLT *, int);
@@ -135,6 +136,17 @@ int csoundRegisterDeinitCallback(CSOUND *, void *p,
 int csoundRegisterResetCallback(CSOUND *, void *userData,
                                 int (*func)(CSOUND *, void *));
 
+/**
+ * Registers 'batchadr' as the multi-voice version of the perf function
+ * 'opadr' (see --voice-batch), for instruments compiled from now on.
+ * Returns zero on success.
+ */
+int csoundRegisterBatchKernel(CSOUND *, SUBR opadr, BSUBR batchadr);
+/**
+ * Returns the multi-voice version of the perf function 'opadr',
+ * or NULL if there is none.
+ */
+BSUBR csoundFindBatchKernel(CSOUND *, SUBR opadr);
 /**
  * Returns the name of the opcode of which the data structure
  * is pointed to by 'p'.
@@ -293,6 +305,13 @@ int csoundSetUtilityDescription(CSOUND *, const char *utilName,
  */
 int csoundDeleteAllConfigurationVariables(CSOUND *);
 
+/**
+ * Lock and unlock the process-wide mutex (defined in csGblMtx.h), which
+ * protects data shared by all Csound instances in the process.
+ */
+void csoundLock(void);
+void csoundUnLock(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,167 @@
+/*
+    sampconv.h:
+
+    Copyright (C) 2026
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/*                                                      SAMPCONV.H      */
+
+/* Sample format conversion and dither for the sound file and real time  */
+/* audio modules.  No loop carries state from one sample to the next, so */
+/* the compiler can vectorise all of them: the dither for sample n of a  */
+/* stream is a hash of n, rather than the next value of a serial random  */
+/* generator, and rounding and clipping are done without branches.       */
+
+#ifndef CSOUND_SAMPCONV_H
+#define CSOUND_SAMPCONV_H
+
+#include <float.h>
+
+/* dither shapes, as in csound->dither_output */
+#define SCONV_NO_DITHER         0
+#define SCONV_TRIANGULAR        1
+#define SCONV_RECTANGULAR       2
+
+/* integer hash of a sample counter (the "lowbias32" mixer) */
+static inline uint32_t sconv_hash(uint32_t x)
+{
+    x ^= x >> 16; x *= 0x7FEB352DU;
+    x ^= x >> 15; x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+/* dither in (-0.5, 0.5) LSB from a hash value: the mean of its two */
+/* 16-bit halves for triangular, or the low half for rectangular    */
+static inline MYFLT sconv_dither(uint32_t h, int shape)
+{
+    int32_t r = (shape == SCONV_TRIANGULAR ?
+                 (int32_t) (((h & 0xFFFF) + (h >> 16)) >> 1) :
+                 (int32_t) (h & 0xFFFF));
+    return (MYFLT) (r - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
+}
+
+/* round to nearest, ties to even, as lrint() does; exact for |x| below */
+/* 2^22, and larger values stay large enough to be clipped afterwards  */
+static inline MYFLT sconv_round(MYFLT x)
+{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+    /* x87 arithmetic: intermediates are not rounded to MYFLT */
+    return (MYFLT) MYFLT2LRND(x);
+#else
+#ifdef USE_DOUBLE
+    const MYFLT magic = 6755399441055744.0;     /* 1.5 * 2^52 */
+#else
+    const MYFLT magic = 12582912.0f;            /* 1.5 * 2^23 */
+#endif
+    return (x + magic) - magic;
+#endif
+}
+
+/* as sconv_round(), in double precision, exact for |x| below 2^51 */
+static inline double sconv_round_d(double x)
+{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+    return (double) llrint(x);
+#else
+    return (x + 6755399441055744.0) - 6755399441055744.0;
+#endif
+}
+
+/* add dither of the given amplitude (one LSB of the output format, */
+/* relative to 0dbfs) to n samples; *count is the sample counter    */
+static inline void sconv_dither_add(MYFLT *buf, int n, MYFLT lsb,
+                                    int shape, uint32_t *count)
+{
+    uint32_t c = *count;
+    int i;
+    for (i = 0; i < n; i++)
+      buf[i] += lsb * sconv_dither(sconv_hash(c + (uint32_t) i), shape);
+    *count = c + (uint32_t) n;
+}
+
+/* MYFLT in [-1, 1] to 16 bit integer, with or without dither */
+static inline void sconv_to_short(const MYFLT *in, int16_t *out, int n,
+                                  int shape, uint32_t *count)
+{
+    uint32_t c = *count;
+    int i;
+    if (shape == SCONV_NO_DITHER) {
+      for (i = 0; i < n; i++) {
+        MYFLT x = sconv_round(in[i] * (MYFLT) 0x8000);
+        x = (x > FL(-32768.0) ? x : FL(-32768.0));  /* NaN to -32768 */
+        x = (x < FL(32767.0) ? x : FL(32767.0));
+        out[i] = (int16_t) (int32_t) x;
+      }
+      return;
+    }
+    for (i = 0; i < n; i++) {
+      MYFLT x = sconv_round(in[i] * (MYFLT) 0x8000
+                            + sconv_dither(sconv_hash(c + (uint32_t) i),
+                                           shape));
+      x = (x > FL(-32768.0) ? x : FL(-32768.0));
+      x = (x < FL(32767.0) ? x : FL(32767.0));
+      out[i] = (int16_t) (int32_t) x;
+    }
+    *count = c + (uint32_t) n;
+}
+
+/* MYFLT in [-1, 1] to 32 bit integer; computed in double precision, */
+/* which is exact for float input as well                            */
+static inline void sconv_to_long(const MYFLT *in, int32_t *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+      double x = sconv_round_d((double) in[i] * 2147483648.0);
+      x = (x > -2147483648.0 ? x : -2147483648.0);
+      x = (x < 2147483647.0 ? x : 2147483647.0);
+      out[i] = (int32_t) x;
+    }
+}
+
+static inline void sconv_to_float(const MYFLT *in, float *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      out[i] = (float) in[i];
+}
+
+static inline void sconv_from_short(const int16_t *in, MYFLT *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i] * (FL(1.0) / (MYFLT) 0x8000);
+}
+
+static inline void sconv_from_long(const int32_t *in, MYFLT *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i] * (FL(1.0) / (MYFLT) 0x80000000UL);
+}
+
+static inline void sconv_from_float(const float *in, MYFLT *out, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+      out[i] = (MYFLT) in[i];
+}
+
+#endif  /* CSOUND_SAMPCONV_H */
@@ -0,0 +1,78 @@
+/*
+    sndstream.h:
+
+    Copyright (C) 2026
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+/*                                                      SNDSTREAM.H     */
+
+/* Random access to compressed sound files.  An MP3 file is kept in     */
+/* memory as it is, with an index of its frames built when it is first  */
+/* opened; other files are read through libsndfile.  Decoded audio is   */
+/* held in blocks shared by every reader in the process, and the least  */
+/* recently used blocks are dropped once SNDSTREAM_CACHE bytes (or the  */
+/* size set by sndstream_reserve()) are in use, so that a table or      */
+/* reader only costs memory for the parts of a file that are being      */
+/* played.                                                              */
+
+#ifndef CSOUND_SNDSTREAM_H
+#define CSOUND_SNDSTREAM_H
+
+#define SNDSTREAM_SNDFILE       0
+#define SNDSTREAM_MP3           1
+
+#define SNDSTREAM_CACHE         (64 * 1024 * 1024)  /* decoded bytes */
+
+typedef struct SNDSTREAM_ SNDSTREAM;
+
+typedef struct {
+    const char *path;                   /* full path name of the file */
+    int     type;                       /* SNDSTREAM_MP3 or _SNDFILE */
+    int     channels;
+    int     sr;
+    int64_t frames;                     /* exact length in sample frames */
+    int     layer;                      /* MPEG layer, or 0 */
+    int     bitrate;                    /* average, in kbit/s, or 0 */
+    int     format;                     /* libsndfile format, or 0 */
+    int     hasinstr;                   /* instr holds the loop points */
+    SF_INSTRUMENT instr;
+} SNDSTREAM_INFO;
+
+/* open sound file name (searched for in SFDIR and SSDIR), sharing the */
+/* stream if it is already open; returns NULL if it cannot be decoded  */
+SNDSTREAM *sndstream_open(CSOUND *csound, const char *name);
+/* the same for a full path name; uses no Csound services, so that it */
+/* can be called from any thread                                      */
+SNDSTREAM *sndstream_open_path(const char *path);
+void sndstream_close(SNDSTREAM *s);
+const SNDSTREAM_INFO *sndstream_info(SNDSTREAM *s);
+
+/* read up to n interleaved sample frames, in the range -1 to 1, from */
+/* frame pos on; returns the number of frames read, which is less     */
+/* than n only at the end of the file                                 */
+int64_t sndstream_read(SNDSTREAM *s, int64_t pos, float *out, int64_t n);
+
+/* decode the whole stream into the cache, if it fits */
+void sndstream_fetch(SNDSTREAM *s);
+
+/* let the cache hold at least bytes of decoded audio */
+void sndstream_reserve(size_t bytes);
+
+#endif  /* CSOUND_SNDSTREAM_H */
@@ -23,12 +23,40 @@
 
 #include <csoundCore.h>
 
+/* Single-producer, single-consumer ring buffer. The write position is
+   only stored by the writer and the read position only by the reader.
+   Each side publishes its position with release ordering after the
+   data it covers has been copied, and loads the other side's position
+   with acquire ordering, so no other synchronisation is needed. The two
+   positions are kept on separate cache lines, so that the writer and
+   the reader do not invalidate each other's line on every update.
+   Transfers are done with at most two copies, split at the end of the
+   buffer. */
+
+#define CB_CACHE_LINE   64
+
+#if defined(MSVC)
+#define CB_LOAD_ACQUIRE(x)                                              \
+    InterlockedCompareExchange((volatile LONG *) &(x), 0, 0)
+#define CB_STORE_RELEASE(x, v)                                          \
+    InterlockedExchange((volatile LONG *) &(x), (v))
+#elif defined(HAVE_ATOMIC_BUILTIN)
+#define CB_LOAD_ACQUIRE(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define CB_STORE_RELEASE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#else
+#define CB_LOAD_ACQUIRE(x)      (x)
+#define CB_STORE_RELEASE(x, v)  ((x) = (v))
+#endif
+
 typedef struct _circular_buffer {
   char *buffer;
-  int  wp;
-  int rp;
   int numelem;
   int elemsize; /* in number of bytes */
+  char pad0[CB_CACHE_LINE];
+  int wp;       /* written by the producer only */
+  char pad1[CB_CACHE_LINE];
+  int rp;       /* written by the consumer only */
+  char pad2[CB_CACHE_LINE];
 } circular_buffer;
 
 void *csoundCreateCircularBuffer(CSOUND *csound, int numelem, int elemsize){
@@ -48,18 +76,46 @@ void *csoundCreateCircularBuffer(CSOUND *csound, int numelem, int elemsize){
     return (void *)p;
 }
 
-static int checkspace(circular_buffer *p, int writeCheck){
-    int wp = p->wp, rp = p->rp, numelem = p->numelem;
-    if(writeCheck){
-      if (wp > rp) return rp - wp + numelem - 1;
-      else if (wp < rp) return rp - wp - 1;
-      else return numelem - 1;
+/* number of items that can be read */
+
+static inline int readspace(circular_buffer *p, int wp, int rp){
+    int n = wp - rp;
+    return n < 0 ? n + p->numelem : n;
+}
+
+/* number of items that can be written (one slot is always kept free) */
+
+static inline int writespace(circular_buffer *p, int wp, int rp){
+    return p->numelem - 1 - readspace(p, wp, rp);
+}
+
+/* copy items starting at rp to out, and return the new read position */
+
+static int copyout(circular_buffer *p, int rp, char *out, int items){
+    int n = p->numelem - rp, size = p->elemsize;
+    if (n > items) n = items;
+    memcpy(out, p->buffer + (size_t) rp * size, (size_t) n * size);
+    if (items > n) {
+      memcpy(out + (size_t) n * size, p->buffer, (size_t) (items - n) * size);
+      return items - n;
     }
-    else {
-      if (wp > rp) return wp - rp;
-      else if (wp < rp) return wp - rp + numelem;
-      else return 0;
+    rp += n;
+    return rp == p->numelem ? 0 : rp;
+}
+
+/* copy items from in to the buffer starting at wp, and return the new */
+/* write position                                                        */
+
+static int copyin(circular_buffer *p, int wp, const char *in, int items){
+    int n = p->numelem - wp, size = p->elemsize;
+    if (n > items) n = items;
+    memcpy(p->buffer + (size_t) wp * size, in, (size_t) n * size);
+    if (items > n) {
+      memcpy(p->buffer, in + (size_t) n * size, (size_t) (items - n) * size);
+      return items - n;
     }
+    wp += n;
+    return wp == p->numelem ? 0 : wp;
 }
 
 int csoundReadCircularBuffer(CSOUND *csound, void *p, void *out, int items)
@@ -67,29 +123,15 @@ int csoundReadCircularBuffer(CSOUND *csound, void *p, void *out, int items)
     IGN(csound);
     if (p == NULL) return 0;
     {
-      int remaining;
-      int itemsread, numelem = ((circular_buffer *)p)->numelem;
-      int elemsize = ((circular_buffer *)p)->elemsize;
-      int i=0, rp = ((circular_buffer *)p)->rp;
-      char *buffer = ((circular_buffer *)p)->buffer;
-      if ((remaining = checkspace(p, 0)) == 0) {
+      circular_buffer *cb = (circular_buffer *) p;
+      int rp = cb->rp;
+      int remaining = readspace(cb, CB_LOAD_ACQUIRE(cb->wp), rp);
+      int itemsread = items > remaining ? remaining : items;
+      if (itemsread <= 0) {
         return 0;
       }
-      itemsread = items > remaining ? remaining : items;
-      for (i=0; i < itemsread; i++){
-        memcpy((char *) out + (i * elemsize),
-               &(buffer[elemsize * rp++]),  elemsize);
-        if (rp == numelem) {
-          rp = 0;
-        }
-      }
-#if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->rp, rp);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_exchange_n(&((circular_buffer *)p)->rp,rp, __ATOMIC_SEQ_CST);
-#else
-      ((circular_buffer *)p)->rp = rp;
-#endif
+      rp = copyout(cb, rp, (char *) out, itemsread);
+      CB_STORE_RELEASE(cb->rp, rp);
       return itemsread;
     }
 }
@@ -98,77 +140,105 @@ int csoundPeekCircularBuffer(CSOUND *csound, void *p, void *out, int items)
 {
     IGN(csound);
     if (p == NULL) return 0;
-    int remaining;
-    int itemsread, numelem = ((circular_buffer *)p)->numelem;
-    int elemsize = ((circular_buffer *)p)->elemsize;
-    int i=0, rp = ((circular_buffer *)p)->rp;
-    char *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 0)) == 0) {
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int rp = cb->rp;
+      int remaining = readspace(cb, CB_LOAD_ACQUIRE(cb->wp), rp);
+      int itemsread = items > remaining ? remaining : items;
+      if (itemsread <= 0) {
         return 0;
+      }
+      copyout(cb, rp, (char *) out, itemsread);
+      return itemsread;
     }
-    itemsread = items > remaining ? remaining : items;
-    for(i=0; i < itemsread; i++){
-        memcpy((char *) out + (i * elemsize),
-               &(buffer[elemsize * rp++]),  elemsize);
-        if (rp == numelem) {
-            rp = 0;
-        }
-    }
-    return itemsread;
 }
 
 void csoundFlushCircularBuffer(CSOUND *csound, void *p)
 {
     IGN(csound);
     if (p == NULL) return;
-    int remaining;
-    int itemsread, numelem = ((circular_buffer *)p)->numelem;
-    int i=0, rp = ((circular_buffer *)p)->rp;
-    //MYFLT *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 0)) == 0) {
-        return;
-    }
-    itemsread = numelem > remaining ? remaining: numelem;
-    for (i=0; i < itemsread; i++){
-        rp++;
-        if(rp == numelem) rp = 0;
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      CB_STORE_RELEASE(cb->rp, CB_LOAD_ACQUIRE(cb->wp));
     }
-#if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->rp, rp);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_store_n(&((circular_buffer *)p)->rp,rp, __ATOMIC_SEQ_CST);
-#else
-      ((circular_buffer *)p)->rp = rp;
-#endif
 }
 
-
 int csoundWriteCircularBuffer(CSOUND *csound, void *p, const void *in, int items)
 {
     IGN(csound);
     if (p == NULL) return 0;
-    int remaining;
-    int itemswrite, numelem = ((circular_buffer *)p)->numelem;
-    int elemsize = ((circular_buffer *)p)->elemsize;
-    int i=0, wp = ((circular_buffer *)p)->wp;
-    char *buffer = ((circular_buffer *)p)->buffer;
-    if ((remaining = checkspace(p, 1)) == 0) {
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int wp = cb->wp;
+      int remaining = writespace(cb, wp, CB_LOAD_ACQUIRE(cb->rp));
+      int itemswrite = items > remaining ? remaining : items;
+      if (itemswrite <= 0) {
         return 0;
+      }
+      wp = copyin(cb, wp, (const char *) in, itemswrite);
+      CB_STORE_RELEASE(cb->wp, wp);
+      return itemswrite;
     }
-    itemswrite = items > remaining ? remaining : items;
-    for(i=0; i < itemswrite; i++){
-        memcpy(&(buffer[elemsize * wp++]),
-                ((char *) in) + (i * elemsize),  elemsize);
-        if(wp == numelem) wp = 0;
+}
+
+void *csoundAcquireCircularBufferRead(CSOUND *csound, void *p,
+                                      int items, int *avail)
+{
+    IGN(csound);
+    *avail = 0;
+    if (p == NULL) return NULL;
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int rp = cb->rp;
+      int n = readspace(cb, CB_LOAD_ACQUIRE(cb->wp), rp);
+      if (n > cb->numelem - rp) n = cb->numelem - rp;   /* up to the end */
+      if (n > items) n = items;
+      if (n <= 0) return NULL;
+      *avail = n;
+      return cb->buffer + (size_t) rp * cb->elemsize;
+    }
+}
+
+void csoundCommitCircularBufferRead(CSOUND *csound, void *p, int items)
+{
+    IGN(csound);
+    if (p == NULL || items <= 0) return;
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int rp = cb->rp + items;
+      if (rp >= cb->numelem) rp -= cb->numelem;
+      CB_STORE_RELEASE(cb->rp, rp);
+    }
+}
+
+void *csoundAcquireCircularBufferWrite(CSOUND *csound, void *p,
+                                       int items, int *avail)
+{
+    IGN(csound);
+    *avail = 0;
+    if (p == NULL) return NULL;
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int wp = cb->wp;
+      int n = writespace(cb, wp, CB_LOAD_ACQUIRE(cb->rp));
+      if (n > cb->numelem - wp) n = cb->numelem - wp;   /* up to the end */
+      if (n > items) n = items;
+      if (n <= 0) return NULL;
+      *avail = n;
+      return cb->buffer + (size_t) wp * cb->elemsize;
+    }
+}
+
+void csoundCommitCircularBufferWrite(CSOUND *csound, void *p, int items)
+{
+    IGN(csound);
+    if (p == NULL || items <= 0) return;
+    {
+      circular_buffer *cb = (circular_buffer *) p;
+      int wp = cb->wp + items;
+      if (wp >= cb->numelem) wp -= cb->numelem;
+      CB_STORE_RELEASE(cb->wp, wp);
     }
-#if defined(MSVC)
-      InterlockedExchange(&((circular_buffer *)p)->wp, wp);
-#elif defined(HAVE_ATOMIC_BUILTIN)
-      __atomic_store_n(&((circular_buffer *)p)->wp,wp, __ATOMIC_SEQ_CST);
-#else
-      ((circular_buffer *)p)->wp = wp;
-#endif
-    return itemswrite;
 }
 
 void csoundDestroyCircularBuffer(CSOUND *csound, void *p){
@@ -23,6 +23,7 @@
 
 #include "csoundCore.h"                 /*             SNDLIB.C         */
 #include "soundio.h"
+#include "sampconv.h"
 #include <stdlib.h>
 #include <time.h>
 #include <inttypes.h>
@@ -200,216 +201,183 @@ static void writesf(CSOUND *csound, const MYFLT *outbuf, int nbytes)
     }
 }
 
-static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
-{
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int    dith;
+/* dithered output: dither of one LSB of the file format is added to */
+/* the buffer before the write; STA(dither) counts the samples        */
 
+static inline void writesf_dithered(CSOUND *csound, const MYFLT *outbuf,
+                                    int nbytes, int shape, MYFLT lsb)
+{
     if (UNLIKELY(STA(outfile) == NULL))
       return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   tmp = ((dith * 15625) + 1) & 0xFFFF;
-      int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith = rnd;
-      rnd = (rnd+tmp)>>1;           /* triangular distribution */
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7fff);
-      buf[n] += result;
-    }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
-    }
+    sconv_dither_add((MYFLT*) outbuf, nbytes / (int) sizeof(MYFLT), lsb,
+                     shape, &STA(dither));
+    writesf(csound, outbuf, nbytes);
+}
+
+static void writesf_dither_16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    writesf_dithered(csound, outbuf, nbytes,
+                     SCONV_TRIANGULAR, FL(1.0) / (MYFLT) 0x7fff);
 }
 
 static void writesf_dither_8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    writesf_dithered(csound, outbuf, nbytes,
+                     SCONV_TRIANGULAR, FL(1.0) / (MYFLT) 0x7f);
+}
 
-    if (UNLIKELY(STA(outfile) == NULL))
-      return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   tmp = ((dith * 15625) + 1) & 0xFFFF;
-      int   rnd = ((tmp * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith = rnd;
-      rnd = (rnd+tmp)>>1;           /* triangular distribution */
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7f);
-      buf[n] += result;
-    }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
+static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    writesf_dithered(csound, outbuf, nbytes,
+                     SCONV_RECTANGULAR, FL(1.0) / (MYFLT) 0x7fff);
+}
+
+static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+{
+    writesf_dithered(csound, outbuf, nbytes,
+                     SCONV_RECTANGULAR, FL(1.0) / (MYFLT) 0x7f);
+}
+
+/* Sound file writer thread (--write-buffers=N).  Full output buffers  */
+/* are queued for a thread that calls the synchronous audtran above,   */
+/* and spoutsf carries on in one of N spare buffers; the performance   */
+/* thread only waits on the file system when all of them are queued.   */
+
+typedef struct {
+    MYFLT   *buf;
+    int     nbytes;
+} SFBLOCK;
+
+typedef struct {
+    void    (*write)(CSOUND *, const MYFLT *, int);
+    void    *full, *empty;          /* circular buffers of SFBLOCK      */
+    void    *dataReady, *bufFree;   /* thread locks                     */
+    void    *thread;
+    int     running;
+    int     nret, nput;             /* short write, reported on return  */
+    uint32  nblocks, nstalls;       /* stall statistics                 */
+    double  stalltime, maxstall;
+} SFWRITER;
+
+static uintptr_t sfwriter_thread(void *data)
+{
+    CSOUND    *csound = (CSOUND*) data;
+    SFWRITER  *w = (SFWRITER*) STA(writer);
+    SFBLOCK   blk;
+    int       running;
+
+    do {
+      running = ATOMIC_GET(w->running);
+      if (csoundReadCircularBuffer(csound, w->full, &blk, 1) == 1) {
+        /* after a failed write, only hand the buffers back */
+        if (!ATOMIC_GET(w->nput))
+          w->write(csound, blk.buf, blk.nbytes);
+        csoundWriteCircularBuffer(csound, w->empty, &blk, 1);
+        csound->NotifyThreadLock(w->bufFree);
+      }
+      else if (running)
+        csound->WaitThreadLock(w->dataReady, 100);
+      else
         break;
-    }
+    } while (1);
+    return 0;
 }
 
-static void writesf_dither_u16(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static int sfwriter_stop(CSOUND *csound, int *nret);
+
+/* audtran of the writer thread: queue the buffer, and continue in a   */
+/* free one                                                             */
+static void writesf_async(CSOUND *csound, const MYFLT *outbuf, int nbytes)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    SFWRITER  *w = (SFWRITER*) STA(writer);
+    SFBLOCK   blk;
+    int       nret, nput;
 
-    if (UNLIKELY(STA(outfile) == NULL))
+    if (UNLIKELY(ATOMIC_GET(w->nput) != 0)) {
+      nput = sfwriter_stop(csound, &nret);
+      sndwrterr(csound, nret, nput);
       return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   rnd = ((dith * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      dith =  rnd;
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7fff);
-      buf[n] += result;
     }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s",  "\a");
-        break;
+    blk.buf = (MYFLT*) outbuf;
+    blk.nbytes = nbytes;
+    csoundWriteCircularBuffer(csound, w->full, &blk, 1);
+    csound->NotifyThreadLock(w->dataReady);
+    w->nblocks++;
+    if (UNLIKELY(csoundReadCircularBuffer(csound, w->empty, &blk, 1) == 0)) {
+      /* every spare buffer is waiting to be written */
+      RTCLOCK t;
+      double  dt;
+      csoundInitTimerStruct(&t);
+      while (csoundReadCircularBuffer(csound, w->empty, &blk, 1) == 0)
+        csound->WaitThreadLock(w->bufFree, 10);
+      dt = csoundGetRealTime(&t);
+      w->nstalls++;
+      w->stalltime += dt;
+      if (dt > w->maxstall)
+        w->maxstall = dt;
     }
+    STA(outbuf) = blk.buf;
 }
 
-static void writesf_dither_u8(CSOUND *csound, const MYFLT *outbuf, int nbytes)
+static void sfwriter_start(CSOUND *csound, int nbufs)
 {
-    OPARMS  *O = csound->oparms;
-    int     n;
-    int m = nbytes / sizeof(MYFLT);
-    MYFLT *buf = (MYFLT*) outbuf;
-    int dith;
+    SFWRITER  *w;
+    SFBLOCK   blk;
+    int       i;
 
-    if (UNLIKELY(STA(outfile) == NULL))
+    w = (SFWRITER*) csound->Calloc(csound, sizeof(SFWRITER));
+    w->write = csound->audtran;
+    /* one slot of each circular buffer is always kept free */
+    w->full = csoundCreateCircularBuffer(csound, nbufs + 2, sizeof(SFBLOCK));
+    w->empty = csoundCreateCircularBuffer(csound, nbufs + 2, sizeof(SFBLOCK));
+    w->dataReady = csound->CreateThreadLock();
+    w->bufFree = csound->CreateThreadLock();
+    for (i = 0; i < nbufs; i++) {
+      blk.buf = (MYFLT*) csound->Malloc(csound, STA(outbufsiz));
+      blk.nbytes = 0;
+      csoundWriteCircularBuffer(csound, w->empty, &blk, 1);
+    }
+    w->running = 1;
+    STA(writer) = w;
+    if (UNLIKELY((w->thread = csound->CreateThread(sfwriter_thread,
+                                                   csound)) == NULL)) {
+      csound->Warning(csound, Str("could not start the sound file writer "
+                                  "thread, writing synchronously"));
+      sfwriter_stop(csound, &i);
       return;
-    dith = STA(dither);
-    for (n=0; n<m; n++) {
-      int   rnd = ((dith * 15625) + 1) & 0xFFFF;
-      MYFLT result;
-      STA(dither) = rnd;
-      result = (MYFLT) (rnd - 0x8000)  / ((MYFLT) 0x10000);
-      result /= ((MYFLT) 0x7f);
-      buf[n] += result;
     }
-    STA(dither) = dith;
-    n = (int) sf_write_MYFLT(STA(outfile), (MYFLT*) outbuf,
-                             nbytes / sizeof(MYFLT)) * (int) sizeof(MYFLT);
-    if (UNLIKELY(n < nbytes))
-      sndwrterr(csound, n, nbytes);
-    if (UNLIKELY(O->rewrt_hdr))
-      rewriteheader(STA(outfile));
-    switch (O->heartbeat) {
-      case 1:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME,
-                                 "%c\010", "|/-\\"[csound->nrecs & 3]);
-        break;
-      case 2:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, ".");
-        break;
-      case 3:
-        {
-          char    s[512];
-          CS_SPRINTF(s, "%ld(%.3f)%n", (long) csound->nrecs,
-                  csound->icurTime/csound->esr, &n);
-          if (n > 0) {
-            memset(&(s[n]), '\b', n);
-            s[n + n] = '\0';
-            csound->MessageS(csound, CSOUNDMSG_REALTIME, "%s", s);
-          }
-        }
-        break;
-      case 4:
-        csound->MessageS(csound, CSOUNDMSG_REALTIME, "\a");
-        break;
+    csound->audtran = writesf_async;
+}
+
+/* write out everything queued, and return to synchronous output;    */
+/* returns the byte count of a failed write, or zero                   */
+static int sfwriter_stop(CSOUND *csound, int *nret)
+{
+    SFWRITER  *w = (SFWRITER*) STA(writer);
+    SFBLOCK   blk;
+    int       nput;
+
+    if (w->thread != NULL) {
+      ATOMIC_SET(w->running, 0);
+      csound->NotifyThreadLock(w->dataReady);
+      csound->JoinThread(w->thread);
     }
+    csound->audtran = w->write;
+    STA(writer) = NULL;
+    csound->Message(csound, Str("sound file writer: %u buffers, "
+                                "%u stalls (%.1f ms, longest %.1f ms)\n"),
+                    (unsigned int) w->nblocks, (unsigned int) w->nstalls,
+                    w->stalltime * 1000.0, w->maxstall * 1000.0);
+    while (csoundReadCircularBuffer(csound, w->empty, &blk, 1) == 1)
+      csound->Free(csound, blk.buf);
+    csoundDestroyCircularBuffer(csound, w->full);
+    csoundDestroyCircularBuffer(csound, w->empty);
+    csound->DestroyThreadLock(w->dataReady);
+    csound->DestroyThreadLock(w->bufFree);
+    *nret = w->nret;
+    nput = w->nput;
+    csound->Free(csound, w);
+    return nput;
 }
 
 static int readsf(CSOUND *csound, MYFLT *inbuf, int inbufsize)
@@ -827,9 +795,11 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
     if (csound->dither_output && csound->oparms->outformat!=AE_FLOAT &&
         csound->oparms->outformat!=AE_DOUBLE) {
       if (csound->oparms->outformat==AE_SHORT)
-        csound->audtran = writesf_dither_16;
+        csound->audtran = (csound->dither_output==1 ?
+                           writesf_dither_16 : writesf_dither_u16);
       else if (csound->oparms->outformat==AE_CHAR)
-        csound->audtran = writesf_dither_8;
+        csound->audtran = (csound->dither_output==1 ?
+                           writesf_dither_8 : writesf_dither_u8);
       else
         csound->audtran = writesf;
     }
@@ -866,6 +836,9 @@ void sfopenout(CSOUND *csound)                  /* init for sound out       */
     /* calc outbuf size & alloc bufspace */
     STA(outbufsiz) = O->outbufsamps * sizeof(MYFLT);
     STA(outbufp)   = STA(outbuf) = csound->Malloc(csound, STA(outbufsiz));
+    if (O->writeBuffers > 0 && STA(pipdevout) != 2 && STA(outfile) != NULL &&
+        STA(writer) == NULL)
+      sfwriter_start(csound, O->writeBuffers);
     if (STA(pipdevout) == 2)
       csound->Message(csound,
                       Str("writing %d sample blks of %lu-bit floats to %s\n"),
@@ -921,6 +894,11 @@ void sfcloseout(CSOUND *csound)
       csound->nrecs++;
       csound->audtran(csound, STA(outbuf), nb);
     }
+    if (STA(writer) != NULL) {
+      int nret, nput;
+      if (UNLIKELY((nput = sfwriter_stop(csound, &nret)) != 0))
+        sndwrterr(csound, nret, nput);
+    }
     if (STA(pipdevout) == 2 && (!STA(isfopen) || STA(pipdevin) != 2)) {
       /* close only if not open for input too */
       csound->rtclose_callback(csound);
@@ -965,6 +943,13 @@ void sfcloseout(CSOUND *csound)
 
 static void sndwrterr(CSOUND *csound, int nret, int nput)
 {
+    if (STA(writer) != NULL) {
+      /* in the writer thread: leave it to writesf_async */
+      SFWRITER  *w = (SFWRITER*) STA(writer);
+      w->nret = nret;
+      ATOMIC_SET(w->nput, nput);
+      return;
+    }
     csound->ErrorMsg(csound,
                      Str("soundfile write returned bytecount of %d, not %d"),
                      nret, nput);
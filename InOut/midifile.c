@@ -31,24 +31,26 @@ static const char *midiTrack_ID = "MTrk";
 static const double default_tempo = 120.0;
 
 typedef struct tempoEvent_s {
-    unsigned long   kcnt;               /* time (in ticks while reading     */
-                                        /*   MIDI file, will be converted   */
-                                        /*   to kperiods once file is read) */
+    unsigned long   tick;               /* time in ticks                    */
+    unsigned long   kcnt;               /* time in kperiods                 */
+    double          kTime;              /* unrounded time in kperiods       */
+    double          kPerTick;           /* kperiods per tick from here on   */
     double          tempoVal;           /* tempo value in beats per minute  */
 } tempoEvent_t;
 
-typedef struct midiEvent_s {
-    unsigned long   kcnt;               /* time (in ticks while reading     */
-                                        /*   MIDI file, will be converted   */
-                                        /*   to kperiods once file is read) */
-#if 0
-    unsigned char   *data;              /* pointer to sysex or meta event   */
-                                        /*   data (currently not used)      */
-#endif
-    unsigned char   st;                 /* status byte (0x80-0xFF)          */
-    unsigned char   d1;                 /* data byte 1 (0x00-0x7F)          */
-    unsigned char   d2;                 /* data byte 2 (0x00-0x7F)          */
-} midiEvent_t;
+typedef struct midiTrack_s {
+    const unsigned char *data;          /* track data (in file image)       */
+    int             len;                /* length of track data             */
+    int             pos;                /* read position in track data      */
+    int             saved_st;           /* status byte for running status   */
+    unsigned long   tick;               /* time of next event in ticks      */
+    unsigned long   kcnt;               /*   and in kperiods                */
+    unsigned char   st;                 /* next event: status byte          */
+    unsigned char   d1;                 /*   data byte 1                    */
+    unsigned char   d2;                 /*   data byte 2                    */
+    unsigned char   muted;              /* non-zero if track is muted       */
+    int             tempoIndex;         /* tempo change last looked up      */
+} midiTrack_t;
 
 typedef struct midiFile_s {
     /* static file data, not changed at performance */
@@ -57,42 +59,34 @@ typedef struct midiFile_s {
     unsigned long   totalKcnt;          /* total duration of file           */
                                         /*   (in ticks while reading file,  */
                                         /*   converted to kperiods)         */
-    int             nEvents;            /* number of events                 */
-    int             maxEvents;          /* event array size                 */
+    unsigned char   *fileData;          /* image of the whole file          */
+    int             nTracks;            /* number of tracks                 */
     int             nTempo;             /* number of tempo changes          */
     int             maxTempo;           /* tempo change array size          */
-    midiEvent_t     *eventList;         /* array of MIDI events             */
-    tempoEvent_t    *tempoList;         /* array of tempo changes           */
+    midiTrack_t     *trackList;         /* array of tracks                  */
+    tempoEvent_t    *tempoList;         /* tempo map, from time zero        */
+    int             *trackHeap;         /* tracks with events left, heap    */
+                                        /*   ordered by next event time     */
     /* performance time state variables */
     double          currentTempo;       /* current tempo in BPM             */
-    int             eventListIndex;     /* index of next MIDI event in list */
+    int             heapSize;           /* number of tracks in heap         */
     int             tempoListIndex;     /* index of next tempo change       */
+    unsigned long   lastKcnt;           /* time of last read in kperiods    */
 } midiFile_t;
 
 #define MIDIFILE    (csound->midiGlobals->midiFileData)
 #define MF(x)       (((midiFile_t*) MIDIFILE)->x)
 
-static int getCh(CSOUND *csound, FILE *f, int *bytesLeft)
+static int getCh(CSOUND *csound, midiTrack_t *t)
 {
-    int c;
-
-    if (f == NULL)
-      return -1;
-    c = getc(f);
-    if (UNLIKELY(c == EOF)) {
-      csound->Message(csound, Str(" *** unexpected end of MIDI file\n"));
+    if (UNLIKELY(t->pos >= t->len)) {
+      csound->Message(csound, Str(" *** unexpected end of MIDI track\n"));
       return -1;
     }
-    if (bytesLeft != NULL) {
-      if (UNLIKELY(--(*bytesLeft) < 0)) {
-        csound->Message(csound, Str(" *** unexpected end of MIDI track\n"));
-        return -1;
-      }
-    }
-    return (c & 0xFF);
+    return (int) t->data[t->pos++];
 }
 
-static int getVLenData(CSOUND *csound, FILE *f, int *bytesLeft)
+static int getVLenData(CSOUND *csound, midiTrack_t *t)
 {
     int c, n, cnt;
 
@@ -103,7 +97,7 @@ static int getVLenData(CSOUND *csound, FILE *f, int *bytesLeft)
                         Str(" *** invalid dynamic length data in MIDI file\n"));
         return -1;
       }
-      c = getCh(csound, f, bytesLeft);
+      c = getCh(csound, t);
       if (c < 0)
         return -1;
       n = (n << 7) | (c & 0x7F);
@@ -150,34 +144,20 @@ static int msgDataBytes(int c)
     return -1;
 }
 
-static int alloc_event(CSOUND *csound, unsigned long kcnt, unsigned char *data,
-                                       int st, int d1, int d2)
+/* a real time message may appear within any other message: */
+/* it is skipped, and anything else is an error             */
+
+static int checkRealTimeEvent(CSOUND *csound, int st)
 {
-    midiEvent_t *tmp;
-    IGN(data);
-    /* expand array if necessary */
-    if (MF(nEvents) >= MF(maxEvents)) {
-      MF(maxEvents) += (MF(maxEvents) >> 3);
-      MF(maxEvents) = (MF(maxEvents) + 64) & (~63);
-      tmp = (midiEvent_t*) csound->ReAlloc(csound, MF(eventList),
-                                    sizeof(midiEvent_t) * MF(maxEvents));
-      MF(eventList) = tmp;
-      tmp = &(MF(eventList)[MF(nEvents)]);
-      memset(tmp, 0, sizeof(midiEvent_t) * (MF(maxEvents) - MF(nEvents)));
+    if (UNLIKELY(st < 0xF8 || msgDataBytes(st) != 0)) {
+      csound->Message(csound, Str(" *** unexpected event 0x%02X\n"),
+                              (unsigned int) st);
+      return -1;
     }
-    /* store new event */
-    tmp = &(MF(eventList)[MF(nEvents)]);
-    MF(nEvents)++;
-    tmp->kcnt = kcnt;
- /* tmp->data = data; */        /* not used yet */
-    tmp->st = (unsigned char) st;
-    tmp->d1 = (unsigned char) d1;
-    tmp->d2 = (unsigned char) d2;
-    /* done */
     return 0;
 }
 
-static int alloc_tempo(CSOUND *csound, unsigned long kcnt, double tempoVal)
+static int alloc_tempo(CSOUND *csound, unsigned long tick, double tempoVal)
 {
     tempoEvent_t *tmp;
     /* expand array if necessary */
@@ -193,243 +173,183 @@ static int alloc_tempo(CSOUND *csound, unsigned long kcnt, double tempoVal)
     /* store new event */
     tmp = &(MF(tempoList)[MF(nTempo)]);
     MF(nTempo)++;
-    tmp->kcnt = kcnt; tmp->tempoVal = tempoVal;
+    tmp->tick = tick; tmp->tempoVal = tempoVal;
     /* done */
     return 0;
 }
 
-static int readEvent(CSOUND *csound, FILE *f, int *tlen,
-                     unsigned long tickCnt, int st, int *saved_st);
+/* read events from track 't' up to the next one that is sent to the   */
+/* MIDI input, and store it in 't'; the others are skipped, unless     */
+/* 'scan' is non-zero (when the file is opened), in which case text    */
+/* meta events are printed, and tempo changes and the end of track are */
+/* stored. Returns 1 if an event was read, 0 at the end of the track,  */
+/* and -1 on error.                                                    */
 
-static int checkRealTimeEvent(CSOUND *csound, FILE *f, int *tlen,
-                              unsigned long tickCnt, int st, int *saved_st)
+static int readEvent(CSOUND *csound, midiTrack_t *t, int scan)
 {
-    if (st & 0x80) {
-      if (UNLIKELY(st < 0xF8 || st > 0xFE)) {
-        csound->Message(csound, Str(" *** unexpected event 0x%02X\n"),
-                                (unsigned int) st);
-        return -1;
-      }
-      /* handle real time message (return code -2) */
-      if (readEvent(csound, f, tlen, tickCnt, st, saved_st) != 0)
-        return -1;
-      return -2;
-    }
-    return st;
-}
+    int i, c, d, st, cnt, dataBytes[2];
 
-static int readEvent(CSOUND *csound, FILE *f, int *tlen,
-                     unsigned long tickCnt, int st, int *saved_st)
-{
-    int i, c, d, cnt, dataBytes[2];
-
-    cnt = dataBytes[0] = dataBytes[1] = 0;
-    if (st < 0x80) {
-      /* repeat previous status byte */
-      dataBytes[cnt++] = st;
-      st = *saved_st;
-      if (UNLIKELY(st < 0x80)) {
-        csound->Message(csound, Str(" *** invalid MIDI file data\n"));
+    while (t->pos < t->len) {
+      /* get delta time */
+      c = getVLenData(csound, t);
+      if (c < 0)
         return -1;
-      }
-    }
-    c = msgDataBytes(st);
-    if (c >= 0) {
-      if (c > 0) {
-        /* save status byte for repeat */
-        *saved_st = st;
-      }
-      while (cnt < c) {
-        /* read data byte(s) */
-        d = getCh(csound, f, tlen);
-        if (d < 0 || *tlen < 0) return -1;
-        d = checkRealTimeEvent(csound, f, tlen, tickCnt, d, saved_st);
-        if (d == -2)    /* read real time event: continue with reading data */
-          continue;
-        if (d < 0) return -1;
-        dataBytes[cnt++] = d;
-      }
-      return alloc_event(csound, tickCnt, NULL, st,
-                         dataBytes[0], dataBytes[1]);
-    }
-    /* message is of unknown or special type */
-    if (st == 0xF0) {
-      /* system exclusive */
-      i = getVLenData(csound, f, tlen);
-      if (i < 0 || *tlen < 0) return -1;
-      /* read message */
-      while (--i >= 0) {
-        d = getCh(csound, f, tlen);
-        if (d < 0 || *tlen < 0) return -1;
-        if (d == 0xF7) {        /* EOX */
-          if (LIKELY(!i))
-            return 0;           /* should be at end of message */
-          csound->Message(csound, Str(" *** unexpected end of system "
-                                      "exclusive message\n"));
+      t->tick += (unsigned long) c;
+      /* get status byte */
+      st = getCh(csound, t);
+      if (st < 0)
+        return -1;
+      cnt = dataBytes[0] = dataBytes[1] = 0;
+      if (st < 0x80) {
+        /* repeat previous status byte */
+        dataBytes[cnt++] = st;
+        st = t->saved_st;
+        if (UNLIKELY(st < 0x80)) {
+          csound->Message(csound, Str(" *** invalid MIDI file data\n"));
           return -1;
         }
-        d = checkRealTimeEvent(csound, f, tlen, tickCnt, d, saved_st);
-        if (d == -2)            /* if read real time event, */
-          i++;                  /* continue with reading message bytes */
-        else if (UNLIKELY(d < 0))
-          return -1;            /* error */
       }
-      /* zero length or EOX not found */
-      csound->Message(csound, Str(" *** invalid system exclusive "
-                                  "message in MIDI file\n"));
-      return -1;
-    }
-    else if (st == 0xF7) {
-      /* escape sequence: skip message */
-      i = getVLenData(csound, f, tlen);         /* message length */
-      if (i < 0 || *tlen < 0) return -1;
-      while (--i >= 0) {
-        c = getCh(csound, f, tlen);
-        if (c < 0 || *tlen < 0) return -1;
-      }
-      return 0;
-    }
-    else if (st == 0xFF) {
-      /* meta event */
-      st = getCh(csound, f, tlen);              /* message type */
-      if (st < 0 || *tlen < 0) return -1;
-      i = getVLenData(csound, f, tlen);         /* message length */
-      if (i < 0 || *tlen < 0) return -1;
-      if (i > 0 &&
-          ((st >= 1 && st <= 5 && (csound->oparms->msglevel & 7) == 7) ||
-           (st == 3 && csound->oparms->msglevel != 0))) {
-        /* print non-empty text meta events, depending on message level */
-        switch (st) {
-          case 0x01: csound->Message(csound, Str("  Message: ")); break;
-          case 0x02: csound->Message(csound, Str("  Copyright info: ")); break;
-          case 0x03: csound->Message(csound, Str("  Track name: ")); break;
-          case 0x04: csound->Message(csound, Str("  Instrument name: ")); break;
-          case 0x05: csound->Message(csound, Str("  Song lyric: ")); break;
+      c = msgDataBytes(st);
+      if (c >= 0) {
+        if (c > 0) {
+          /* save status byte for repeat */
+          t->saved_st = st;
         }
-        while (--i >= 0) {
-          c = getCh(csound, f, tlen);
-          if (c < 0 || *tlen < 0) return -1;
-          csound->Message(csound, "%c", c);
+        while (cnt < c) {
+          /* read data byte(s) */
+          d = getCh(csound, t);
+          if (d < 0)
+            return -1;
+          if (d & 0x80) {
+            if (checkRealTimeEvent(csound, d) != 0)
+              return -1;
+            continue;
+          }
+          dataBytes[cnt++] = d;
         }
-        csound->Message(csound, "\n");
-        return 0;
+        t->st = (unsigned char) st;
+        t->d1 = (unsigned char) dataBytes[0];
+        t->d2 = (unsigned char) dataBytes[1];
+        return 1;
       }
-      switch (st) {
-        case 0x51:                        /* tempo change */
-          d = 0;
-          while (--i >= 0) {
-            c = getCh(csound, f, tlen);
-            if (c < 0 || *tlen < 0) return -1;
-            d = (d << 8) | c;
-          }
-          if (UNLIKELY(d < 1)) {
-            csound->Message(csound, Str(" *** invalid tempo\n"));
+      /* message is of unknown or special type */
+      if (st == 0xF0) {
+        /* system exclusive */
+        i = getVLenData(csound, t);
+        if (i < 0)
+          return -1;
+        d = -1;
+        /* read message */
+        while (--i >= 0) {
+          d = getCh(csound, t);
+          if (d < 0)
             return -1;
-          }
-          return alloc_tempo(csound, tickCnt, (60000000.0 / (double) d));
-        case 0x2F:                        /* end of track */
-          if (UNLIKELY(i)) {
-            csound->Message(csound, Str(" *** invalid end of track event\n"));
+          if (d == 0xF7) {      /* EOX */
+            if (LIKELY(!i))
+              break;            /* should be at end of message */
+            csound->Message(csound, Str(" *** unexpected end of system "
+                                        "exclusive message\n"));
             return -1;
           }
-          if (UNLIKELY(*tlen > 0)) {
-            csound->Message(csound, Str(" *** trailing garbage at end of "
-                                        "MIDI track\n"));
+          if (d & 0x80) {       /* if real time event, */
+            if (checkRealTimeEvent(csound, d) != 0)
+              return -1;
+            i++;                /* continue with reading message bytes */
+          }
+        }
+        if (UNLIKELY(d != 0xF7)) {
+          /* zero length or EOX not found */
+          csound->Message(csound, Str(" *** invalid system exclusive "
+                                      "message in MIDI file\n"));
+          return -1;
+        }
+      }
+      else if (st == 0xF7) {
+        /* escape sequence: skip message */
+        i = getVLenData(csound, t);             /* message length */
+        if (i < 0)
+          return -1;
+        while (--i >= 0) {
+          if (getCh(csound, t) < 0)
             return -1;
+        }
+      }
+      else if (st == 0xFF) {
+        /* meta event */
+        st = getCh(csound, t);                  /* message type */
+        if (st < 0)
+          return -1;
+        i = getVLenData(csound, t);             /* message length */
+        if (i < 0)
+          return -1;
+        if (scan && i > 0 &&
+            ((st >= 1 && st <= 5 && (csound->oparms->msglevel & 7) == 7) ||
+             (st == 3 && csound->oparms->msglevel != 0))) {
+          /* print non-empty text meta events, depending on message level */
+          switch (st) {
+            case 0x01: csound->Message(csound, Str("  Message: ")); break;
+            case 0x02: csound->Message(csound, Str("  Copyright info: ")); break;
+            case 0x03: csound->Message(csound, Str("  Track name: ")); break;
+            case 0x04: csound->Message(csound, Str("  Instrument name: ")); break;
+            case 0x05: csound->Message(csound, Str("  Song lyric: ")); break;
           }
-          /* update file length info */
-          if (tickCnt > MF(totalKcnt))
-            MF(totalKcnt) = tickCnt;
-          return 0;
-        default:                          /* skip any other meta event */
           while (--i >= 0) {
-            c = getCh(csound, f, tlen);
-            if (c < 0 || *tlen < 0) return -1;
+            c = getCh(csound, t);
+            if (c < 0)
+              return -1;
+            csound->Message(csound, "%c", c);
           }
-          return 0;
+          csound->Message(csound, "\n");
+          continue;
+        }
+        switch (st) {
+          case 0x51:                      /* tempo change */
+            d = 0;
+            while (--i >= 0) {
+              c = getCh(csound, t);
+              if (c < 0)
+                return -1;
+              d = (d << 8) | c;
+            }
+            if (UNLIKELY(d < 1)) {
+              csound->Message(csound, Str(" *** invalid tempo\n"));
+              return -1;
+            }
+            if (scan)
+              alloc_tempo(csound, t->tick, (60000000.0 / (double) d));
+            break;
+          case 0x2F:                      /* end of track */
+            if (UNLIKELY(i)) {
+              csound->Message(csound, Str(" *** invalid end of track event\n"));
+              return -1;
+            }
+            if (UNLIKELY(t->pos < t->len)) {
+              csound->Message(csound, Str(" *** trailing garbage at end of "
+                                          "MIDI track\n"));
+              return -1;
+            }
+            /* update file length info */
+            if (scan && t->tick > MF(totalKcnt))
+              MF(totalKcnt) = t->tick;
+            return 0;
+          default:                        /* skip any other meta event */
+            while (--i >= 0) {
+              if (getCh(csound, t) < 0)
+                return -1;
+            }
+            break;
+        }
       }
-    }
-    csound->Message(csound, Str(" *** unknown MIDI message: 0x%02X\n"),
-                            (unsigned int) st);
-    return -1;
-}
-
-static int readTrack(CSOUND *csound, FILE *f)
-{
-    unsigned int    tickCnt;
-    int             i, c, tlen, st, saved_st;
-
-    /* check for track header */
-    for (i = 0; i < 4; i++) {
-      c = getCh(csound, f, NULL);
-      if (c < 0)
-        return -1;
-      if (UNLIKELY(c != (int) midiTrack_ID[i])) {
-        csound->Message(csound, Str(" *** invalid MIDI track header\n"));
+      else {
+        csound->Message(csound, Str(" *** unknown MIDI message: 0x%02X\n"),
+                                (unsigned int) st);
         return -1;
       }
     }
-    /* read track length */
-    tlen = 0;
-    for (i = 0; i < 4; i++) {
-      c = getCh(csound, f, NULL);
-      if (c < 0)
-        return -1;
-      tlen = (tlen << 8) | c;
-    }
-    /* read track data */
-    tickCnt = 0UL;
-    saved_st = -1;
-    while (tlen > 0) {
-      /* get delta time */
-      c = getVLenData(csound, f, &tlen);
-      if (c < 0 || tlen < 0)
-        return -1;
-      tickCnt += (unsigned long) c;
-      /* get status byte */
-      st = getCh(csound, f, &tlen);
-      if (st < 0 || tlen < 0)
-        return -1;
-      /* process event */
-      if (readEvent(csound, f, &tlen, tickCnt, st, &saved_st) != 0)
-        return -1;
-    }
-    /* successfully read track */
+    /* end of track data */
     return 0;
 }
 
-/**
- * Sorts an array of midiEvent_t structures using merge sort algorithm
- * so that the order of events at the same time is preserved.
- * 'p' is the array to be sorted, and 'cnt' is the number of elements
- * (should be > 1). 'tmp' is temporary space of the same length as 'p'.
- */
-
-static CS_NOINLINE void midiEvent_sort(midiEvent_t *p, midiEvent_t *tmp,
-                                       size_t cnt)
-{
-    size_t  p1, p2, dstp;
-    size_t  n = cnt >> 1;
-
-    if (n > (size_t) 1)
-      midiEvent_sort(p, tmp, n);
-    if (cnt > (size_t) 2)
-      midiEvent_sort(&(p[n]), tmp, cnt - n);
-    dstp = (size_t) 0;
-    p1 = (size_t) 0;
-    p2 = n;
-    do {
-      size_t  srcp;
-      if (p2 >= cnt || (p1 < n && p[p1].kcnt <= p[p2].kcnt))
-        srcp = p1++;
-      else
-        srcp = p2++;
-      tmp[dstp] = p[srcp];
-    } while (++dstp < cnt);
-    /* copy result back to original array */
-    memcpy(p, tmp, cnt * sizeof(midiEvent_t));
-}
-
 /**
  * Sorts an array of tempoEvent_t structures using merge sort algorithm
  * so that the order of events at the same time is preserved.
@@ -452,7 +372,7 @@ static CS_NOINLINE void tempoEvent_sort(tempoEvent_t *p, tempoEvent_t *tmp,
     p2 = n;
     do {
       size_t  srcp;
-      if (p2 >= cnt || (p1 < n && p[p1].kcnt <= p[p2].kcnt))
+      if (p2 >= cnt || (p1 < n && p[p1].tick <= p[p2].tick))
         srcp = p1++;
       else
         srcp = p2++;
@@ -462,96 +382,171 @@ static CS_NOINLINE void tempoEvent_sort(tempoEvent_t *p, tempoEvent_t *tmp,
     memcpy(p, tmp, cnt * sizeof(tempoEvent_t));
 }
 
-/* sort event lists by time and convert tick times to Csound k-periods */
+/* convert time in ticks to Csound k-periods: looks up the last tempo */
+/* change at or before 'tick' in the tempo map, searching forward from */
+/* '*idx' (the one found for the previous event of the same track) in  */
+/* steps that double in size, and then by binary search                */
 
-static void sortEventLists(CSOUND *csound)
+static unsigned long tickToKcnt(midiFile_t *mf, int *idx, unsigned long tick)
 {
-    double        timeVal, tempoVal;
-    unsigned long prvTicks, curTicks, tickEvent, tickTempo;
-    int           i, j;
-
-    /* sort events by time in ascending order */
-    if (MF(nEvents) > 1 || MF(nTempo) > 1) {
-      void    *tmp;
-      size_t  nbytes;
-      nbytes = (size_t) MF(nEvents) * sizeof(midiEvent_t);
-      if (((size_t) MF(nTempo) * sizeof(tempoEvent_t)) > nbytes)
-        nbytes = (size_t) MF(nTempo) * sizeof(tempoEvent_t);
-      tmp = csound->Malloc(csound, nbytes);
-      if (MF(nEvents) > 1)
-        midiEvent_sort(MF(eventList), (midiEvent_t *) tmp,
-                       (size_t) MF(nEvents));
-      if (MF(nTempo) > 1)
-        tempoEvent_sort(MF(tempoList), (tempoEvent_t *) tmp,
-                        (size_t) MF(nTempo));
+    tempoEvent_t  *p = mf->tempoList;
+    int           lo = *idx, hi, mid, step = 1;
+
+    if (mf->timeCode < 0.0)             /* time based tick values */
+      return (unsigned long) ((double) tick * p[0].kPerTick + 0.5);
+    if (p[lo].tick > tick)
+      lo = 0;
+    hi = lo + 1;
+    while (hi < mf->nTempo && p[hi].tick <= tick) {
+      lo = hi;
+      step <<= 1;
+      hi = lo + step;
+    }
+    hi = (hi < mf->nTempo ? hi : mf->nTempo) - 1;
+    while (lo < hi) {
+      mid = (lo + hi + 1) >> 1;
+      if (p[mid].tick <= tick)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    *idx = lo;
+    return (unsigned long) (p[lo].kTime +
+                            (double) (tick - p[lo].tick) * p[lo].kPerTick + 0.5);
+}
+
+/* sort tempo changes by time, and find the time of each in k-periods; */
+/* the first entry is the default tempo at time zero                   */
+
+static void makeTempoMap(CSOUND *csound)
+{
+    tempoEvent_t  *p;
+    double        timeVal = 0.0;
+    int           i;
+
+    if (MF(nTempo) > 1) {
+      tempoEvent_t  *tmp;
+      tmp = (tempoEvent_t*) csound->Malloc(csound, (size_t) MF(nTempo)
+                                                   * sizeof(tempoEvent_t));
+      tempoEvent_sort(MF(tempoList), tmp, (size_t) MF(nTempo));
       csound->Free(csound, tmp);
     }
-    if (MF(timeCode) > 0.0) {
-      /* tick values are in fractions of a beat */
-      timeVal = 0.0;
-      tempoVal = default_tempo;
-      prvTicks = curTicks = 0UL;
-      /* k-periods per tick */
-      tempoVal = (double) csound->ekr / (tempoVal * MF(timeCode) / 60.0);
-      i = j = 0;
-      while (i < MF(nEvents) || j < MF(nTempo)) {
-        prvTicks = curTicks;
-        tickEvent = tickTempo = 0UL;
-        tickEvent--; tickTempo--;   /* will be max value for unsigned long */
-        if (i < MF(nEvents)) tickEvent = MF(eventList)[i].kcnt;
-        if (j < MF(nTempo)) tickTempo = MF(tempoList)[j].kcnt;
-        if (tickEvent < tickTempo) {
-          curTicks = tickEvent;
-          timeVal += ((double) ((long) (curTicks - prvTicks)) * tempoVal);
-          MF(eventList)[i++].kcnt = (unsigned long) (timeVal + 0.5);
-        }
-        else {
-          curTicks = tickTempo;
-          timeVal += ((double) ((long) (curTicks - prvTicks)) * tempoVal);
-          tempoVal = MF(tempoList)[j].tempoVal;     /* new tempo */
-          /* k-periods per tick */
-          tempoVal = (double) csound->ekr / (tempoVal * MF(timeCode) / 60.0);
-          MF(tempoList)[j++].kcnt = (unsigned long) (timeVal + 0.5);
-        }
+    for (i = 0; i < MF(nTempo); i++) {
+      p = &(MF(tempoList)[i]);
+      if (MF(timeCode) > 0.0) {
+        /* tick values are in fractions of a beat */
+        if (i > 0)
+          timeVal += (double) (p->tick - p[-1].tick) * p[-1].kPerTick;
+        /* k-periods per tick */
+        p->kPerTick = (double) csound->ekr
+                      / (p->tempoVal * MF(timeCode) / 60.0);
       }
-      /* calculate total file length in k-periods */
-      timeVal += ((double) ((long) (MF(totalKcnt) - curTicks)) * tempoVal);
-      MF(totalKcnt) = (unsigned long) (timeVal + 0.5);
-    }
-    else {
-      /* simple case: time based tick values */
-      tempoVal = -(MF(timeCode));
-      /* k-periods per tick */
-      tempoVal = (double) csound->ekr / tempoVal;
-      i = -1;
-      while (++i < MF(nEvents)) {
-        curTicks = MF(eventList)[i].kcnt;
-        timeVal = (double) curTicks * tempoVal;
-        curTicks = (unsigned long) (timeVal + 0.5);
-        MF(eventList)[i].kcnt = curTicks;
+      else {
+        /* simple case: time based tick values */
+        p->kPerTick = (double) csound->ekr / -(MF(timeCode));
+        timeVal = (double) p->tick * p->kPerTick;
       }
-      i = -1;
-      while (++i < MF(nTempo)) {
-        curTicks = MF(tempoList)[i].kcnt;
-        timeVal = (double) curTicks * tempoVal;
-        curTicks = (unsigned long) (timeVal + 0.5);
-        MF(tempoList)[i].kcnt = curTicks;
+      p->kTime = timeVal;
+      p->kcnt = (unsigned long) (timeVal + 0.5);
+    }
+    /* calculate total file length in k-periods */
+    i = 0;
+    MF(totalKcnt) = tickToKcnt((midiFile_t*) MIDIFILE, &i, MF(totalKcnt));
+}
+
+/* the heap of tracks is ordered by the time of the next event, and */
+/* by track number for events at the same time                      */
+
+static inline int trackBefore(midiFile_t *mf, int a, int b)
+{
+    unsigned long ta = mf->trackList[a].tick, tb = mf->trackList[b].tick;
+    return (ta < tb || (ta == tb && a < b));
+}
+
+static void trackHeap_down(midiFile_t *mf, int i)
+{
+    int *h = mf->trackHeap, n = mf->heapSize, c, tmp;
+
+    while ((c = (i << 1) + 1) < n) {
+      if (c + 1 < n && trackBefore(mf, h[c + 1], h[c]))
+        c++;
+      if (!trackBefore(mf, h[c], h[i]))
+        break;
+      tmp = h[i]; h[i] = h[c]; h[c] = tmp;
+      i = c;
+    }
+}
+
+/* read the next event of the track on top of the heap */
+
+static void nextTrackEvent(CSOUND *csound, midiFile_t *mf)
+{
+    midiTrack_t *t = &(mf->trackList[mf->trackHeap[0]]);
+
+    if (readEvent(csound, t, 0) > 0)
+      t->kcnt = tickToKcnt(mf, &(t->tempoIndex), t->tick);
+    else                                /* end of track: remove from heap */
+      mf->trackHeap[0] = mf->trackHeap[--(mf->heapSize)];
+    trackHeap_down(mf, 0);
+}
+
+/* move all tracks to their first event at or after 'kcnt' k-periods; */
+/* the tracks were checked for errors when the file was opened        */
+
+static void midiFileSeek(CSOUND *csound, midiFile_t *mf, unsigned long kcnt)
+{
+    midiTrack_t *t;
+    int         i;
+
+    mf->heapSize = 0;
+    for (i = 0; i < mf->nTracks; i++) {
+      t = &(mf->trackList[i]);
+      if (t->muted)
+        continue;
+      t->pos = 0;
+      t->saved_st = -1;
+      t->tick = 0UL;
+      t->tempoIndex = 0;
+      while (readEvent(csound, t, 0) > 0) {
+        t->kcnt = tickToKcnt(mf, &(t->tempoIndex), t->tick);
+        if (t->kcnt >= kcnt) {
+          mf->trackHeap[mf->heapSize++] = i;
+          break;
+        }
       }
-      /* calculate total file length in k-periods */
-      MF(totalKcnt) = (unsigned long) ((double) MF(totalKcnt) * tempoVal + 0.5);
     }
+    for (i = (mf->heapSize >> 1) - 1; i >= 0; i--)
+      trackHeap_down(mf, i);
+    /* tempo changes up to 'kcnt' are found by the next read */
+    mf->currentTempo = default_tempo;
+    mf->tempoListIndex = 0;
+    mf->lastKcnt = kcnt;
+}
+
+/* big-endian integer of 'n' bytes from the file header */
+
+static int getBE(const unsigned char *p, int n)
+{
+    int i, c = 0;
+
+    for (i = 0; i < n; i++)
+      c = (c << 8) | (int) p[i];
+    return c;
 }
 
  /* ------------------------------------------------------------------------ */
 
-/* open MIDI file, read all tracks, and create event list */
+/* open MIDI file, read it into memory, check all tracks, and make the */
+/* tempo map; events are merged from the tracks at performance time    */
 
 int csoundMIDIFileOpen(CSOUND *csound, const char *name)
 {
     FILE    *f = NULL;
     void    *fd = NULL;
     char    *m;
-    int     i, c, hdrLen, fileFormat, nTracks, timeCode, saved_nEvents;
+    unsigned char *buf = NULL;
+    size_t  bufSize = 0, fileLen = 0, n;
+    int     i, c, pos, hdrLen, fileFormat, nTracks, timeCode, tlen;
     int     mute_track;
 
     if (MIDIFILE != NULL)
@@ -572,33 +567,41 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
       }
     }
     csound->Message(csound, Str("Reading MIDI file '%s'...\n"), name);
-    /* check header */
-    for (i = 0; i < 4; i++) {
-      c = getCh(csound, f, NULL);
-      if (UNLIKELY(c < 0)) goto err_return;
-      if (UNLIKELY(c != (int) midiFile_ID[i])) {
-        csound->Message(csound, Str(" *** invalid MIDI file header\n"));
-        goto err_return;
+    /* read the whole file, which is then only parsed in memory */
+    do {
+      if (fileLen >= bufSize) {
+        bufSize = (bufSize ? bufSize << 1 : (size_t) 65536);
+        buf = (unsigned char*) csound->ReAlloc(csound, buf, bufSize);
       }
+      n = fread(buf + fileLen, 1, bufSize - fileLen, f);
+      fileLen += n;
+    } while (n > 0);
+    if (fd != NULL)
+      csound->FileClose(csound, fd);
+    /* allocate structure */
+    MIDIFILE = (void*) csound->Calloc(csound, sizeof(midiFile_t));
+    MF(fileData) = buf;
+    if (UNLIKELY(fileLen > (size_t) 0x7FFFFFFF)) {
+      csound->Message(csound, Str(" *** MIDI file is too large\n"));
+      goto err_return;
     }
-    /* header length: must be 6 bytes */
-    hdrLen = 0;
-    for (i = 0; i < 4; i++) {
-      c = getCh(csound, f, NULL);
-      if (UNLIKELY(c < 0)) goto err_return;
-      hdrLen = (hdrLen << 8) | c;
+    /* check header */
+    if (UNLIKELY(fileLen < 14)) {
+      csound->Message(csound, Str(" *** unexpected end of MIDI file\n"));
+      goto err_return;
+    }
+    if (UNLIKELY(memcmp(buf, midiFile_ID, 4) != 0)) {
+      csound->Message(csound, Str(" *** invalid MIDI file header\n"));
+      goto err_return;
     }
+    /* header length: must be 6 bytes */
+    hdrLen = getBE(buf + 4, 4);
     if (UNLIKELY(hdrLen != 6)) {
       csound->Message(csound, Str(" *** invalid MIDI file header\n"));
       goto err_return;
     }
     /* file format (only 0 and 1 are supported) */
-    fileFormat = 0;
-    for (i = 0; i < 2; i++) {
-      c = getCh(csound, f, NULL);
-      if (UNLIKELY(c < 0)) goto err_return;
-      fileFormat = (fileFormat << 8) | c;
-    }
+    fileFormat = getBE(buf + 8, 2);
     if (UNLIKELY(fileFormat != 0 && fileFormat != 1)) {
       csound->Message(csound,
                       Str(" *** MIDI file format %d is not supported\n"),
@@ -606,12 +609,7 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
       goto err_return;
     }
     /* number of tracks */
-    nTracks = 0;
-    for (i = 0; i < 2; i++) {
-      c = getCh(csound, f, NULL);
-      if (UNLIKELY(c < 0)) goto err_return;
-      nTracks = (nTracks << 8) | c;
-    }
+    nTracks = getBE(buf + 10, 2);
     if (UNLIKELY(nTracks < 1)) {
       csound->Message(csound, Str(" *** invalid number of tracks\n"));
       goto err_return;
@@ -621,14 +619,7 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
                                   "multiple tracks\n"));
     }
     /* time code */
-    timeCode = 0;
-    for (i = 0; i < 2; i++) {
-      c = getCh(csound, f, NULL);
-      if (UNLIKELY(c < 0)) goto err_return;
-      timeCode = (timeCode << 8) | c;
-    }
-    /* allocate structure */
-    MIDIFILE = (void*) csound->Calloc(csound, sizeof(midiFile_t));
+    timeCode = getBE(buf + 12, 2);
     /* calculate ticks per second or beat based on time code */
     if (UNLIKELY(timeCode < 1 || (timeCode >= 0x8000 && (timeCode & 0xFF) == 0))) {
       csound->Message(csound, Str(" *** invalid time code: %d\n"), timeCode);
@@ -655,17 +646,19 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
     }
     /* initialise structure data */
     MF(totalKcnt) = csound->global_kcounter;
-    MF(nEvents) = 0; MF(maxEvents) = 0;
+    MF(nTracks) = nTracks;
+    MF(trackList) = (midiTrack_t*) csound->Calloc(csound, (size_t) nTracks
+                                                          * sizeof(midiTrack_t));
+    MF(trackHeap) = (int*) csound->Calloc(csound, (size_t) nTracks
+                                                  * sizeof(int));
     MF(nTempo) = 0; MF(maxTempo) = 0;
-    MF(eventList) = (midiEvent_t*) NULL;
     MF(tempoList) = (tempoEvent_t*) NULL;
-    MF(currentTempo) = default_tempo;
-    MF(eventListIndex) = 0;
-    MF(tempoListIndex) = 0;
-    /* read all tracks */
+    alloc_tempo(csound, 0UL, default_tempo);
+    /* check all tracks, and store tempo changes */
     m = &(csound->midiGlobals->muteTrackList[0]);
+    pos = 14;
     for (i = 0; i < nTracks; i++) {
-      saved_nEvents = MF(nEvents);
+      midiTrack_t *t = &(MF(trackList)[i]);
       mute_track = 0;
       if (*m != '\0') {             /* is this track muted ? */
         if (*m == '1')
@@ -680,23 +673,42 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
         csound->Message(csound, Str(" Track %2d\n"), i);
       else
         csound->Message(csound, Str(" Track %2d is muted\n"), i);
-      if (readTrack(csound, f) != 0)
+      /* check for track header, and read track length */
+      if (UNLIKELY(fileLen - (size_t) pos < 8)) {
+        csound->Message(csound, Str(" *** unexpected end of MIDI file\n"));
+        goto err_return;
+      }
+      if (UNLIKELY(memcmp(buf + pos, midiTrack_ID, 4) != 0)) {
+        csound->Message(csound, Str(" *** invalid MIDI track header\n"));
+        goto err_return;
+      }
+      tlen = getBE(buf + pos + 4, 4);
+      pos += 8;
+      if (UNLIKELY(tlen < 0 || (size_t) tlen > fileLen - (size_t) pos)) {
+        csound->Message(csound, Str(" *** unexpected end of MIDI file\n"));
         goto err_return;
-      if (mute_track)                   /* if track is muted, discard any */
-        MF(nEvents) = saved_nEvents;    /* non-tempo events read */
+      }
+      t->data = buf + pos;
+      t->len = tlen;
+      t->saved_st = -1;
+      t->muted = (unsigned char) mute_track;
+      /* read track data */
+      do {
+        c = readEvent(csound, t, 1);
+      } while (c > 0);
+      if (c < 0)
+        goto err_return;
+      pos += tlen;
     }
-    if (fd != NULL)
-      csound->FileClose(csound, fd);
-    /* prepare event and tempo list for reading */
-    sortEventLists(csound);
+    /* prepare tempo map and tracks for reading */
+    makeTempoMap(csound);
+    midiFileSeek(csound, (midiFile_t*) MIDIFILE, 0UL);
     /* successfully read MIDI file */
     csound->Message(csound, Str("done.\n"));
     return 0;
 
     /* in case of error: clean up and report error */
  err_return:
-    if (fd != NULL)
-      csound->FileClose(csound, fd);
     csoundMIDIFileClose(csound);
     return -1;
 }
@@ -705,25 +717,29 @@ int csoundMIDIFileOpen(CSOUND *csound, const char *name)
 
 int csoundMIDIFileRead(CSOUND *csound, unsigned char *buf, int nBytes)
 {
-    midiFile_t  *mf;
-    int         i, j, n, nRead;
+    midiFile_t    *mf;
+    midiTrack_t   *t;
+    unsigned long kcnt;
+    int           j, n, nRead;
 
     mf = (midiFile_t*) MIDIFILE;
     if (mf == NULL)
       return 0;
-    i = mf->eventListIndex;
+    kcnt = (unsigned long) csound->global_kcounter;
+    if (UNLIKELY(kcnt < mf->lastKcnt))
+      midiFileSeek(csound, mf, kcnt);   /* time has moved back */
+    mf->lastKcnt = kcnt;
     j = mf->tempoListIndex;
-    if (i >= mf->nEvents && j >= mf->nTempo) {
+    if (mf->heapSize == 0 && j >= mf->nTempo) {
       /* there are no more events, */
-      if ((unsigned long) csound->global_kcounter >= mf->totalKcnt &&
-          !(csound->MTrkend)) {
+      if (kcnt >= mf->totalKcnt && !(csound->MTrkend)) {
         /* and end of file is reached: */
         csound->Message(csound, Str("end of midi track in '%s'\n"),
                                 csound->oparms->FMidiname);
         csound->Message(csound, Str("%d forced decays, %d extra noteoffs\n"),
                                 csound->Mforcdecs, csound->Mxtroffs);
         csound->MTrkend = 1;
-        csoundMIDIFileClose(csound);
+        /* the file is kept in memory for csoundRewindScore() */
         csound->oparms->FMidiin = 0;
         if (csound->oparms->ringbell && !(csound->oparms->termifend))
           csound->Message(csound, "\a");
@@ -732,19 +748,17 @@ int csoundMIDIFileRead(CSOUND *csound, unsigned char *buf, int nBytes)
     }
     /* otherwise read any events with time less than or equal to */
     /* current orchestra time */
-    while (j < mf->nTempo &&
-           (unsigned long) csound->global_kcounter >= mf->tempoList[j].kcnt) {
+    while (j < mf->nTempo && kcnt >= mf->tempoList[j].kcnt) {
       /* tempo change */
       mf->currentTempo = mf->tempoList[j++].tempoVal;
     }
     mf->tempoListIndex = j;
     nRead = 0;
-    while (i < mf->nEvents &&
-           (unsigned long) csound->global_kcounter >= mf->eventList[i].kcnt) {
-      n = msgDataBytes((int) mf->eventList[i].st) + 1;
-      if (n < 1) {
-        i++; continue;        /* unknown or system event: skip */
-      }
+    while (mf->heapSize > 0) {
+      t = &(mf->trackList[mf->trackHeap[0]]);
+      if (kcnt < t->kcnt)
+        break;
+      n = msgDataBytes((int) t->st) + 1;
       nBytes -= n;
       if (UNLIKELY(nBytes < 0)) {
         csound->Message(csound, Str(" *** buffer overflow while reading "
@@ -752,21 +766,26 @@ int csoundMIDIFileRead(CSOUND *csound, unsigned char *buf, int nBytes)
         break;      /* return with whatever has been read so far */
       }
       nRead += n;
-      *buf++ = mf->eventList[i].st;
-      if (n > 1) *buf++ = mf->eventList[i].d1;
-      if (n > 2) *buf++ = mf->eventList[i].d2;
-      i++;
+      *buf++ = t->st;
+      if (n > 1) *buf++ = t->d1;
+      if (n > 2) *buf++ = t->d2;
+      nextTrackEvent(csound, mf);
     }
-    mf->eventListIndex = i;
     /* return the number of bytes read */
     return nRead;
 }
 
-/* destroy MIDI file event list */
+/* close MIDI file, and free the file image and tempo map */
 
 int csoundMIDIFileClose(CSOUND *csound)
 {
-    /* nothing to do: memRESET() will free any allocated memory */
+    if (MIDIFILE != NULL) {
+      csound->Free(csound, MF(fileData));
+      csound->Free(csound, MF(trackList));
+      csound->Free(csound, MF(trackHeap));
+      csound->Free(csound, MF(tempoList));
+      csound->Free(csound, MIDIFILE);
+    }
     MIDIFILE = (void*) NULL;
     return 0;
 }
@@ -782,11 +801,10 @@ void midifile_rewind_score(CSOUND *csound)
     OPARMS *O = csound->oparms;
 
     if (MIDIFILE != NULL) {
-      /* reset event index and tempo */
-      MF(currentTempo) = default_tempo;
-      MF(eventListIndex) = 0;
-      MF(tempoListIndex) = 0;
+      /* seek to the start of the tracks, which are still in memory */
+      midiFileSeek(csound, (midiFile_t*) MIDIFILE, 0UL);
       csound->MTrkend = csound->Mxtroffs = csound->Mforcdecs = 0;
+      O->FMidiin = 1;
       /* reset controllers on all channels */
       for (i = 0; i < MAXCHAN; i++)
         midi_ctl_reset(csound, (int16) i);
@@ -805,7 +823,7 @@ void midifile_rewind_score(CSOUND *csound)
 
 int midiTempoOpcode(CSOUND *csound, MIDITEMPO *p)
 {
-    if (MIDIFILE == NULL)
+    if (MIDIFILE == NULL || csound->MTrkend)
       *(p->kResult) = FL(60.0) *csound->esr / (MYFLT)(csound->ibeatTime);
     else
       *(p->kResult) = (MYFLT) MF(currentTempo);
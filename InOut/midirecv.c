@@ -471,6 +471,84 @@ static void midNotesOff(CSOUND *csound)
     } while (++chan < MAXCHAN);
 }
 
+/* queue a timestamped message: any thread may call this, so slot */
+/* 'seq' tells a writer and the reader whose turn it is; it holds  */
+/* the position less the slot index, which lets a calloc'd ring    */
+/* start out with every slot free                                  */
+
+PUBLIC int csoundPushMidiMessage(CSOUND *csound, const unsigned char *msg,
+                                 int nbytes, double time)
+{
+    MGLOBAL   *p = csound->midiGlobals;
+    MIDITSMSG *slot;
+    long      pos, seq, idx, nxt;
+
+    if (UNLIKELY(p == NULL || msg == NULL || nbytes < 1 || nbytes > 3 ||
+                 !(msg[0] & 0x80)))
+      return CSOUND_ERROR;
+    pos = ATOMIC_GET(p->tswp);
+    for (;;) {
+      idx = pos & MIDITSBUFMSK;
+      slot = &(p->tsbuf[idx]);
+      seq = ATOMIC_GET(slot->seq);
+      if (seq == pos - idx) {
+        nxt = pos + 1;
+        if (!ATOMIC_CMP_XCH(&p->tswp, nxt, pos))
+          break;
+      }
+      else if (seq < pos - idx)
+        return CSOUND_ERROR;            /* ring is full */
+      pos = ATOMIC_GET(p->tswp);
+    }
+    slot->time = (time < 0.0 ? csoundGetMidiTime(csound) : time);
+    slot->nbytes = nbytes;
+    memcpy(slot->data, msg, nbytes);
+    ATOMIC_SET(slot->seq, pos + 1 - idx);
+    ATOMIC_SET(p->tsactive, 1);
+    return CSOUND_SUCCESS;
+}
+
+PUBLIC double csoundGetMidiTime(CSOUND *csound)
+{
+    return csoundGetRealTime(csound->csRtClock);
+}
+
+/* copy the next queued message to mbuf if it falls before the end */
+/* of this k-period, and note where in the period it falls: real   */
+/* time maps to score time through the least lag seen, which may   */
+/* creep up slowly so that the two clocks can drift apart          */
+
+static int midi_ts_read(CSOUND *csound, MGLOBAL *p)
+{
+    MIDITSMSG *slot;
+    long      pos = p->tsrp, idx = pos & MIDITSBUFMSK;
+    double    lag, smp;
+
+    if (p->tskcnt != (int64_t) csound->kcounter + 1) {
+      lag = csoundGetMidiTime(csound) - CURTIME;
+      if (p->tskcnt == 0 || lag < p->tslag)
+        p->tslag = lag;
+      else {
+        p->tslag += CURTIME_inc * 1.0e-4;
+        if (p->tslag > lag)
+          p->tslag = lag;
+      }
+      p->tskcnt = (int64_t) csound->kcounter + 1;
+    }
+    slot = &(p->tsbuf[idx]);
+    if (ATOMIC_GET(slot->seq) != pos + 1 - idx)
+      return 0;
+    smp = (slot->time - p->tslag) * csound->esr - csound->icurTime;
+    if (smp >= (double) csound->ksmps)
+      return 0;                         /* not yet */
+    memcpy(p->endatp, slot->data, slot->nbytes);
+    p->endatp += slot->nbytes;
+    p->ksmpsOffset = (smp > 0.0 ? (int) smp : 0);
+    ATOMIC_SET(slot->seq, pos + MIDITSBUFMAX - idx);
+    p->tsrp = pos + 1;
+    return 1;
+}
+
 /* sense a MIDI event, collect the data & dispatch */
 /* called from sensevents(), returns 2 if MIDI on/off */
 
@@ -486,19 +564,24 @@ int sensMidi(CSOUND *csound)
     if (p->bufp >= p->endatp) {
       p->bufp = &(p->mbuf[0]);
       p->endatp = p->bufp;
-      if (O->Midiin && !csound->advanceCnt) {   /* read MIDI device */
-        n = p->MidiReadCallback(csound, p->midiInUserData, p->bufp, MBUFSIZ);
-        if (n < 0)
-          csoundErrorMsg(csound, Str(" *** error reading MIDI device: %d (%s)"),
-                                 n, csoundExternalMidiErrorString(csound, n));
-        else
-          p->endatp += (int) n;
-      }
-      if (O->FMidiin) {                         /* read MIDI file */
-        n = csoundMIDIFileRead(csound, p->endatp,
-                               MBUFSIZ - (int) (p->endatp - p->bufp));
-        if (n > 0)
-          p->endatp += (int) n;
+      p->ksmpsOffset = 0;
+      if (ATOMIC_GET(p->tsactive) && !csound->advanceCnt)
+        midi_ts_read(csound, p);                /* timestamped message */
+      if (p->endatp == p->bufp) {
+        if (O->Midiin && !csound->advanceCnt) { /* read MIDI device */
+          n = p->MidiReadCallback(csound, p->midiInUserData, p->bufp, MBUFSIZ);
+          if (n < 0)
+            csoundErrorMsg(csound, Str(" *** error reading MIDI device: %d (%s)"),
+                           n, csoundExternalMidiErrorString(csound, n));
+          else
+            p->endatp += (int) n;
+        }
+        if (O->FMidiin) {                       /* read MIDI file */
+          n = csoundMIDIFileRead(csound, p->endatp,
+                                 MBUFSIZ - (int) (p->endatp - p->bufp));
+          if (n > 0)
+            p->endatp += (int) n;
+        }
       }
       if (p->endatp <= p->bufp)
         return 0;               /* no events were received */
@@ -384,6 +384,21 @@ static int ReadMidiData_(CSOUND *csound, void *userData,
                        !(st == 0xF8 || st == 0xFA || st == 0xFB ||
                          st == 0xFC || st == 0xFF)))
             continue;
+          /* channel messages keep the time PortMidi stamped them with; */
+          /* all of them are queued, so that a device's controllers and  */
+          /* notes are read in the order they were sent                  */
+          if (st < 0xF0) {
+            unsigned char msg[3];
+            double t = csound->GetMidiTime(csound) -
+                       (Pt_Time() - mev.timestamp) * 0.001;
+            msg[0] = (unsigned char) st;
+            msg[1] = (unsigned char) d1;
+            msg[2] = (unsigned char) d2;
+            if (csound->PushMidiMessage(csound, msg,
+                                        datbyts[(st - 0x80) >> 4] + 1,
+                                        t) == CSOUND_SUCCESS)
+              continue;
+          }
           nbytes -= (datbyts[(st - 0x80) >> 4] + 1);
           if (UNLIKELY(nbytes < 0)) {
             portMidiErrMsg(csound, Str("buffer overflow in MIDI input"));
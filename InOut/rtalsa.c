@@ -45,6 +45,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <poll.h>
 #include <termios.h>
 #include <errno.h>
 #include <stdio.h>
@@ -57,6 +58,7 @@
 
 
 #include "soundio.h"
+#include "sampconv.h"
 
 /* Modified from BSD sources for strlcpy */
 /*
@@ -104,10 +106,15 @@ typedef struct devparams_ {
     int             buffer_smps;    /* buffer length in samples         */
     int             period_smps;    /* period time in samples           */
     /* playback sample conversion function */
-    void            (*playconv)(int, MYFLT *, void *, int *);
+    void            (*playconv)(int, MYFLT *, void *, uint32_t *);
     /* record sample conversion function */
     void            (*rec_conv)(int, void *, MYFLT *);
-    int             seed;           /* random seed for dithering        */
+    uint32_t        dithcnt;        /* sample counter for dithering     */
+    int             mmap;           /* mmap access, waits with poll()   */
+    int             mmap_smps;      /* buffer length for mmap (-B)      */
+    struct pollfd   *pfds;          /* descriptors to poll (mmap mode)  */
+    int             npfds;
+    struct devparams_ *linked;      /* playback linked to this capture  */
 } DEVPARAMS;
 
 #ifdef BUF_SIZE
@@ -183,120 +190,53 @@ int set_scheduler_priority(CSOUND *csound, int priority)
 
 /* sample conversion routines for playback */
 
-static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
+static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf,
+                           uint32_t *count)
 {
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = (((rnd) * 15625) + 1) & 0xFFFF;
-      rnd += *seed;           /* triangular distribution */
-      tmp_f = (MYFLT) ((rnd>>1) - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_TRIANGULAR, count);
 }
 
-static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
+static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf,
+                             uint32_t *count)
 {
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = rnd;
-      tmp_f = (MYFLT) (rnd - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_RECTANGULAR, count);
 }
 
 static void MYFLT_to_short_no_dither(int nSmps, MYFLT *inBuf,
-                                     int16_t *outBuf, int *seed)
+                                     int16_t *outBuf, uint32_t *count)
 {
-  IGN(seed);
-    MYFLT tmp_f;
-    int   tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x8000;
-#ifndef USE_DOUBLE
-      tmp_i = (int) lrintf(tmp_f);
-#else
-      tmp_i = (int) lrint(tmp_f);
-#endif
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_NO_DITHER, count);
 }
 
-static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf, int *seed)
+static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf,
+                          uint32_t *count)
 {
-    MYFLT   tmp_f;
-    int64_t tmp_i;
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x80000000UL;
-#ifndef USE_DOUBLE
-      tmp_i = (int64_t) llrintf(tmp_f);
-#else
-      tmp_i = (int64_t) llrint(tmp_f);
-#endif
-      if (tmp_i < -((int64_t) 0x80000000UL))
-        tmp_i = -((int64_t) 0x80000000UL);
-      if (tmp_i > (int64_t) 0x7FFFFFFF) tmp_i = (int64_t) 0x7FFFFFFF;
-      outBuf[n] = (int32_t) tmp_i;
-    }
+    (void) count;
+    sconv_to_long(inBuf, outBuf, nSmps);
 }
 
-static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf, int *seed)
+static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf,
+                           uint32_t *count)
 {
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (float) inBuf[n];
+    (void) count;
+    sconv_to_float(inBuf, outBuf, nSmps);
 }
 
 /* sample conversion routines for recording */
 
 static void short_to_MYFLT(int nSmps, int16_t *inBuf, MYFLT *outBuf)
 {
-    int n;
-    MYFLT adjust = FL(1.0) / (MYFLT) 0x8000;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * adjust;
+    sconv_from_short(inBuf, outBuf, nSmps);
 }
 
 static void long_to_MYFLT(int nSmps, int32_t *inBuf, MYFLT *outBuf)
 {
-    int n;
-    MYFLT adjust = FL(1.0) / (MYFLT) 0x80000000UL;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * adjust;
+    sconv_from_long(inBuf, outBuf, nSmps);
 }
 
 static void float_to_MYFLT(int nSmps, float *inBuf, MYFLT *outBuf)
 {
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n];
+    sconv_from_float(inBuf, outBuf, nSmps);
 }
 
 /* select sample format */
@@ -425,7 +365,17 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
 
     /* now set the various hardware parameters: */
     /* access method, */
-    if (UNLIKELY(snd_pcm_hw_params_set_access(dev->handle, hw_params,
+    if (dev->mmap &&
+        snd_pcm_hw_params_set_access(dev->handle, hw_params,
+                                     SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0) {
+      p->Message(p, Str("ALSA %s: mmap access not supported, "
+                        "using read/write\n"), (play ? "output" : "input"));
+      dev->mmap = 0;
+    }
+    if (dev->mmap)    /* -B sets the hardware buffer for low latency */
+      dev->buffer_smps = dev->mmap_smps;
+    if (UNLIKELY(!dev->mmap &&
+                 snd_pcm_hw_params_set_access(dev->handle, hw_params,
                                               SND_PCM_ACCESS_RW_INTERLEAVED) < 0)) {
       strNcpy(msg, Str("Error setting access type for soundcard"), MSGLEN);
       goto err_return_msg;
@@ -437,7 +387,7 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
     {
       void  (*fp)(void) = NULL;
       alsaFmt = set_format(&fp, dev->format, play, csound->GetDitherMode(csound));
-      if (play) dev->playconv = (void (*)(int, MYFLT*, void*, int*)) fp;
+      if (play) dev->playconv = (void (*)(int, MYFLT*, void*, uint32_t*)) fp;
       else      dev->rec_conv = (void (*)(int, void*, MYFLT*)) fp;
     }
 
@@ -552,6 +502,20 @@ static int set_device_params(CSOUND *csound, DEVPARAMS *dev, int play)
               Str("Error setting software parameters for real-time audio"),MSGLEN);
       goto err_return_msg;
     }
+    if (dev->mmap) {
+      /* samples are converted in place in the hardware buffer */
+      dev->npfds = snd_pcm_poll_descriptors_count(dev->handle);
+      dev->pfds = (struct pollfd*)
+        csound->Calloc(csound, (size_t) dev->npfds * sizeof(struct pollfd));
+      if (UNLIKELY(dev->npfds <= 0 ||
+                   snd_pcm_poll_descriptors(dev->handle, dev->pfds,
+                                            (unsigned int) dev->npfds) < 0)) {
+        strNcpy(msg, Str("Error getting poll descriptors for real-time audio"),
+                MSGLEN);
+        goto err_return_msg;
+      }
+      return 0;
+    }
     /* allocate memory for sample conversion buffer */
     n = (dev->format == AE_SHORT ? 2 : 4) * dev->nchns * alloc_smps;
     dev->buf = (void*) csound->Malloc(csound, (size_t) n);
@@ -694,14 +658,36 @@ static int open_device(CSOUND *csound, const csRtAudioParams *parm, int play)
     dev->nchns = parm->nChannels;
 
     dev->period_smps = parm->bufSamp_SW;
-    dev->playconv = (void (*)(int, MYFLT*, void*, int*)) NULL;
+    dev->playconv = (void (*)(int, MYFLT*, void*, uint32_t*)) NULL;
     dev->rec_conv = (void (*)(int, void*, MYFLT*)) NULL;
-    dev->seed = 1;
+    dev->dithcnt = 0;
+    {
+      int *mmap_mode = (int*) csound->QueryGlobalVariable(csound, "::alsa_mmap");
+      dev->mmap = (mmap_mode != NULL && *mmap_mode != 0);
+    }
+    dev->mmap_smps = parm->bufSamp_HW;
     /* open device */
     retval = set_device_params(csound, dev, play);
     if (retval != 0) {
+      if (dev->pfds != NULL)
+        csound->Free(csound, dev->pfds);
       csound->Free(csound,dev);
       *userDataPtr = NULL;
+      return retval;
+    }
+    if (dev->mmap) {
+      /* in full duplex, link the streams so that they run in step */
+      DEVPARAMS *other = (DEVPARAMS*)
+        *(play ? csound->GetRtRecordUserData(csound)
+              : csound->GetRtPlayUserData(csound));
+      if (other != NULL && other->mmap && other->handle != NULL) {
+        DEVPARAMS *in = (play ? other : dev), *out = (play ? dev : other);
+        if (snd_pcm_link(in->handle, out->handle) == 0)
+          in->linked = out;
+        else
+          csound->Message(csound, Str("ALSA: could not link input and output, "
+                                      "running them separately\n"));
+      }
     }
     return retval;
 }
@@ -730,6 +716,177 @@ static int playopen_(CSOUND *csound, const csRtAudioParams *parm)
         csound->Warning(csound, Str(x));                  \
   }
 
+/* mmap mode (-+alsa_mmap=1): samples are converted directly from and to */
+/* the hardware buffer, and rtrecord_ and rtplay_ wait for the device in  */
+/* poll() on its descriptors rather than blocking in readi/writei.  In    */
+/* full duplex the two streams are linked so that they start and stop    */
+/* together, and the wait for each input period paces the performance.   */
+
+static int mmap_recover(CSOUND *csound, DEVPARAMS *dev, int err, int play)
+{
+    if (err == -EPIPE) {
+      if (play)
+        warning(Str("Buffer underrun in real-time audio output"))
+      else
+        warning(Str("Buffer overrun in real-time audio input"))
+      return snd_pcm_prepare(dev->handle);
+    }
+    if (err == -ESTRPIPE) {
+      if (play)
+        warning(Str("Real-time audio output suspended"))
+      else
+        warning(Str("Real-time audio input suspended"))
+      while ((err = snd_pcm_resume(dev->handle)) == -EAGAIN) sleep(1);
+      if (err < 0)
+        err = snd_pcm_prepare(dev->handle);
+      return err;
+    }
+    return err;
+}
+
+/* wait until the device can take or deliver more samples; if a second  */
+/* goes by without, the host may have stalled, or a linked stream may    */
+/* not have started yet, so a stopped stream is recovered and handed     */
+/* back to mmap_transfer() to be refilled and started, and a running one */
+/* is waited for again; only a device that has gone away is an error     */
+
+static int mmap_wait(CSOUND *csound, DEVPARAMS *dev, int play)
+{
+    unsigned short revents;
+    snd_pcm_state_t state;
+    int err;
+
+    for (;;) {
+      err = poll(dev->pfds, (nfds_t) dev->npfds, 1000);
+      if (err < 0) {
+        if (errno == EINTR) continue;
+        return -errno;
+      }
+      if (err == 0) {
+        switch (state = snd_pcm_state(dev->handle)) {
+        case SND_PCM_STATE_XRUN:
+        case SND_PCM_STATE_SUSPENDED:
+          err = mmap_recover(csound, dev, (state == SND_PCM_STATE_XRUN ?
+                                           -EPIPE : -ESTRPIPE), play);
+          return (err < 0 ? err : 0);
+        case SND_PCM_STATE_PREPARED:
+          return 0;
+        case SND_PCM_STATE_RUNNING:
+        case SND_PCM_STATE_DRAINING:
+        case SND_PCM_STATE_PAUSED:
+          continue;
+        default:                        /* disconnected */
+          return -ENODEV;
+        }
+      }
+      if (snd_pcm_poll_descriptors_revents(dev->handle, dev->pfds,
+                                           (unsigned int) dev->npfds,
+                                           &revents) < 0)
+        return -EIO;
+      if (revents & POLLERR) {
+        switch (snd_pcm_state(dev->handle)) {
+        case SND_PCM_STATE_XRUN:      return -EPIPE;
+        case SND_PCM_STATE_SUSPENDED: return -ESTRPIPE;
+        default:                      return -EIO;
+        }
+      }
+      if (revents & (POLLIN | POLLOUT))
+        return 0;
+    }
+}
+
+/* start capture; a linked output is first filled with silence, */
+/* which is then the latency of the duplex stream                */
+
+static int mmap_start(DEVPARAMS *dev)
+{
+    DEVPARAMS *out = dev->linked;
+
+    if (out != NULL && out->handle != NULL &&
+        snd_pcm_state(out->handle) == SND_PCM_STATE_PREPARED) {
+      const snd_pcm_channel_area_t  *areas;
+      snd_pcm_uframes_t             offset, frames;
+      snd_pcm_sframes_t             avail;
+      int   frameBytes = (out->format == AE_SHORT ? 2 : 4) * out->nchns;
+      while ((avail = snd_pcm_avail_update(out->handle)) > 0) {
+        frames = (snd_pcm_uframes_t) avail;
+        if (snd_pcm_mmap_begin(out->handle, &areas, &offset, &frames) < 0)
+          break;
+        memset((char*) areas[0].addr + (areas[0].first >> 3)
+               + offset * (areas[0].step >> 3), 0,
+               (size_t) frames * frameBytes);
+        if (snd_pcm_mmap_commit(out->handle, offset, frames) < 0)
+          break;
+      }
+    }
+    /* a full output buffer may have started both streams already */
+    if (snd_pcm_state(dev->handle) != SND_PCM_STATE_PREPARED)
+      return 0;
+    return snd_pcm_start(dev->handle);
+}
+
+/* transfer nframes frames between smps and the hardware buffer; */
+/* returns the number of frames transferred                      */
+
+static int mmap_transfer(CSOUND *csound, DEVPARAMS *dev,
+                         MYFLT *smps, int nframes, int play)
+{
+    const snd_pcm_channel_area_t  *areas;
+    snd_pcm_uframes_t             offset, frames;
+    snd_pcm_sframes_t             avail, n;
+    int   done = 0, err;
+
+    while (done < nframes) {
+      avail = snd_pcm_avail_update(dev->handle);
+      if (avail < 0) {
+        err = (int) avail;
+        goto recover;
+      }
+      if (avail == 0) {
+        if (snd_pcm_state(dev->handle) == SND_PCM_STATE_PREPARED)
+          err = (play ? snd_pcm_start(dev->handle) : mmap_start(dev));
+        else
+          err = mmap_wait(csound, dev, play);
+        if (err < 0)
+          goto recover;
+        continue;
+      }
+      frames = (snd_pcm_uframes_t) (nframes - done);
+      err = snd_pcm_mmap_begin(dev->handle, &areas, &offset, &frames);
+      if (err < 0)
+        goto recover;
+      {
+        char  *hw = (char*) areas[0].addr + (areas[0].first >> 3)
+                    + offset * (areas[0].step >> 3);
+        if (play)
+          dev->playconv((int) frames * dev->nchns, &smps[done * dev->nchns],
+                        hw, &(dev->dithcnt));
+        else
+          dev->rec_conv((int) frames * dev->nchns, hw,
+                        &smps[done * dev->nchns]);
+      }
+      n = snd_pcm_mmap_commit(dev->handle, offset, frames);
+      if (n < 0 || (snd_pcm_uframes_t) n != frames) {
+        err = (n < 0 ? (int) n : -EPIPE);
+        goto recover;
+      }
+      done += (int) frames;
+      continue;
+ recover:
+      if (mmap_recover(csound, dev, err, play) >= 0)
+        continue;
+      /* could not recover from error */
+      csound->ErrorMsg(csound, (play ?
+                                Str("Error writing data to audio output device")
+                                : Str("Error reading data from audio input "
+                                      "device")));
+      snd_pcm_close(dev->handle);
+      dev->handle = NULL;
+      break;
+    }
+    return done;
+}
+
 static int rtrecord_(CSOUND *csound, MYFLT *inbuf, int nbytes)
 {
     DEVPARAMS *dev;
@@ -743,6 +900,8 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf, int nbytes)
     }
     /* calculate the number of samples to record */
     n = nbytes / dev->sampleSize;
+    if (dev->mmap)
+      return (mmap_transfer(csound, dev, inbuf, n, 0) * dev->sampleSize);
 
     m = 0;
     while (n) {
@@ -786,9 +945,13 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf, int nbytes)
       return;
     /* calculate the number of samples to play */
     n = nbytes / dev->sampleSize;
+    if (dev->mmap) {
+      mmap_transfer(csound, dev, (MYFLT*) outbuf, n, 1);
+      return;
+    }
 
     /* convert samples from MYFLT */
-    dev->playconv(n * dev->nchns, (MYFLT*) outbuf, dev->buf, &(dev->seed));
+    dev->playconv(n * dev->nchns, (MYFLT*) outbuf, dev->buf, &(dev->dithcnt));
 
     while (n) {
       err = (int) snd_pcm_writei(dev->handle, dev->buf, (snd_pcm_uframes_t) n);
@@ -830,6 +993,8 @@ static void rtclose_(CSOUND *csound)
         snd_pcm_close(dev->handle);
       if (dev->buf != NULL)
         csound->Free(csound, dev->buf);
+      if (dev->pfds != NULL)
+        csound->Free(csound, dev->pfds);
       csound->Free(csound,dev);
     }
     dev = (DEVPARAMS*) (*(csound->GetRtPlayUserData(csound)));
@@ -839,6 +1004,8 @@ static void rtclose_(CSOUND *csound)
         snd_pcm_close(dev->handle);
       if (dev->buf != NULL)
         csound->Free(csound, dev->buf);
+      if (dev->pfds != NULL)
+        csound->Free(csound, dev->pfds);
       csound->Free(csound,dev);
     }
 }
@@ -1619,7 +1786,7 @@ static int alsaseq_out_close(CSOUND *csound, void *userData)
 
 PUBLIC int csoundModuleCreate(CSOUND *csound)
 {
-    int minsched, maxsched, *priority, maxlen;
+    int minsched, maxsched, *priority, *alsa_mmap, maxlen;
     char *alsaseq_client;
     csound->CreateGlobalVariable(csound, "::priority", sizeof(int));
     priority = (int *) (csound->QueryGlobalVariable(csound, "::priority"));
@@ -1631,6 +1798,14 @@ PUBLIC int csoundModuleCreate(CSOUND *csound)
                                         CSOUNDCFG_INTEGER, 0, &minsched, &maxsched,
                                         Str("RT scheduler priority, alsa module"),
                                         NULL);
+    csound->CreateGlobalVariable(csound, "::alsa_mmap", sizeof(int));
+    alsa_mmap = (int *) (csound->QueryGlobalVariable(csound, "::alsa_mmap"));
+    if (alsa_mmap != NULL)
+      csound->CreateConfigurationVariable(csound, "alsa_mmap", alsa_mmap,
+                                          CSOUNDCFG_BOOLEAN, 0, NULL, NULL,
+                                          Str("Use mmap access and poll() for "
+                                              "ALSA audio (default: off)"),
+                                          NULL);
     maxlen = 64;
     alsaseq_client = (char*) csound->Calloc(csound, maxlen*sizeof(char));
     strcpy(alsaseq_client, "Csound");
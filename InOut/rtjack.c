@@ -30,6 +30,8 @@
 /* no #ifdef, should always have these on systems where JACK is available */
 #include <unistd.h>
 #include <stdint.h>
+#include <errno.h>
+#include <time.h>
 #ifdef LINUX
 #include <pthread.h>
 #endif
@@ -79,99 +81,134 @@ static int listDevices(CSOUND *csound,
                        CS_AUDIODEVICE *list,
                        int isOutput);
 
+/* The JACK callback and the Csound thread pass the ring buffers to each */
+/* other by counting them: jackCount is the number of buffers the JACK   */
+/* callback has finished with, and csndCount the number of buffers the   */
+/* Csound thread has released.  Each counter has a single writer, so no  */
+/* lock is needed; the Csound thread only sleeps on csndWake when it has */
+/* to wait, and the callback posts it only if csndWaiting is set.        */
+
 #ifdef LINUX
 
-static inline int rtJack_CreateLock(CSOUND *csound, pthread_mutex_t *p)
+static inline int rtJack_CreateWake(CSOUND *csound, sem_t *p)
 {
     (void) csound;
-    return (pthread_mutex_init(p, (pthread_mutexattr_t*) NULL));
+    return sem_init(p, 0, 0U);
 }
 
-static inline void rtJack_Lock(CSOUND *csound, pthread_mutex_t *p)
+static inline void rtJack_Wake(CSOUND *csound, sem_t *p)
 {
     (void) csound;
-    pthread_mutex_lock(p);
+    sem_post(p);
 }
 
-static inline int rtJack_LockTimeout(CSOUND *csound, pthread_mutex_t *p,
-                                     size_t milliseconds)
+/* wait until woken up, or for at most 'milliseconds' if it is non-zero; */
+/* returns non-zero on timeout                                           */
+static inline int rtJack_WaitWake(CSOUND *csound, sem_t *p,
+                                  size_t milliseconds)
 {
-  IGN(csound);
-    struct timeval  tv;
     struct timespec ts;
-    register size_t n, s;
-    register int retval = pthread_mutex_trylock(p);
-    if (!retval)
-      return retval;
-    if (!milliseconds)
+    int             retval;
+    (void) csound;
+    if (!milliseconds) {
+      while ((retval = sem_wait(p)) != 0 && errno == EINTR)
+        ;
       return retval;
-    gettimeofday(&tv, NULL);
-    s = milliseconds / (size_t) 1000;
-    n = milliseconds - (s * (size_t) 1000);
-    s += (size_t) tv.tv_sec;
-    n = (size_t) (((int) n * 1000 + (int) tv.tv_usec) * 1000);
-    ts.tv_nsec = (long) (n < (size_t) 1000000000 ? n : n - 1000000000);
-    ts.tv_sec = (time_t) (n < (size_t) 1000000000 ? s : s + 1);
-    return pthread_mutex_timedlock(p, &ts);
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += (time_t) (milliseconds / (size_t) 1000);
+    ts.tv_nsec += (long) (milliseconds % (size_t) 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000L;
+    }
+    while ((retval = sem_timedwait(p, &ts)) != 0 && errno == EINTR)
+      ;
+    return retval;
 }
 
-static inline int rtJack_TryLock(CSOUND *csound, pthread_mutex_t *p)
+static inline void rtJack_DestroyWake(CSOUND *csound, sem_t *p)
 {
     (void) csound;
-    return (pthread_mutex_trylock(p));
+    sem_destroy(p);
 }
 
-static inline void rtJack_Unlock(CSOUND *csound, pthread_mutex_t *p)
-{
-    (void) csound;
-    pthread_mutex_unlock(p);
-}
+#else   /* LINUX */
 
-static inline void rtJack_DestroyLock(CSOUND *csound, pthread_mutex_t *p)
+static inline int rtJack_CreateWake(CSOUND *csound, void **p)
 {
-    (void) csound;
-    pthread_mutex_unlock(p);
-    pthread_mutex_destroy(p);
+    *p = csound->CreateThreadLock();
+    if (*p == NULL)
+      return -1;
+    csound->WaitThreadLock(*p, (size_t) 0);
+    return 0;
 }
 
-#else   /* LINUX */
-
-static inline int rtJack_CreateLock(CSOUND *csound, void **p)
+static inline void rtJack_Wake(CSOUND *csound, void **p)
 {
-    *p = csound->CreateThreadLock();
-    return (*p != NULL ? 0 : -1);
+    csound->NotifyThreadLock(*p);
 }
 
-static inline void rtJack_Lock(CSOUND *csound, void **p)
+static inline int rtJack_WaitWake(CSOUND *csound, void **p,
+                                  size_t milliseconds)
 {
-    csound->WaitThreadLockNoTimeout(*p);
+    if (!milliseconds) {
+      csound->WaitThreadLockNoTimeout(*p);
+      return 0;
+    }
+    return csound->WaitThreadLock(*p, milliseconds);
 }
 
-static inline int rtJack_LockTimeout(CSOUND *csound, void **p, size_t timeout)
+static inline void rtJack_DestroyWake(CSOUND *csound, void **p)
 {
-    return csound->WaitThreadLock(*p, timeout);
+    csound->NotifyThreadLock(*p);
+    csound->DestroyThreadLock(*p);
+    *p = NULL;
 }
 
+#endif  /* !LINUX */
+
+/* a - b for the buffer counters, which are allowed to wrap around */
 
-static inline int rtJack_TryLock(CSOUND *csound, void **p)
+static inline int rtJack_Diff(int a, int b)
 {
-    return (csound->WaitThreadLock(*p, (size_t) 0));
+    return (int) ((unsigned int) a - (unsigned int) b);
 }
 
-static inline void rtJack_Unlock(CSOUND *csound, void **p)
+/* called by the JACK callback: wake up the Csound thread if it sleeps */
+
+static inline void rtJack_Notify(RtJackGlobals *p)
 {
-    csound->NotifyThreadLock(*p);
+    if (ATOMIC_GET(p->csndWaiting)) {
+      ATOMIC_SET(p->csndWaiting, 0);
+      rtJack_Wake(p->csound, &(p->csndWake));
+    }
 }
 
-static inline void rtJack_DestroyLock(CSOUND *csound, void **p)
+/* called by the Csound thread: wait until the JACK callback is done */
+/* with buffer number n (counted from the start of the stream), for  */
+/* at most 'ms' milliseconds if non-zero; returns non-zero on        */
+/* timeout, or if the connection to the server has been lost         */
+
+static int rtJack_WaitBuffer(RtJackGlobals *p, int n, size_t ms)
 {
-    csound->NotifyThreadLock(*p);
-    csound->DestroyThreadLock(*p);
-    *p = NULL;
+    while (rtJack_Diff(ATOMIC_GET(p->jackCount), n) <= 0) {
+      if (p->jackState != 0)
+        return -1;
+      ATOMIC_SET(p->csndWaiting, 1);
+      /* check again, the callback may have finished the buffer before */
+      /* it could see the flag                                         */
+      if (rtJack_Diff(ATOMIC_GET(p->jackCount), n) > 0)
+        break;
+      if (rtJack_WaitWake(p->csound, &(p->csndWake), ms) != 0) {
+        ATOMIC_SET(p->csndWaiting, 0);
+        return -1;
+      }
+    }
+    ATOMIC_SET(p->csndWaiting, 0);
+    return 0;
 }
 
-#endif  /* !LINUX */
-
 /* print error message, close connection, and terminate performance */
 
 static CS_NORETURN void rtJack_Error(CSOUND *, int errCode, const char *msg);
@@ -234,14 +271,8 @@ static void shutDownCallback(void *arg)
     RtJackGlobals *p = (RtJackGlobals*) arg;
 
     p->jackState = 2;
-    if (p->bufs != NULL) {
-      int   i;
-      for (i = 0; i < p->nBuffers; i++) {
-        if (p->bufs[i] != NULL &&
-            (p->bufs[i]->inBufs != NULL || p->bufs[i]->outBufs != NULL))
-          rtJack_Unlock(p->csound, &(p->bufs[i]->csndLock));
-      }
-    }
+    if (p->wakeCreated)
+      rtJack_Wake(p->csound, &(p->csndWake));
 }
 
 static inline size_t rtJack_AlignData(size_t ofs)
@@ -283,16 +314,6 @@ static void rtJack_AllocateBuffers(RtJackGlobals *p)
       ptr = (void*) ((char*) ptr + (long) nBytesPerBuf);
     }
     for (i = (size_t) 0; i < (size_t) p->nBuffers; i++) {
-      /* create lock for signaling when the process callback is done */
-      /* with the buffer */
-      if (UNLIKELY(rtJack_CreateLock(csound, &(p->bufs[i]->csndLock)) != 0))
-        rtJack_Error(csound, CSOUND_MEMORY, Str("memory allocation failure"));
-      /* create lock for signaling when the Csound thread is done */
-      /* with the buffer */
-      if (UNLIKELY(rtJack_CreateLock(csound, &(p->bufs[i]->jackLock)) != 0)) {
-        rtJack_DestroyLock(csound, &(p->bufs[i]->csndLock));
-        rtJack_Error(csound, CSOUND_MEMORY, Str("memory allocation failure"));
-      }
       ptr = (void*) p->bufs[i];
       ptr = (void*) ((char*) ptr + (long) ofs2);
       /* set pointers to input/output buffers */
@@ -403,7 +424,8 @@ static void openJackStreams(RtJackGlobals *p)
       rtJack_Error(csound, -1, Str("invalid period size (-b)"));
     if (p->nBuffers < 2)
       p->nBuffers = 2;
-    if (UNLIKELY((unsigned int) (p->nBuffers * p->bufSize) > (unsigned int) 65536))
+    if (UNLIKELY((unsigned int) (p->nBuffers * p->bufSize)
+                 > (unsigned int) 65536))
       rtJack_Error(csound, -1, Str("invalid buffer size (-B)"));
     if (UNLIKELY(((p->nBuffers - 1) * p->bufSize)
                  < (int) jack_get_buffer_size(p->client)))
@@ -415,15 +437,21 @@ static void openJackStreams(RtJackGlobals *p)
     /* allocate ring buffers if not done yet */
     if (p->bufs == NULL)
       rtJack_AllocateBuffers(p);
+    if (!p->wakeCreated) {
+      if (UNLIKELY(rtJack_CreateWake(csound, &(p->csndWake)) != 0))
+        rtJack_Error(csound, CSOUND_MEMORY, Str("memory allocation failure"));
+      p->wakeCreated = 1;
+    }
 
     /* initialise ring buffers */
     p->csndBufCnt = 0;
     p->csndBufPos = 0;
     p->jackBufCnt = 0;
     p->jackBufPos = 0;
-    for (i = 0; i < p->nBuffers; i++) {
-      rtJack_TryLock(p->csound, &(p->bufs[i]->csndLock));
-      rtJack_Unlock(p->csound, &(p->bufs[i]->jackLock));
+    p->jackCount = 0;
+    p->csndCount = 0;
+    p->csndWaiting = 0;
+    for (i = 0; i < p->nBuffers && p->bufs != NULL; i++) {
       if (p->inputEnabled) {
         for (j = 0; j < p->nChannels_i; j++) {
           for (k = 0; k < p->bufSize; k++)
@@ -696,6 +724,18 @@ static int playopen_(CSOUND *csound, const csRtAudioParams *parm)
     return 0;
 }
 
+/* fill the output port buffers with zero samples from frame 'offs' on */
+
+static void rtJack_ClearOutput(RtJackGlobals *p, int offs, int nframes)
+{
+    int   j, k;
+    if (!p->outputEnabled)
+      return;
+    for (j = 0; j < p->nChannels; j++)
+      for (k = offs; k < nframes; k++)
+        p->outPortBufs[j][k] = (jack_default_audio_sample_t) 0;
+}
+
 /* the process callback is called by the JACK client thread, */
 /* and copies data to the input and from the output ring buffers */
 
@@ -720,17 +760,13 @@ static int processCallback(jack_nframes_t nframes, void *arg)
     do {
       /* if starting new buffer: */
       if (p->jackBufPos == 0) {
-        /* check for xrun: */
-        if (rtJack_TryLock(p->csound, &(p->bufs[p->jackBufCnt]->jackLock))
-            != 0) {
+        /* check for xrun: the Csound thread still has this buffer */
+        if (rtJack_Diff(p->jackCount, ATOMIC_GET(p->csndCount))
+            >= p->nBuffers) {
           p->xrunFlag = 1;
           /* yes, discard input and fill output with zero samples */
-          if (p->outputEnabled) {
-            for (j = 0; j < p->nChannels; j++)
-              for (k = i; k < (int) nframes; k++)
-                p->outPortBufs[j][k] = (jack_default_audio_sample_t) 0;
-            return 0;
-          }
+          rtJack_ClearOutput(p, i, (int) nframes);
+          return 0;
         }
       }
       /* copy audio data on each channel */
@@ -760,7 +796,8 @@ static int processCallback(jack_nframes_t nframes, void *arg)
       /* if done with a buffer, notify Csound thread and advance to next one */
       if (p->jackBufPos >= p->bufSize) {
         p->jackBufPos = 0;
-        rtJack_Unlock(p->csound, &(p->bufs[p->jackBufCnt]->csndLock));
+        ATOMIC_INCR(p->jackCount);
+        rtJack_Notify(p);
         if (++(p->jackBufCnt) >= p->nBuffers)
           p->jackBufCnt = 0;
       }
@@ -795,10 +832,12 @@ static CS_NOINLINE void rtJack_Restart(RtJackGlobals *p)
 static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
 {
     RtJackGlobals *p;
-    int           i, j, k, nframes, bufpos, bufcnt;
+    int           i, j, k, nframes, bufpos, bufcnt, bufnum;
+    size_t        timeout;
 
     p = (RtJackGlobals*) *(csound->GetRtPlayUserData(csound));
     if (UNLIKELY(p==NULL)) rtJack_Abort(csound, 0);
+    nframes = bytes_ / (p->nChannels_i * (int) sizeof(MYFLT));
     if (p->jackState != 0) {
       if (p->jackState < 0)
         openJackStreams(p);     /* open audio input */
@@ -807,17 +846,17 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
       else
         rtJack_Abort(csound, p->jackState);
     }
-    nframes = bytes_ / (p->nChannels_i * (int) sizeof(MYFLT));
     bufpos = p->csndBufPos;
     bufcnt = p->csndBufCnt;
+    bufnum = p->csndCount;
+    /* VL 28.03.15 -- timeout after wait for 10 buffer lengths */
+    timeout = (size_t) (10000*(nframes/csound->GetSr(csound)));
+    if (timeout < (size_t) 1)
+      timeout = (size_t) 1;
     for (i = j = 0; i < nframes; i++) {
       if (bufpos == 0) {
         /* wait until there is enough data in ring buffer */
-        /* VL 28.03.15 -- timeout after wait for 10 buffer
-           lengths */
-        int ret = rtJack_LockTimeout(csound, &(p->bufs[bufcnt]->csndLock),
-                                     10000*(nframes/csound->GetSr(csound)));
-        if (ret) {
+        if (rtJack_WaitBuffer(p, bufnum, timeout) != 0) {
           memset(inbuf_, 0, bytes_);
           OPARMS oparms;
           csound->GetOParms(csound, &oparms);
@@ -833,8 +872,9 @@ static int rtrecord_(CSOUND *csound, MYFLT *inbuf_, int bytes_)
         bufpos = 0;
         /* notify JACK callback that this buffer has been consumed */
         if (!p->outputEnabled)
-          rtJack_Unlock(csound, &(p->bufs[bufcnt]->jackLock));
+          ATOMIC_INCR(p->csndCount);
         /* advance to next buffer */
+        bufnum = (int) ((unsigned int) bufnum + 1U);
         if (++bufcnt >= p->nBuffers)
           bufcnt = 0;
       }
@@ -864,6 +904,7 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
     p = (RtJackGlobals*) *(csound->GetRtPlayUserData(csound));
     if (p == NULL)
       return;
+    nframes = bytes_ / (p->nChannels * (int) sizeof(MYFLT));
     if (p->jackState != 0) {
       if (p->jackState == 2)
         rtJack_Restart(p);
@@ -871,13 +912,13 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
         rtJack_Abort(csound, p->jackState);
       return;
     }
-    nframes = bytes_ / (p->nChannels * (int) sizeof(MYFLT));
     for (i = j = 0; i < nframes; i++) {
       if (p->csndBufPos == 0) {
-        /* wait until there is enough free space in ring buffer */
-        if (!p->inputEnabled)
-          /* **** COVERITY: claims this is a double lock **** */
-          rtJack_Lock(csound, &(p->bufs[p->csndBufCnt]->csndLock));
+        /* wait until the JACK callback has played this buffer; in */
+        /* full duplex mode, rtrecord_() has waited for it already  */
+        if (!p->inputEnabled &&
+            rtJack_WaitBuffer(p, p->csndCount, (size_t) 0) != 0)
+          return;               /* connection lost, reconnect next time */
       }
       /* copy audio data */
       for (k = 0; k < p->nChannels; k++)
@@ -886,7 +927,7 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
       if (++(p->csndBufPos) >= p->bufSize) {
         p->csndBufPos = 0;
         /* notify JACK callback that this buffer is now filled */
-        rtJack_Unlock(csound, &(p->bufs[p->csndBufCnt]->jackLock));
+        ATOMIC_INCR(p->csndCount);
         /* advance to next buffer */
         if (++(p->csndBufCnt) >= p->nBuffers)
           p->csndBufCnt = 0;
@@ -903,19 +944,11 @@ static void rtplay_(CSOUND *csound, const MYFLT *outbuf_, int bytes_)
 static void rtJack_DeleteBuffers(RtJackGlobals *p)
 {
     RtJackBuffer  **bufs;
-    size_t        i;
 
     if (p->bufs == (RtJackBuffer**) NULL)
       return;
     bufs = p->bufs;
     p->bufs = (RtJackBuffer**) NULL;
-    for (i = (size_t) 0; i < (size_t) p->nBuffers; i++) {
-      if (bufs[i]->inBufs == (jack_default_audio_sample_t**) NULL &&
-          bufs[i]->outBufs == (jack_default_audio_sample_t**) NULL)
-        continue;
-      rtJack_DestroyLock(p->csound, &(bufs[i]->csndLock));
-      rtJack_DestroyLock(p->csound, &(bufs[i]->jackLock));
-    }
     p->csound->Free(p->csound,(void*) bufs);
 }
 
@@ -980,6 +1013,8 @@ static CS_NOINLINE void rtclose_(CSOUND *csound)
       csound->Free(csound,p.outPortBufs);
     /* free ring buffers */
     rtJack_DeleteBuffers(&p);
+    if (p.wakeCreated)
+      rtJack_DestroyWake(csound, &(pp->csndWake));
     csound->DestroyGlobalVariable(csound, "_rtjackGlobals");
 }
 
@@ -1081,6 +1116,7 @@ PUBLIC int csoundModuleCreate(CSOUND *csound)
     p->outPorts = (jack_port_t**) NULL;
     p->outPortBufs = (jack_default_audio_sample_t**) NULL;
     p->bufs = (RtJackBuffer**) NULL;
+    p->wakeCreated = 0;
     /* register options: */
     /*   client name */
     i = jack_client_name_size();
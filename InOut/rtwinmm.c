@@ -24,6 +24,7 @@
 #include <windows.h>
 #include "csdl.h"
 #include "soundio.h"
+#include "sampconv.h"
 
 #ifdef MAXBUFFERS
 #undef MAXBUFFERS
@@ -35,10 +36,10 @@ typedef struct rtWinMMDevice_ {
     HWAVEOUT  outDev;
     int       cur_buf;
     int       nBuffers;
-    int       seed;             /* random seed for dithering */
+    uint32_t  dithcnt;          /* sample counter for dithering */
     int       enable_buf_timer;
     /* playback sample conversion function */
-    void      (*playconv)(int, MYFLT*, void*, int*);
+    void      (*playconv)(int, MYFLT*, void*, uint32_t*);
     /* record sample conversion function */
     void      (*rec_conv)(int, void*, MYFLT*);
     int64_t   prv_time;
@@ -152,100 +153,53 @@ static int set_format_params(CSOUND *csound, WAVEFORMATEX *wfx,
 
 /* sample conversion routines for playback */
 
-static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
+static void MYFLT_to_short(int nSmps, MYFLT *inBuf, int16_t *outBuf,
+                           uint32_t *count)
 {
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++){
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = (((rnd) * 15625) + 1) & 0xFFFF;
-      rnd += *seed;           /* triangular distribution */
-      tmp_f = (MYFLT) ((rnd>>1) - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_TRIANGULAR, count);
 }
 
-static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf, int *seed)
+static void MYFLT_to_short_u(int nSmps, MYFLT *inBuf, int16_t *outBuf,
+                             uint32_t *count)
 {
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      int rnd = (((*seed) * 15625) + 1) & 0xFFFF;
-      *seed = rnd;
-      tmp_f = (MYFLT) (rnd - 0x8000) * (FL(1.0) / (MYFLT) 0x10000);
-      tmp_f += inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_RECTANGULAR, count);
 }
 
 static void MYFLT_to_short_no_dither(int nSmps, MYFLT *inBuf,
-                                     int16_t *outBuf, int *seed)
+                                     int16_t *outBuf, uint32_t *count)
 {
-    MYFLT   tmp_f;
-    int     tmp_i;
-    int n;
-    for (n=0; n<nSmps; n++){
-      tmp_f = inBuf[n] * (MYFLT) 0x8000;
-      tmp_i = (int) MYFLT2LRND(tmp_f);
-      if (tmp_i < -0x8000) tmp_i = -0x8000;
-      if (tmp_i > 0x7FFF) tmp_i = 0x7FFF;
-      outBuf[n] = (int16_t) tmp_i;
-    }
+    sconv_to_short(inBuf, outBuf, nSmps, SCONV_NO_DITHER, count);
 }
 
-static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf, int *seed)
+static void MYFLT_to_long(int nSmps, MYFLT *inBuf, int32_t *outBuf,
+                          uint32_t *count)
 {
-    MYFLT   tmp_f;
-    int64_t tmp_i;
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++) {
-      tmp_f = inBuf[n] * (MYFLT) 0x80000000UL;
-      tmp_i = (int64_t) (tmp_f + (tmp_f < FL(0.0) ? FL(-0.5) : FL(0.5)));
-      if (tmp_i < -((int64_t) 0x80000000UL))
-        tmp_i = -((int64_t) 0x80000000UL);
-      if (tmp_i > (int64_t) 0x7FFFFFFF) tmp_i = (int64_t) 0x7FFFFFFF;
-      outBuf[n] = (int32_t) tmp_i;
-    }
+    (void) count;
+    sconv_to_long(inBuf, outBuf, nSmps);
 }
 
-static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf, int *seed)
+static void MYFLT_to_float(int nSmps, MYFLT *inBuf, float *outBuf,
+                           uint32_t *count)
 {
-    (void) seed;
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (float) inBuf[n];
+    (void) count;
+    sconv_to_float(inBuf, outBuf, nSmps);
 }
 
 /* sample conversion routines for recording */
 
 static void short_to_MYFLT(int nSmps, int16_t *inBuf, MYFLT *outBuf)
 {
-    while (nSmps--)
-      *(outBuf++) = (MYFLT) *(inBuf++) * (FL(1.0) / (MYFLT) 0x8000);
+    sconv_from_short(inBuf, outBuf, nSmps);
 }
 
 static void long_to_MYFLT(int nSmps, int32_t *inBuf, MYFLT *outBuf)
 {
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n] * (FL(1.0) / (MYFLT) 0x80000000UL);
+    sconv_from_long(inBuf, outBuf, nSmps);
 }
 
 static void float_to_MYFLT(int nSmps, float *inBuf, MYFLT *outBuf)
 {
-    int n;
-    for (n=0; n<nSmps; n++)
-      outBuf[n] = (MYFLT) inBuf[n];
+    sconv_from_float(inBuf, outBuf, nSmps);
 }
 
 static int open_device(CSOUND *csound,
@@ -326,18 +280,18 @@ static int open_device(CSOUND *csound,
         case 0:
           if (csound->GetDitherMode(csound)==1)
             dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short;
+                  (void (*)(int, MYFLT*, void*, uint32_t*)) MYFLT_to_short;
           else if (csound->GetDitherMode(csound)==2)
             dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short_u;
+                  (void (*)(int, MYFLT*, void*, uint32_t*)) MYFLT_to_short_u;
           else
             dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_short_no_dither;
+                  (void (*)(int, MYFLT*, void*, uint32_t*)) MYFLT_to_short_no_dither;
           break;
         case 1: dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_long;   break;
+                  (void (*)(int, MYFLT*, void*, uint32_t*)) MYFLT_to_long;   break;
         case 2: dev->playconv =
-                  (void (*)(int, MYFLT*, void*, int*)) MYFLT_to_float;  break;
+                  (void (*)(int, MYFLT*, void*, uint32_t*)) MYFLT_to_float;  break;
       }
     }
     else {
@@ -430,7 +384,7 @@ static void rtplay_(CSOUND *csound, const MYFLT *outBuf, int nbytes)
     while (!(*dwFlags & WHDR_DONE))
       Sleep(1);
     dev->playconv(nbytes / (int) sizeof(MYFLT),
-                  (MYFLT*) outBuf, (void*) buf->lpData, &(dev->seed));
+                  (MYFLT*) outBuf, (void*) buf->lpData, &(dev->dithcnt));
     waveOutWrite(dev->outDev, (LPWAVEHDR) buf, sizeof(WAVEHDR));
     if (++(dev->cur_buf) >= dev->nBuffers)
       dev->cur_buf = 0;
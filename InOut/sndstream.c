@@ -0,0 +1,794 @@
+/*
+    sndstream.c:
+
+    Copyright (C) 2026
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include "csoundCore.h"                 /*              SNDSTREAM.C     */
+#include "soundio.h"
+#include "sndstream.h"
+#include "mpadec.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Streams are shared by all instances of Csound in the process, and are  */
+/* found by path name, size and modification time.  Streams that are no   */
+/* longer open stay in the list while they have decoded blocks in the     */
+/* cache, and up to SS_IDLE more; a sound file is closed when its stream  */
+/* is no longer open, and opened again if one of its blocks is needed.    */
+/*                                                                        */
+/* An MP3 file is decoded SS_MP3_BLOCK frames at a time.  Decoding a      */
+/* block from the middle of a file starts a few frames earlier, so that   */
+/* the bit reservoir and the overlap of the filter banks are filled, and  */
+/* the output of those frames is thrown away; a block that follows the    */
+/* last one decoded is decoded straight on.  Positions in the stream skip */
+/* the delay of the decoder and of the encoder, as mp3dec does.           */
+
+#define SS_IDLE         8               /* streams kept when not in use */
+#define SS_MP3_BLOCK    16              /* MPEG frames per block */
+#define SS_SF_BLOCK     16384           /* sample frames per block */
+#define SS_RESERVOIR    511             /* largest Layer III main_data_begin */
+#define SS_SYNC_SKIP    128             /* bytes mpadec skips before its
+                                           first sync */
+
+typedef struct SSBLOCK_ {
+    struct SSBLOCK_ *nxt, *prv;         /* in the cache, most recent first */
+    SNDSTREAM *stream;
+    int64_t index;
+    int     pins;                       /* readers copying from the block */
+    int64_t frames;
+    size_t  bytes;
+    float   data[1];                    /* interleaved */
+} SSBLOCK;
+
+typedef struct {
+    int64_t offset;
+    int32_t size;
+    int32_t payload;                    /* main data bytes, Layer III */
+} SSFRAME;
+
+typedef struct {
+    uint32_t word;
+    int     lsf, layer, sridx, sr, channels, bitrate;
+    int     size, spf, sideinfo, crc;
+} SSHEADER;
+
+struct SNDSTREAM_ {
+    SNDSTREAM *nxt;                     /* all streams, most recent first */
+    char    *path;
+    int64_t fsize, mtime;
+    int     refs;                       /* protected by csoundLock() */
+    SNDSTREAM_INFO info;
+    SSBLOCK **blocks;                   /* protected by csoundLock() */
+    int64_t ncached;                    /* blocks in the cache, likewise */
+    int64_t nblocks, blockframes;
+    int64_t delay;                      /* decoded frames before frame 0 */
+    void    *mutex;                     /* held while decoding */
+    SNDFILE *sf;
+    /* MP3 files */
+    uint8_t *data;                      /* the whole file, compressed */
+    size_t  datalen;
+    int     mapped;
+    SSFRAME *frame;
+    int64_t nframes;
+    int     spf;                        /* samples per frame */
+    mpadec_t mpa;
+    int64_t next;                       /* frame the decoder stopped at */
+    uint8_t *in;                        /* frames for the decoder */
+    float   *out;
+    size_t  insize, outsize;
+};
+
+static SNDSTREAM *ss_streams = NULL;
+static SSBLOCK  *ss_head = NULL, *ss_tail = NULL;
+static size_t   ss_bytes = 0;
+static size_t   ss_limit = SNDSTREAM_CACHE;
+
+static const int ss_bitrate[2][3][15] = {
+  { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+  { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } }
+};
+
+static const int ss_srate[3] = { 44100, 48000, 32000 };
+
+/* decode the MPEG audio frame header at b; returns the frame size, or 0 */
+/* if it is not one mpadec can decode (free format is not supported)    */
+static int ss_header(const uint8_t *b, SSHEADER *h)
+{
+    uint32_t w = ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) |
+                 ((uint32_t) b[2] << 8) | (uint32_t) b[3];
+    int     version = (w >> 19) & 3, bridx = (w >> 12) & 15;
+    int     pad = (w >> 9) & 1;
+
+    if ((w & 0xFFE00000) != 0xFFE00000 || version == 1 ||
+        ((w >> 17) & 3) == 0 || bridx == 0 || bridx == 15 ||
+        ((w >> 10) & 3) == 3)
+      return 0;
+    h->word = w;
+    h->lsf = (version != 3);
+    h->layer = 4 - ((w >> 17) & 3);
+    h->sridx = (w >> 10) & 3;
+    h->sr = ss_srate[h->sridx] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    h->channels = (((w >> 6) & 3) == 3 ? 1 : 2);
+    h->bitrate = ss_bitrate[h->lsf][h->layer - 1][bridx];
+    h->crc = ((w >> 16) & 1) ? 0 : 2;
+    switch (h->layer) {
+    case 1:
+      h->spf = 384;
+      h->size = (12000 * h->bitrate / h->sr + pad) * 4;
+      h->sideinfo = 0;
+      break;
+    case 2:
+      h->spf = 1152;
+      h->size = 144000 * h->bitrate / h->sr + pad;
+      h->sideinfo = 0;
+      break;
+    default:
+      h->spf = 1152 >> h->lsf;
+      h->size = 144000 * h->bitrate / (h->sr << h->lsf) + pad;
+      h->sideinfo = (h->lsf ? (h->channels > 1 ? 17 : 9) :
+                     (h->channels > 1 ? 32 : 17));
+      break;
+    }
+    return h->size;
+}
+
+/* frames of one stream must agree in the fields that mpadec checks */
+static int ss_same(const SSHEADER *h, const SSHEADER *ref)
+{
+    return (h->layer == ref->layer && h->lsf == ref->lsf &&
+            (h->word & 0x00180C00) == (ref->word & 0x00180C00) &&
+            h->channels == ref->channels);
+}
+
+/* is the frame the Xing or Info header of a VBR file (which mpadec */
+/* skips wherever it appears)?                                      */
+static int ss_xing(const uint8_t *f, const SSHEADER *h)
+{
+    const uint8_t *b = f + 4 + h->sideinfo;
+    if (h->layer != 3 || h->size < h->sideinfo + 12)
+      return 0;
+    return (!memcmp(b, "Xing", 4) || !memcmp(b, "Info", 4));
+}
+
+/* the encoder delay and padding from a LAME tag, read as mpadec does */
+static void ss_lame(const uint8_t *f, const SSHEADER *h,
+                    int *delay, int *padding, int *hasframes)
+{
+    const uint8_t *b = f + 4 + h->sideinfo + 4;
+    uint32_t flags;
+    int     d, p;
+
+    *delay = *padding = *hasframes = 0;
+    if (h->size < h->sideinfo + 124)
+      return;
+    flags = ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) |
+            ((uint32_t) b[2] << 8) | (uint32_t) b[3];
+    b += 4;
+    if (flags & 1) b += 4;
+    if (flags & 2) b += 4;
+    if (flags & 4) b += 100;
+    if (flags & 8) b += 4;
+    *hasframes = (int) (flags & 1);
+    if (h->size < h->sideinfo + 160)
+      return;
+    b += 15 + 2 + 4;
+    d = (b[0] << 4) | ((b[1] >> 4) & 0x0F);
+    p = ((b[1] & 0x0F) << 8) | b[2];
+    if (d <= 3000 && p <= 3000) {
+      *delay = d;
+      *padding = p;
+    }
+}
+
+/* does the file start like an MPEG audio stream? */
+static int ss_is_mp3(const uint8_t *d, size_t len)
+{
+    SSHEADER h, h2;
+    if (len >= 10 && !memcmp(d, "ID3", 3))
+      return 1;
+    if (len < 4 || !ss_header(d, &h))
+      return 0;
+    if ((size_t) h.size + 4 > len)
+      return ((size_t) h.size == len);
+    return (ss_header(d + h.size, &h2) && ss_same(&h2, &h));
+}
+
+/* build the index of the frames of an MP3 file; returns 0 on success */
+static int ss_mp3_scan(SNDSTREAM *s)
+{
+    const uint8_t *d = s->data;
+    size_t  pos = 0, end = s->datalen, cap = 0;
+    int64_t bytes = 0, samples;
+    int     delay = 0, padding = 0, hasframes = 0, insync = 0, first = 1;
+    SSHEADER ref, h, h2;
+
+    if (end >= 10 && !memcmp(d, "ID3", 3))
+      pos = 10 + (((size_t) (d[6] & 0x7F) << 21) | ((d[7] & 0x7F) << 14) |
+                  ((d[8] & 0x7F) << 7) | (d[9] & 0x7F)) +
+            ((d[5] & 0x10) ? 10 : 0);
+    if (end >= 128 && !memcmp(d + end - 128, "TAG", 3))
+      end -= 128;
+    memset(&ref, 0, sizeof(SSHEADER));
+    while (pos + 4 <= end) {
+      if (!ss_header(d + pos, &h) || pos + h.size > end ||
+          (!first && !ss_same(&h, &ref))) {
+        pos++;
+        insync = 0;
+        continue;
+      }
+      /* away from a known frame boundary, only accept a header that */
+      /* is followed by another one                                  */
+      if (!insync && pos + h.size + 4 <= end &&
+          !(ss_header(d + pos + h.size, &h2) && ss_same(&h2, &h))) {
+        pos++;
+        continue;
+      }
+      insync = 1;
+      if (first) {
+        ref = h;
+        first = 0;
+      }
+      if (ss_xing(d + pos, &h)) {
+        if (s->nframes == 0)
+          ss_lame(d + pos, &h, &delay, &padding, &hasframes);
+        pos += h.size;
+        continue;
+      }
+      if (s->nframes >= (int64_t) cap) {
+        SSFRAME *tmp;
+        cap = (cap ? cap * 2 : 1024);
+        if ((tmp = (SSFRAME*) realloc(s->frame, cap * sizeof(SSFRAME))) == NULL)
+          return -1;
+        s->frame = tmp;
+      }
+      s->frame[s->nframes].offset = (int64_t) pos;
+      s->frame[s->nframes].size = h.size;
+      s->frame[s->nframes].payload =
+        (h.layer == 3 ? h.size - 4 - h.crc - h.sideinfo : 0);
+      s->nframes++;
+      bytes += h.size;
+      pos += h.size;
+    }
+    if (s->nframes == 0)
+      return -1;
+    s->spf = ref.spf;
+    s->delay = (ref.layer == 3 ? 529 : 241) + delay;
+    if (ref.layer == 3 && hasframes && padding > 529)
+      padding -= 529;
+    else
+      padding = 0;
+    samples = s->nframes * (int64_t) ref.spf - s->delay - padding;
+    s->info.type = SNDSTREAM_MP3;
+    s->info.channels = ref.channels;
+    s->info.sr = ref.sr;
+    s->info.frames = (samples > 0 ? samples : 0);
+    s->info.layer = ref.layer;
+    s->info.bitrate =
+      (int) ((bytes * 8 * ref.sr / (s->nframes * (int64_t) ref.spf)
+              + 500) / 1000);
+    s->blockframes = (int64_t) SS_MP3_BLOCK * ref.spf;
+    return 0;
+}
+
+static int ss_mp3_init(SNDSTREAM *s)
+{
+    mpadec_config_t config = { MPADEC_CONFIG_FULL_QUALITY, MPADEC_CONFIG_AUTO,
+                               MPADEC_CONFIG_FLOAT, MPADEC_CONFIG_LITTLE_ENDIAN,
+                               MPADEC_CONFIG_REPLAYGAIN_NONE, FALSE, TRUE, TRUE,
+                               0.0 };
+    union {
+      uint8_t  t8[2];
+      uint16_t t16;
+    } ch;
+
+    ch.t16 = 1;
+    if (!ch.t8[0])
+      config.endian = MPADEC_CONFIG_BIG_ENDIAN;
+    if (ss_mp3_scan(s) != 0)
+      return -1;
+    if ((s->mpa = mpadec_init()) == NULL ||
+        mpadec_configure(s->mpa, &config) != MPADEC_RETCODE_OK)
+      return -1;
+    s->next = -1;
+    return 0;
+}
+
+/* make the buffers for the decoder at least insize and outsize bytes */
+static int ss_mp3_buffers(SNDSTREAM *s, size_t insize, size_t outsize)
+{
+    void    *tmp;
+    if (insize > s->insize) {
+      if ((tmp = realloc(s->in, insize)) == NULL)
+        return -1;
+      s->in = (uint8_t*) tmp;
+      s->insize = insize;
+    }
+    if (outsize > s->outsize) {
+      if ((tmp = realloc(s->out, outsize)) == NULL)
+        return -1;
+      s->out = (float*) tmp;
+      s->outsize = outsize;
+    }
+    return 0;
+}
+
+/* decode block k of an MP3 stream into b->data */
+static void ss_mp3_decode(SNDSTREAM *s, int64_t k, SSBLOCK *b)
+{
+    int64_t t0 = k * SS_MP3_BLOCK, t1 = t0 + SS_MP3_BLOCK, b0, i;
+    size_t  len = 0, insize = 0, framebytes;
+    uint32_t used = 0, dused = 0;
+    int32_t acc = 0;
+    int     fresh;
+
+    if (t1 > s->nframes)
+      t1 = s->nframes;
+    framebytes = (size_t) s->spf * s->info.channels * sizeof(float);
+    b->frames = (t1 - t0) * s->spf;
+    if ((fresh = (s->next != t0)) == 0)
+      b0 = t0;
+    else {
+      /* the two frames before the block must decode correctly too, */
+      /* so for Layer III their main data has to be in the frames   */
+      /* decoded before them                                        */
+      b0 = (t0 > 2 ? t0 - 2 : 0);
+      if (s->info.layer == 3)
+        while (b0 > 0 && acc < SS_RESERVOIR)
+          acc += s->frame[--b0].payload;
+      len = SS_SYNC_SKIP;
+    }
+    for (i = b0; i < t1; i++)
+      insize += (size_t) s->frame[i].size;
+    if (ss_mp3_buffers(s, len + insize, (size_t) (t1 - b0) * framebytes) != 0) {
+      memset(b->data, 0, (size_t) (t1 - t0) * framebytes);
+      s->next = -1;
+      return;
+    }
+    if (fresh) {
+      mpadec_reset(s->mpa);
+      memset(s->in, 0, SS_SYNC_SKIP);
+    }
+    for (i = b0; i < t1; i++) {
+      memcpy(s->in + len, s->data + s->frame[i].offset,
+             (size_t) s->frame[i].size);
+      len += (size_t) s->frame[i].size;
+    }
+    mpadec_decode(s->mpa, s->in, (uint32_t) len, (uint8_t*) s->out,
+                  (uint32_t) ((t1 - b0) * framebytes), &used, &dused);
+    if ((size_t) dused == (size_t) (t1 - b0) * framebytes)
+      s->next = t1;
+    else {
+      /* lost sync: what is missing is silence, and the next block is */
+      /* decoded from scratch                                        */
+      memset((char*) s->out + dused, 0, (size_t) (t1 - b0) * framebytes - dused);
+      s->next = -1;
+    }
+    memcpy(b->data, (char*) s->out + (size_t) (t0 - b0) * framebytes,
+           (size_t) (t1 - t0) * framebytes);
+}
+
+static void ss_sf_decode(SNDSTREAM *s, int64_t k, SSBLOCK *b)
+{
+    int64_t n = s->info.frames - k * SS_SF_BLOCK, got = 0;
+    if (n > SS_SF_BLOCK)
+      n = SS_SF_BLOCK;
+    if (s->sf == NULL) {                /* closed while not in use */
+      SF_INFO sfinfo;
+      memset(&sfinfo, 0, sizeof(SF_INFO));
+      if ((s->sf = sf_open(s->path, SFM_READ, &sfinfo)) != NULL &&
+          sfinfo.channels != s->info.channels) {
+        sf_close(s->sf);
+        s->sf = NULL;
+      }
+    }
+    if (s->sf != NULL &&
+        sf_seek(s->sf, (sf_count_t) (k * SS_SF_BLOCK), SEEK_SET) >= 0)
+      got = (int64_t) sf_readf_float(s->sf, b->data, (sf_count_t) n);
+    if (got < 0)
+      got = 0;
+    if (got < n)
+      memset(&b->data[got * s->info.channels], 0,
+             (size_t) ((n - got) * s->info.channels) * sizeof(float));
+    b->frames = n;
+}
+
+static void ss_unlink(SSBLOCK *b)
+{
+    if (b->prv != NULL) b->prv->nxt = b->nxt;
+    else ss_head = b->nxt;
+    if (b->nxt != NULL) b->nxt->prv = b->prv;
+    else ss_tail = b->prv;
+    b->nxt = b->prv = NULL;
+}
+
+static void ss_front(SSBLOCK *b)
+{
+    b->prv = NULL;
+    if ((b->nxt = ss_head) != NULL)
+      b->nxt->prv = b;
+    else
+      ss_tail = b;
+    ss_head = b;
+}
+
+/* drop least recently used blocks that nobody is reading, until the */
+/* cache fits in ss_limit bytes; called with csoundLock() held        */
+static void ss_trim_blocks(void)
+{
+    SSBLOCK *b = ss_tail, *prv;
+    while (b != NULL && ss_bytes > ss_limit) {
+      prv = b->prv;
+      if (b->pins == 0) {
+        ss_unlink(b);
+        b->stream->blocks[b->index] = NULL;
+        b->stream->ncached--;
+        ss_bytes -= b->bytes;
+        free(b);
+      }
+      b = prv;
+    }
+}
+
+static void ss_stream_free(SNDSTREAM *s)
+{
+    int64_t k;
+    if (s->blocks != NULL) {
+      for (k = 0; k < s->nblocks; k++) {
+        SSBLOCK *b = s->blocks[k];
+        if (b != NULL) {
+          ss_unlink(b);
+          ss_bytes -= b->bytes;
+          free(b);
+        }
+      }
+      free(s->blocks);
+    }
+    if (s->sf != NULL)
+      sf_close(s->sf);
+    if (s->mpa != NULL)
+      mpadec_uninit(s->mpa);
+#ifdef HAVE_SYS_MMAN_H
+    if (s->mapped)
+      munmap(s->data, s->datalen);
+    else
+#endif
+      free(s->data);
+    if (s->mutex != NULL)
+      csoundDestroyMutex(s->mutex);
+    free(s->frame);
+    free(s->in);
+    free(s->out);
+    free(s->path);
+    free(s);
+}
+
+/* close the least recently used streams nobody has open and with no  */
+/* blocks in the cache, so that no more than SS_IDLE of them are kept; */
+/* called with csoundLock() held                                       */
+static void ss_trim_streams(void)
+{
+    SNDSTREAM *s, **pp, **last;
+    int     n;
+    for (;;) {
+      n = 0; last = NULL;
+      for (pp = &ss_streams; (s = *pp) != NULL; pp = &s->nxt)
+        if (s->refs == 0 && s->ncached == 0) {
+          n++;
+          last = pp;
+        }
+      if (n <= SS_IDLE)
+        return;
+      s = *last;
+      *last = s->nxt;
+      ss_stream_free(s);
+    }
+}
+
+/* the whole file, mapped if possible */
+static int ss_load(SNDSTREAM *s)
+{
+    FILE    *f;
+    if (s->fsize <= 0 || (uint64_t) s->fsize > (uint64_t) ((size_t) -1 >> 1))
+      return -1;
+    s->datalen = (size_t) s->fsize;
+#ifdef HAVE_SYS_MMAN_H
+    {
+      int   fd = open(s->path, O_RDONLY);
+      void  *addr;
+      if (fd >= 0) {
+        addr = mmap(NULL, s->datalen, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr != MAP_FAILED) {
+          s->data = (uint8_t*) addr;
+          s->mapped = 1;
+          return 0;
+        }
+      }
+    }
+#endif
+    if ((f = fopen(s->path, "rb")) == NULL)
+      return -1;
+    if ((s->data = (uint8_t*) malloc(s->datalen)) == NULL ||
+        fread(s->data, 1, s->datalen, f) != s->datalen) {
+      fclose(f);
+      return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+static SNDSTREAM *ss_stream_new(const char *path, const struct stat *st)
+{
+    SNDSTREAM *s = (SNDSTREAM*) calloc(1, sizeof(SNDSTREAM));
+    SF_INFO sfinfo;
+    int     ok = 0;
+
+    if (s == NULL)
+      return NULL;
+    if ((s->path = strdup(path)) == NULL) {
+      free(s);
+      return NULL;
+    }
+    s->info.path = s->path;
+    s->fsize = (int64_t) st->st_size;
+    s->mtime = (int64_t) st->st_mtime;
+    if (ss_load(s) == 0 && ss_is_mp3(s->data, s->datalen))
+      ok = (ss_mp3_init(s) == 0);
+    if (!ok) {
+      memset(&sfinfo, 0, sizeof(SF_INFO));
+      if ((s->sf = sf_open(s->path, SFM_READ, &sfinfo)) != NULL &&
+          sfinfo.channels > 0 && sfinfo.frames > 0) {
+        s->info.type = SNDSTREAM_SNDFILE;
+        s->info.channels = sfinfo.channels;
+        s->info.sr = sfinfo.samplerate;
+        s->info.frames = (int64_t) sfinfo.frames;
+        s->info.format = sfinfo.format;
+        s->info.hasinstr = (sf_command(s->sf, SFC_GET_INSTRUMENT,
+                                       &s->info.instr,
+                                       sizeof(SF_INSTRUMENT)) != 0);
+        s->blockframes = SS_SF_BLOCK;
+        s->delay = 0;
+        ok = 1;
+      }
+      else if (s->data != NULL && s->mpa == NULL && s->frame == NULL)
+        ok = (ss_mp3_init(s) == 0);     /* MP3 with junk at the start */
+    }
+    /* a sound file does not need its compressed data in memory */
+    if (ok && s->info.type == SNDSTREAM_SNDFILE && s->data != NULL) {
+#ifdef HAVE_SYS_MMAN_H
+      if (s->mapped)
+        munmap(s->data, s->datalen);
+      else
+#endif
+        free(s->data);
+      s->data = NULL;
+      s->mapped = 0;
+    }
+    if (ok) {
+      s->nblocks = (s->delay + s->info.frames + s->blockframes - 1)
+                   / s->blockframes;
+      s->blocks = (SSBLOCK**) calloc((size_t) (s->nblocks + 1),
+                                     sizeof(SSBLOCK*));
+      s->mutex = csoundCreateMutex(0);
+      ok = (s->blocks != NULL && s->mutex != NULL);
+    }
+    if (!ok) {
+      ss_stream_free(s);
+      return NULL;
+    }
+    return s;
+}
+
+static SNDSTREAM *ss_find(const char *path, const struct stat *st)
+{
+    SNDSTREAM *s, **pp;
+    for (pp = &ss_streams; (s = *pp) != NULL; pp = &s->nxt) {
+      if (s->fsize == (int64_t) st->st_size &&
+          s->mtime == (int64_t) st->st_mtime && !strcmp(s->path, path)) {
+        *pp = s->nxt;                   /* move to the front */
+        s->nxt = ss_streams;
+        ss_streams = s;
+        s->refs++;
+        return s;
+      }
+    }
+    return NULL;
+}
+
+SNDSTREAM *sndstream_open(CSOUND *csound, const char *name)
+{
+    SNDSTREAM   *s;
+    char        *path;
+
+    if ((path = csoundFindInputFile(csound, name, "SFDIR;SSDIR")) == NULL)
+      return NULL;
+    s = sndstream_open_path(path);
+    csound->Free(csound, path);
+    return s;
+}
+
+SNDSTREAM *sndstream_open_path(const char *path)
+{
+    SNDSTREAM   *s, *t;
+    struct stat st;
+
+    if (stat(path, &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+      return NULL;
+    csoundLock();
+    s = ss_find(path, &st);
+    csoundUnLock();
+    if (s == NULL && (s = ss_stream_new(path, &st)) != NULL) {
+      /* the file is indexed without the lock, so another thread */
+      /* may have opened it meanwhile                            */
+      csoundLock();
+      if ((t = ss_find(path, &st)) != NULL) {
+        ss_stream_free(s);
+        s = t;
+      }
+      else {
+        s->refs = 1;
+        s->nxt = ss_streams;
+        ss_streams = s;
+        ss_trim_streams();
+      }
+      csoundUnLock();
+    }
+    return s;
+}
+
+void sndstream_close(SNDSTREAM *s)
+{
+    if (s == NULL)
+      return;
+    csoundLock();
+    /* with no other reference, no block of s is being decoded, and */
+    /* none can be until the stream is found again under the lock   */
+    if (--s->refs == 0 && s->sf != NULL) {
+      sf_close(s->sf);
+      s->sf = NULL;
+    }
+    ss_trim_streams();
+    csoundUnLock();
+}
+
+const SNDSTREAM_INFO *sndstream_info(SNDSTREAM *s)
+{
+    return &s->info;
+}
+
+/* block k of s, pinned, decoding it if it is not in the cache */
+static SSBLOCK *ss_block(SNDSTREAM *s, int64_t k)
+{
+    SSBLOCK *b;
+    size_t  bytes;
+
+    csoundLock();
+    if ((b = s->blocks[k]) != NULL) {
+      b->pins++;
+      ss_unlink(b);
+      ss_front(b);
+    }
+    csoundUnLock();
+    if (b != NULL)
+      return b;
+    csoundLockMutex(s->mutex);
+    csoundLock();
+    if ((b = s->blocks[k]) != NULL) {   /* decoded by another reader */
+      b->pins++;
+      ss_unlink(b);
+      ss_front(b);
+    }
+    csoundUnLock();
+    if (b == NULL) {
+      bytes = sizeof(SSBLOCK) + (size_t) (s->blockframes * s->info.channels)
+                                * sizeof(float);
+      if ((b = (SSBLOCK*) malloc(bytes)) != NULL) {
+        b->stream = s;
+        b->index = k;
+        b->pins = 1;
+        b->bytes = bytes;
+        if (s->info.type == SNDSTREAM_SNDFILE)
+          ss_sf_decode(s, k, b);
+        else
+          ss_mp3_decode(s, k, b);
+        csoundLock();
+        s->blocks[k] = b;
+        s->ncached++;
+        ss_front(b);
+        ss_bytes += bytes;
+        ss_trim_blocks();
+        ss_trim_streams();
+        csoundUnLock();
+      }
+    }
+    csoundUnlockMutex(s->mutex);
+    return b;
+}
+
+static void ss_unpin(SSBLOCK *b)
+{
+    csoundLock();
+    b->pins--;
+    csoundUnLock();
+}
+
+int64_t sndstream_read(SNDSTREAM *s, int64_t pos, float *out, int64_t n)
+{
+    int     nch = s->info.channels;
+    int64_t done = 0;
+
+    if (pos < 0 || n <= 0)
+      return 0;
+    if (n > s->info.frames - pos)
+      n = s->info.frames - pos;
+    while (done < n) {
+      int64_t r = pos + done + s->delay, k = r / s->blockframes;
+      int64_t i = r - k * s->blockframes, m = n - done;
+      SSBLOCK *b = ss_block(s, k);
+      if (b == NULL)
+        break;
+      if (m > b->frames - i)
+        m = b->frames - i;
+      if (m > 0)
+        memcpy(&out[done * nch], &b->data[i * nch],
+               (size_t) (m * nch) * sizeof(float));
+      ss_unpin(b);
+      if (m <= 0)
+        break;
+      done += m;
+    }
+    return done;
+}
+
+void sndstream_fetch(SNDSTREAM *s)
+{
+    size_t  bytes = (size_t) (s->nblocks * s->blockframes * s->info.channels)
+                    * sizeof(float);
+    int64_t k;
+    SSBLOCK *b;
+
+    csoundLock();
+    if (bytes > ss_limit)               /* the last blocks would push out */
+      bytes = 0;                        /* the first ones                 */
+    csoundUnLock();
+    for (k = 0; bytes > 0 && k < s->nblocks; k++) {
+      if ((b = ss_block(s, k)) == NULL)
+        break;
+      ss_unpin(b);
+    }
+}
+
+void sndstream_reserve(size_t bytes)
+{
+    csoundLock();
+    if (bytes > ss_limit)
+      ss_limit = bytes;
+    csoundUnLock();
+}
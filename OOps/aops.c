@@ -1012,6 +1012,13 @@ int32_t rtclock(CSOUND *csound, EVAL *p)
     return OK;
 }
 
+/* 1 while the engine is overloaded, see csoundSetOverloadPolicy() */
+int32_t overload_state(CSOUND *csound, EVAL *p)
+{
+    *p->r = (MYFLT) (csound->ovlState != 0);
+    return OK;
+}
+
 int32_t octpch(CSOUND *csound, EVAL *p)
 {
     IGN(csound);
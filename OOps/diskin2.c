@@ -26,13 +26,327 @@
 #include "diskin2.h"
 #include <math.h>
 #include <inttypes.h>
+#if defined(HAVE_UNISTD_H) && !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(POSIX_FADV_WILLNEED)
+#define DISKIN_FADVISE  1
+#endif
+#endif
+
+/* Asynchronous streams.  Each stream renders its output into a ring    */
+/* buffer, in chunks of aOut_bufsize frames, from a pool of I/O threads  */
+/* shared by all the streams of an instance.  The performance thread     */
+/* queues a refill request when a whole chunk of the ring has been       */
+/* consumed (the low-water mark), so idle streams cost no wakeups, and a */
+/* slow file only holds up the thread that is serving it.                */
+
+#define DISKIN_IO_THREADS  4        /* maximum number of I/O threads      */
+#define DISKIN_IO_TIMEOUT  50       /* ms, fallback wakeup of I/O threads */
+#define DISKIN_MAX_DEPTH   6        /* maximum ring length in chunks      */
+#define DISKIN_HINT_SLACK  65536    /* bytes, allowance for file headers  */
 
 typedef struct DISKIN_INST_ {
-  CSOUND *csound;
-  DISKIN2 *diskin;
-  struct DISKIN_INST_ *nxt;
+  CSOUND  *csound;
+  void    *diskin;
+  int32_t (*read)(CSOUND *, void *, MYFLT *);   /* render one chunk */
+  void    *cb;                  /* ring buffer */
+  int32_t chunk;                /* ring items per chunk */
+  int32_t frames;               /* sample frames per chunk */
+  int32_t depth;                /* ring length in chunks */
+  int32_t consumed;             /* items read since the last request */
+  int32_t underruns;
+  int32_t hintfd, frameBytes;   /* for read-ahead hints */
+  int32_t primed;               /* set once the first chunk is written */
+  int     queued, busy, again;  /* protected by the pool lock */
+  struct DISKIN_INST_ *nxt;     /* in the request queue */
 } DISKIN_INST;
 
+typedef struct {
+  CSOUND  *csound;
+  spin_lock_t lock;
+  void    *wakeup;                      /* notified when work is queued */
+  void    *threads[DISKIN_IO_THREADS];
+  int     nthreads, nstreams, running;
+  DISKIN_INST *head, *tail;             /* queued refill requests */
+} DISKIN_POOL;
+
+int32_t diskin_file_read(CSOUND *csound, DISKIN2 *p);
+int32_t diskin_file_read_array(CSOUND *csound, DISKIN2_ARRAY *p);
+
+/* ring length in chunks: faster playback reads more of the file for each */
+/* chunk, so it is given more chunks of slack                             */
+static int32_t diskin_stream_depth(double rate)
+{
+    int32_t n = 2 + (int32_t) ceil(fabs(rate));
+    return (n < DISKIN_MAX_DEPTH ? n : DISKIN_MAX_DEPTH);
+}
+
+/* bytes per sample frame, or zero for formats without a fixed frame size */
+static int32_t diskin_frame_bytes(int32_t format, int32_t chans)
+{
+    switch (format & SF_FORMAT_SUBMASK) {
+    case SF_FORMAT_PCM_S8:
+    case SF_FORMAT_PCM_U8:  return chans;
+    case SF_FORMAT_PCM_16:  return 2 * chans;
+    case SF_FORMAT_PCM_24:  return 3 * chans;
+    case SF_FORMAT_PCM_32:
+    case SF_FORMAT_FLOAT:   return 4 * chans;
+    case SF_FORMAT_DOUBLE:  return 8 * chans;
+    default:                return 0;
+    }
+}
+
+/* ask the kernel to read ahead the part of the file that the next ring's */
+/* worth of output will need                                              */
+static void diskin_stream_hint(DISKIN_INST *s, int64_t frame, double rate)
+{
+#ifdef DISKIN_FADVISE
+    if (s->hintfd >= 0 && s->frameBytes > 0) {
+      int64_t ahead = (int64_t) (fabs(rate) * s->frames * s->depth) + 1;
+      if (rate < 0.0) frame -= ahead;
+      if (frame < 0) frame = 0;
+      posix_fadvise(s->hintfd, (off_t) (frame * s->frameBytes),
+                    (off_t) (ahead * s->frameBytes + DISKIN_HINT_SLACK),
+                    POSIX_FADV_WILLNEED);
+    }
+#else
+    IGN(s); IGN(frame); IGN(rate);
+#endif
+}
+
+static int32_t diskin_stream_read(CSOUND *csound, void *data, MYFLT *out)
+{
+    DISKIN2 *p = (DISKIN2 *) data;
+    diskin_stream_hint((DISKIN_INST *) p->stream, p->pos_frac >> POS_FRAC_SHIFT,
+                       (double) p->pos_frac_inc * (1.0 / POS_FRAC_SCALE));
+    p->aOut_buf = out;
+    return diskin_file_read(csound, p);
+}
+
+static int32_t diskin_stream_read_array(CSOUND *csound, void *data, MYFLT *out)
+{
+    DISKIN2_ARRAY *p = (DISKIN2_ARRAY *) data;
+    diskin_stream_hint((DISKIN_INST *) p->stream, p->pos_frac >> POS_FRAC_SHIFT,
+                       (double) p->pos_frac_inc * (1.0 / POS_FRAC_SCALE));
+    p->aOut_buf = out;
+    return diskin_file_read_array(csound, p);
+}
+
+/* render chunks into the ring for as long as a whole one fits; chunks  */
+/* start at multiples of the chunk size, so each one is contiguous       */
+static void diskin_stream_fill(CSOUND *csound, DISKIN_INST *s)
+{
+    MYFLT   *region;
+    int     avail;
+
+    while ((region = (MYFLT *)
+            csoundAcquireCircularBufferWrite(csound, s->cb,
+                                             s->chunk, &avail)) != NULL &&
+           avail == s->chunk) {
+      if (s->read(csound, s->diskin, region) != OK)
+        break;
+      csoundCommitCircularBufferWrite(csound, s->cb, s->chunk);
+      ATOMIC_SET(s->primed, 1);
+    }
+}
+
+static uintptr_t diskin_io_thread(void *data)
+{
+    DISKIN_POOL *pool = (DISKIN_POOL *) data;
+    CSOUND      *csound = pool->csound;
+    DISKIN_INST *s;
+    int         running, more, again;
+
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    do {
+      csoundSpinLock(&pool->lock);
+      if ((running = pool->running) && (s = pool->head) != NULL) {
+        if ((pool->head = s->nxt) == NULL)
+          pool->tail = NULL;
+        s->queued = 0;
+        s->busy = 1;
+      }
+      else s = NULL;
+      more = (pool->head != NULL);
+      csoundSpinUnLock(&pool->lock);
+      if (s == NULL) {
+        if (running)
+          csound->WaitThreadLock(pool->wakeup, DISKIN_IO_TIMEOUT);
+        continue;
+      }
+      /* pass the wakeup on if other requests are waiting */
+      if (more)
+        csound->NotifyThreadLock(pool->wakeup);
+      do {
+        diskin_stream_fill(csound, s);
+        csoundSpinLock(&pool->lock);
+        if (!(again = s->again))
+          s->busy = 0;
+        s->again = 0;
+        csoundSpinUnLock(&pool->lock);
+      } while (again);
+    } while (running);
+    return 0;
+}
+
+static int32_t diskin_pool_reset(CSOUND *csound, void *data)
+{
+    DISKIN_POOL *pool = (DISKIN_POOL *) data;
+    int         i;
+
+    csoundSpinLock(&pool->lock);
+    pool->running = 0;
+    csoundSpinUnLock(&pool->lock);
+    for (i = 0; i < pool->nthreads; i++) {
+      csound->NotifyThreadLock(pool->wakeup);
+      csound->JoinThread(pool->threads[i]);
+    }
+    pool->nthreads = 0;
+    csound->DestroyThreadLock(pool->wakeup);
+    return OK;
+}
+
+static DISKIN_POOL *diskin_pool(CSOUND *csound)
+{
+    DISKIN_POOL *pool;
+
+    pool = (DISKIN_POOL *) csound->QueryGlobalVariable(csound, "DISKIN_POOL");
+    if (pool == NULL) {
+      if (UNLIKELY(csound->CreateGlobalVariable(csound, "DISKIN_POOL",
+                                                sizeof(DISKIN_POOL)) != 0))
+        return NULL;
+      pool = (DISKIN_POOL *) csound->QueryGlobalVariable(csound, "DISKIN_POOL");
+      pool->csound = csound;
+      csoundSpinLockInit(&pool->lock);
+      pool->wakeup = csound->CreateThreadLock();
+      pool->running = 1;
+      csound->RegisterResetCallback(csound, pool, diskin_pool_reset);
+    }
+    return pool;
+}
+
+/* queue a refill of stream s, unless one is pending already */
+static void diskin_stream_request(CSOUND *csound, DISKIN_INST *s)
+{
+    DISKIN_POOL *pool = diskin_pool(csound);
+    int         notify = 0;
+
+    if (UNLIKELY(pool->nthreads == 0)) {
+      /* no I/O threads: refill from the performance thread */
+      diskin_stream_fill(csound, s);
+      return;
+    }
+    csoundSpinLock(&pool->lock);
+    if (s->busy)
+      s->again = 1;
+    else if (!s->queued) {
+      s->queued = 1;
+      s->nxt = NULL;
+      if (pool->tail != NULL)
+        pool->tail->nxt = s;
+      else
+        pool->head = s;
+      pool->tail = s;
+      notify = 1;
+    }
+    csoundSpinUnLock(&pool->lock);
+    if (notify)
+      csound->NotifyThreadLock(pool->wakeup);
+}
+
+/* create a stream for opcode diskin, reading from file fd through the  */
+/* ring buffer cb, and queue its first refill                           */
+static DISKIN_INST *diskin_stream_new(CSOUND *csound, void *diskin,
+                                      int32_t (*read)(CSOUND *, void *,
+                                                      MYFLT *),
+                                      void *cb, int32_t frames, int32_t chans,
+                                      int32_t depth, void *fd, int32_t format)
+{
+    DISKIN_POOL *pool = diskin_pool(csound);
+    DISKIN_INST *s;
+
+    if (UNLIKELY(pool == NULL))
+      return NULL;
+    s = (DISKIN_INST *) csound->Calloc(csound, sizeof(DISKIN_INST));
+    s->csound = csound;
+    s->diskin = diskin;
+    s->read = read;
+    s->cb = cb;
+    s->frames = frames;
+    s->chunk = frames * chans;
+    s->depth = depth;
+    s->hintfd = -1;
+#ifdef DISKIN_FADVISE
+    if ((s->frameBytes = diskin_frame_bytes(format, chans)) > 0)
+      s->hintfd = open(csound->GetFileName(fd), O_RDONLY);
+#else
+    IGN(fd); IGN(format);
+#endif
+    csoundSpinLock(&pool->lock);
+    pool->nstreams++;
+    csoundSpinUnLock(&pool->lock);
+#ifndef __EMSCRIPTEN__
+    /* one more I/O thread for each new stream, up to the maximum */
+    if (pool->nthreads < DISKIN_IO_THREADS &&
+        pool->nthreads < pool->nstreams) {
+      void *t = csound->CreateThread(diskin_io_thread, pool);
+      if (t != NULL)
+        pool->threads[pool->nthreads++] = t;
+    }
+#endif
+    return s;
+}
+
+/* account for items read by the performance thread; underrun is set if */
+/* the ring ran dry                                                     */
+static void diskin_stream_consume(CSOUND *csound, DISKIN_INST *s,
+                                  int32_t items, int32_t underrun)
+{
+    if (underrun && ATOMIC_GET(s->primed))
+      s->underruns++;
+    if ((s->consumed += items) >= s->chunk || underrun) {
+      s->consumed = 0;
+      diskin_stream_request(csound, s);
+    }
+}
+
+/* take stream s out of the pool, waiting for a refill in progress */
+static void diskin_stream_remove(CSOUND *csound, DISKIN_INST *s)
+{
+    DISKIN_POOL *pool = diskin_pool(csound);
+    DISKIN_INST *q, *prv = NULL;
+
+    csoundSpinLock(&pool->lock);
+    if (s->queued) {
+      for (q = pool->head; q != s; prv = q, q = q->nxt)
+        ;
+      if (prv == NULL)
+        pool->head = s->nxt;
+      else
+        prv->nxt = s->nxt;
+      if (pool->tail == s)
+        pool->tail = prv;
+    }
+    while (s->busy) {
+      s->again = 0;
+      csoundSpinUnLock(&pool->lock);
+      csoundSleep(1);
+      csoundSpinLock(&pool->lock);
+    }
+    pool->nstreams--;
+    csoundSpinUnLock(&pool->lock);
+    if (UNLIKELY(s->underruns > 0))
+      csound->Warning(csound, Str("diskin2: %d buffer underrun(s)\n"),
+                      s->underruns);
+#ifdef DISKIN_FADVISE
+    if (s->hintfd >= 0)
+      close(s->hintfd);
+#endif
+    csound->DestroyCircularBuffer(csound, s->cb);
+    csound->Free(csound, s);
+}
+
 
 static CS_NOINLINE void diskin2_read_buffer(CSOUND *csound,
                                             DISKIN2 *p, int32_t bufReadPos)
@@ -315,6 +629,9 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
       /* skip initialisation if requested */
       if (p->SkipInit != FL(0.0))
         return OK;
+      /* a reinitialised asynchronous stream starts over */
+      if (p->stream != NULL)
+        diskin2_async_deinit(csound, p);
       fd_close(csound, &(p->fdch));
     }
     /* set default format parameters */
@@ -418,57 +735,25 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
     memset(p->buf, 0, n*sizeof(MYFLT));
 
     // create circular buffer, on fail set mode to synchronous
-    if (csound->oparms->realtime==1 && p->fforceSync==0 &&
-        (p->cb = csound->CreateCircularBuffer(csound,
-                                              p->bufSize*p->nChannels*2,
-                                              sizeof(MYFLT))) != NULL){
-      DISKIN_INST **top, *current;
-#ifndef __EMSCRIPTEN__
-      int32_t *start;
-#endif
-      // allocate buffer
+    p->cb = NULL;
+    if (csound->oparms->realtime==1 && p->fforceSync==0) {
+      int32_t depth = diskin_stream_depth(p->warpScale * *(p->kTranspose));
       p->aOut_bufsize =  ((unsigned int)p->bufSize) < CS_KSMPS ?
         ((MYFLT)CS_KSMPS) : ((MYFLT)p->bufSize);
-      n = p->aOut_bufsize*sizeof(MYFLT)*p->nChannels;
-      if (n != (int32_t)p->auxData2.size)
-        csound->AuxAlloc(csound, (int32_t) n, &(p->auxData2));
-      p->aOut_buf = (MYFLT *) (p->auxData2.auxp);
-      memset(p->aOut_buf, 0, n);
-      top = (DISKIN_INST **)csound->QueryGlobalVariable(csound, "DISKIN_INST");
-#ifndef __EMSCRIPTEN__
-      if (top == NULL){
-        csound->CreateGlobalVariable(csound, "DISKIN_INST", sizeof(DISKIN_INST *));
-        top = (DISKIN_INST **) csound->QueryGlobalVariable(csound, "DISKIN_INST");
-        *top = (DISKIN_INST *) csound->Calloc(csound, sizeof(DISKIN_INST));
-        csound->CreateGlobalVariable(csound, "DISKIN_PTHREAD", sizeof(void**));
-        csound->CreateGlobalVariable(csound,
-                                     "DISKIN_THREAD_START", sizeof(int32_t));
-        current = *top;
-      }
-      else
-#endif
-        {
-          current = *top;
-          while(current->nxt != NULL) { /* find next empty slot in chain */
-            current = current->nxt;
-          }
-          current->nxt = (DISKIN_INST *) csound->Calloc(csound,
-                                                        sizeof(DISKIN_INST));
-          current = current->nxt;
-        }
-      current->csound = csound;
-      current->diskin = p;
-      current->nxt = NULL;
-
-#ifndef __EMSCRIPTEN__
-      if ( *(start = csound->QueryGlobalVariable(csound,
-                                                 "DISKIN_THREAD_START")) == 0) {
-        uintptr_t diskin_io_thread(void *p);
-        void **thread = csound->QueryGlobalVariable(csound, "DISKIN_PTHREAD");
-        *thread = csound->CreateThread(diskin_io_thread, *top);
-        *start = 1;
-      }
-#endif
+      n = (int32_t) p->aOut_bufsize * p->nChannels;
+      if ((p->cb = csound->CreateCircularBuffer(csound, n * depth,
+                                                sizeof(MYFLT))) != NULL &&
+          (p->stream = diskin_stream_new(csound, p, diskin_stream_read, p->cb,
+                                         (int32_t) p->aOut_bufsize,
+                                         p->nChannels, depth, fd,
+                                         sfinfo.format)) == NULL) {
+        csound->DestroyCircularBuffer(csound, p->cb);
+        p->cb = NULL;
+      }
+    }
+    if (p->cb != NULL) {
+      /* the I/O threads render straight into the ring buffer */
+      p->aOut_buf = NULL;
       csound->RegisterDeinitCallback(csound, p, diskin2_async_deinit);
       p->async = 1;
 
@@ -503,41 +788,18 @@ static int32_t diskin2_init_(CSOUND *csound, DISKIN2 *p, int32_t stringname)
 
     /* done initialisation */
     p->initDone = 1;
+    if (p->async)
+      diskin_stream_request(csound, (DISKIN_INST *) p->stream);
     return OK;
 }
 
 int32_t diskin2_async_deinit(CSOUND *csound,  void *p){
+    DISKIN2 *pp = (DISKIN2 *) p;
 
-    DISKIN_INST **top, *current, *prv;
-
-    if ((top = (DISKIN_INST **)
-         csound->QueryGlobalVariable(csound, "DISKIN_INST")) == NULL) return NOTOK;
-    current = *top;
-    prv = NULL;
-    while(current->diskin != (DISKIN2 *)p) {
-      prv = current;
-      current = current->nxt;
-    }
-    if (prv == NULL) *top = current->nxt;
-    else prv->nxt = current->nxt;
-
-#ifndef __EMSCRIPTEN__
-    if (*top == NULL) {
-      int32_t *start; void **pt;
-
-      start = (int32_t *) csound->QueryGlobalVariable(csound,"DISKIN_THREAD_START");
-      *start = 0;
-      pt = csound->QueryGlobalVariable(csound,"DISKIN_PTHREAD");
-      //csound->Message(csound, "dealloc %p %d\n", start, *start);
-      csound->JoinThread(*pt);
-      csound->DestroyGlobalVariable(csound, "DISKIN_PTHREAD");
-      csound->DestroyGlobalVariable(csound, "DISKIN_THREAD_START");
-      csound->DestroyGlobalVariable(csound, "DISKIN_INST");
-    }
-#endif
-    csound->Free(csound, current);
-    csound->DestroyCircularBuffer(csound, ((DISKIN2 *)p)->cb);
-
+    if (pp->stream == NULL) return NOTOK;
+    diskin_stream_remove(csound, (DISKIN_INST *) pp->stream);
+    pp->stream = NULL;
+    pp->cb = NULL;
     return OK;
 }
 
@@ -918,16 +1180,6 @@ int32_t diskin_file_read(CSOUND *csound, DISKIN2 *p)
         diskin2_file_pos_inc(p, &ndx);
       }
     }
-    {
-      /* write to circular buffer */
-      int32_t lc, mc=0, nc=nsmps*p->nChannels;
-      int32_t *start = csound->QueryGlobalVariable(csound,"DISKIN_THREAD_START");
-      do{
-        lc =  csound->WriteCircularBuffer(csound, p->cb, &aOut[mc], nc);
-        nc -= lc;
-        mc += lc;
-      } while(nc && *start);
-    }
     return OK;
  file_error:
     csound->ErrorMsg(csound, Str("diskin2: file descriptor closed or invalid\n"));
@@ -940,8 +1192,8 @@ int32_t diskin2_perf_asynchronous(CSOUND *csound, DISKIN2 *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t nn, nsmps = CS_KSMPS;
-    MYFLT samp;
-    int32_t chn;
+    MYFLT *samp, scl = csound->e0dbfs;
+    int32_t chn, n, m;
     void *cb = p->cb;
     int32_t chans = p->nChannels;
 
@@ -957,39 +1209,31 @@ int32_t diskin2_perf_asynchronous(CSOUND *csound, DISKIN2 *p)
       return csound->PerfError(csound, &(p->h),
                                Str("diskin2: not initialised"));
     }
-    for (nn = offset; nn < nsmps; nn++){
-
+    /* read whole frames directly from the circular buffer; the buffer */
+    /* holds a whole number of frames, so none straddles the wrap point */
+    nn = offset;
+    while (nn < nsmps &&
+           (samp = (MYFLT*)
+            csoundAcquireCircularBufferRead(csound, cb,
+                                            (nsmps - nn) * chans, &n)) != NULL) {
+      if ((m = n / chans) == 0) break;
       for (chn = 0; chn < chans; chn++) {
-        //int32_t i =0;
-        //do {
-        // i =
-        csound->ReadCircularBuffer(csound, cb, &samp, 1);
-        //} while(i==0);
-        p->aOut[chn][nn] = csound->e0dbfs*samp;
+        MYFLT *out = &(p->aOut[chn][nn]);
+        for (n = 0; n < m; n++)
+          out[n] = scl * samp[n * chans + chn];
       }
+      csoundCommitCircularBufferRead(csound, cb, m * chans);
+      nn += m;
     }
+    /* buffer underrun: output silence */
+    for (chn = 0; chn < chans; chn++)
+      memset(&(p->aOut[chn][nn]), 0, (nsmps - nn) * sizeof(MYFLT));
+    diskin_stream_consume(csound, (DISKIN_INST *) p->stream,
+                          (nn - offset) * chans, nn < nsmps);
     return OK;
 }
 
 
-uintptr_t diskin_io_thread(void *p){
-    DISKIN_INST *current = (DISKIN_INST *) p;
-    int32_t wakeup = 1000*current->csound->ksmps/current->csound->esr;
-    int32_t *start =
-      current->csound->QueryGlobalVariable(current->csound,"DISKIN_THREAD_START");
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    while(*start){
-      current = (DISKIN_INST *) p;
-      csoundSleep(wakeup > 0 ? wakeup : 1);
-      while(current != NULL){
-        diskin_file_read(current->csound, current->diskin);
-        current = current->nxt;
-      }
-    }
-    return 0;
-}
-
-
 int32_t diskin2_perf(CSOUND *csound, DISKIN2 *p) {
     if (!p->async) return diskin2_perf_synchronous(csound, p);
     else return diskin2_perf_asynchronous(csound, p);
@@ -1309,39 +1553,12 @@ static inline void diskin2_get_sample_array(CSOUND *csound,
 }
 
 int32_t diskin2_async_deinit_array(CSOUND *csound,  void *p){
+    DISKIN2_ARRAY *pp = (DISKIN2_ARRAY *) p;
 
-    DISKIN_INST **top, *current, *prv;
-
-    if ((top = (DISKIN_INST **)
-         csound->QueryGlobalVariable(csound, "DISKIN_INST_ARRAY")) == NULL)
-      return NOTOK;
-    current = *top;
-    prv = NULL;
-    while(current->diskin != (DISKIN2 *)p) {
-      prv = current;
-      current = current->nxt;
-    }
-    if (prv == NULL) *top = current->nxt;
-    else prv->nxt = current->nxt;
-
-#ifndef __EMSCRIPTEN__
-    if (*top == NULL) {
-      int32_t *start; void **pt;
-      start = (int32_t *) csound->QueryGlobalVariable(csound,
-                                                  "DISKIN_THREAD_START_ARRAY");
-      *start = 0;
-      pt = csound->QueryGlobalVariable(csound,"DISKIN_PTHREAD_ARRAY");
-      //csound->Message(csound, "dealloc %p %d\n", start, *start);
-      csound->JoinThread(*pt);
-      csound->DestroyGlobalVariable(csound, "DISKIN_PTHREAD_ARRAY");
-      csound->DestroyGlobalVariable(csound, "DISKIN_THREAD_START_ARRAY");
-      csound->DestroyGlobalVariable(csound, "DISKIN_INST_ARRAY");
-    }
-#endif
-
-    csound->Free(csound, current);
-    csound->DestroyCircularBuffer(csound, ((DISKIN2_ARRAY *)p)->cb);
-
+    if (pp->stream == NULL) return NOTOK;
+    diskin_stream_remove(csound, (DISKIN_INST *) pp->stream);
+    pp->stream = NULL;
+    pp->cb = NULL;
     return OK;
 }
 
@@ -1520,41 +1737,12 @@ int32_t diskin_file_read_array(CSOUND *csound, DISKIN2_ARRAY *p)
         diskin2_file_pos_inc_array(p, &ndx);
       }
     }
-    {
-      /* write to circular buffer */
-      int32_t lc, mc=0, nc=nsmps*p->nChannels;
-      int32_t *start = csound->QueryGlobalVariable(csound,"DISKIN_THREAD_START");
-      do{
-        lc = csound->WriteCircularBuffer(csound, p->cb, &aOut[mc], nc);
-        nc -= lc;
-        mc += lc;
-      } while(nc && *start);
-    }
     return OK;
  file_error:
     csound->ErrorMsg(csound, Str("diskin2: file descriptor closed or invalid\n"));
     return NOTOK;
 }
 
-uintptr_t diskin_io_thread_array(void *p){
-    DISKIN_INST *current = (DISKIN_INST *) p;
-    int32_t wakeup = 1000*current->csound->ksmps/current->csound->esr;
-    int32_t *start =
-      current->csound->QueryGlobalVariable(current->csound,
-                                           "DISKIN_THREAD_START_ARRAY");
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    while(*start){
-      current = (DISKIN_INST *) p;
-      csoundSleep(wakeup > 0 ? wakeup : 1);
-      while(current != NULL){
-        diskin_file_read_array(current->csound, (DISKIN2_ARRAY *)current->diskin);
-        current = current->nxt;
-      }
-    }
-    return 0;
-}
-
-
 static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
                                   int32_t stringname)
 {
@@ -1570,6 +1758,9 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
       /* skip initialisation if requested */
       if (p->SkipInit != FL(0.0))
         return OK;
+      /* a reinitialised asynchronous stream starts over */
+      if (p->stream != NULL)
+        diskin2_async_deinit_array(csound, p);
       fd_close(csound, &(p->fdch));
     }
     // to handle raw files number of channels
@@ -1694,67 +1885,26 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
     memset(p->buf, 0, n*sizeof(MYFLT));
 
     // create circular buffer, on fail set mode to synchronous
-    if (csound->oparms->realtime==1 && p->fforceSync==0 &&
-        (p->cb = csound->CreateCircularBuffer(csound,
-                                              p->bufSize*p->nChannels*2,
-                                              sizeof(MYFLT))) != NULL){
-      DISKIN_INST **top, *current;
-#ifndef __EMSCRIPTEN__
-      int32_t *start;
-#endif
-      // allocate buffer
+    p->cb = NULL;
+    if (csound->oparms->realtime==1 && p->fforceSync==0) {
+      int32_t depth = diskin_stream_depth(p->warpScale * *(p->kTranspose));
       p->aOut_bufsize =
         ((unsigned int)p->bufSize) < CS_KSMPS ?
         ((MYFLT)CS_KSMPS) : ((MYFLT)p->bufSize);
-      n = p->aOut_bufsize*sizeof(MYFLT)*p->nChannels;
-      if (n != (int32_t)p->auxData2.size)
-        csound->AuxAlloc(csound, (int32_t) n, &(p->auxData2));
-      p->aOut_buf = (MYFLT *) (p->auxData2.auxp);
-      memset(p->aOut_buf, 0, n);
-      top =
-        (DISKIN_INST **)csound->QueryGlobalVariable(csound, "DISKIN_INST_ARRAY");
-#ifndef __EMSCRIPTEN__
-      if (top == NULL){
-        csound->CreateGlobalVariable(csound,
-                                     "DISKIN_INST_ARRAY", sizeof(DISKIN_INST *));
-        top = (DISKIN_INST **) csound->QueryGlobalVariable(csound,
-                                                           "DISKIN_INST_ARRAY");
-        *top = (DISKIN_INST *) csound->Calloc(csound, sizeof(DISKIN_INST));
-        csound->CreateGlobalVariable(csound,
-                                     "DISKIN_PTHREAD_ARRAY", sizeof(void**));
-        csound->CreateGlobalVariable(csound,
-                                     "DISKIN_THREAD_START_ARRAY", sizeof(int32_t));
-        current = *top;
-      }
-      else
-#endif
-        {
-          current = *top;
-          while(current->nxt != NULL) { /* find next empty slot in chain */
-            current = current->nxt;
-          }
-          current->nxt =
-            (DISKIN_INST *) csound->Calloc(csound, sizeof(DISKIN_INST));
-          current = current->nxt;
-        }
-      current->csound = csound;
-      current->diskin =  (DISKIN2 *) p;
-      current->nxt = NULL;
-
-#ifndef __EMSCRIPTEN__
-      if (*(start =
-            csound->QueryGlobalVariable(csound,
-                                        "DISKIN_THREAD_START_ARRAY")) == 0) {
-        uintptr_t diskin_io_thread_array(void *p);
-        // TOFIX: this variable (thread) is not referenced
-        #if 0
-        void **thread = csound->QueryGlobalVariable(csound,
-                                                       "DISKIN_PTHREAD_ARRAY");
-        #endif
-        *start = 1;
-        csound->CreateThread(diskin_io_thread_array, *top);
-      }
-#endif
+      n = (int32_t) p->aOut_bufsize * p->nChannels;
+      if ((p->cb = csound->CreateCircularBuffer(csound, n * depth,
+                                                sizeof(MYFLT))) != NULL &&
+          (p->stream = diskin_stream_new(csound, p, diskin_stream_read_array,
+                                         p->cb, (int32_t) p->aOut_bufsize,
+                                         p->nChannels, depth, fd,
+                                         sfinfo.format)) == NULL) {
+        csound->DestroyCircularBuffer(csound, p->cb);
+        p->cb = NULL;
+      }
+    }
+    if (p->cb != NULL) {
+      /* the I/O threads render straight into the ring buffer */
+      p->aOut_buf = NULL;
       csound->RegisterDeinitCallback(csound, (DISKIN2 *) p,
                                      diskin2_async_deinit_array);
       p->async = 1;
@@ -1790,6 +1940,8 @@ static int32_t diskin2_init_array(CSOUND *csound, DISKIN2_ARRAY *p,
 
     /* done initialisation */
     p->initDone = 1;
+    if (p->async)
+      diskin_stream_request(csound, (DISKIN_INST *) p->stream);
     return OK;
 }
 
@@ -1988,8 +2140,8 @@ int32_t diskin2_perf_asynchronous_array(CSOUND *csound, DISKIN2_ARRAY *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t nn, nsmps = CS_KSMPS, ksmps = CS_KSMPS;
-    MYFLT samp;
-    int32_t chn;
+    MYFLT *samp, scl = csound->e0dbfs;
+    int32_t chn, n, m;
     void *cb = p->cb;
     int32_t chans = p->nChannels;
     MYFLT *aOut = (MYFLT *) p->aOut->data;
@@ -2006,17 +2158,26 @@ int32_t diskin2_perf_asynchronous_array(CSOUND *csound, DISKIN2_ARRAY *p)
       return csound->PerfError(csound, &(p->h),
                                Str("diskin2: not initialised"));
     }
-    for (nn = offset; nn < nsmps; nn++){
-
+    /* read whole frames directly from the circular buffer */
+    nn = offset;
+    while (nn < nsmps &&
+           (samp = (MYFLT*)
+            csoundAcquireCircularBufferRead(csound, cb,
+                                            (nsmps - nn) * chans, &n)) != NULL) {
+      if ((m = n / chans) == 0) break;
       for (chn = 0; chn < chans; chn++) {
-        //int32_t i =0;
-        //do {
-        // i =
-        csound->ReadCircularBuffer(csound, cb, &samp, 1);
-        //} while(i==0);
-        aOut[chn*ksmps+nn] = csound->e0dbfs*samp;
+        MYFLT *out = &aOut[chn*ksmps+nn];
+        for (n = 0; n < m; n++)
+          out[n] = scl * samp[n * chans + chn];
       }
+      csoundCommitCircularBufferRead(csound, cb, m * chans);
+      nn += m;
     }
+    /* buffer underrun: output silence */
+    for (chn = 0; chn < chans; chn++)
+      memset(&aOut[chn*ksmps+nn], 0, (nsmps - nn) * sizeof(MYFLT));
+    diskin_stream_consume(csound, (DISKIN_INST *) p->stream,
+                          (nn - offset) * chans, nn < nsmps);
     return OK;
 }
 
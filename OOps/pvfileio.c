@@ -57,6 +57,10 @@
 
 #include "csoundCore.h"
 #include "pvfileio.h"
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #if !defined(WAVE_FORMAT_EXTENSIBLE)
 #define WAVE_FORMAT_EXTENSIBLE  (0xFFFE)
@@ -989,6 +993,62 @@ int32_t pvoc_fseek(CSOUND *csound, int32_t ifd, int32_t offset)
     return 0;
 }
 
+/* Map the frames of a file opened for reading into memory, read-only and
+ * private: pages are read from disk when first used, and share the page
+ * cache with every other mapping of the same file.  Returns a pointer to
+ * the first frame, and stores the region to pass to pvoc_unmapframes() in
+ * *base and *len; returns NULL, leaving the file untouched, if the frames
+ * cannot be used in place (big endian host, no mmap(), or a file whose
+ * size does not match the frame count of its header), and the caller
+ * should read them with pvoc_getframes().
+ */
+
+float *pvoc_mapframes(CSOUND *csound, int32_t ifd, uint32 nframes,
+                      void **base, size_t *len)
+{
+#ifdef HAVE_SYS_MMAN_H
+    PVOCFILE  *p = pvsys_getFileHandle(csound, ifd);
+    struct stat st;
+    size_t    start, end, pagesize;
+    void      *addr;
+
+    if (UNLIKELY(p == NULL || p->fd == NULL))
+      return NULL;
+    if (byte_order() || (p->datachunkoffset & 3) != 0)
+      return NULL;
+    /* the frames must be packed as the header says, and all be there */
+    if (nframes != (uint32) p->nFrames ||
+        p->pvdata.dwFrameAlign
+          != (uint32_t) p->pvdata.nAnalysisBins * 2 * sizeof(float))
+      return NULL;
+    pagesize = (size_t) sysconf(_SC_PAGESIZE);
+    start = (size_t) p->datachunkoffset & ~(pagesize - 1);
+    end = (size_t) p->datachunkoffset
+          + (size_t) p->nFrames * (size_t) p->pvdata.dwFrameAlign;
+    if (fstat(fileno(p->fp), &st) != 0 || (size_t) st.st_size < end)
+      return NULL;
+    addr = mmap(NULL, end - start, PROT_READ, MAP_PRIVATE,
+                fileno(p->fp), (off_t) start);
+    if (addr == MAP_FAILED)
+      return NULL;
+    *base = addr;
+    *len = end - start;
+    return (float*) ((char*) addr + ((size_t) p->datachunkoffset - start));
+#else
+    (void) csound; (void) ifd; (void) nframes; (void) base; (void) len;
+    return NULL;
+#endif
+}
+
+void pvoc_unmapframes(void *base, size_t len)
+{
+#ifdef HAVE_SYS_MMAN_H
+    munmap(base, len);
+#else
+    (void) base; (void) len;
+#endif
+}
+
 /* may be more to do in here later on */
 
 int32_t pvsys_release(CSOUND *csound)
@@ -1222,144 +1222,156 @@ int32_t koscil(CSOUND *csound, OSC *p)
                              Str("oscil(krate): not initialised"));
 }
 
-int32_t osckk(CSOUND *csound, OSC *p)
+/* Block kernels for the a-rate oscillators.  The phases of OSC_BLOCK
+   samples are produced first (a lane-wise multiply-add for k-rate
+   frequency, a short prefix sum for a-rate frequency), table indices
+   and fractions are then derived with branch-free selects, and the
+   table is read with gathers.  Every sample sees exactly the arithmetic
+   of the old one-sample-at-a-time loops, so output is bit-identical;
+   building with -DOSC_BLOCK=1 gives the serial reference order. */
+#ifndef OSC_BLOCK
+#define OSC_BLOCK 32
+#endif
+
+static inline int32_t osc_phases(int32_t *ph, int32_t phs, int32_t inc,
+                                 const MYFLT *cpsp, MYFLT sicvt, uint32_t nb)
 {
-    FUNC    *ftp;
-    MYFLT   amp, *ar, *ftbl;
-    int32_t   phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
+    uint32_t j;
+    if (cpsp == NULL) {
+      /* phase accumulation is modulo 2^24, so wrapping in 32 bits
+         and masking afterwards gives the same result as stepping */
+      for (j=0; j<nb; j++)
+        ph[j] = (int32_t) (((uint32_t) phs + j * (uint32_t) inc) & PHMASK);
+      return (int32_t) (((uint32_t) phs + nb * (uint32_t) inc) & PHMASK);
     }
+    else {
+      int32_t incs[OSC_BLOCK];
+      for (j=0; j<nb; j++)
+        incs[j] = MYFLT2LONG(cpsp[j] * sicvt);
+      for (j=0; j<nb; j++) {
+        ph[j] = phs;
+        phs = (phs+incs[j]) & PHMASK;
+      }
+      return phs;
+    }
+}
 
-    for (n=offset;n<nsmps;n++) {
-      ar[n] = ftbl[phs >> lobits] * amp;
-      /* phs += inc; */
-      /* phs &= PHMASK; */
-      phs = (phs+inc)&PHMASK;
+/* One block of nb samples: order is 0 (truncating), 1 (linear) or 3
+   (cubic).  The result goes to a local buffer first so the compiler
+   need not assume the output may alias the table or the inputs. */
+static inline int32_t osc_block(OSC *p, MYFLT *ar, const MYFLT *ampp,
+                                const MYFLT *cpsp, int32_t phs, int32_t inc,
+                                MYFLT sicvt, int32_t order, uint32_t nb)
+{
+    FUNC    *ftp = p->ftp;
+    const MYFLT *ftab = ftp->ftable;
+    int32_t lobits = ftp->lobits, lomask = ftp->lomask;
+    int32_t flen = (int32_t) ftp->flen;
+    MYFLT   lodiv = ftp->lodiv, amp = *p->xamp;
+    MYFLT   out[OSC_BLOCK];
+    int32_t ph[OSC_BLOCK];
+    uint32_t j;
+
+    phs = osc_phases(ph, phs, inc, cpsp, sicvt, nb);
+    if (order == 0) {
+      for (j=0; j<nb; j++)
+        out[j] = ftab[ph[j] >> lobits];
     }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil: not initialised"));
+    else if (order == 1) {
+      for (j=0; j<nb; j++) {
+        MYFLT fract = (MYFLT)(ph[j] & lomask) * lodiv;
+        int32_t x = ph[j] >> lobits;
+        MYFLT v1 = ftab[x];
+        out[j] = v1 + (ftab[x+1] - v1) * fract;
+      }
+    }
+    else {
+      for (j=0; j<nb; j++) {
+        MYFLT fract = (MYFLT)(ph[j] & lomask) * lodiv;
+        int32_t x = ph[j] >> lobits;
+        /* the neighbours wrap round the table ends */
+        MYFLT ym1 = ftab[x > 0 ? x-1 : flen-1];
+        MYFLT y0 = ftab[x], y1 = ftab[x+1];
+        MYFLT y2 = ftab[x+2 > flen ? 1 : x+2];
+        MYFLT frsq = fract*fract;
+        MYFLT frcu = frsq*ym1;
+        MYFLT t1 = y2 + y0+y0+y0;
+        out[j] = y0 + FL(0.5)*frcu +
+          fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
+          frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) +
+          frsq*(FL(0.5)* y1 - y0);
+      }
+    }
+    if (ampp != NULL)
+      for (j=0; j<nb; j++) ar[j] = out[j] * ampp[j];
+    else
+      for (j=0; j<nb; j++) ar[j] = out[j] * amp;
+    return phs;
 }
 
-int32_t oscka(CSOUND *csound, OSC *p)
+/* acps and aamp say which of the inputs are audio rate.  All arguments
+   but p are constants at the call sites, so each caller gets its own
+   specialised loops. */
+static inline int32_t osc_block_perf(CSOUND *csound, OSC *p, int32_t order,
+                                     int32_t acps, int32_t aamp)
 {
-    FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, *ftbl;
-    int32_t    phs, lobits;
+    MYFLT   *ar, *ampp, *cpsp;
+    int32_t phs, inc = 0;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
     MYFLT   sicvt = csound->sicvt;
 
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
+    if (UNLIKELY(p->ftp==NULL)) goto err1;
     phs = p->lphs;
+    ampp = aamp ? p->xamp : NULL;
+    cpsp = acps ? p->xcps : NULL;
+    if (!acps) inc = MYFLT2LONG(*p->xcps * sicvt);
     ar = p->sr;
     if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
     if (UNLIKELY(early)) {
       nsmps -= early;
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      ar[n] = ftbl[phs >> lobits] * amp;
-      phs += inc;
-      phs &= PHMASK;
-    }
+    for (n=offset; n+OSC_BLOCK<=nsmps; n+=OSC_BLOCK)
+      phs = osc_block(p, &ar[n], aamp ? &ampp[n] : NULL,
+                      acps ? &cpsp[n] : NULL, phs, inc, sicvt,
+                      order, OSC_BLOCK);
+    if (n<nsmps)
+      phs = osc_block(p, &ar[n], aamp ? &ampp[n] : NULL,
+                      acps ? &cpsp[n] : NULL, phs, inc, sicvt,
+                      order, nsmps-n);
     p->lphs = phs;
     return OK;
  err1:
+    if (order == 0)
+      return csound->PerfError(csound, &(p->h),
+                               Str("oscil: not initialised"));
+    else if (order == 1)
+      return csound->PerfError(csound, &(p->h),
+                               Str("oscili: not initialised"));
     return csound->PerfError(csound, &(p->h),
-                             Str("oscil: not initialised"));
+                             Str("oscil3: not initialised"));
 }
 
-int32_t oscak(CSOUND *csound, OSC *p)
+int32_t osckk(CSOUND *csound, OSC *p)
 {
-    FUNC    *ftp;
-    MYFLT   *ar, *ampp, *ftbl;
-    int32_t    phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    return osc_block_perf(csound, p, 0, 0, 0);
+}
 
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    ampp = p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      ar[n] = ftbl[phs >> lobits] * ampp[n];
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil: not initialised"));
+int32_t oscka(CSOUND *csound, OSC *p)
+{
+    return osc_block_perf(csound, p, 0, 1, 0);
 }
 
-int32_t oscaa(CSOUND *csound, OSC *p)
+int32_t oscak(CSOUND *csound, OSC *p)
 {
-    FUNC    *ftp;
-    MYFLT   *ar, *ampp, *cpsp, *ftbl;
-    int32_t    phs, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    MYFLT   sicvt = csound->sicvt;
+    return osc_block_perf(csound, p, 0, 0, 1);
+}
 
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftbl = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    ampp = p->xamp;
-    cpsp = p->xcps;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      ar[n] = ftbl[phs >> lobits] * ampp[n];
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil: not initialised"));
+int32_t oscaa(CSOUND *csound, OSC *p)
+{
+    return osc_block_perf(csound, p, 0, 1, 1);
 }
 
 int32_t koscli(CSOUND *csound, OSC   *p)
@@ -1387,152 +1399,117 @@ int32_t koscli(CSOUND *csound, OSC   *p)
 
 int32_t osckki(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT   fract, v1, amp, *ar, *ft, *ftab;
-    int32_t   phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-
-    if (UNLIKELY((ftp = p->ftp)==NULL)) goto err1;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    amp = *p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    ft = ftp->ftable;
-    for (n=offset; n<nsmps; n++) {
-      fract = PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * amp;
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscili: not initialised"));
+    return osc_block_perf(csound, p, 1, 0, 0);
 }
 
 int32_t osckai(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, fract, v1, *ftab, *ft;
-    int32_t    phs, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    MYFLT   sicvt = csound->sicvt;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
-    phs = p->lphs;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    ft = ftp->ftable;
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * amp;
-      phs += inc;
-      phs &= PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscili: not initialised"));
+    return osc_block_perf(csound, p, 1, 1, 0);
 }
 
 int32_t oscaki(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT    v1, fract, *ar, *ampp, *ftab, *ft;
-    int32_t    phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    return osc_block_perf(csound, p, 1, 0, 1);
+}
 
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    ampp = p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
+int32_t oscaai(CSOUND *csound, OSC   *p)
+{
+    return osc_block_perf(csound, p, 1, 1, 1);
+}
+
+/* Multi-voice versions of osckk() and osckki() for --voice-batch.
+   The state of up to VOICE_LANES instances is gathered into local
+   arrays, so the inner loop runs across voices for each sample and the
+   table reads become gathers.  The arithmetic is the same as in the
+   single-voice code, so every voice gets bit-identical output.
+   The engine only passes voices without sample-accurate offsets. */
+#define VOICE_LANES 8
+
+static void osckk_lanes(CSOUND *csound, OSC **p, int32_t nl)
+{
+    MYFLT   *ar[VOICE_LANES], *ftbl[VOICE_LANES], amp[VOICE_LANES];
+    int32_t phs[VOICE_LANES], inc[VOICE_LANES], lobits[VOICE_LANES];
+    uint32_t n, nsmps = p[0]->h.insdshead->ksmps;
+    int32_t v;
+
+    for (v = 0; v < nl; v++) {
+      FUNC *ftp = p[v]->ftp;
+      ftbl[v] = ftp->ftable;
+      lobits[v] = ftp->lobits;
+      phs[v] = p[v]->lphs;
+      inc[v] = MYFLT2LONG(*p[v]->xcps * csound->sicvt);
+      amp[v] = *p[v]->xamp;
+      ar[v] = p[v]->sr;
     }
-    ft = ftp->ftable;
-    for (n=offset;n<nsmps;n++) {
-      fract = (MYFLT) PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    for (n=0; n<nsmps; n++)
+      for (v = 0; v < nl; v++) {
+        ar[v][n] = ftbl[v][phs[v] >> lobits[v]] * amp[v];
+        phs[v] = (phs[v]+inc[v]) & PHMASK;
+      }
+    for (v = 0; v < nl; v++)
+      p[v]->lphs = phs[v];
+}
+
+static void osckki_lanes(CSOUND *csound, OSC **p, int32_t nl)
+{
+    MYFLT   *ar[VOICE_LANES], *ft[VOICE_LANES], amp[VOICE_LANES];
+    MYFLT   lodiv[VOICE_LANES];
+    int32_t phs[VOICE_LANES], inc[VOICE_LANES], lobits[VOICE_LANES];
+    int32_t lomask[VOICE_LANES];
+    uint32_t n, nsmps = p[0]->h.insdshead->ksmps;
+    int32_t v;
+
+    for (v = 0; v < nl; v++) {
+      FUNC *ftp = p[v]->ftp;
+      ft[v] = ftp->ftable;
+      lobits[v] = ftp->lobits;
+      lomask[v] = ftp->lomask;
+      lodiv[v] = ftp->lodiv;
+      phs[v] = p[v]->lphs;
+      inc[v] = MYFLT2LONG(*p[v]->xcps * csound->sicvt);
+      amp[v] = *p[v]->xamp;
+      ar[v] = p[v]->sr;
     }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscili: not initialised"));
+    for (n=0; n<nsmps; n++)
+      for (v = 0; v < nl; v++) {
+        MYFLT fract = (MYFLT)(phs[v] & lomask[v]) * lodiv[v];
+        MYFLT *ftab = ft[v] + (phs[v] >> lobits[v]);
+        MYFLT v1 = ftab[0];
+        ar[v][n] = (v1 + (ftab[1] - v1) * fract) * amp[v];
+        phs[v] = (phs[v]+inc[v]) & PHMASK;
+      }
+    for (v = 0; v < nl; v++)
+      p[v]->lphs = phs[v];
 }
 
-int32_t oscaai(CSOUND *csound, OSC   *p)
+static int32_t osc_batch(CSOUND *csound, OSC **p, int32_t nv,
+                         int32_t (*single)(CSOUND *, OSC *),
+                         void (*lanes)(CSOUND *, OSC **, int32_t))
 {
-    FUNC    *ftp;
-    MYFLT   v1, fract, *ar, *ampp, *cpsp, *ftab, *ft;
-    int32_t   phs, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    MYFLT   sicvt = csound->sicvt;
+    OSC     *lane[VOICE_LANES];
+    int32_t i, nl = 0;
 
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ft = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    ampp = p->xamp;
-    cpsp = p->xcps;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = (MYFLT) PFRAC(phs);
-      ftab = ft + (phs >> lobits);
-      v1 = ftab[0];
-      ar[n] = (v1 + (ftab[1] - v1) * fract) * ampp[n];
-      phs = (phs+inc) & PHMASK;
+    for (i = 0; i < nv; i++) {
+      if (UNLIKELY(p[i]->ftp == NULL))
+        (void) single(csound, p[i]);        /* reports the error */
+      else
+        lane[nl++] = p[i];
+      if (nl == VOICE_LANES || (nl > 0 && i == nv-1)) {
+        lanes(csound, lane, nl);
+        nl = 0;
+      }
     }
-    p->lphs = phs;
     return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscili: not initialised"));
+}
+
+int32_t osckk_batch(CSOUND *csound, void **p, int32_t nv)
+{
+    return osc_batch(csound, (OSC **) p, nv, osckk, osckk_lanes);
+}
+
+int32_t osckki_batch(CSOUND *csound, void **p, int32_t nv)
+{
+    return osc_batch(csound, (OSC **) p, nv, osckki, osckki_lanes);
 }
 
 int32_t koscl3(CSOUND *csound, OSC   *p)
@@ -1578,223 +1555,20 @@ int32_t koscl3(CSOUND *csound, OSC   *p)
 
 int32_t osckk3(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT   fract, amp, *ar, *ftab;
-    int32_t    phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    amp = *p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      fract = PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-/*    printf("fract = %f; y = %f, %f, %f, %f\n", fract,ym1,y0,y1,y2); */
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-/*      MYFLT old = (y0 + (y1 - y0) * fract) * amp; */
-/*      double x = ((double)(x0-2)+fract)*twopi/32.0; */
-/*      MYFLT tr = amp*sin(x); */
-        ar[n] = amp * (y0 + FL(0.5)*frcu +
-                       fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
-                       frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) +
-                       frsq*(FL(0.5)* y1 - y0));
-/*      printf("oscilkk3: old=%.4f new=%.4f true=%.4f (%f; %f)\n", */
-/*                       old, *(ar-1), tr, fabs(*(ar-1)-tr), fabs(old-tr)); */
-      }
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil3: not initialised"));
+    return osc_block_perf(csound, p, 3, 0, 0);
 }
 
 int32_t oscka3(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT   *ar, amp, *cpsp, fract, *ftab;
-    int32_t    phs, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
-    MYFLT   sicvt = csound->sicvt;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
-    amp = *p->xamp;
-    cpsp = p->xcps;
-    phs = p->lphs;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc;
-      inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = amp * (y0 + FL(0.5)*frcu +
-                       fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0)) +
-                       frsq*fract*(t1/FL(6.0) - FL(0.5)*y1) + frsq*(FL(0.5)*
-                                                                    y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil3: not initialised"));
+    return osc_block_perf(csound, p, 3, 1, 0);
 }
 
 int32_t oscak3(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT   fract, *ar, *ampp, *ftab;
-    int32_t    phs, inc, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t   x0;
-    MYFLT   y0, y1, ym1, y2;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    inc = MYFLT2LONG(*p->xcps * csound->sicvt);
-    ampp = p->xamp;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      fract = (MYFLT) PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = ampp[n] *(y0 + FL(0.5)*frcu
-                          + fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0))
-                          + frsq*fract*(t1/FL(6.0) - FL(0.5)*y1)
-                          + frsq*(FL(0.5)* y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil3: not initialised"));
+    return osc_block_perf(csound, p, 3, 0, 1);
 }
 
 int32_t oscaa3(CSOUND *csound, OSC   *p)
 {
-    FUNC    *ftp;
-    MYFLT    fract, *ar, *ampp, *cpsp, *ftab;
-    int32_t    phs, lobits;
-    uint32_t offset = p->h.insdshead->ksmps_offset;
-    uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
-    int32_t    x0;
-    MYFLT    y0, y1, ym1, y2;
-    MYFLT    sicvt = csound->sicvt;
-
-    ftp = p->ftp;
-    if (UNLIKELY(ftp==NULL)) goto err1;
-    ftab = ftp->ftable;
-    lobits = ftp->lobits;
-    phs = p->lphs;
-    ampp = p->xamp;
-    cpsp = p->xcps;
-    ar = p->sr;
-    if (UNLIKELY(offset)) memset(ar, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n=offset;n<nsmps;n++) {
-      int32_t inc = MYFLT2LONG(cpsp[n] * sicvt);
-      fract = (MYFLT) PFRAC(phs);
-      x0 = (phs >> lobits);
-      x0--;
-      if (UNLIKELY(x0<0)) {
-        ym1 = ftab[ftp->flen-1]; x0 = 0;
-      }
-      else ym1 = ftab[x0++];
-      y0 = ftab[x0++];
-      y1 = ftab[x0++];
-      if (UNLIKELY(x0>(int32_t)ftp->flen)) y2 = ftab[1]; else y2 = ftab[x0];
-      {
-        MYFLT frsq = fract*fract;
-        MYFLT frcu = frsq*ym1;
-        MYFLT t1 = y2 + y0+y0+y0;
-        ar[n] = ampp[n] *(y0 + FL(0.5)*frcu
-                          + fract*(y1 - frcu/FL(6.0) - t1/FL(6.0) - ym1/FL(3.0))
-                          + frsq*fract*(t1/FL(6.0) - FL(0.5)*y1)
-                          + frsq*(FL(0.5)* y1 - y0));
-      }
-      phs = (phs+inc) & PHMASK;
-    }
-    p->lphs = phs;
-    return OK;
- err1:
-    return csound->PerfError(csound, &(p->h),
-                             Str("oscil3: not initialised"));
+    return osc_block_perf(csound, p, 3, 1, 1);
 }
@@ -24,6 +24,7 @@
 
 #include "csoundCore.h" /*                              UGENS6.C        */
 #include "ugens6.h"
+#include "delayline.h"
 #include <math.h>
 
 #define log001 (-FL(6.9078))    /* log(.001) */
@@ -373,7 +374,8 @@ int32_t tapset(CSOUND *csound, DELTAP *p)
 
 int32_t delay(CSOUND *csound, DELAY *p)
 {
-    MYFLT       *ar, *asig, *curp, *endp;
+    MYFLT       *ar, *asig, *curp, *begp;
+    int32_t     pos, len;
     uint32_t offset = 0;
     uint32_t n, nsmps = CS_KSMPS;
 
@@ -390,16 +392,20 @@ int32_t delay(CSOUND *csound, DELAY *p)
       }
     }
     asig = p->asig;
-    curp = p->curp;
-    endp = (MYFLT *) p->auxch.endp;
-    for (n=offset; n<nsmps; n++) {
-      MYFLT in = asig[n];       /* Allow overwriting form */
-      ar[n] = *curp;
-      *curp = in;
-      if (UNLIKELY(++curp >= endp))
-        curp = (MYFLT *) p->auxch.auxp;
+    begp = (MYFLT *) p->auxch.auxp;
+    len = (int32_t) ((MYFLT *) p->auxch.endp - begp);
+    pos = (int32_t) (p->curp - begp);
+    for (n=offset; n<nsmps; ) {
+      uint32_t i, m = dline_span(pos, len, nsmps - n);
+      curp = &begp[pos];
+      for (i = 0; i < m; i++, n++) {
+        MYFLT in = asig[n];     /* Allow overwriting form */
+        ar[n] = curp[i];
+        curp[i] = in;
+      }
+      if ((pos += m) >= len) pos = 0;
     }
-    p->curp = curp;             /* sav the new curp */
+    p->curp = &begp[pos];       /* sav the new curp */
 
     return OK;
  err1:
@@ -409,10 +415,10 @@ int32_t delay(CSOUND *csound, DELAY *p)
 
 int32_t delayr(CSOUND *csound, DELAYR *p)
 {
-    MYFLT       *ar, *curp, *endp;
+    MYFLT       *ar, *begp;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
 
     if (UNLIKELY(p->auxch.auxp==NULL)) goto err1; /* RWD fix */
     ar = p->ar;
@@ -421,13 +427,9 @@ int32_t delayr(CSOUND *csound, DELAYR *p)
       nsmps -= early;
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
-    curp = p->curp;
-    endp = (MYFLT *) p->auxch.endp;
-    for (n=offset; n<nsmps; n++) {
-      ar[n] = *curp++;
-      if (UNLIKELY(curp >= endp))
-        curp = (MYFLT *) p->auxch.auxp;
-    }
+    begp = (MYFLT *) p->auxch.auxp;
+    dline_read(&ar[offset], begp, (int32_t) ((MYFLT *) p->auxch.endp - begp),
+               (int32_t) (p->curp - begp), nsmps - offset);
     return OK;
  err1:
     return csound->PerfError(csound, &(p->h),
@@ -437,22 +439,19 @@ int32_t delayr(CSOUND *csound, DELAYR *p)
 int32_t delayw(CSOUND *csound, DELAYW *p)
 {
     DELAYR      *q = p->delayr;
-    MYFLT       *asig, *curp, *endp;
+    MYFLT       *asig, *begp;
+    int32_t     pos;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
 
     if (UNLIKELY(q->auxch.auxp==NULL)) goto err1; /* RWD fix */
     asig = p->asig;
-    curp = q->curp;
-    endp = (MYFLT *) q->auxch.endp;
+    begp = (MYFLT *) q->auxch.auxp;
     if (UNLIKELY(early)) nsmps -= early;
-    for (n=offset; n<nsmps; n++) {
-      *curp = asig[n];
-      if (UNLIKELY(++curp >= endp))
-        curp = (MYFLT *) q->auxch.auxp;
-    }
-    q->curp = curp;                                     /* now sav new curp */
+    pos = dline_write(begp, (int32_t) ((MYFLT *) q->auxch.endp - begp),
+                      (int32_t) (q->curp - begp), &asig[offset], nsmps - offset);
+    q->curp = &begp[pos];                               /* now sav new curp */
     return OK;
  err1:
     return csound->PerfError(csound, &(p->h),
@@ -462,10 +461,11 @@ int32_t delayw(CSOUND *csound, DELAYW *p)
 int32_t deltap(CSOUND *csound, DELTAP *p)
 {
     DELAYR      *q = p->delayr;
-    MYFLT       *ar, *tap, *endp;
+    MYFLT       *ar, *begp;
+    int32_t     pos;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
-    uint32_t n, nsmps = CS_KSMPS;
+    uint32_t nsmps = CS_KSMPS;
 
     if (UNLIKELY(q->auxch.auxp==NULL)) goto err1; /* RWD fix */
     ar = p->ar;
@@ -474,15 +474,14 @@ int32_t deltap(CSOUND *csound, DELTAP *p)
       nsmps -= early;
       memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
     }
-    tap = q->curp - MYFLT2LRND(*p->xdlt * csound->esr);
-    while (tap < (MYFLT *) q->auxch.auxp)
-      tap += q->npts;
-    endp = (MYFLT *) q->auxch.endp;
-    for (n=offset; n<nsmps; n++) {
-      if (UNLIKELY(tap >= endp))
-        tap -= q->npts;
-      ar[n] = *tap++;
-    }
+    begp = (MYFLT *) q->auxch.auxp;
+    pos = (int32_t) (q->curp - begp)
+          - (int32_t) MYFLT2LRND(*p->xdlt * csound->esr);
+    while (pos < 0)
+      pos += q->npts;
+    while (UNLIKELY(pos >= (int32_t) q->npts))
+      pos -= q->npts;
+    dline_read(&ar[offset], begp, (int32_t) q->npts, pos, nsmps - offset);
     return OK;
  err1:
     return csound->PerfError(csound, &(p->h),
@@ -496,7 +495,7 @@ int32_t deltapi(CSOUND *csound, DELTAP *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
-    int32_t       idelsmps;
+    int32_t       idelsmps, pos, len = (int32_t) q->npts;
     MYFLT       delsmps, delfrac;
 
     if (UNLIKELY(q->auxch.auxp==NULL)) goto err1;
@@ -513,15 +512,22 @@ int32_t deltapi(CSOUND *csound, DELTAP *p)
       delsmps = *p->xdlt * csound->esr;
       idelsmps = (int32_t)delsmps;
       delfrac = delsmps - idelsmps;
-      tap = q->curp - idelsmps;
-      while (tap < begp) tap += q->npts;
-      for (n=offset; n<nsmps; n++) {
-        if (UNLIKELY(tap >= endp))
-          tap -= q->npts;
-        if (UNLIKELY((prv = tap - 1) < begp))
-          prv += q->npts;
-        ar[n] = *tap + (*prv - *tap) * delfrac;
-        tap++;
+      pos = (int32_t) (q->curp - begp) - idelsmps;
+      while (pos < 0) pos += q->npts;
+      while (UNLIKELY(pos >= len)) pos -= len;
+      for (n=offset; n<nsmps; ) {
+        uint32_t i, m;
+        if (UNLIKELY(pos == 0)) {   /* previous sample is at the far end */
+          ar[n++] = *begp + (begp[len - 1] - *begp) * delfrac;
+          pos = (len > 1 ? 1 : 0);
+          continue;
+        }
+        m = dline_span(pos, len, nsmps - n);
+        tap = &begp[pos];
+        prv = tap - 1;
+        for (i = 0; i < m; i++, n++)
+          ar[n] = tap[i] + (prv[i] - tap[i]) * delfrac;
+        if ((pos += m) >= len) pos = 0;
       }
     }
     else {
@@ -610,7 +616,7 @@ int32_t deltap3(CSOUND *csound, DELTAP *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
-    int32_t       idelsmps;
+    int32_t       idelsmps, pos, len = (int32_t) q->npts;
     MYFLT       delsmps, delfrac;
 
     if (UNLIKELY(q->auxch.auxp==NULL)) goto err1;
@@ -627,31 +633,31 @@ int32_t deltap3(CSOUND *csound, DELTAP *p)
       delsmps = *p->xdlt * csound->esr;
       idelsmps = (int32_t)delsmps;
       delfrac = delsmps - idelsmps;
-      tap = q->curp - idelsmps;
-      while (tap < begp) tap += q->npts;
-      for (n=offset; n<nsmps; n++) {
-        MYFLT ym1, y0, y1, y2;
-        if (UNLIKELY(tap >= endp))
-          tap -= q->npts;
-        if (UNLIKELY((prv = tap - 1) < begp))
-          prv += q->npts;
-        if (UNLIKELY(prv - 1 < begp))
-          y2 = *(prv-1+q->npts);
-        else
-          y2 = *(prv-1);
-        if (UNLIKELY(tap + 1 >= endp))
-          ym1 = *(tap+1-q->npts);
-        else
-          ym1 = *(tap+1);
-        y0 = *tap; y1 = *prv;
-        {
-          MYFLT w, x, y, z;
-          z = delfrac * delfrac; z--; z *= FL(0.16666666666667);
-          y = delfrac; y++; w = (y *= FL(0.5)); w--;
-          x = FL(3.0) * z; y -= x; w -= z; x -= delfrac;
-          ar[n] = (w*ym1 + x*y0 + y*y1 + z*y2) * delfrac + y0;
+      MYFLT w, x, y, z;
+      z = delfrac * delfrac; z--; z *= FL(0.16666666666667);
+      y = delfrac; y++; w = (y *= FL(0.5)); w--;
+      x = FL(3.0) * z; y -= x; w -= z; x -= delfrac;
+      pos = (int32_t) (q->curp - begp) - idelsmps;
+      while (pos < 0) pos += q->npts;
+      while (UNLIKELY(pos >= len)) pos -= len;
+      for (n=offset; n<nsmps; ) {
+        uint32_t i, m;
+        if (UNLIKELY(pos < 2 || pos + 1 >= len)) {
+          /* near either end of the buffer, wrap each index */
+          int32_t inx = (pos + 1 >= len ? pos + 1 - len : pos + 1);
+          int32_t ipv = (pos < 1 ? pos - 1 + len : pos - 1);
+          int32_t ipp = (ipv < 1 ? ipv - 1 + len : ipv - 1);
+          ar[n++] = (w*begp[inx] + x*begp[pos] + y*begp[ipv] + z*begp[ipp])
+                    * delfrac + begp[pos];
+          if (++pos >= len) pos = 0;
+          continue;
         }
-        tap++;
+        m = dline_span(pos, len - 1, nsmps - n);
+        prv = &begp[pos - 2];
+        for (i = 0; i < m; i++, n++)
+          ar[n] = (w*prv[i + 3] + x*prv[i + 2] + y*prv[i + 1] + z*prv[i])
+                  * delfrac + prv[i + 2];
+        pos += m;
       }
     }
     else {
@@ -112,17 +112,50 @@ int32_t tabler_kontrol(CSOUND *csound, TABL *p) {
 
 
 
+/* The a-rate readers work in blocks of TAB_BLOCK samples: the integer
+   indices and fractions of a whole block are computed first, with the
+   limit or power-of-two wrap applied as selects, and the table is then
+   read with gathers.  The per-sample arithmetic is unchanged, so the
+   output is the same as reading one sample at a time.  Non power-of-two
+   tables in wrap mode keep the iterative wrap. */
+#define TAB_BLOCK 32
+
+static inline void tab_index(TABL *p, const MYFLT *ndx_f, int32_t *ix,
+                             MYFLT *fr, uint32_t nb)
+{
+    int32_t len = p->len, mask = p->ftp->lenmask;
+    MYFLT offset = *p->offset, mul = p->mul;
+    uint32_t j;
+
+    for (j = 0; j < nb; j++) {
+      MYFLT tmp = (ndx_f[j] + offset)*mul;
+      ix[j] = MYFLOOR(tmp);
+      if (fr != NULL) fr[j] = tmp - ix[j];
+    }
+    if (!p->iwrap) {
+      for (j = 0; j < nb; j++)
+        ix[j] = ix[j] >= len ? len - 1 : (ix[j] < 0 ? 0 : ix[j]);
+    }
+    else if (!p->np2) {
+      for (j = 0; j < nb; j++)
+        ix[j] &= mask;
+    }
+    else {
+      for (j = 0; j < nb; j++) {
+        while(ix[j] >= len) ix[j] -= len;
+        while(ix[j] < 0)  ix[j] += len;
+      }
+    }
+}
+
 int32_t tabler_audio(CSOUND *csound, TABL *p)
 {
     IGN(csound);
-    int32_t ndx, len = p->len, n, nsmps = CS_KSMPS;
-    int32_t mask = p->ftp->lenmask;
+    uint32_t n, j, nb, nsmps = CS_KSMPS;
     MYFLT *sig = p->sig;
     MYFLT *ndx_f = p->ndx;
     MYFLT *func = p->ftp->ftable;
-    MYFLT offset = *p->offset;
-    MYFLT mul = p->mul;
-    int32_t iwrap = p->iwrap;
+    int32_t ix[TAB_BLOCK];
     uint32_t    koffset = p->h.insdshead->ksmps_offset;
     uint32_t    early  = p->h.insdshead->ksmps_no_end;
 
@@ -132,19 +165,11 @@ int32_t tabler_audio(CSOUND *csound, TABL *p)
       memset(&sig[nsmps], '\0', early*sizeof(MYFLT));
     }
 
-    for (n=koffset; n < nsmps; n++) {
-      ndx = MYFLOOR((ndx_f[n] + offset)*mul);
-      if (iwrap) {
-        if (p->np2) {
-          while(ndx >= len) ndx -= len;
-          while(ndx < 0)  ndx += len;
-        }
-        else ndx &= mask;
-      } else {
-    if (UNLIKELY(ndx >= len)) ndx = len - 1;
-    else if (UNLIKELY(ndx < 0)) ndx = 0;
-      }
-      p->sig[n] = func[ndx];
+    for (n=koffset; n < nsmps; n += nb) {
+      nb = nsmps - n < TAB_BLOCK ? nsmps - n : TAB_BLOCK;
+      tab_index(p, &ndx_f[n], ix, NULL, nb);
+      for (j = 0; j < nb; j++)
+        sig[n+j] = func[ix[j]];
     }
 
     return OK;
@@ -222,14 +247,12 @@ int32_t tableir_kontrol(CSOUND *csound, TABL *p) {
 int32_t tableir_audio(CSOUND *csound, TABL *p)
 {
     IGN(csound);
-    int32_t ndx, len    = p->len, n, nsmps = CS_KSMPS;
-    int32_t mask        = p->ftp->lenmask;
+    uint32_t n, j, nb, nsmps = CS_KSMPS;
     MYFLT *sig          = p->sig;
     MYFLT *ndx_f        = p->ndx;
     MYFLT *func         = p->ftp->ftable;
-    MYFLT offset        = *p->offset;
-    MYFLT mul           = p->mul, tmp, frac;
-    int32_t iwrap       = p->iwrap;
+    int32_t ix[TAB_BLOCK];
+    MYFLT   fr[TAB_BLOCK];
     uint32_t    koffset = p->h.insdshead->ksmps_offset;
     uint32_t    early   = p->h.insdshead->ksmps_no_end;
 
@@ -239,24 +262,14 @@ int32_t tableir_audio(CSOUND *csound, TABL *p)
       memset(&sig[nsmps], '\0', early*sizeof(MYFLT));
     }
 
-    for (n=koffset; n < nsmps; n++) {
-      MYFLT x1, x2;
-      tmp = (ndx_f[n] + offset)*mul;
-      ndx = MYFLOOR(tmp);
-      frac = tmp - ndx;
-      if (iwrap) {
-        if (p->np2) {
-          while(ndx >= len) ndx -= len;
-          while(ndx < 0)  ndx += len;
-        }
-        else ndx &= mask;
-      } else {
-        if (UNLIKELY(ndx >= len)) ndx = len - 1;
-        else if (UNLIKELY(ndx < 0)) ndx = 0;
+    for (n=koffset; n < nsmps; n += nb) {
+      nb = nsmps - n < TAB_BLOCK ? nsmps - n : TAB_BLOCK;
+      tab_index(p, &ndx_f[n], ix, fr, nb);
+      for (j = 0; j < nb; j++) {
+        MYFLT x1 = func[ix[j]];
+        MYFLT x2 = func[ix[j]+1];
+        sig[n+j] = x1 + (x2 - x1)*fr[j];
       }
-      x1 = func[ndx];
-      x2 = func[ndx+1];
-      p->sig[n] = x1 + (x2 - x1)*frac;
     }
 
     return OK;
@@ -366,14 +379,13 @@ int32_t table3r_kontrol(CSOUND *csound, TABL *p) {
 int32_t table3r_audio(CSOUND *csound, TABL *p)
 {
     IGN(csound);
-    int32_t ndx, len = p->len, n, nsmps = CS_KSMPS;
-    int32_t mask = p->ftp->lenmask;
+    int32_t len = p->len;
+    uint32_t n, j, nb, nsmps = CS_KSMPS;
     MYFLT *sig = p->sig;
     MYFLT *ndx_f = p->ndx;
     MYFLT *func = p->ftp->ftable;
-    MYFLT offset = *p->offset;
-    MYFLT mul = p->mul, tmp, frac;
-    int32_t iwrap = p->iwrap;
+    int32_t ix[TAB_BLOCK];
+    MYFLT   fr[TAB_BLOCK];
     uint32_t    koffset = p->h.insdshead->ksmps_offset;
     uint32_t    early  = p->h.insdshead->ksmps_no_end;
 
@@ -383,37 +395,29 @@ int32_t table3r_audio(CSOUND *csound, TABL *p)
       memset(&sig[nsmps], '\0', early*sizeof(MYFLT));
     }
 
-    for (n=koffset; n < nsmps; n++) {
-      MYFLT x0,x1,x2,x3,temp1,fracub,fracsq;
-      tmp = (ndx_f[n] + offset)*mul;
-      ndx = MYFLOOR(tmp);
-      frac = tmp - ndx;
-      if (iwrap) {
-        if (p->np2) {
-          while(ndx >= len) ndx -= len;
-          while(ndx < 0)  ndx += len;
+    for (n=koffset; n < nsmps; n += nb) {
+      nb = nsmps - n < TAB_BLOCK ? nsmps - n : TAB_BLOCK;
+      tab_index(p, &ndx_f[n], ix, fr, nb);
+      for (j = 0; j < nb; j++) {
+        MYFLT x0,x1,x2,x3,temp1,fracub,fracsq;
+        int32_t ndx = ix[j];
+        MYFLT frac = fr[j];
+        if (UNLIKELY(ndx<1 || ndx==len-1 || len <4)) {
+          x1 = func[ndx];
+          x2 = func[ndx+1];
+          sig[n+j] = x1 + (x2 - x1)*frac;
+        } else {
+          x0 = func[ndx-1];
+          x1 = func[ndx];
+          x2 = func[ndx+1];
+          x3 = func[ndx+2];
+          fracsq = frac*frac;
+          fracub = fracsq*x0;
+          temp1 = x3+x1+x1+x1;
+          sig[n+j] =  x1 + FL(0.5)*fracub +
+            frac*(x2 - fracub/FL(6.0) - temp1/FL(6.0) - x0/FL(3.0)) +
+            fracsq*frac*(temp1/FL(6.0) - FL(0.5)*x2) + fracsq*(FL(0.5)*x2 - x1);
         }
-        else ndx &= mask;
-      } else {
-        if (UNLIKELY(ndx >= len)) ndx = len - 1;
-        else if (UNLIKELY(ndx < 0)) ndx = 0;
-      }
-
-      if (UNLIKELY(ndx<1 || ndx==len-1 || len <4)) {
-        x1 = func[ndx];
-        x2 = func[ndx+1];
-        p->sig[n] = x1 + (x2 - x1)*frac;
-      } else {
-        x0 = func[ndx-1];
-        x1 = func[ndx];
-        x2 = func[ndx+1];
-        x3 = func[ndx+2];
-        fracsq = frac*frac;
-        fracub = fracsq*x0;
-        temp1 = x3+x1+x1+x1;
-        p->sig[n] =  x1 + FL(0.5)*fracub +
-          frac*(x2 - fracub/FL(6.0) - temp1/FL(6.0) - x0/FL(3.0)) +
-          fracsq*frac*(temp1/FL(6.0) - FL(0.5)*x2) + fracsq*(FL(0.5)*x2 - x1);
       }
     }
     return OK;
@@ -31,9 +31,38 @@
 #include <math.h>
 #include "vdelay.h"
 
+#include "delayline.h"
+
 //#define ESR     (csound->esr/FL(1000.0))
 #define ESR     (csound->esr*FL(0.001))
 
+/* Whether the delay of every sample of the block, in samples, lies in */
+/* [lo, hi].  Inside that range no read of the block touches a sample  */
+/* that the block itself overwrites later on, so the input for the     */
+/* whole block can be written to the buffer before any output is       */
+/* computed, and the reads need no more than one wrap test each.       */
+static int32_t vdel_inside(const MYFLT *del, int32_t arate, MYFLT scale,
+                           uint32_t offset, uint32_t nsmps, MYFLT lo, MYFLT hi)
+{
+    uint32_t n;
+    int32_t  ok = (offset < nsmps);
+    MYFLT    d;
+
+    if (!arate) {
+      d = *del * scale;
+      return ok & (d >= lo) & (d <= hi);
+    }
+    for (n = offset; n < nsmps; n++) {
+      d = del[n] * scale;
+      ok &= (d >= lo) & (d <= hi);
+    }
+    return ok;
+}
+
+/* The reads are computed VDEL_CHUNK samples at a time into a local */
+/* buffer, which cannot alias the delay buffer, so they vectorise.  */
+#define VDEL_CHUNK 32
+
 int32_t vdelset(CSOUND *csound, VDEL *p)            /*  vdelay set-up   */
 {
     uint32 n = (int32_t)(*p->imaxd * ESR)+1;
@@ -72,7 +101,33 @@ int32_t vdelay(CSOUND *csound, VDEL *p)               /*      vdelay  routine */
       memset(&out[nsmps], '\0', early*sizeof(MYFLT));
     }
 
-    if (IS_ASIG_ARG(p->adel)) {          /*      if delay is a-rate      */
+    if (vdel_inside(del, IS_ASIG_ARG(p->adel), esr, offset, nsmps,
+                    FL(1.0), (MYFLT) (maxd - (int32_t) nsmps - 1))) {
+      uint32_t dinc = (IS_ASIG_ARG(p->adel) ? 1 : 0);
+      /* write the whole block, then read it with at most one wrap */
+      dline_write(buf, maxd, indx, &in[offset], nsmps - offset);
+      for (nn=offset; nn<nsmps; ) {
+        MYFLT    tmp[VDEL_CHUNK];
+        uint32_t i, m = dline_span(indx, maxd, nsmps - nn);
+        m = (m < VDEL_CHUNK ? m : VDEL_CHUNK);
+        for (i = 0; i < m; i++) {
+          MYFLT  fv1, fv2;
+          int32_t   v1, v2;
+
+          fv1 = (indx + (int32_t) i) - del[(nn + i) * dinc] * esr;
+          fv1 = (fv1 < FL(0.0) ? fv1 + (MYFLT)maxd : fv1);
+          fv1 = (fv1 >= (MYFLT)maxd ? fv1 - (MYFLT)maxd : fv1);
+          fv2 = (fv1 < maxd - 1 ? fv1 + FL(1.0) : FL(0.0));
+          v1 = (int32_t)fv1;
+          v2 = (int32_t)fv2;
+          tmp[i] = buf[v1] + (fv1 - v1) * ( buf[v2] - buf[v1]);
+        }
+        memcpy(&out[nn], tmp, m * sizeof(MYFLT));
+        nn += m;
+        if ((indx += m) >= maxd) indx = 0;
+      }
+    }
+    else if (IS_ASIG_ARG(p->adel)) {     /*      if delay is a-rate      */
       for (nn=offset; nn<nsmps; nn++) {
         MYFLT  fv1, fv2;
         int32_t   v1, v2;
@@ -166,7 +221,81 @@ int32_t vdelay3(CSOUND *csound, VDEL *p)    /*  vdelay routine with cubic interp
       memset(&out[nsmps], '\0', early*sizeof(MYFLT));
     }
 
-    if (IS_ASIG_ARG(p->adel)) {              /*      if delay is a-rate      */
+    if (maxd >= 4 &&
+        vdel_inside(del, IS_ASIG_ARG(p->adel), esr, offset, nsmps,
+                    FL(2.0), (MYFLT) (maxd - (int32_t) nsmps - 3))) {
+      /* write the whole block, then read it with at most one wrap */
+      int32_t  newindx = dline_write(buf, maxd, indx, &in[offset],
+                                     nsmps - offset);
+      if (IS_ASIG_ARG(p->adel)) {
+        for (nn=offset; nn<nsmps; ) {
+          MYFLT    tmp[VDEL_CHUNK];
+          uint32_t i, m = dline_span(indx, maxd, nsmps - nn);
+          m = (m < VDEL_CHUNK ? m : VDEL_CHUNK);
+          for (i = 0; i < m; i++) {
+            MYFLT  fv1, w, x, y, z;
+            int32_t   v0, v1, v2, v3, wrap;
+
+            fv1 = del[nn + i] * (-esr);
+            v1 = (int32_t)fv1;
+            fv1 -= (MYFLT) v1;
+            v1 += indx + (int32_t) i;
+            wrap = (v1 < 0L) | (fv1 < FL(0.0));
+            fv1 = (wrap ? fv1 + FL(1.0) : fv1);
+            v1 = (wrap ? v1 - 1L : v1);
+            v1 = (v1 < 0L ? v1 + maxd : v1);
+            v2 = (v1 == (int32_t)(maxd - 1UL) ? 0L : v1 + 1L);
+            v0 = (v1 == 0 ? maxd - 1 : v1 - 1);
+            v3 = (v2 == (int32_t)maxd - 1 ? 0 : v2 + 1);
+            z = fv1 * fv1; z--; z *= FL(0.1666666667);
+            y = fv1; y++; w = (y *= FL(0.5)); w--;
+            x = FL(3.0) * z; y -= x; w -= z; x -= fv1;
+            tmp[i] = (w*buf[v0] + x*buf[v1] + y*buf[v2] + z*buf[v3])
+              * fv1 + buf[v1];
+          }
+          memcpy(&out[nn], tmp, m * sizeof(MYFLT));
+          nn += m;
+          if ((indx += m) >= maxd) indx = 0;
+        }
+      }
+      else {
+        MYFLT  fv1, w, x, y, z, *bp;
+        int32_t   v0, v1, v2, v3;
+
+        fv1 = *del * -esr; v1 = (int32_t)fv1; fv1 -= (MYFLT) v1;
+        v1 += (int32_t)indx;
+        if ((v1 < 0L) || (fv1 < FL(0.0))) {
+          fv1++; v1--; while (UNLIKELY(v1 < 0L)) v1 += (int32_t)maxd;
+        }
+        else {
+          while (UNLIKELY(v1 >= (int32_t)maxd)) v1 -= (int32_t)maxd;
+        }
+        z = fv1 * fv1; z--; z *= FL(0.1666666667);
+        y = fv1; y++; w = (y *= FL(0.5)); w--;
+        x = FL(3.0) * z; y -= x; w -= z; x -= fv1;
+        for (nn=offset; nn<nsmps; ) {
+          uint32_t i, m;
+          if (UNLIKELY(v1 < 1 || v1 + 2 >= maxd)) {
+            /* near either end of the buffer, wrap each index */
+            v2 = (v1 == (int32_t)(maxd - 1UL) ? 0L : v1 + 1L);
+            v0 = (v1 == 0L ? (int32_t)(maxd - 1UL) : v1 - 1L);
+            v3 = (v2 == (int32_t)(maxd - 1UL) ? 0L : v2 + 1L);
+            out[nn++] = (w*buf[v0] + x*buf[v1] + y*buf[v2] + z*buf[v3])
+                        * fv1 + buf[v1];
+            if (UNLIKELY(++v1 >= (int32_t)maxd)) v1 -= (int32_t)maxd;
+            continue;
+          }
+          m = dline_span(v1, maxd - 2, nsmps - nn);
+          bp = &buf[v1 - 1];
+          for (i = 0; i < m; i++, nn++)
+            out[nn] = (w*bp[i] + x*bp[i + 1] + y*bp[i + 2] + z*bp[i + 3])
+                      * fv1 + bp[i + 1];
+          v1 += m;
+        }
+      }
+      indx = newindx;
+    }
+    else if (IS_ASIG_ARG(p->adel)) {         /*      if delay is a-rate      */
       for (nn=offset; nn<nsmps; nn++) {
         MYFLT  fv1;
         int32_t   v0, v1, v2, v3;
@@ -258,6 +387,89 @@ int32_t vdelay3(CSOUND *csound, VDEL *p)    /*  vdelay routine with cubic interp
 /* vdelayx, vdelayxs, vdelayxq, vdelayxw, vdelayxws, vdelayxwq */
 /* coded by Istvan Varga, Mar 2001 */
 
+#define VDELX_LANES 16
+
+/* Windowed sinc read for vdelayx, vdelayxs and vdelayxq, used once the */
+/* input of the block is in the buffers.  The samples of the block are  */
+/* taken VDELX_LANES at a time and the loop over the window runs across */
+/* them, so each sample still sums its taps in the same order.          */
+static inline void vdelx_read(CSOUND *csound, MYFLT **buf, MYFLT **out,
+                              int32_t nch, const MYFLT *del, int32_t maxd,
+                              int32_t indx, int32_t wsize,
+                              uint32_t offset, uint32_t nsmps)
+{
+    double   x2[VDELX_LANES], d[VDELX_LANES], acc[4][VDELX_LANES];
+    int32_t  xpos[VDELX_LANES], ipos[VDELX_LANES], sinc[VDELX_LANES];
+    int32_t  c, i, i2 = (wsize >> 1);
+    double   d2x, esr = (double)csound->esr;
+    uint32_t l, nl, nn;
+
+    d2x = (1.0 - pow ((double)wsize * 0.85172, -0.89624)) / (double)(i2 * i2);
+    for (nn = offset; nn < nsmps; nn += nl) {
+      nl = (nsmps - nn < VDELX_LANES ? nsmps - nn : VDELX_LANES);
+      for (l = 0; l < nl; l++) {
+        double  x1;
+        int32_t xp;
+        /* x1: fractional part of delay time */
+        /* x2: sine of x1 (for interpolation) */
+        /* xpos: integer part of delay time (buffer position to read from) */
+        xp = indx + (int32_t) (nn - offset + l);
+        if (xp >= maxd) xp -= maxd;
+        x1 = (double)xp - ((double)del[nn + l] * esr);
+        if (x1 < 0.0) x1 += (double)maxd;
+        xp = (int32_t)x1;
+        x1 -= (double)xp;
+        x2[l] = sin (PI * x1) / PI;
+        if (xp >= maxd) xp -= maxd;
+        sinc[l] = (x1 * (1.0 - x1) > 0.00000001);
+        if (sinc[l]) {
+          xp += (1 - i2);
+          if (xp < 0) xp += maxd;
+          d[l] = (double)(1 - i2) - x1;
+          ipos[l] = xp;
+        }
+        else {                                          /* integer sample */
+          ipos[l] = (int32_t)((double)xp + x1 + 0.5);   /* position */
+          if (ipos[l] >= maxd) ipos[l] -= maxd;
+          d[l] = 0.5;           /* not used, but keeps the weights finite */
+        }
+        xpos[l] = ipos[l];
+        for (c = 0; c < nch; c++)
+          acc[c][l] = 0.0;
+      }
+      for (i = i2; i--;) {
+        for (l = 0; l < nl; l++) {
+          double  w;
+          int32_t xp = xpos[l];
+          w = 1.0 - d[l]*d[l]*d2x; w *= (w / d[l]); d[l] += 1.0;
+          for (c = 0; c < nch; c++)
+            acc[c][l] += (double)buf[c][xp] * w;
+          xp = (xp + 1 >= maxd ? xp + 1 - maxd : xp + 1);
+          w = 1.0 - d[l]*d[l]*d2x; w *= (w / d[l]); d[l] += 1.0;
+          for (c = 0; c < nch; c++)
+            acc[c][l] -= (double)buf[c][xp] * w;
+          xpos[l] = (xp + 1 >= maxd ? xp + 1 - maxd : xp + 1);
+        }
+      }
+      for (c = 0; c < nch; c++)
+        for (l = 0; l < nl; l++)
+          out[c][nn + l] = (sinc[l] ? (MYFLT) (acc[c][l] * x2[l])
+                                    : buf[c][ipos[l]]);
+    }
+}
+
+/* Input for the whole block can go to the buffers first if the window */
+/* of every read lies behind the write position and clear of what the  */
+/* rest of the block overwrites.                                        */
+static inline int32_t vdelx_inside(CSOUND *csound, const MYFLT *del,
+                                   int32_t maxd, int32_t wsize,
+                                   uint32_t offset, uint32_t nsmps)
+{
+    int32_t i2 = (wsize >> 1);
+    return vdel_inside(del, 1, csound->esr, offset, nsmps, (MYFLT) i2,
+                       (MYFLT) (maxd - (int32_t) nsmps - i2 - 1));
+}
+
 int32_t vdelxset(CSOUND *csound, VDELX *p)      /*  vdelayx set-up (1 channel) */
 {
     uint32_t n = (int32_t)(*p->imaxd * csound->esr);
@@ -365,6 +577,14 @@ int32_t vdelayx(CSOUND *csound, VDELX *p)               /*      vdelayx routine
       memset(&out1[nsmps], '\0', early*sizeof(MYFLT));
     }
 
+    if (vdelx_inside(csound, del, maxd, wsize, offset, nsmps)) {
+      int32_t newindx = dline_write(buf1, maxd, indx, &in1[offset],
+                                    nsmps - offset);
+      vdelx_read(csound, &buf1, &out1, 1, del, maxd, indx, wsize,
+                 offset, nsmps);
+      p->left = newindx;
+      return OK;
+    }
     for (nn=offset; nn<nsmps; nn++) {
       buf1[indx] = in1[nn];
       n1 = 0.0;
@@ -512,6 +732,17 @@ int32_t vdelayxs(CSOUND *csound, VDELXS *p)     /*      vdelayxs routine  */
       memset(&out2[nsmps], '\0', early*sizeof(MYFLT));
     }
 
+    if (vdelx_inside(csound, del, maxd, wsize, offset, nsmps)) {
+      MYFLT   *bufs[2], *outs[2];
+      int32_t newindx;
+      bufs[0] = buf1; bufs[1] = buf2; outs[0] = out1; outs[1] = out2;
+      newindx = dline_write(buf1, maxd, indx, &in1[offset], nsmps - offset);
+      dline_write(buf2, maxd, indx, &in2[offset], nsmps - offset);
+      vdelx_read(csound, bufs, outs, 2, del, maxd, indx, wsize,
+                 offset, nsmps);
+      p->left = newindx;
+      return OK;
+    }
     for (n=offset; n<nsmps; n++) {
       buf1[indx] = in1[n]; buf2[indx] = in2[n];
       n1 = 0.0; n2 = 0.0;
@@ -679,6 +910,20 @@ int32_t vdelayxq(CSOUND *csound, VDELXQ *p)     /*      vdelayxq routine  */
       memset(&out4[nsmps], '\0', early*sizeof(MYFLT));
     }
 
+    if (vdelx_inside(csound, del, maxd, wsize, offset, nsmps)) {
+      MYFLT   *bufs[4], *outs[4];
+      int32_t newindx;
+      bufs[0] = buf1; bufs[1] = buf2; bufs[2] = buf3; bufs[3] = buf4;
+      outs[0] = out1; outs[1] = out2; outs[2] = out3; outs[3] = out4;
+      newindx = dline_write(buf1, maxd, indx, &in1[offset], nsmps - offset);
+      dline_write(buf2, maxd, indx, &in2[offset], nsmps - offset);
+      dline_write(buf3, maxd, indx, &in3[offset], nsmps - offset);
+      dline_write(buf4, maxd, indx, &in4[offset], nsmps - offset);
+      vdelx_read(csound, bufs, outs, 4, del, maxd, indx, wsize,
+                 offset, nsmps);
+      p->left = newindx;
+      return OK;
+    }
     for (n=offset; n<nsmps; n++) {
       buf1[indx] = in1[n]; buf2[indx] = in2[n];
       buf3[indx] = in3[n]; buf4[indx] = in4[n];
@@ -853,7 +1098,7 @@ int32_t multitap_set(CSOUND *csound, MDEL *p)
 
 int32_t multitap_play(CSOUND *csound, MDEL *p)
 {                               /* assign object data to local variables   */
-    int32_t  indx = p->left, delay;
+    int32_t  indx = p->left, delay, fast;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t i, n, nsmps = CS_KSMPS;
@@ -867,6 +1112,27 @@ int32_t multitap_play(CSOUND *csound, MDEL *p)
       nsmps -= early;
       memset(&out[nsmps], '\0', early*sizeof(MYFLT));
     }
+    /* If every tap is at least one sample and no more than max-nsmps+1 */
+    /* samples back, write the block first and then add each tap in as  */
+    /* a whole, split once where it wraps.                              */
+    for (i = 0, fast = (offset < nsmps); fast && i < p->INOCOUNT - 1; i += 2) {
+      delay = (int32_t)(csound->esr * *p->ndel[i]);
+      fast = (delay >= 1 && delay <= p->max - (int32_t) nsmps + 1);
+    }
+    if (fast) {
+      int32_t  len = p->max, next;
+      next = dline_write(buf, len, indx, &in[offset], nsmps - offset);
+      memset(&out[offset], '\0', (nsmps - offset)*sizeof(MYFLT));
+      if (UNLIKELY(++indx == len)) indx = 0;
+      for (i = 0; i < p->INOCOUNT - 1; i += 2) {
+        delay = indx - (int32_t)(csound->esr * *p->ndel[i]);
+        if (UNLIKELY(delay < 0))
+          delay += len;
+        dline_mix(&out[offset], buf, len, delay, *p->ndel[i+1], nsmps - offset);
+      }
+      p->left = next;
+      return OK;
+    }
     for (n=offset; n<nsmps; n++) {
       MYFLT v = FL(0.0);
       buf[indx] = in[n];        /*      Write input     */
@@ -1155,7 +1421,7 @@ int32_t reverbx(CSOUND *csound, NREV2 *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
-    MYFLT   *in, *out = p->out, *buf, *end;
+    MYFLT   *in, *out = p->out, *buf;
     MYFLT   gain, z;
     MYFLT   hdif = *p->hdif;
     MYFLT   time = *p->time;
@@ -1198,38 +1464,48 @@ int32_t reverbx(CSOUND *csound, NREV2 *p)
     }
 
     for (i = 0; i < numCombs; i++) {
-      buf = p->pcbuf_cur[i];
-      end = p->cbuf_cur[i + 1];
+      MYFLT   *beg = p->cbuf_cur[i], zi = p->z[i], gi = p->g[i];
+      int32_t pos = (int32_t) (p->pcbuf_cur[i] - beg);
+      int32_t len = (int32_t) (p->cbuf_cur[i + 1] - beg);
       gain = p->c_gain[i];
       in = (MYFLT*) p->temp.auxp;
       out = p->out;
-      for (n=offset;n<nsmps;n++) {
-        out[n] += *buf;
-        *buf += p->z[i] * p->g[i];
-        p->z[i] = *buf;
-        *buf *= gain;
-        *buf += in[n];
-        if (UNLIKELY(++buf >= end))
-          buf = (MYFLT*) p->cbuf_cur[i];
+      for (n=offset;n<nsmps;) {
+        uint32_t k, m = dline_span(pos, len, nsmps - n);
+        buf = &beg[pos];
+        for (k = 0; k < m; k++, n++) {
+          z = buf[k];
+          out[n] += z;
+          z += zi * gi;
+          zi = z;
+          z *= gain;
+          buf[k] = z + in[n];
+        }
+        if ((pos += m) >= len) pos = 0;
       }
-      p->pcbuf_cur[i] = buf;
+      p->z[i] = zi;
+      p->pcbuf_cur[i] = &beg[pos];
     }
 
     for (i = 0; i < numAlpas; i++) {
+      MYFLT   *beg = p->abuf_cur[i];
+      int32_t pos = (int32_t) (p->pabuf_cur[i] - beg);
+      int32_t len = (int32_t) (p->abuf_cur[i + 1] - beg);
       in = (MYFLT*) p->temp.auxp;
       out = p->out;
       memcpy(in+offset, out+offset, (nsmps-offset)*sizeof(MYFLT));
-      buf = p->pabuf_cur[i];
-      end = p->abuf_cur[i + 1];
       gain = p->a_gain[i];
-      for (n=offset;n<nsmps;n++) {
-        z = *buf;
-        *buf = gain * z + in[n];
-        out[n] = z - gain * *buf;
-        if (UNLIKELY(++buf >= end))
-          buf = (MYFLT*) p->abuf_cur[i];
+      for (n=offset;n<nsmps;) {
+        uint32_t k, m = dline_span(pos, len, nsmps - n);
+        buf = &beg[pos];
+        for (k = 0; k < m; k++, n++) {
+          z = buf[k];
+          buf[k] = gain * z + in[n];
+          out[n] = z - gain * buf[k];
+        }
+        if ((pos += m) >= len) pos = 0;
       }
-      p->pabuf_cur[i] = buf;
+      p->pabuf_cur[i] = &beg[pos];
     }
 
     return OK;
@@ -64,20 +64,39 @@ typedef struct {
 } OSCSEND;
 
 
+/* Messages received by a listener are kept in slots preallocated when  */
+/* the opcode starts, so that the liblo thread neither allocates memory */
+/* nor waits for the opcodes.  Strings and blobs are copied to the      */
+/* bytes that follow each slot, or to the heap if they do not fit.      */
+
+#define OSC_QUEUE_SLOTS (256)   /* default messages waiting per listener */
+#define OSC_SLOT_BYTES  (1024)  /* default string and blob bytes per message */
+
+#define OSC_DROP_NEWEST (0)     /* when a listener's slots are all in use */
+#define OSC_DROP_OLDEST (1)
+
 typedef struct osc_pat {
-    struct osc_pat *next;
+    void    *heap;              /* strings and blobs that did not fit */
     union {
       MYFLT number;
-      STRINGDAT string;
-      void     *blob;
+      char  *string;
+      void  *blob;
     } args[ARG_CNT-1];
 } OSC_PAT;
 
 typedef struct {
     lo_server_thread thread;
     CSOUND  *csound;
-    void    *mutex_;
+    void    *mutex_;            /* only held while listeners are added */
+                                /* or removed, and by the liblo thread */
     void    *oplst;             /* list of opcodes listening on this port */
+    int32_t qslots;             /* queue settings for new listeners */
+    int32_t qbytes;
+    int32_t policy;
+    long    received;           /* statistics, written by the liblo thread */
+    long    dropped;
+    long    overwritten;
+    long    oversize;
 } OSC_PORT;
 
 /* structure for global variables */
@@ -87,7 +106,7 @@ typedef struct {
     /* for OSCinit/OSClisten */
     int32_t   nPorts;
     OSC_PORT  *ports;
-    int32_t   osccounter;
+    long      osccounter;
     void      *mutex_;
 } OSC_GLOBALS;
 
@@ -109,8 +128,16 @@ typedef struct osclcommon {
     lo_method method;
     char    *saved_path;
     char    saved_types[ARG_CNT];    /* copy of type list */
-    OSC_PAT *patterns;          /* FIFO list of pending messages */
-    OSC_PAT *freePatterns;      /* free message stack */
+    /* slot numbers go to the opcode through queue, and back to the   */
+    /* liblo thread through freeq; with OSC_DROP_OLDEST both threads   */
+    /* may take the oldest message, so qhead is only changed by CAS    */
+    char    *slots;
+    size_t  slotSize;
+    size_t  slotBytes;          /* string and blob bytes in each slot */
+    long    nslots, mask;
+    long    *queue, *freeq;     /* mask + 1 entries each */
+    long    qhead, qtail, fhead, ftail;
+    int32_t policy;
     struct osclcomon *nxt;       /* pointer to next opcode on the same port */
 } OSCLCOMMON;
 
@@ -136,6 +163,22 @@ typedef struct {
     OSCLCOMMON c;
 } OSCLISTENA;
 
+typedef struct {
+    OPDS    h;                  /* default header */
+    MYFLT   *ihandle;
+    MYFLT   *islots;            /* messages waiting per listener */
+    MYFLT   *ipolicy;           /* 0: drop new messages, 1: drop oldest */
+    MYFLT   *ibytes;            /* string and blob bytes per message */
+} OSCBUFFER;
+
+typedef struct {
+    OPDS    h;                  /* default header */
+    MYFLT   *kreceived, *kdropped, *koverwritten, *koversize;
+    MYFLT   *ihandle;
+    OSC_GLOBALS *g;
+    int32_t n;
+} OSCSTATS;
+
 static int32_t oscsend_deinit(CSOUND *csound, OSCSEND *p)
 {
     lo_address a = (lo_address)p->addr;
@@ -436,29 +479,110 @@ static CS_NOINLINE OSC_GLOBALS *alloc_globals(CSOUND *csound)
 
  /* ------------------------------------------------------------------------ */
 
-static CS_NOINLINE OSC_PAT *alloc_pattern(CSOUND *csound)
+#define OSC_SLOT(o, n)  ((OSC_PAT*) ((o)->slots + (size_t) (n) * (o)->slotSize))
+
+/* allocate the message slots of a listener, all of them free */
+
+static void alloc_slots(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *o)
+{
+    long    i, n = (port->qslots > 0 ? port->qslots : OSC_QUEUE_SLOTS);
+    size_t  bytes = 0;
+    for (i = 0; o->saved_types[i] != '\0'; i++)
+      if (o->saved_types[i] == 's' || o->saved_types[i] == 'b')
+        bytes = (port->qbytes > 0 ? (size_t) port->qbytes : OSC_SLOT_BYTES);
+    if (n < 2) n = 2;
+    o->mask = 1;
+    while (o->mask < n) o->mask <<= 1;
+    o->mask--;
+    o->nslots = n;
+    o->slotBytes = bytes;
+    o->slotSize = sizeof(OSC_PAT) + ((bytes + 7) & ~((size_t) 7));
+    o->slots = (char*) csound->Calloc(csound, (size_t) n * o->slotSize);
+    o->queue = (long*) csound->Calloc(csound, sizeof(long) * (o->mask + 1));
+    o->freeq = (long*) csound->Calloc(csound, sizeof(long) * (o->mask + 1));
+    for (i = 0; i < n; i++)
+      o->freeq[i] = i;
+    o->qhead = o->qtail = 0;
+    o->fhead = 0;
+    o->ftail = n;
+    o->policy = port->policy;
+}
+
+static void free_slots(CSOUND *csound, OSCLCOMMON *o)
 {
-    OSC_PAT *p;
-    size_t  nbytes;
+    long i;
+    if (o->slots == NULL) return;
+    for (i = 0; i < o->nslots; i++)
+      if (OSC_SLOT(o, i)->heap != NULL)
+        csound->Free(csound, OSC_SLOT(o, i)->heap);
+    csound->Free(csound, o->slots);
+    csound->Free(csound, o->queue);
+    csound->Free(csound, o->freeq);
+    o->slots = NULL;
+}
 
-    /* number of bytes to allocate */
-    nbytes = sizeof(OSC_PAT);
-    /* allocate and initialise structure */
-    p = (OSC_PAT*) csound->Calloc(csound, nbytes);
+/* take the oldest message from the queue; -1 if it is empty */
 
-    return p;
+static long pop_slot(OSCLCOMMON *o)
+{
+    for (;;) {
+      long h = ATOMIC_GET(o->qhead), h1 = h + 1, n;
+      if (h == ATOMIC_GET(o->qtail))
+        return -1;
+      /* may be stale if the other thread took it first, then the CAS fails */
+      n = ATOMIC_GET(o->queue[h & o->mask]);
+      if (!ATOMIC_CMP_XCH(&o->qhead, h1, h))
+        return n;
+    }
 }
 
-static inline OSC_PAT *get_pattern(CSOUND *csound,OSCLCOMMON *pp)
+/* return a slot to the liblo thread; opcode side only */
+
+static inline void release_slot(OSCLCOMMON *o, long n)
 {
-    OSC_PAT *p;
+    long t = o->ftail;
+    o->freeq[t & o->mask] = n;
+    ATOMIC_SET(o->ftail, t + 1);
+}
 
-    if (pp->freePatterns != NULL) {
-      p = pp->freePatterns;
-      pp->freePatterns = p->next;
-      return p;
+/* done with a message taken by pop_slot(); opcode side only */
+
+static void OSC_release(CSOUND *csound, OSCLCOMMON *o, long n)
+{
+    OSC_PAT     *m = OSC_SLOT(o, n);
+    OSC_GLOBALS *g = alloc_globals(csound);
+    if (m->heap != NULL) {
+      csound->Free(csound, m->heap);
+      m->heap = NULL;
     }
-    return alloc_pattern(csound);
+    release_slot(o, n);
+    ATOMIC_DECR(g->osccounter);
+}
+
+/* get a slot for a new message, or -1 to drop it; liblo thread only */
+
+static long get_slot(CSOUND *csound, OSC_PORT *pp, OSCLCOMMON *o,
+                     int32_t *replaced)
+{
+    long h = o->fhead, n;
+    *replaced = 0;
+    if (h != ATOMIC_GET(o->ftail)) {
+      n = o->freeq[h & o->mask];
+      ATOMIC_SET(o->fhead, h + 1);
+      return n;
+    }
+    if (o->policy == OSC_DROP_OLDEST && (n = pop_slot(o)) >= 0) {
+      OSC_PAT *m = OSC_SLOT(o, n);
+      if (m->heap != NULL) {
+        csound->Free(csound, m->heap);
+        m->heap = NULL;
+      }
+      ATOMIC_INCR(pp->overwritten);
+      *replaced = 1;
+      return n;
+    }
+    ATOMIC_INCR(pp->dropped);
+    return -1;
 }
 
 typedef struct {
@@ -469,7 +593,7 @@ typedef struct {
 static int32_t OSCcounter(CSOUND *csound, OSCcount *p)
 {
     OSC_GLOBALS *g = alloc_globals(csound);
-    *p->ans = (MYFLT)g->osccounter;
+    *p->ans = (MYFLT) ATOMIC_GET(g->osccounter);
     return OK;
 }
 
@@ -492,22 +616,29 @@ static int32_t OSC_handler(const char *path, const char *types,
           strcmp(o->saved_types, types) == 0) {
         /* Message is for this guy */
         int32_t     i;
+        long        n;
+        int32_t     replaced;
+        size_t      bytes = 0;
+        char        *dst;
         OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        pp->csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        pp->csound->UnlockMutex(g->mutex_);
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
+        ATOMIC_INCR(pp->received);
+        n = get_slot(csound, pp, o, &replaced);
+        if (n >= 0) {
+          OSC_GLOBALS *g = alloc_globals(csound);
+          m = OSC_SLOT(o, n);
+          /* strings and blobs go after the slot if they fit */
+          for (i = 0; o->saved_types[i] != '\0'; i++) {
+            if (types[i] == 's')
+              bytes += (strlen((char*) &(argv[i]->s)) + 8) & ~((size_t) 7);
+            else if (types[i] == 'b')
+              bytes += ((size_t) lo_blobsize((lo_blob*)argv[i]) + 7)
+                       & ~((size_t) 7);
+          }
+          if (bytes <= o->slotBytes)
+            dst = (char*) (m + 1);
           else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
+            dst = m->heap = csound->Malloc(csound, bytes);
+            ATOMIC_INCR(pp->oversize);
           }
           /* copy argument list */
           for (i = 0; o->saved_types[i] != '\0'; i++) {
@@ -524,25 +655,20 @@ static int32_t OSC_handler(const char *path, const char *types,
             case 'd':
                m->args[i].number= (MYFLT) argv[i]->d; break;
             case 's':
-              { // ***NO CHECK THAT m->args[i] IS A STRING
-                char  *src = (char*) &(argv[i]->s), *dst = m->args[i].string.data;
-                if (m->args[i].string.size <= (int32_t) strlen(src)) {
-                  if (dst != NULL) csound->Free(csound, dst);
-                  dst = csound->Strdup(csound, src);
-                  // who sets m->args[i].string.size ??
-                  m->args[i].string.data = dst;
-                  m->args[i].string.size = strlen(dst)+1;
-                }
-                else strcpy(dst, src);
+              {
+                size_t len = strlen((char*) &(argv[i]->s)) + 1;
+                memcpy(dst, &(argv[i]->s), len);
+                m->args[i].string = dst;
+                dst += (len + 7) & ~((size_t) 7);
                 break;
               }
             case 'b':
               {
                 int32_t len =
                   lo_blobsize((lo_blob*)argv[i]);
-                m->args[i].blob =
-                  csound->Malloc(csound,len);
-                memcpy(m->args[i].blob, argv[i], len);
+                memcpy(dst, argv[i], len);
+                m->args[i].blob = dst;
+                dst += ((size_t) len + 7) & ~((size_t) 7);
 #ifdef OSC_DEBUG
                 {
                   lo_blob *bb = (lo_blob*)m->args[i].blob;
@@ -555,8 +681,17 @@ static int32_t OSC_handler(const char *path, const char *types,
               }
             }
           }
-          retval = 0;
+          /* queue message for being read by OSClisten opcode; a */
+          /* message that was overwritten was counted already    */
+          {
+            long t = o->qtail;
+            ATOMIC_SET(o->queue[t & o->mask], n);
+            ATOMIC_SET(o->qtail, t + 1);
+          }
+          if (!replaced)
+            ATOMIC_INCR(g->osccounter);
         }
+        retval = 0;
         break;
       }
       o = (OSCLCOMMON*) o->nxt;
@@ -603,6 +738,11 @@ static int32_t osc_listener_init(CSOUND *csound, OSCINIT *p)
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
     ports[n].oplst = NULL;
+    ports[n].qslots = OSC_QUEUE_SLOTS;
+    ports[n].qbytes = OSC_SLOT_BYTES;
+    ports[n].policy = OSC_DROP_NEWEST;
+    ports[n].received = ports[n].dropped = 0;
+    ports[n].overwritten = ports[n].oversize = 0;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new(buff, OSC_error);
     if (UNLIKELY(ports[n].thread==NULL))
@@ -638,6 +778,11 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
     ports[n].csound = csound;
     ports[n].mutex_ = csound->Create_Mutex(0);
     ports[n].oplst = NULL;
+    ports[n].qslots = OSC_QUEUE_SLOTS;
+    ports[n].qbytes = OSC_SLOT_BYTES;
+    ports[n].policy = OSC_DROP_NEWEST;
+    ports[n].received = ports[n].dropped = 0;
+    ports[n].overwritten = ports[n].oversize = 0;
     snprintf(buff, 32, "%d", (int32_t) *(p->port));
     ports[n].thread = lo_server_thread_new_multicast(p->group->data,
                                                      buff, OSC_error);
@@ -663,8 +808,6 @@ static int32_t osc_listener_initMulti(CSOUND *csound, OSCINITM *p)
 
 static int32_t OSC_listendeinit(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *p)
 {
-    OSC_PAT *m;
-
     if (port->mutex_==NULL) return NOTOK;
     csound->LockMutex(port->mutex_);
     if (port->oplst == (void*)p)
@@ -685,20 +828,8 @@ static int32_t OSC_listendeinit(CSOUND *csound, OSC_PORT *port, OSCLCOMMON *p)
     csound->Free(csound, p->saved_path);
     p->saved_path = NULL;
     p->nxt = NULL;
-    m = p->patterns;
-    p->patterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
-    m = p->freePatterns;
-    p->freePatterns = NULL;
-    while (m != NULL) {
-      OSC_PAT *mm = m->next;
-      csound->Free(csound, m);
-      m = mm;
-    }
+    /* the liblo thread cannot reach the slots once unlinked */
+    free_slots(csound, p);
     return OK;
 }
 
@@ -772,6 +903,7 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
+    alloc_slots(csound, p->port, &p->c);
     csound->LockMutex(p->port->mutex_);
     p->c.nxt = p->port->oplst;
     p->port->oplst = (void*) &p->c;
@@ -787,25 +919,17 @@ static int32_t OSC_list_init(CSOUND *csound, OSCLISTEN *p)
 static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
 {
     OSC_PAT *m;
+    long    n = pop_slot(&p->c);
 
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
-    if (m != NULL) {
+    if (n >= 0) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
+      m = OSC_SLOT(&p->c, n);
       /* copy arguments */
       //printf("copying args\n");
       for (i = 0; p->c.saved_types[i] != '\0'; i++) {
         //printf("%d: type %c\n", i, p->c.saved_types[i]);
         if (p->c.saved_types[i] == 's') {
-          char *src = m->args[i].string.data;
+          char *src = m->args[i].string;
           char *dst = ((STRINGDAT*) p->args[i])->data;
           if (src != NULL) {
             if (((STRINGDAT*) p->args[i])->size <= (int32_t) strlen(src)){
@@ -883,12 +1007,14 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
             MYFLT *data = (MYFLT *) idata;
             int32_t fno = MYFLT2LRND(*p->args[i]);
             FUNC *ftp;
-            if (UNLIKELY(fno <= 0))
+            if (UNLIKELY(fno <= 0)) {
+              OSC_release(csound, &p->c, n);
               return csound->PerfError(csound, &(p->h),
                                        Str("Invalid ftable no. %d"), fno);
-
+            }
             ftp = csound->FTnp2Find(csound, p->args[i]);
             if (UNLIKELY(ftp==NULL)) {
+              OSC_release(csound, &p->c, n);
               return csound->PerfError(csound, &(p->h),
                                        "%s", Str("OSC internal error"));
             }
@@ -931,93 +1057,24 @@ static int32_t OSC_list(CSOUND *csound, OSCLISTEN *p)
           }
           else if (c == 'S') {
           }
-          else return csound->PerfError(csound,  &(p->h), "Oh dear");
-          csound->Free(csound, m->args[i].blob);
+          else {
+            OSC_release(csound, &p->c, n);
+            return csound->PerfError(csound,  &(p->h), "Oh dear");
+          }
         }
         else
           *(p->args[i]) = m->args[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      OSC_release(csound, &p->c, n);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
 /* ******** ARRAY VERSION **** EXPERIMENTAL *** */
 
-static int32_t OSC_ahandler(const char *path, const char *types,
-                       lo_arg **argv, int32_t argc, void *data, void *p)
-{
-    IGN(argc);  IGN(data);
-    OSC_PORT  *pp = (OSC_PORT*) p;
-    OSCLCOMMON *o;
-    CSOUND    *csound = (CSOUND *) pp->csound;
-    int32_t   retval = 1;
-    //printf("***in ahandler\n");
-    csound->LockMutex(pp->mutex_);
-    o = (OSCLCOMMON*) pp->oplst;
-    //printf("opst=%p\n", o);
-    while (o != NULL) {
-      //printf("Looking at %s/%s against %s/%s\n",
-      //       o->saved_path, path,o->saved_types, types);
-      if (strcmp(o->saved_path, path) == 0 &&
-          strcmp(o->saved_types, types) == 0) {
-        /* Message is for this guy */
-        int32_t     i;
-        OSC_PAT *m;
-        OSC_GLOBALS *g = alloc_globals(csound);
-        csound->LockMutex(g->mutex_);
-        g->osccounter++;
-        csound->UnlockMutex(g->mutex_);
-        //printf("handler found message\n");
-        m = get_pattern(csound, o);
-        if (m != NULL) {
-          /* queue message for being read by OSClisten opcode */
-          m->next = NULL;
-          if (o->patterns == NULL)
-            o->patterns = m;
-          else {
-            OSC_PAT *mm;
-            for (mm = o->patterns; mm->next != NULL; mm = mm->next)
-              ;
-            mm->next = m;
-          }
-          /* copy argument list */
-          for (i = 0; o->saved_types[i] != '\0'; i++) {
-            switch (types[i]) {
-            default:              /* Should not happen */
-            case 'i':
-              m->args[i].number = (MYFLT) argv[i]->i; break;
-            case 'h':
-              m->args[i].number = (MYFLT) argv[i]->i64; break;
-            case 'c':
-              m->args[i].number= (MYFLT) argv[i]->c; break;
-            case 'f':
-              m->args[i].number = (MYFLT) argv[i]->f; break;
-            case 'd':
-              m->args[i].number= (MYFLT) argv[i]->d; break;
-            }
-          }
-          retval = 0;
-        }
-        break;
-      }
-      o = (OSCLCOMMON*) o->nxt;
-    }
-
-    pp->csound->UnlockMutex(pp->mutex_);
-    return retval;
-}
-
 #include "arrays.h"
 
 static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
@@ -1052,13 +1109,14 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
         return csound->InitError(csound, "%s", Str("invalid type"));
       }
     }
+    alloc_slots(csound, p->port, &p->c);
     csound->LockMutex(p->port->mutex_);
     p->c.nxt = p->port->oplst;
     p->port->oplst = (void*) &p->c;
     csound->UnlockMutex(p->port->mutex_);
     p->c.method = lo_server_thread_add_method(p->port->thread,
                                               p->c.saved_path, p->c.saved_types,
-                                              OSC_ahandler, p->port);
+                                              OSC_handler, p->port);
     csound->RegisterDeinitCallback(csound, p,
                                    (int32_t (*)(CSOUND *, void *)) OSC_listadeinit);
     return OK;
@@ -1067,39 +1125,71 @@ static int32_t OSC_alist_init(CSOUND *csound, OSCLISTENA *p)
 static int32_t OSC_alist(CSOUND *csound, OSCLISTENA *p)
 {
     OSC_PAT *m;
-    /* quick check for empty queue */
-    if (p->c.patterns == NULL) {
-      *p->kans = 0;
-      return OK;
-    }
-    csound->LockMutex(p->port->mutex_);
-    m = p->c.patterns;
-    /* check again for thread safety */
-    if (m != NULL) {
+    long    n = pop_slot(&p->c);
+
+    if (n >= 0) {
       int32_t i;
-      /* unlink from queue */
-      p->c.patterns = m->next;
+      m = OSC_SLOT(&p->c, n);
       /* copy arguments */
       //printf("copying args\n");
       for (i = 0; p->c.saved_types[i] != '\0'; i++) {
         //printf("%d: type %c\n", i, p->c.saved_types[i]);
         ((MYFLT*)p->args->data)[i] = m->args[i].number;
       }
-      /* push to stack of free message structures */
-      m->next = p->c.freePatterns;
-      p->c.freePatterns = m;
+      OSC_release(csound, &p->c, n);
       *p->kans = 1;
-      OSC_GLOBALS *g = alloc_globals(csound);
-      csound->LockMutex(g->mutex_);
-      g->osccounter--;
-      csound->UnlockMutex(g->mutex_);
     }
     else
       *p->kans = 0;
-    csound->UnlockMutex(p->port->mutex_);
     return OK;
 }
 
+/* OSCbuffer ihandle, islots[, ipolicy[, ibytes]]: queue settings for */
+/* the listeners started on a port from now on                        */
+
+static int32_t OSC_buffer(CSOUND *csound, OSCBUFFER *p)
+{
+    OSC_GLOBALS *pp =
+      (OSC_GLOBALS*) csound->QueryGlobalVariable(csound, "_OSC_globals");
+    int32_t n = (int32_t) *p->ihandle;
+    if (UNLIKELY(pp == NULL))
+      return csound->InitError(csound, "%s", Str("OSC not running"));
+    if (UNLIKELY(n < 0 || n >= pp->nPorts))
+      return csound->InitError(csound, "%s", Str("invalid handle"));
+    if (UNLIKELY(*p->islots < 2))
+      return csound->InitError(csound, "%s", Str("OSCbuffer: too few slots"));
+    pp->ports[n].qslots = (int32_t) *p->islots;
+    pp->ports[n].policy = (*p->ipolicy != FL(0.0) ?
+                           OSC_DROP_OLDEST : OSC_DROP_NEWEST);
+    pp->ports[n].qbytes = (*p->ibytes > FL(0.0) ?
+                           (int32_t) *p->ibytes : OSC_SLOT_BYTES);
+    return OK;
+}
+
+/* messages received, dropped, overwritten and too large for their slot */
+
+static int32_t OSC_stats(CSOUND *csound, OSCSTATS *p)
+{
+    OSC_PORT *port = &(p->g->ports[p->n]);
+    IGN(csound);
+    *p->kreceived = (MYFLT) ATOMIC_GET(port->received);
+    *p->kdropped = (MYFLT) ATOMIC_GET(port->dropped);
+    *p->koverwritten = (MYFLT) ATOMIC_GET(port->overwritten);
+    *p->koversize = (MYFLT) ATOMIC_GET(port->oversize);
+    return OK;
+}
+
+static int32_t OSC_stats_init(CSOUND *csound, OSCSTATS *p)
+{
+    p->g = (OSC_GLOBALS*) csound->QueryGlobalVariable(csound, "_OSC_globals");
+    p->n = (int32_t) *p->ihandle;
+    if (UNLIKELY(p->g == NULL))
+      return csound->InitError(csound, "%s", Str("OSC not running"));
+    if (UNLIKELY(p->n < 0 || p->n >= p->g->nPorts))
+      return csound->InitError(csound, "%s", Str("invalid handle"));
+    return OSC_stats(csound, p);
+}
+
 
 
 #define S(x)    sizeof(x)
@@ -1118,7 +1208,11 @@ static OENTRY localops[] = {
   { "OSClisten", S(OSCLISTENA),0, 3, "kk[]", "iSS",
     (SUBR)OSC_alist_init, (SUBR)OSC_alist, NULL, NULL },
   { "OSCcount", S(OSCcount), 0, 3, "k", "",
-    (SUBR)OSCcounter, (SUBR)OSCcounter, NULL }
+    (SUBR)OSCcounter, (SUBR)OSCcounter, NULL },
+  { "OSCbuffer", S(OSCBUFFER), 0, 1, "", "iioo",
+    (SUBR)OSC_buffer, NULL, NULL, NULL },
+  { "OSCstats", S(OSCSTATS), 0, 3, "kkkk", "i",
+    (SUBR)OSC_stats_init, (SUBR)OSC_stats, NULL, NULL }
 };
 
 PUBLIC int64_t csound_opcode_init(CSOUND *csound, OENTRY **ep)
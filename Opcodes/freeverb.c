@@ -81,7 +81,7 @@ typedef struct {
     MYFLT           *iSkipInit;
     freeVerbComb    *Comb[NR_COMB][2];
     freeVerbAllPass *AllPass[NR_ALLPASS][2];
-    MYFLT           *tmpBuf;
+    MYFLT           *tmpBuf[2];     /* comb/allpass output, L and R */
     AUXCH           auxData;
     MYFLT           prvDampFactor;
     double          dampValue;
@@ -128,7 +128,7 @@ static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
       nbytes += allpass_nbytes(p, allpass_delays[i][0]);
       nbytes += allpass_nbytes(p, allpass_delays[i][1]);
     }
-    nbytes += (int32_t) sizeof(MYFLT) * (int32_t) CS_KSMPS;
+    nbytes += 2 * (int32_t) sizeof(MYFLT) * (int32_t) CS_KSMPS;
     /* allocate space if size has changed */
     if (nbytes != (int32_t) p->auxData.size)
       csound->AuxAlloc(csound, (int32) nbytes, &(p->auxData));
@@ -159,7 +159,8 @@ static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
         allpassp->buf[j] = FL(0.0);
       nbytes += allpass_nbytes(p, allpass_delays[i >> 1][i & 1]);
     }
-    p->tmpBuf = (MYFLT*) ((unsigned char*)p->auxData.auxp + (int32_t)nbytes);
+    p->tmpBuf[0] = (MYFLT*) ((unsigned char*)p->auxData.auxp + (int32_t)nbytes);
+    p->tmpBuf[1] = p->tmpBuf[0] + CS_KSMPS;
     p->prvDampFactor = -FL(1.0);
     if (*(p->iSampleRate) >= MIN_SRATE)
       p->srFact = pow((DEFAULT_SRATE / *(p->iSampleRate)), 0.8);
@@ -171,9 +172,12 @@ static int32_t freeverb_init(CSOUND *csound, FREEVERB *p)
 static int32_t freeverb_perf(CSOUND *csound, FREEVERB *p)
 {
     double          feedback, damp1, damp2, x;
+    double          filterState[NR_COMB << 1];
     freeVerbComb    *combp;
     freeVerbAllPass *allpassp;
-    int32_t             i;
+    MYFLT           *buf[NR_COMB << 1], y[NR_COMB << 1], sumL, sumR;
+    int32_t         bufPos[NR_COMB << 1], nSamples[NR_COMB << 1];
+    int32_t             i, j;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t n, nsmps = CS_KSMPS;
@@ -193,78 +197,72 @@ static int32_t freeverb_perf(CSOUND *csound, FREEVERB *p)
     else
       damp1 = p->dampValue;
     damp2 = 1.0 - damp1;
-    /* comb filters (left channel) */
-    memset(p->tmpBuf,0, sizeof(MYFLT)*nsmps);
-    for (i = 0; i < NR_COMB; i++) {
-      combp = p->Comb[i][0];
-      for (n = 0; n < nsmps; n++) {
-        p->tmpBuf[n] += combp->buf[combp->bufPos];
-        x = (double) combp->buf[combp->bufPos];
-        combp->filterState = (combp->filterState * damp1) + (x * damp2);
-        x = combp->filterState * feedback + (double) p->aInL[n];
-        combp->buf[combp->bufPos] = (MYFLT) x;
-        if (UNLIKELY(++(combp->bufPos) >= combp->nSamples))
-          combp->bufPos = 0;
-      }
+    /* comb filters: the sixteen combs (eight per channel) are independent */
+    /* of each other, so their state is copied to per-comb arrays and all  */
+    /* of them are advanced together, one sample at a time                 */
+    for (i = 0; i < (NR_COMB << 1); i++) {
+      combp = p->Comb[i >> 1][i & 1];
+      buf[i] = combp->buf;
+      bufPos[i] = combp->bufPos;
+      nSamples[i] = combp->nSamples;
+      filterState[i] = combp->filterState;
     }
-    /* allpass filters (left channel) */
-    for (i = 0; i < NR_ALLPASS; i++) {
-      allpassp = p->AllPass[i][0];
-      for (n = 0; n < nsmps; n++) {
-        x = (double) allpassp->buf[allpassp->bufPos] - (double) p->tmpBuf[n];
-        allpassp->buf[allpassp->bufPos] *= (MYFLT) allPassFeedBack;
-        allpassp->buf[allpassp->bufPos] += p->tmpBuf[n];
-        if (UNLIKELY(++(allpassp->bufPos) >= allpassp->nSamples))
-          allpassp->bufPos = 0;
-        p->tmpBuf[n] = (MYFLT) x;
+    for (n = 0; n < nsmps; n++) {
+      for (i = 0; i < (NR_COMB << 1); i++) {
+        y[i] = buf[i][bufPos[i]];
+        x = (double) y[i];
+        filterState[i] = (filterState[i] * damp1) + (x * damp2);
       }
-    }
-
-    /* write left channel output */
-    if (UNLIKELY(offset)) memset(p->aOutL, '\0', offset*sizeof(MYFLT));
-    if (UNLIKELY(early)) {
-      nsmps -= early;
-      memset(&p->aOutL[nsmps], '\0', early*sizeof(MYFLT));
-    }
-    for (n = offset; n < nsmps; n++)
-      p->aOutL[n] = p->tmpBuf[n] * (MYFLT) fixedGain;
-    /* comb filters (right channel) */
-    memset(p->tmpBuf, 0, sizeof(MYFLT)*nsmps);
-    /* for (n = 0; n < nsmps; n++) */
-    /*   p->tmpBuf[n] = FL(0.0); */
-    for (i = 0; i < NR_COMB; i++) {
-      combp = p->Comb[i][1];
-      for (n = 0; n < nsmps; n++) {
-        p->tmpBuf[n] += combp->buf[combp->bufPos];
-        x = (double) combp->buf[combp->bufPos];
-        combp->filterState = (combp->filterState * damp1) + (x * damp2);
-        x = combp->filterState * feedback + (double) p->aInR[n];
-        combp->buf[combp->bufPos] = (MYFLT) x;
-        if (UNLIKELY(++(combp->bufPos) >= combp->nSamples))
-          combp->bufPos = 0;
+      for (i = 0; i < (NR_COMB << 1); i++) {
+        x = filterState[i] * feedback
+            + (double) (i & 1 ? p->aInR[n] : p->aInL[n]);
+        buf[i][bufPos[i]] = (MYFLT) x;
+        bufPos[i] = (bufPos[i] + 1 >= nSamples[i] ? 0 : bufPos[i] + 1);
+      }
+      sumL = sumR = FL(0.0);
+      for (i = 0; i < (NR_COMB << 1); i += 2) {
+        sumL += y[i];
+        sumR += y[i + 1];
       }
+      p->tmpBuf[0][n] = sumL;
+      p->tmpBuf[1][n] = sumR;
+    }
+    for (i = 0; i < (NR_COMB << 1); i++) {
+      combp = p->Comb[i >> 1][i & 1];
+      combp->bufPos = bufPos[i];
+      combp->filterState = filterState[i];
     }
-    /* allpass filters (right channel) */
+    /* allpass filters: these are in series, so only the two channels can */
+    /* run side by side                                                   */
     for (i = 0; i < NR_ALLPASS; i++) {
-      allpassp = p->AllPass[i][1];
-      for (n = 0; n < nsmps; n++) {
-        x = (double) allpassp->buf[allpassp->bufPos] - (double) p->tmpBuf[n];
-        allpassp->buf[allpassp->bufPos] *= (MYFLT) allPassFeedBack;
-        allpassp->buf[allpassp->bufPos] += p->tmpBuf[n];
-        if (UNLIKELY(++(allpassp->bufPos) >= allpassp->nSamples))
-          allpassp->bufPos = 0;
-        p->tmpBuf[n] = (MYFLT) x;
+      for (j = 0; j < 2; j++) {
+        MYFLT   *tmpBuf = p->tmpBuf[j];
+        allpassp = p->AllPass[i][j];
+        for (n = 0; n < nsmps; n++) {
+          x = (double) allpassp->buf[allpassp->bufPos] - (double) tmpBuf[n];
+          allpassp->buf[allpassp->bufPos] *= (MYFLT) allPassFeedBack;
+          allpassp->buf[allpassp->bufPos] += tmpBuf[n];
+          if (UNLIKELY(++(allpassp->bufPos) >= allpassp->nSamples))
+            allpassp->bufPos = 0;
+          tmpBuf[n] = (MYFLT) x;
+        }
       }
     }
-    nsmps = CS_KSMPS;
-    /* write right channel output */
-    if (UNLIKELY(offset)) memset(p->aOutR, '\0', offset*sizeof(MYFLT));
+
+    /* write output */
+    if (UNLIKELY(offset)) {
+      memset(p->aOutL, '\0', offset*sizeof(MYFLT));
+      memset(p->aOutR, '\0', offset*sizeof(MYFLT));
+    }
     if (UNLIKELY(early)) {
       nsmps -= early;
+      memset(&p->aOutL[nsmps], '\0', early*sizeof(MYFLT));
       memset(&p->aOutR[nsmps], '\0', early*sizeof(MYFLT));
     }
-    for (n = offset; n < nsmps; n++)
-      p->aOutR[n] = p->tmpBuf[n] * (MYFLT) fixedGain;
+    for (n = offset; n < nsmps; n++) {
+      p->aOutL[n] = p->tmpBuf[0][n] * (MYFLT) fixedGain;
+      p->aOutR[n] = p->tmpBuf[1][n] * (MYFLT) fixedGain;
+    }
 
     return OK;
  err1:
@@ -26,7 +26,9 @@
 #endif
 
 #define HDF5ERROR(x) if (UNLIKELY((x) == -1)) \
-    {csound->Die(csound, #x" error\nExiting\n");}
+    {HDF5IO_releaseLock(csound); csound->Die(csound, #x" error\nExiting\n");}
+
+static void HDF5IO_releaseLock(CSOUND *csound);
 
 // Type strings to match the enum types
 static const char typeStrings[8][12] = {
@@ -40,6 +42,430 @@ static const char typeStrings[8][12] = {
     "UNKNOWN"
 };
 
+// Serialise calls to the hdf5 library between the performance thread and the
+// background I/O thread, the library is not thread safe unless it is built to
+// be. The lock is released before csound is stopped on an error so that
+// the deinit callbacks of other hdf5 opcodes can still close their files
+
+static void HDF5IO_lock(CSOUND *csound, HDF5Globals *globals)
+{
+    csound->LockMutex(globals->hdf5Lock);
+    globals->locked = true;
+}
+
+static void HDF5IO_unlock(CSOUND *csound, HDF5Globals *globals)
+{
+    globals->locked = false;
+    csound->UnlockMutex(globals->hdf5Lock);
+}
+
+static void HDF5IO_releaseLock(CSOUND *csound)
+{
+    HDF5Globals *globals = csound->QueryGlobalVariable(csound, "HDF5IO");
+
+    if (globals != NULL && globals->locked == true) {
+
+      HDF5IO_unlock(csound, globals);
+    }
+}
+
+// Stop the background I/O thread and free the locks when csound is reset
+//
+// Any jobs left in the queue are finished before the thread exits, all
+// opcodes have waited for their own jobs in their deinit callbacks by now
+
+static int32_t HDF5IO_resetGlobals(CSOUND *csound, void *userData)
+{
+    HDF5Globals *globals = userData;
+
+    if (globals->thread != NULL) {
+
+      csound->LockMutex(globals->queueLock);
+      globals->running = 0;
+      csound->UnlockMutex(globals->queueLock);
+      csound->NotifyThreadLock(globals->wakeup);
+      csound->JoinThread(globals->thread);
+      csound->DestroyThreadLock(globals->wakeup);
+      globals->thread = NULL;
+    }
+
+    csound->DestroyMutex(globals->queueLock);
+    csound->DestroyMutex(globals->hdf5Lock);
+
+    return OK;
+}
+
+// Get the hdf5 settings for this csound instance, creating them the first
+// time any of the hdf5 opcodes is initialised
+
+HDF5Globals *HDF5IO_getGlobals(CSOUND *csound)
+{
+    HDF5Globals *globals = csound->QueryGlobalVariable(csound, "HDF5IO");
+
+    if (globals == NULL) {
+
+      if (UNLIKELY(csound->CreateGlobalVariable(csound, "HDF5IO",
+                                                sizeof(HDF5Globals)) != 0)) {
+
+        csound->Die(csound, "%s", Str("hdf5: Error, unable to allocate "
+                                      "memory, exiting"));
+      }
+
+      globals = csound->QueryGlobalVariable(csound, "HDF5IO");
+      globals->csound = csound;
+      globals->kperiods = HDF5IO_DEFAULT_KPERIODS;
+      globals->hdf5Lock = csound->Create_Mutex(0);
+      globals->queueLock = csound->Create_Mutex(0);
+      csound->RegisterResetCallback(csound, globals, HDF5IO_resetGlobals);
+    }
+
+    return globals;
+}
+
+// Read or write a batch of rows, a row being one element of the first
+// dimension of a dataset, at the specified row offset
+//
+// These functions run on the background I/O thread so they return an error
+// status instead of stopping csound, the caller must hold the hdf5 lock
+// When writing, the dataset is first extended to the end of the batch
+
+static herr_t HDF5IO_transferRows(HDF5Dataset *dataset, bool isWriting,
+                                  hsize_t rowOffset, size_t rowCount,
+                                  MYFLT *data)
+{
+    hsize_t offset[H5S_MAX_RANK];
+    hsize_t count[H5S_MAX_RANK];
+    herr_t status = 0;
+    int32_t i;
+
+    for (i = 0; i < dataset->rank; ++i) {
+
+      offset[i] = 0;
+      count[i] = dataset->datasetSize[i];
+    }
+
+    offset[0] = rowOffset;
+    count[0] = rowOffset + rowCount;
+
+    if (isWriting == true) {
+
+      status = H5Dset_extent(dataset->datasetID, count);
+    }
+
+    count[0] = rowCount;
+
+    if (status < 0) {
+
+      return -1;
+    }
+
+    hid_t filespace = H5Dget_space(dataset->datasetID);
+
+    if (filespace < 0) {
+
+      return -1;
+    }
+
+    hid_t memspace = H5Screate_simple(dataset->rank, count, NULL);
+    status = memspace < 0 ? -1 :
+      H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, NULL, count, NULL);
+
+    if (status >= 0) {
+
+      status = isWriting == true ?
+        H5Dwrite(dataset->datasetID, dataset->hdf5File->floatSize, memspace,
+                 filespace, H5P_DEFAULT, data) :
+        H5Dread(dataset->datasetID, dataset->hdf5File->floatSize, memspace,
+                filespace, H5P_DEFAULT, data);
+    }
+
+    H5Sclose(filespace);
+
+    if (memspace >= 0) {
+
+      H5Sclose(memspace);
+    }
+
+    return status < 0 ? -1 : 0;
+}
+
+// Background I/O thread
+//
+// Take the next dataset from the job queue, read or write its pending buffer
+// half, then clear the pending flag and wake the performance thread if it is
+// waiting for that half. The flag is cleared with the queue lock held so that
+// a dataset is never touched again once its owner has seen the flag cleared
+// and taken the queue lock
+
+static uintptr_t HDF5IO_thread(void *data)
+{
+    HDF5Globals *globals = data;
+    CSOUND *csound = globals->csound;
+    HDF5Dataset *dataset;
+    int32_t running;
+
+    do {
+
+      csound->LockMutex(globals->queueLock);
+      running = globals->running;
+
+      if ((dataset = globals->jobHead) != NULL) {
+
+        if ((globals->jobHead = dataset->nextJob) == NULL) {
+
+          globals->jobTail = NULL;
+        }
+      }
+
+      csound->UnlockMutex(globals->queueLock);
+
+      if (dataset == NULL) {
+
+        if (running) {
+
+          csound->WaitThreadLock(globals->wakeup, 50);
+        }
+
+        continue;
+      }
+
+      int32_t buffer = dataset->jobBuffer;
+      csound->LockMutex(globals->hdf5Lock);
+      herr_t status = HDF5IO_transferRows(dataset, dataset->isWriting,
+                                          dataset->jobOffset, dataset->jobRows,
+                                          dataset->ioBuffer[buffer]);
+      csound->UnlockMutex(globals->hdf5Lock);
+
+      if (status < 0) {
+
+        dataset->ioFailed = true;
+      }
+      else if (dataset->isWriting == false) {
+
+        dataset->bufferRows[buffer] = dataset->jobRows;
+      }
+
+      csound->LockMutex(globals->queueLock);
+      ATOMIC_SET(dataset->pending[buffer], 0);
+      csound->NotifyThreadLock(dataset->jobDone);
+      csound->UnlockMutex(globals->queueLock);
+    } while (running || dataset != NULL);
+
+    return 0;
+}
+
+// Start the background I/O thread if it is not running yet
+//
+// Returns false if the thread cannot be created, the opcode then does its
+// reads and writes on the performance thread
+
+static bool HDF5IO_startThread(CSOUND *csound, HDF5Globals *globals)
+{
+    if (globals->thread != NULL) {
+
+      return true;
+    }
+
+    globals->wakeup = csound->CreateThreadLock();
+    globals->running = 1;
+    globals->thread = csound->CreateThread(HDF5IO_thread, globals);
+
+    if (UNLIKELY(globals->thread == NULL)) {
+
+      csound->DestroyThreadLock(globals->wakeup);
+      csound->Warning(csound, "%s", Str("hdf5: unable to start the I/O thread, "
+                                        "reading and writing on the "
+                                        "performance thread"));
+      return false;
+    }
+
+    return true;
+}
+
+// Queue a read or write of one buffer half for the background I/O thread
+
+static void HDF5IO_queueJob(CSOUND *csound, HDF5Globals *globals,
+                            HDF5Dataset *dataset, int32_t buffer,
+                            hsize_t rowOffset, size_t rowCount)
+{
+    dataset->jobBuffer = buffer;
+    dataset->jobOffset = rowOffset;
+    dataset->jobRows = rowCount;
+    dataset->nextJob = NULL;
+    ATOMIC_SET(dataset->pending[buffer], 1);
+
+    csound->LockMutex(globals->queueLock);
+
+    if (globals->jobTail != NULL) {
+
+      globals->jobTail->nextJob = dataset;
+    }
+    else {
+
+      globals->jobHead = dataset;
+    }
+
+    globals->jobTail = dataset;
+    csound->UnlockMutex(globals->queueLock);
+    csound->NotifyThreadLock(globals->wakeup);
+}
+
+// Wait until the background I/O thread has finished with a buffer half
+//
+// Stop csound if the read or write of that buffer failed
+
+static void HDF5IO_waitForBuffer(CSOUND *csound, HDF5Dataset *dataset,
+                                 int32_t buffer)
+{
+    while (ATOMIC_GET(dataset->pending[buffer]) != 0) {
+
+      csound->WaitThreadLock(dataset->jobDone, 10);
+    }
+
+    if (UNLIKELY(dataset->ioFailed == true)) {
+
+      csound->Die(csound, Str("hdf5: Error, unable to access dataset %s in "
+                              "the I/O thread, exiting"), dataset->datasetName);
+    }
+}
+
+// Wait for all jobs of a dataset before it is closed
+//
+// Taking the queue lock once the pending flags are clear makes sure the I/O
+// thread has finished notifying, so the job lock can be destroyed
+
+static void HDF5IO_finishJobs(CSOUND *csound, HDF5Globals *globals,
+                              HDF5Dataset *dataset)
+{
+    if (dataset->jobDone == NULL) {
+
+      return;
+    }
+
+    HDF5IO_waitForBuffer(csound, dataset, 0);
+    HDF5IO_waitForBuffer(csound, dataset, 1);
+    csound->LockMutex(globals->queueLock);
+    csound->UnlockMutex(globals->queueLock);
+    csound->DestroyThreadLock(dataset->jobDone);
+    dataset->jobDone = NULL;
+}
+
+// Find the chunk settings given to hdf5chunk for a dataset name
+
+static HDF5Chunk *HDF5IO_findChunk(HDF5Globals *globals, const char *name)
+{
+    HDF5Chunk *chunk;
+
+    for (chunk = globals->chunks; chunk != NULL; chunk = chunk->next) {
+
+      if (strcmp(chunk->datasetName, name) == 0) {
+
+        return chunk;
+      }
+    }
+
+    return NULL;
+}
+
+// Set up the buffer used to write or read a dataset in batches of k-periods
+//
+// Work out the row size as the product of all but the first dimension
+// The batch holds the amount of k-periods set by hdf5buffer, one row per
+// k-period for k-rate data, ksmps rows for a-rate data
+// Allocate one buffer half, or two when using the I/O thread so one can be
+// filled or emptied while the other is written or read
+
+static void HDF5IO_newIOBuffer(CSOUND *csound, HDF5Globals *globals,
+                               HDF5Dataset *dataset, size_t rowsPerPeriod,
+                               bool useThread)
+{
+    int32_t i;
+    dataset->rowSize = 1;
+
+    for (i = 1; i < dataset->rank; ++i) {
+
+      dataset->rowSize *= dataset->datasetSize[i];
+    }
+
+    dataset->batchRows = (size_t)globals->kperiods * rowsPerPeriod;
+    size_t halfSize = dataset->batchRows * dataset->rowSize;
+
+    csound->AuxAlloc(csound, (useThread == true ? 2 : 1) * halfSize
+                     * sizeof(MYFLT), &dataset->ioBufferMemory);
+    dataset->ioBuffer[0] = dataset->ioBufferMemory.auxp;
+    dataset->ioBuffer[1] = useThread == true ?
+      &dataset->ioBuffer[0][halfSize] : NULL;
+    dataset->bufferRows[0] = dataset->bufferRows[1] = 0;
+    dataset->bufferPosition = 0;
+    dataset->currentBuffer = 0;
+    dataset->ioOffset = 0;
+    dataset->pending[0] = dataset->pending[1] = 0;
+    dataset->ioFailed = false;
+    dataset->jobDone = useThread == true ? csound->CreateThreadLock() : NULL;
+}
+
+// Set the amount of k-periods read or written with each hdf5 call and
+// whether a background thread does the reading and writing
+//
+// Applies to hdf5read and hdf5write opcodes initialised afterwards
+
+int32_t HDF5IO_setBuffer(CSOUND *csound, HDF5Buffer *self)
+{
+    HDF5Globals *globals = HDF5IO_getGlobals(csound);
+    int32_t kperiods = (int32_t)MYFLT2LRND(*self->kperiods);
+
+    if (UNLIKELY(kperiods < 1)) {
+
+      return csound->InitError(csound, "%s", Str("hdf5buffer: Error, the "
+                                                 "amount of k-periods must be "
+                                                 "at least 1"));
+    }
+
+    globals->kperiods = kperiods;
+    globals->useThread = *self->useThread != FL(0.0);
+
+    return OK;
+}
+
+// Set the storage chunk size in k-periods and the deflate compression
+// level, 0 to 9, of a dataset created by hdf5write afterwards
+
+int32_t HDF5IO_setChunk(CSOUND *csound, HDF5ChunkOpcode *self)
+{
+    HDF5Globals *globals = HDF5IO_getGlobals(csound);
+    int32_t kperiods = (int32_t)MYFLT2LRND(*self->kperiods);
+    int32_t deflate = (int32_t)MYFLT2LRND(*self->deflate);
+
+    if (UNLIKELY(kperiods < 1)) {
+
+      return csound->InitError(csound, "%s", Str("hdf5chunk: Error, the "
+                                                 "amount of k-periods must be "
+                                                 "at least 1"));
+    }
+
+    if (UNLIKELY(deflate < 0 || deflate > 9)) {
+
+      return csound->InitError(csound, "%s", Str("hdf5chunk: Error, the "
+                                                 "compression level must be "
+                                                 "between 0 and 9"));
+    }
+
+    HDF5Chunk *chunk = HDF5IO_findChunk(globals, self->datasetName->data);
+
+    if (chunk == NULL) {
+
+      chunk = csound->Calloc(csound, sizeof(HDF5Chunk));
+      chunk->datasetName = csound->Strdup(csound, self->datasetName->data);
+      chunk->next = globals->chunks;
+      globals->chunks = chunk;
+    }
+
+    chunk->kperiods = kperiods;
+    chunk->deflate = deflate;
+
+    return OK;
+}
+
 // Get the argument enum type from the opcode argument pointer
 //
 // Get the csound type from the argument
@@ -162,6 +588,7 @@ HDF5File *HDF5IO_newHDF5File(CSOUND *csound, AUXCH *hdf5FileMemory,
       }
       else {
 
+        HDF5IO_releaseLock(csound);
         csound->Die(csound, "hdf5read: Error, file does not exist");
       }
     }
@@ -267,6 +694,7 @@ bool HDF5IO_getSampleAccurate(CSOUND *csound)
 // Check that the first argument is a string for the filename, check others
 // are not strings
 // Register the callback to close the hdf5 file when performance finishes
+// Start the background I/O thread if hdf5buffer asked for it
 // Get the path argument and open a hdf5 file, if it doesn't exist create it
 // Create the datasets in the file so they can be written
 
@@ -275,11 +703,16 @@ int32_t HDF5Write_initialise(CSOUND *csound, HDF5Write *self)
     self->ksmps = csound->GetKsmps(csound);
     self->inputArgumentCount = self->INOCOUNT - 1;
     HDF5Write_checkArgumentSanity(csound, self);
+    self->globals = HDF5IO_getGlobals(csound);
+    self->useThread = self->globals->useThread == true
+      && HDF5IO_startThread(csound, self->globals);
     csound->RegisterDeinitCallback(csound, self, HDF5Write_finish);
 
     STRINGDAT *path = (STRINGDAT *)self->arguments[0];
+    HDF5IO_lock(csound, self->globals);
     self->hdf5File = HDF5IO_newHDF5File(csound, &self->hdf5FileMemory, path, true);
     HDF5Write_createDatasets(csound, self);
+    HDF5IO_unlock(csound, self->globals);
 
     return OK;
 }
@@ -306,6 +739,76 @@ void HDF5Write_writeData(CSOUND *csound, HDF5Write *self,
     HDF5ERROR(H5Dwrite(dataset->datasetID, self->hdf5File->floatSize, memspace,
                        filespace, H5P_DEFAULT, data));
     HDF5ERROR(H5Sclose(filespace));
+    HDF5ERROR(H5Sclose(memspace));
+}
+
+// Write the rows held in the current buffer half to the dataset
+//
+// Without the I/O thread write them straight away
+// With it, wait for the other half to be written, queue this half and
+// carry on filling the other one
+
+void HDF5Write_flushBuffer(CSOUND *csound, HDF5Write *self,
+                           HDF5Dataset *dataset)
+{
+    size_t rowCount = dataset->bufferPosition;
+
+    if (rowCount == 0) {
+
+      return;
+    }
+
+    if (self->useThread == true) {
+
+      int32_t next = dataset->currentBuffer ^ 1;
+      HDF5IO_waitForBuffer(csound, dataset, next);
+      HDF5IO_queueJob(csound, self->globals, dataset, dataset->currentBuffer,
+                      dataset->ioOffset, rowCount);
+      dataset->currentBuffer = next;
+    }
+    else {
+
+      HDF5IO_lock(csound, self->globals);
+      HDF5ERROR(HDF5IO_transferRows(dataset, true, dataset->ioOffset, rowCount,
+                                    dataset->ioBuffer[0]));
+      HDF5IO_unlock(csound, self->globals);
+    }
+
+    dataset->ioOffset += rowCount;
+    dataset->bufferPosition = 0;
+}
+
+// Copy rows of data to the write buffer of a dataset
+//
+// Copy as many rows as fit in the current buffer half
+// Write the buffer when it is full and carry on with the rest
+
+void HDF5Write_appendRows(CSOUND *csound, HDF5Write *self,
+                          HDF5Dataset *dataset, MYFLT *data, size_t rowCount)
+{
+    size_t written = 0;
+
+    while (written < rowCount) {
+
+      size_t count = dataset->batchRows - dataset->bufferPosition;
+
+      if (count > rowCount - written) {
+
+        count = rowCount - written;
+      }
+
+      memcpy(&dataset->ioBuffer[dataset->currentBuffer]
+             [dataset->bufferPosition * dataset->rowSize],
+             &data[written * dataset->rowSize],
+             count * dataset->rowSize * sizeof(MYFLT));
+      dataset->bufferPosition += count;
+      written += count;
+
+      if (dataset->bufferPosition == dataset->batchRows) {
+
+        HDF5Write_flushBuffer(csound, self, dataset);
+      }
+    }
 }
 
 // Write a-rate variables and arrays to the specified data set
@@ -313,9 +816,8 @@ void HDF5Write_writeData(CSOUND *csound, HDF5Write *self,
 // For sample accurate mode, get the offset and early variables
 // Calculate the size of the incoming vector
 // If the vector is 0 return, no more data to write
-// Expand the dataset size by ksmps, because data is written in chunks
-// For sample accurate mode the exact dataset size is set when writing is finished
-// Write the data to the dataset
+// Add the vector to the write buffer, it is written to the file once a
+// batch of k-periods has been collected
 // Increment the offset by the size of the vector that was just written
 
 void HDF5Write_writeAudioData(CSOUND *csound, HDF5Write *self,
@@ -330,25 +832,21 @@ void HDF5Write_writeAudioData(CSOUND *csound, HDF5Write *self,
       return;
     }
 
-    dataset->datasetSize[0] += self->ksmps;
-
-    HDF5Write_writeData(csound, self, dataset, &dataPointer[offset]);
+    HDF5Write_appendRows(csound, self, dataset, &dataPointer[offset],
+                         vectorSize);
 
     dataset->offset[0] += vectorSize;
 }
 
 // Write k-rate variables and arrays to the specified data set
 //
-// Increment the data set size by 1
-// Write the data to the dataset
+// Add one row to the write buffer
 // Increment the offset by 1
 
 void HDF5Write_writeControlData(CSOUND *csound, HDF5Write *self,
                                 HDF5Dataset *dataset, MYFLT *dataPointer)
 {
-    dataset->datasetSize[0]++;
-
-    HDF5Write_writeData(csound, self, dataset, dataPointer);
+    HDF5Write_appendRows(csound, self, dataset, dataPointer, 1);
 
     dataset->offset[0]++;
 }
@@ -403,6 +901,8 @@ int32_t HDF5Write_process(CSOUND *csound, HDF5Write *self)
 // Close the hdf5 file and set the a-rate dataset extents for sample accurate mode
 //
 // Check that the datasets exist
+// Write what is left in the buffers of the a-rate and k-rate datasets and
+// wait for the I/O thread to finish writing them
 // Iterate through the datasets, if a-rate, set the size to be the same as
 // current offset
 // Set the set extent of the dataset to the size
@@ -412,6 +912,24 @@ int32_t HDF5Write_finish(CSOUND *csound, void *inReference)
 {
     HDF5Write *self = inReference;
 
+    if (LIKELY(self->datasets != NULL)) {
+      int32_t i;
+      for (i = 0; i < self->inputArgumentCount; ++i) {
+
+        if (self->datasets[i].ioBuffer[0] != NULL) {
+
+          HDF5Write_flushBuffer(csound, self, &self->datasets[i]);
+        }
+      }
+
+      for (i = 0; i < self->inputArgumentCount; ++i) {
+
+        HDF5IO_finishJobs(csound, self->globals, &self->datasets[i]);
+      }
+    }
+
+    HDF5IO_lock(csound, self->globals);
+
     if (LIKELY(self->datasets != NULL)) {
       int32_t i;
       for (i = 0; i < self->inputArgumentCount; ++i) {
@@ -445,6 +963,7 @@ int32_t HDF5Write_finish(CSOUND *csound, void *inReference)
     }
 
     HDF5ERROR(H5Fclose(self->hdf5File->fileHandle));
+    HDF5IO_unlock(csound, self->globals);
 
     return OK;
 }
@@ -481,11 +1000,79 @@ void HDF5Write_checkArgumentSanity(CSOUND *csound, const HDF5Write *self)
     }
 }
 
+// Set the storage chunk size and compression of a dataset
+//
+// i-rate datasets are stored as a single chunk
+// Otherwise use the amount of k-periods given to hdf5chunk for this dataset,
+// or by default the amount written with each hdf5 call limited to
+// HDF5IO_MAX_CHUNK_BYTES, one row per k-period for k-rate data and ksmps rows
+// for a-rate data
+// If a compression level was given, shuffle the bytes of the samples and use
+// deflate compression, if the hdf5 library has it
+
+void HDF5Write_setChunking(CSOUND *csound, HDF5Write *self,
+                           HDF5Dataset *dataset, hid_t cparams)
+{
+    hsize_t chunkDimensions[H5S_MAX_RANK];
+    HDF5Chunk *chunk = HDF5IO_findChunk(self->globals, dataset->datasetName);
+    size_t rowsPerPeriod = dataset->chunkDimensions[0];
+    size_t rowBytes = sizeof(MYFLT);
+    int32_t i;
+
+    memcpy(chunkDimensions, dataset->chunkDimensions,
+           dataset->rank * sizeof(hsize_t));
+
+    for (i = 1; i < dataset->rank; ++i) {
+
+      rowBytes *= dataset->chunkDimensions[i];
+    }
+
+    if (dataset->maxDimensions[0] == H5S_UNLIMITED) {
+
+      if (chunk != NULL) {
+
+        chunkDimensions[0] = (hsize_t)chunk->kperiods * rowsPerPeriod;
+      }
+      else {
+
+        chunkDimensions[0] = (hsize_t)self->globals->kperiods * rowsPerPeriod;
+
+        if (chunkDimensions[0] * rowBytes > HDF5IO_MAX_CHUNK_BYTES) {
+
+          chunkDimensions[0] = HDF5IO_MAX_CHUNK_BYTES / rowBytes;
+        }
+
+        if (chunkDimensions[0] < 1) {
+
+          chunkDimensions[0] = 1;
+        }
+      }
+    }
+
+    HDF5ERROR(H5Pset_chunk(cparams, dataset->rank, chunkDimensions));
+
+    if (chunk != NULL && chunk->deflate > 0) {
+
+      if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+
+        HDF5ERROR(H5Pset_shuffle(cparams));
+        HDF5ERROR(H5Pset_deflate(cparams, (unsigned)chunk->deflate));
+      }
+      else {
+
+        csound->Warning(csound, Str("hdf5write: deflate compression is not "
+                                    "available, dataset %s is not "
+                                    "compressed"), dataset->datasetName);
+      }
+    }
+}
+
 // Create, or delete and create again a dataset in an hdf5 file
 //
 // Check to see if the dataset exists
 // If it exists delete it
-// Create the data space, set the writing chunk size and the empty space fill value
+// Create the data space, set the storage chunk size, compression and the
+// empty space fill value
 // Create the data set in the data space and write the argument type as a string
 // attribute
 
@@ -507,7 +1094,7 @@ void HDF5Write_initialiseHDF5Dataset(CSOUND *csound, HDF5Write *self,
     hid_t cparams = H5Pcreate(H5P_DATASET_CREATE);
     HDF5ERROR(cparams);
 
-    HDF5ERROR(H5Pset_chunk(cparams, dataset->rank, dataset->chunkDimensions));
+    HDF5Write_setChunking(csound, self, dataset, cparams);
 
     MYFLT zero = 0;
 
@@ -518,6 +1105,8 @@ void HDF5Write_initialiseHDF5Dataset(CSOUND *csound, HDF5Write *self,
                                     self->hdf5File->floatSize,
                                     dataspaceID, H5P_DEFAULT, cparams, H5P_DEFAULT);
     HDF5ERROR(dataset->datasetID);
+    HDF5ERROR(H5Pclose(cparams));
+    HDF5ERROR(H5Sclose(dataspaceID));
     HDF5IO_writeStringAttribute(csound, self->hdf5File, dataset,
                                 "Variable Type", typeStrings[dataset->writeType]);
 
@@ -595,6 +1184,7 @@ void HDF5Write_newArrayDataset(CSOUND *csound, HDF5Write *self,
     }
     default: {
 
+      HDF5IO_releaseLock(csound);
       csound->Die(csound, "%s", Str("This should not happen, exiting"));
       break;
     }
@@ -656,7 +1246,7 @@ void HDF5Write_newScalarDataset(CSOUND *csound, HDF5Write *self,
 // Get the argument pointer from the arguments + 1 after the file path string
 // Get the enum write type from the argument pointer
 // Depending on the write type set up the variables in the correct way for
-// writing during performance
+// writing during performance and allocate the write buffer
 // If the variables are i-rate set up the variables and write them
 
 void HDF5Write_createDatasets(CSOUND *csound, HDF5Write *self)
@@ -673,6 +1263,8 @@ void HDF5Write_createDatasets(CSOUND *csound, HDF5Write *self)
       currentDataset->argumentPointer = self->arguments[i + 1];
       currentDataset->writeType =
         HDF5IO_getArgumentTypeFromArgument(csound, currentDataset->argumentPointer);
+      currentDataset->hdf5File = self->hdf5File;
+      currentDataset->isWriting = true;
 
       switch (currentDataset->writeType) {
 
@@ -680,12 +1272,16 @@ void HDF5Write_createDatasets(CSOUND *csound, HDF5Write *self)
 
         HDF5Write_newArrayDataset(csound, self, currentDataset);
         HDF5Write_initialiseHDF5Dataset(csound, self, currentDataset);
+        HDF5IO_newIOBuffer(csound, self->globals, currentDataset, self->ksmps,
+                           self->useThread);
         break;
       }
       case KRATE_ARRAY: {
 
         HDF5Write_newArrayDataset(csound, self, currentDataset);
         HDF5Write_initialiseHDF5Dataset(csound, self, currentDataset);
+        HDF5IO_newIOBuffer(csound, self->globals, currentDataset, 1,
+                           self->useThread);
         break;
       }
       case IRATE_ARRAY: {
@@ -700,12 +1296,16 @@ void HDF5Write_createDatasets(CSOUND *csound, HDF5Write *self)
 
         HDF5Write_newScalarDataset(csound, self, currentDataset);
         HDF5Write_initialiseHDF5Dataset(csound, self, currentDataset);
+        HDF5IO_newIOBuffer(csound, self->globals, currentDataset, self->ksmps,
+                           self->useThread);
         break;
       }
       case KRATE_VAR: {
 
         HDF5Write_newScalarDataset(csound, self, currentDataset);
         HDF5Write_initialiseHDF5Dataset(csound, self, currentDataset);
+        HDF5IO_newIOBuffer(csound, self->globals, currentDataset, 1,
+                           self->useThread);
         break;
       }
       case IRATE_VAR: {
@@ -731,6 +1331,7 @@ void HDF5Write_createDatasets(CSOUND *csound, HDF5Write *self)
 // Get the amount of output arguments
 // Check that input == output arguments and input arguments are strings,
 // output not strings
+// Start the background I/O thread if hdf5buffer asked for it
 // Register the finish callback to close the hdf5 file when performance
 // is finished
 // Check csound is running in sample accurate mode
@@ -743,11 +1344,16 @@ int32_t HDF5Read_initialise(CSOUND *csound, HDF5Read *self)
     self->inputArgumentCount = self->INOCOUNT - 1;
     self->outputArgumentCount = self->OUTOCOUNT;
     HDF5Read_checkArgumentSanity(csound, self);
+    self->globals = HDF5IO_getGlobals(csound);
+    self->useThread = self->globals->useThread == true
+      && HDF5IO_startThread(csound, self->globals);
     csound->RegisterDeinitCallback(csound, self, HDF5Read_finish);
     self->isSampleAccurate = HDF5IO_getSampleAccurate(csound);
     STRINGDAT *path = (STRINGDAT *)self->arguments[self->outputArgumentCount];
+    HDF5IO_lock(csound, self->globals);
     self->hdf5File = HDF5IO_newHDF5File(csound, &self->hdf5FileMemory, path, false);
     HDF5Read_openDatasets(csound, self);
+    HDF5IO_unlock(csound, self->globals);
 
     return OK;
 }
@@ -805,6 +1411,122 @@ void HDF5Read_readData(CSOUND *csound, HDF5Read *self, HDF5Dataset *dataset,
 
 }
 
+// Get the next batch of rows from a dataset into the read buffer
+//
+// Without the I/O thread read the batch straight away
+// With it, wait for the other half to be read, queue a read of the next
+// batch into the half that has just been used up and switch to the other half
+// At the end of the dataset the buffer is left empty
+
+void HDF5Read_nextBuffer(CSOUND *csound, HDF5Read *self, HDF5Dataset *dataset)
+{
+    size_t rowCount = 0;
+
+    if (dataset->ioOffset < dataset->datasetSize[0]) {
+
+      rowCount = dataset->datasetSize[0] - dataset->ioOffset;
+
+      if (rowCount > dataset->batchRows) {
+
+        rowCount = dataset->batchRows;
+      }
+    }
+
+    if (self->useThread == true) {
+
+      int32_t next = dataset->currentBuffer ^ 1;
+      HDF5IO_waitForBuffer(csound, dataset, next);
+      dataset->bufferRows[dataset->currentBuffer] = 0;
+
+      if (rowCount > 0) {
+
+        HDF5IO_queueJob(csound, self->globals, dataset, dataset->currentBuffer,
+                        dataset->ioOffset, rowCount);
+      }
+
+      dataset->currentBuffer = next;
+    }
+    else {
+
+      if (rowCount > 0) {
+
+        HDF5IO_lock(csound, self->globals);
+        HDF5ERROR(HDF5IO_transferRows(dataset, false, dataset->ioOffset,
+                                      rowCount, dataset->ioBuffer[0]));
+        HDF5IO_unlock(csound, self->globals);
+      }
+
+      dataset->bufferRows[0] = rowCount;
+    }
+
+    dataset->ioOffset += rowCount;
+    dataset->bufferPosition = 0;
+}
+
+// Copy rows of data from the read buffer of a dataset
+//
+// Copy as many rows as are left in the current buffer half
+// Get the next batch when it is used up and carry on with the rest
+// Return the amount of rows copied, less than requested at the end of the
+// dataset
+
+size_t HDF5Read_copyRows(CSOUND *csound, HDF5Read *self, HDF5Dataset *dataset,
+                         MYFLT *data, size_t rowCount)
+{
+    size_t copied = 0;
+
+    while (copied < rowCount) {
+
+      if (dataset->bufferPosition >=
+          dataset->bufferRows[dataset->currentBuffer]) {
+
+        HDF5Read_nextBuffer(csound, self, dataset);
+
+        if (dataset->bufferRows[dataset->currentBuffer] == 0) {
+
+          break;
+        }
+      }
+
+      size_t count = dataset->bufferRows[dataset->currentBuffer] -
+        dataset->bufferPosition;
+
+      if (count > rowCount - copied) {
+
+        count = rowCount - copied;
+      }
+
+      memcpy(&data[copied * dataset->rowSize],
+             &dataset->ioBuffer[dataset->currentBuffer]
+             [dataset->bufferPosition * dataset->rowSize],
+             count * dataset->rowSize * sizeof(MYFLT));
+      dataset->bufferPosition += count;
+      copied += count;
+    }
+
+    return copied;
+}
+
+// Start reading ahead from the beginning of a dataset
+//
+// Allocate the read buffer, with the I/O thread queue a read of the first
+// batch so it is ready when performance starts
+
+void HDF5Read_newIOBuffer(CSOUND *csound, HDF5Read *self, HDF5Dataset *dataset,
+                          size_t rowsPerPeriod)
+{
+    dataset->hdf5File = self->hdf5File;
+    dataset->isWriting = false;
+    HDF5IO_newIOBuffer(csound, self->globals, dataset, rowsPerPeriod,
+                       self->useThread);
+
+    if (self->useThread == true) {
+
+      dataset->currentBuffer = 1;
+      HDF5Read_nextBuffer(csound, self, dataset);
+    }
+}
+
 // Read data at audio rate from a hdf5 file dataset
 //
 // If the offset is larger than the size of the dataset there is no more
@@ -816,8 +1538,7 @@ void HDF5Read_readData(CSOUND *csound, HDF5Read *self, HDF5Dataset *dataset,
 // buffer to store read data so the stride can be corrected before
 // writing it to the array data, if not just point directly to array
 // data
-// Create the chunk dimensions variable, set the required size
-// Read data from the hdf5 file
+// Copy the data from the read buffer
 // If the vector size is not equal to ksmps correct the stride of data
 // Increment the offset by the vector size
 
@@ -845,23 +1566,8 @@ void HDF5Read_readAudioData(CSOUND *csound, HDF5Read *self,
     MYFLT *dataPointer =
       vectorSize != self->ksmps ? dataset->sampleBuffer : inputDataPointer;
 
-        // FIXME if this is called frequently or on the audio thread then this won't
-        // work and will need a different solution
-#ifdef _MSC_VER
-    hsize_t* chunkDimensions = malloc (dataset->rank * sizeof (hsize_t));
-#else
-    hsize_t chunkDimensions[dataset->rank];
-#endif
-    memcpy(&chunkDimensions[1], &dataset->datasetSize[1],
-           sizeof(hsize_t) * dataset->rank);
-    chunkDimensions[0] = vectorSize;
-
-    memcpy (chunkDimensions, dataset->datasetSize,
-            sizeof (hsize_t) * dataset->rank);
-    chunkDimensions[dataset->rank - 1] = vectorSize;
-
-    HDF5Read_readData (csound, self, dataset, dataset->offset,
-                       chunkDimensions, dataPointer);
+    vectorSize = HDF5Read_copyRows(csound, self, dataset, dataPointer,
+                                   vectorSize);
 
     if (vectorSize != self->ksmps) {
 
@@ -871,18 +1577,13 @@ void HDF5Read_readAudioData(CSOUND *csound, HDF5Read *self,
     }
 
     dataset->offset[0] += vectorSize;
-
-#ifdef _MSC_VER
-    free (chunkDimensions);
-#endif
 }
 
 // Read data at control rate from a hdf5 dataset
 //
 // If the offset of the dataset is larger than the data set size, no
 // more data to read to return
-// Create chunk dimension variable and set the appropriate size
-// Read the data from the dataset
+// Copy one row from the read buffer
 // Increment the offset variable
 
 void HDF5Read_readControlData(CSOUND *csound, HDF5Read *self,
@@ -894,24 +1595,8 @@ void HDF5Read_readControlData(CSOUND *csound, HDF5Read *self,
       return;
     }
 
-        // FIXME if this is called frequently or on the audio thread then this won't
-        // work and will need a different solution
-#ifndef _MSC_VER
-    hsize_t chunkDimensions[dataset->rank];
-#else
-    hsize_t* chunkDimensions = malloc (dataset->rank * sizeof (hsize_t));
-#endif
-    memcpy(&chunkDimensions[1], &dataset->datasetSize[1],
-           sizeof(hsize_t) * (dataset->rank - 1));
-    chunkDimensions[0] = 1;
-
-    HDF5Read_readData(csound, self, dataset, dataset->offset,
-                      chunkDimensions, dataPointer);
+    HDF5Read_copyRows(csound, self, dataset, dataPointer, 1);
     dataset->offset[0]++;
-#ifdef _MSC_VER
-    free (chunkDimensions);
-#endif
-
 }
 
 // Read dataset variables during performance time
@@ -968,6 +1653,7 @@ int32_t HDF5Read_process(CSOUND *csound, HDF5Read *self)
 
 // Close the necessary variables when reading has finished
 //
+// Wait for the I/O thread to finish reading ahead
 // Iterate through open datasets closing them in the hdf5 file
 // Close the hdf5 file
 
@@ -975,6 +1661,13 @@ int32_t HDF5Read_finish(CSOUND *csound, void *inReference)
 {
     HDF5Read *self = inReference;
     int32_t i;
+    for (i = 0; i < self->inputArgumentCount && self->datasets != NULL; ++i) {
+
+      HDF5IO_finishJobs(csound, self->globals, &self->datasets[i]);
+    }
+
+    HDF5IO_lock(csound, self->globals);
+
     for (i = 0; i < self->inputArgumentCount; ++i) {
 
       HDF5Dataset *dataset = &self->datasets[i];
@@ -983,6 +1676,7 @@ int32_t HDF5Read_finish(CSOUND *csound, void *inReference)
     }
 
     HDF5ERROR(H5Fclose(self->hdf5File->fileHandle));
+    HDF5IO_unlock(csound, self->globals);
 
     return OK;
 }
@@ -1055,6 +1749,7 @@ void HDF5Read_initialiseHDF5Dataset(CSOUND *csound, HDF5Read *self,
 
     if (UNLIKELY(result <= 0)) {
 
+      HDF5IO_releaseLock(csound);
       csound->Die(csound, "%s", Str("hdf5read: Error, dataset does not exist or "
                               "cannot be found in file"));
     }
@@ -1122,6 +1817,7 @@ void HDF5Read_checkReadTypeSanity(CSOUND *csound, HDF5Read *self,
     }
     else {
 
+      HDF5IO_releaseLock(csound);
       csound->Die(csound, "%s", Str("hdf5read: Unable to read saved type of "
                               "dataset, exiting"));
     }
@@ -1176,6 +1872,7 @@ void HDF5Read_allocateArray(CSOUND *csound, HDF5Dataset *dataset,
 // Then allocate the array data for the output argument
 // Allocate the memory for the offset variable
 // If it's an a-rate array and sample accurate allocate data for the sample buffer
+// Allocate the read buffer and start reading ahead
 // Else if it's an i-rate array copy the array dimensions including the last one
 // Then allocate the array data for the output argument
 // Cast the argument pointer to an array, then read the data into the array from
@@ -1222,6 +1919,9 @@ void HDF5Read_initialiseArrayOutput(CSOUND *csound, HDF5Read *self,
                            &dataset->sampleBufferMemory);
           dataset->sampleBuffer = dataset->sampleBufferMemory.auxp;
       }
+
+      HDF5Read_newIOBuffer(csound, self, dataset,
+                           dataset->readType == ARATE_ARRAY ? self->ksmps : 1);
 #ifdef _MSC_VER
       free (arrayDimensions);
 #endif
@@ -1259,8 +1959,9 @@ void HDF5Read_initialiseArrayOutput(CSOUND *csound, HDF5Read *self,
 // Allocate the dataset size memory, get the size of the dataset and copy to
 // the size memory
 // Allocate offset memory and set to 0
-// If the dataset is to be read at a-rate and we are running sample accurate
-// allocate the sample buffer
+// If the dataset is to be read at a-rate allocate the sample buffer, used in
+// sample accurate mode and for the last vector of the dataset
+// Allocate the read buffer and start reading ahead
 // Otherwise create array dimesions variable, set to 1, create offset variable,
 // set to 0 and read the i-rate variable
 
@@ -1288,9 +1989,7 @@ void HDF5Read_initialiseScalarOutput(CSOUND *csound, HDF5Read *self,
       dataset->offset = dataset->offsetMemory.auxp;
       memset(dataset->offset, 0, sizeof(hsize_t));
 
-      if (dataset->readType == ARATE_VAR
-          &&
-          self->isSampleAccurate == true) {
+      if (dataset->readType == ARATE_VAR) {
 
         csound->AuxAlloc(csound, self->ksmps * sizeof(MYFLT),
                          &dataset->sampleBufferMemory);
@@ -1298,6 +1997,12 @@ void HDF5Read_initialiseScalarOutput(CSOUND *csound, HDF5Read *self,
         dataset->elementCount = 1;
       }
 
+      if (dataset->readType != IRATE_VAR && dataset->readAll == false) {
+
+        HDF5Read_newIOBuffer(csound, self, dataset,
+                             dataset->readType == ARATE_VAR ? self->ksmps : 1);
+      }
+
       if (dataset->readType == IRATE_VAR) {
 
         hsize_t arrayDimensions[1] = {1};
@@ -1409,6 +2114,26 @@ static OENTRY localops[] = {
     .iopadr = (SUBR)HDF5Read_initialise,
     .kopadr = (SUBR)HDF5Read_process,
     .aopadr = NULL
+  },
+  {
+    .opname = "hdf5buffer",
+    .dsblksiz = sizeof(HDF5Buffer),
+    .thread = 1,
+    .outypes = "",
+    .intypes = "io",
+    .iopadr = (SUBR)HDF5IO_setBuffer,
+    .kopadr = NULL,
+    .aopadr = NULL
+  },
+  {
+    .opname = "hdf5chunk",
+    .dsblksiz = sizeof(HDF5ChunkOpcode),
+    .thread = 1,
+    .outypes = "",
+    .intypes = "Sio",
+    .iopadr = (SUBR)HDF5IO_setChunk,
+    .kopadr = NULL,
+    .aopadr = NULL
   }
 };
 
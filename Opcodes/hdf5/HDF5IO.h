@@ -71,6 +71,31 @@ typedef struct HDF5Dataset
 
     bool readAll;
 
+    // Rows are the elements of the first (time) dimension, batches of rows
+    // are written and read with one HDF5 call through a buffer of two halves,
+    // the second half is only used when there is a background I/O thread
+
+    size_t rowSize;
+    size_t batchRows;
+    MYFLT *ioBuffer[2];
+    AUXCH ioBufferMemory;
+    size_t bufferRows[2];
+    size_t bufferPosition;
+    int32_t currentBuffer;
+    hsize_t ioOffset;
+
+    // Job for the I/O thread, a dataset has at most one pending job
+
+    struct HDF5File *hdf5File;
+    bool isWriting;
+    int32_t pending[2];
+    int32_t jobBuffer;
+    hsize_t jobOffset;
+    size_t jobRows;
+    bool ioFailed;
+    void *jobDone;
+    struct HDF5Dataset *nextJob;
+
 } HDF5Dataset;
 
 typedef struct HDF5File
@@ -81,6 +106,59 @@ typedef struct HDF5File
 
 } HDF5File;
 
+// Per dataset storage settings from hdf5chunk
+
+typedef struct HDF5Chunk
+{
+    char *datasetName;
+    int32_t kperiods;
+    int32_t deflate;
+    struct HDF5Chunk *next;
+
+} HDF5Chunk;
+
+// Settings and background I/O thread shared by the hdf5 opcodes of
+// one csound instance
+
+typedef struct HDF5Globals
+{
+    CSOUND *csound;
+    int32_t kperiods;
+    bool useThread;
+    HDF5Chunk *chunks;
+    void *hdf5Lock;
+    bool locked;
+    void *queueLock;
+    HDF5Dataset *jobHead;
+    HDF5Dataset *jobTail;
+    void *wakeup;
+    void *thread;
+    int32_t running;
+
+} HDF5Globals;
+
+#define HDF5IO_DEFAULT_KPERIODS     64
+#define HDF5IO_MAX_CHUNK_BYTES      (1024 * 1024)
+
+typedef struct HDF5Buffer
+{
+    OPDS h;
+    MYFLT *kperiods;
+    MYFLT *useThread;
+
+} HDF5Buffer;
+
+typedef struct HDF5ChunkOpcode
+{
+    OPDS h;
+    STRINGDAT *datasetName;
+    MYFLT *kperiods;
+    MYFLT *deflate;
+
+} HDF5ChunkOpcode;
+
+HDF5Globals *HDF5IO_getGlobals(CSOUND *csound);
+
 
 HDF5File *HDF5IO_newHDF5File(CSOUND *csound, AUXCH *hdf5FileMemory,
                              STRINGDAT *path, bool openForWriting);
@@ -97,6 +175,8 @@ typedef struct HDF5Write
     AUXCH hdf5FileMemory;
     HDF5Dataset *datasets;
     AUXCH datasetsMemory;
+    HDF5Globals *globals;
+    bool useThread;
 
 } HDF5Write;
 
@@ -128,6 +208,8 @@ typedef struct HDF5Read
     HDF5Dataset *datasets;
     AUXCH datasetsMemory;
     bool isSampleAccurate;
+    HDF5Globals *globals;
+    bool useThread;
 
 } HDF5Read;
 
@@ -25,6 +25,13 @@
 /* #include "csdl.h" */
 #include "csoundCore.h"
 #include "mp3dec.h"
+#include "sndstream.h"
+
+/* By default mp3in, mp3len and mp3scal run their own mp3dec decoder  */
+/* over the file, as they always have.  With --mp3-stream they read   */
+/* through the shared stream layer in InOut/sndstream.c instead, so    */
+/* that any file libsndfile can decode works as well as MP3, positions */
+/* in the file are exact, and the output is gapless.                   */
 
 typedef struct {
   OPDS    h;
@@ -44,6 +51,11 @@ typedef struct {
   uint8_t  *buf;
   AUXCH    auxch;
   FDCH     fdch;
+  /* --mp3-stream: bufSize and bufused count frames, pos is the next */
+  /* frame of the file to read, and buf holds float frames           */
+  SNDSTREAM *snd;         /* shared, decoded in blocks */
+  int32_t  nChannels;     /* of the file */
+  uint32_t bufpos;        /* next frame of buf to play */
 } MP3IN;
 
 
@@ -60,9 +72,98 @@ int32_t mp3in_cleanup(CSOUND *csound, MP3IN *p)
     if (LIKELY(p->mpa != NULL))
       mp3dec_uninit(p->mpa);
     p->mpa = NULL;
+    sndstream_close(p->snd);
+    p->snd = NULL;
     return OK;
 }
 
+static void mp3_name(CSOUND *csound, char *name, MYFLT *iFileCode,
+                     int32_t stringname)
+{
+    /* FIXME: name can overflow with very long string -- truncates safely */
+    if (stringname==0){
+      if (csound->ISSTRCOD(*iFileCode))
+        strNcpy(name,get_arg_string(csound, *iFileCode), 1023);
+      else csound->strarg2name(csound, name, iFileCode, "soundin.",0);
+    }
+    else strNcpy(name, ((STRINGDAT *)iFileCode)->data, 1023);
+}
+
+static void mp3_describe(CSOUND *csound, const SNDSTREAM_INFO *info)
+{
+    char temp[80];            /* Could be as low as 20 */
+    int32_t secs = (int32_t) (info->frames / info->sr);
+    if (info->type != SNDSTREAM_MP3) {
+      csound->Warning(csound, "Input:  %d channels, %d Hz  (%d:%02d)\n",
+                      info->channels, info->sr, secs/60, secs%60);
+      return;
+    }
+    if (info->sr < 16000) strcpy(temp, "MPEG-2.5 ");
+    else if (info->sr < 32000) strcpy(temp, "MPEG-2 ");
+    else strcpy(temp, "MPEG-1 ");
+    if (info->layer == 1) strcat(temp, "Layer I");
+    else if (info->layer == 2) strcat(temp, "Layer II");
+    else strcat(temp, "Layer III");
+    csound->Warning(csound, "Input:  %s, %s, %d kbps, %d Hz  (%d:%02d)\n",
+                    temp, ((info->channels > 1) ? "stereo" : "mono"),
+                    info->bitrate, info->sr, secs/60, secs%60);
+}
+
+static int32_t mp3ininit_stream(CSOUND *csound, MP3IN *p, int32_t stringname)
+{
+    char    name[1024];
+    const SNDSTREAM_INFO *info;
+    int32_t buffersize;
+    int64_t skip;
+
+    /* if already open, close old file first */
+    if (p->snd != NULL) {
+      /* skip initialisation if requested */
+      if (*(p->iSkipInit) != FL(0.0))
+        return OK;
+      sndstream_close(p->snd);
+      p->snd = NULL;
+    }
+    mp3_name(csound, name, p->iFileCode, stringname);
+    if (UNLIKELY((p->snd = sndstream_open(csound, name)) == NULL)) {
+      return
+        csound->InitError(csound, Str("mp3in: %s: failed to open file"), name);
+    }
+    if (p->initDone == 0)
+      csound->RegisterDeinitCallback(csound, p,
+                                     (int32_t (*)(CSOUND*, void*)) mp3in_cleanup);
+    info = sndstream_info(p->snd);
+    mp3_describe(csound, info);
+    /* skip initialisation if requested */
+    if (*(p->iSkipInit) != FL(0.0)) {
+      p->initDone = -1;
+      return OK;
+    }
+    /* set file parameters from header info */
+    if ((int32_t) (CS_ESR + FL(0.5)) != info->sr) {
+      csound->Warning(csound, Str("mp3in: file sample rate (%d) "
+                                  "!= orchestra sr (%d)\n"),
+                      info->sr, (int32_t) (CS_ESR + FL(0.5)));
+    }
+    /* initialise buffer; ibufsize is in bytes, as it was for 16 bit data */
+    p->nChannels = info->channels;
+    buffersize = (*p->ibufsize <= FL(0.0) ? 8*1152 : (int32_t) *p->ibufsize)
+                 / (2 * p->nChannels);
+    if (buffersize < (int32_t) CS_KSMPS)
+      buffersize = CS_KSMPS;
+    p->bufSize = buffersize;
+    if (p->auxch.auxp == NULL ||
+        p->auxch.size < buffersize * p->nChannels * sizeof(float))
+      csound->AuxAlloc(csound, buffersize * p->nChannels * sizeof(float),
+                       &p->auxch);
+    p->buf = (uint8_t *) p->auxch.auxp;
+    skip = (int64_t) (*p->iSkipTime * info->sr);
+    p->pos = (skip > 0 ? skip : 0);
+    p->bufused = p->bufpos = 0;
+    /* done initialisation */
+    p->initDone = -1;
+    return OK;
+}
 
 int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
 {
@@ -79,6 +180,8 @@ int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
     /* uint64_t maxsize; */
     int32_t r;
     int32_t skip;
+    if (csound->oparms->mp3Stream)
+      return mp3ininit_stream(csound, p, stringname);
     if (p->OUTOCOUNT==1) config.mode = MPADEC_CONFIG_MONO;
     /* if already open, close old file first */
     if (p->fdch.fd != NULL) {
@@ -101,15 +204,7 @@ int32_t mp3ininit_(CSOUND *csound, MP3IN *p, int32_t stringname)
       return csound->InitError(csound, "%s", mp3dec_error(r));
     }
 
-
-    /* FIXME: name can overflow with very long string -- truncates safely */
-    if (stringname==0){
-      if (csound->ISSTRCOD(*p->iFileCode))
-        strNcpy(name,get_arg_string(csound, *p->iFileCode), 1023);
-      else csound->strarg2name(csound, name, p->iFileCode, "soundin.",0);
-    }
-    else strNcpy(name, ((STRINGDAT *)p->iFileCode)->data, 1023);
-
+    mp3_name(csound, name, p->iFileCode, stringname);
     if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
                                    name, "rb", "SFDIR;SSDIR",
                                    CSFTYPE_OTHER_BINARY, 0) == NULL)) {
@@ -206,6 +301,54 @@ int32_t mp3ininit_S(CSOUND *csound, MP3IN *p){
     return mp3ininit_(csound,p,1);
 }
 
+static int32_t mp3in_stream(CSOUND *csound, MP3IN *p)
+{
+    MYFLT *al       = p->ar[0];
+    MYFLT *ar       = p->ar[1];
+    float *buf      = (float *) p->buf;
+    int32_t nch     = p->nChannels;
+    MYFLT scale     = csound->e0dbfs;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t n, nsmps = CS_KSMPS;
+
+    if (UNLIKELY(offset)) {
+      memset(al, '\0', offset*sizeof(MYFLT));
+      if (p->OUTOCOUNT > 1) memset(ar, '\0', offset*sizeof(MYFLT));
+    }
+    if (UNLIKELY(early)) {
+      nsmps -= early;
+      memset(&al[nsmps], '\0', early*sizeof(MYFLT));
+      if (p->OUTOCOUNT > 1) memset(&ar[nsmps], '\0', early*sizeof(MYFLT));
+    }
+    for (n=offset; n<nsmps; n++) {
+      float *frm;
+      if (p->bufpos >= p->bufused) {
+        int64_t got = sndstream_read(p->snd, p->pos, buf, p->bufSize);
+        if (UNLIKELY(got <= 0)) {             /* end of file */
+          memset(&al[n], 0, (nsmps-n)*sizeof(MYFLT));
+          if (p->OUTOCOUNT > 1) memset(&ar[n], 0, (nsmps-n)*sizeof(MYFLT));
+          break;
+        }
+        p->pos += got;
+        p->bufused = (uint32_t) got;
+        p->bufpos = 0;
+      }
+      frm = &buf[p->bufpos++ * nch];
+      if (p->OUTOCOUNT == 1) {                /* mono: mean of the channels */
+        MYFLT sum = FL(0.0);
+        int32_t i;
+        for (i = 0; i < nch; i++)
+          sum += (MYFLT) frm[i];
+        al[n] = sum / nch * scale;
+      }
+      else {                                  /* a mono file plays on both */
+        al[n] = (MYFLT) frm[0] * scale;
+        ar[n] = (MYFLT) frm[nch > 1 ? 1 : 0] * scale;
+      }
+    }
+    return OK;
+}
 
 int32_t mp3in(CSOUND *csound, MP3IN *p)
 {
@@ -219,6 +362,8 @@ int32_t mp3in(CSOUND *csound, MP3IN *p)
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t i, n, nsmps = CS_KSMPS;
 
+    if (p->snd != NULL)
+      return mp3in_stream(csound, p);
     if (UNLIKELY(offset)) {
       memset(al, '\0', offset*sizeof(MYFLT));
       memset(ar, '\0', offset*sizeof(MYFLT));
@@ -258,6 +403,30 @@ int32_t mp3in(CSOUND *csound, MP3IN *p)
     return OK;
 }
 
+static int32_t mp3len_stream(CSOUND *csound, MP3LEN *p, const char *name)
+{
+    SNDSTREAM *snd;
+    const SNDSTREAM_INFO *info;
+    const char *opname = csound->GetOpcodeName(&p->h);
+
+    if (UNLIKELY((snd = sndstream_open(csound, name)) == NULL)) {
+      return
+        csound->InitError(csound, Str("mp3in: %s: failed to open file"), name);
+    }
+    info = sndstream_info(snd);
+    if(!strcmp(opname, "mp3len"))
+      *p->ir = (MYFLT) info->frames / (MYFLT) info->sr;
+    else if(!strcmp(opname, "mp3sr"))
+      *p->ir = (MYFLT) info->sr;
+    else if(!strcmp(opname, "mp3bitrate"))
+      *p->ir = (MYFLT) info->bitrate;
+    else if(!strcmp(opname, "mp3nchnls"))
+      *p->ir = (MYFLT) info->channels;
+    /* the stream stays indexed for the opcodes that play the file */
+    sndstream_close(snd);
+    return OK;
+}
+
 int32_t mp3len_(CSOUND *csound, MP3LEN *p, int32_t stringname)
 {
     char     name[1024];
@@ -270,6 +439,9 @@ int32_t mp3len_(CSOUND *csound, MP3LEN *p, int32_t stringname)
     mpadec_info_t mpainfo;
     int32_t  r;
 
+    mp3_name(csound, name, p->iFileCode, stringname);
+    if (csound->oparms->mp3Stream)
+      return mp3len_stream(csound, p, name);
     /* open file */
     mpa = mp3dec_init();
     if (UNLIKELY(!mpa)) {
@@ -279,13 +451,6 @@ int32_t mp3len_(CSOUND *csound, MP3LEN *p, int32_t stringname)
       mp3dec_uninit(mpa);
       return csound->InitError(csound, "%s", mp3dec_error(r));
     }
-    /* FIXME: name can overflow with very long string -- safely truncated */
-    if (stringname==0){
-      if (csound->ISSTRCOD(*p->iFileCode))
-        strNcpy(name,get_arg_string(csound, *p->iFileCode), 1023);
-      else csound->strarg2name(csound, name, p->iFileCode, "soundin.",0);
-    }
-    else strNcpy(name, ((STRINGDAT *)p->iFileCode)->data, 1023);
     if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
                                    name, "rb", "SFDIR;SSDIR",
                                    CSFTYPE_OTHER_BINARY, 0) == NULL)) {
@@ -341,6 +506,8 @@ typedef struct dats{
   char curbuf;
   mp3dec_t mpa;
   FDCH    fdch;
+  SNDSTREAM *snd;         /* --mp3-stream */
+  int64_t rdpos;          /* next frame of the file for fillbuf */
   MYFLT resamp;
   double tstamp, incr;
   int32_t initDone;
@@ -361,6 +528,9 @@ int32_t mp3scale_cleanup(CSOUND *csound, DATASPACE *p)
     IGN(csound);
     if (p->mpa != NULL)
       mp3dec_uninit(p->mpa);
+    p->mpa = NULL;
+    sndstream_close(p->snd);
+    p->snd = NULL;
     return OK;
 }
 
@@ -439,6 +609,7 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
 {
     uint32_t size;
     char *name;
+    int32_t sr, nch = MP3_CHNS;
     // open file
     int32_t  fd;
     int32_t  r;
@@ -453,60 +624,57 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
       clock_gettime(CLOCK_MONOTONIC, &ts);
       dtime = ts.tv_sec + 1e-9*ts.tv_nsec;*/
     name = ((STRINGDAT *)p->knum)->data;
-    p->mpa = mpa = mp3dec_init();
-    if (UNLIKELY(!mpa)) {
-      return csound->InitError(csound, Str("Not enough memory\n"));
-    }
-    if (UNLIKELY((r = mp3dec_configure(mpa, &config)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      p->mpa = NULL;
-      return csound->InitError(csound, "%s", mp3dec_error(r));
+    mp3scale_cleanup(csound, p);
+    if (csound->oparms->mp3Stream) {
+      const SNDSTREAM_INFO *info;
+      if (UNLIKELY((p->snd = sndstream_open(csound, name)) == NULL)) {
+        return
+          csound->InitError(csound, Str("mp3scale: %s: failed to open file"),
+                            name);
+      }
+      info = sndstream_info(p->snd);
+      sr = info->sr;
+      nch = info->channels;
     }
-    if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
-                                   name, "rb", "SFDIR;SSDIR",
-                                   CSFTYPE_OTHER_BINARY, 0) == NULL)) {
-      mp3dec_uninit(mpa);
-      return
-        csound->InitError(csound, Str("mp3scale: %s: failed to open file"), name);
-    }// else
-    // csound->Message(csound, Str("mp3scale: open %s\n"), name);
-    if (UNLIKELY((r = mp3dec_init_file(mpa, fd, 0, FALSE)) != MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      return csound->InitError(csound, "%s", mp3dec_error(r));
-    } // else
-    // csound->Message(csound, Str("mp3scale: init %s\n"), name);
-
-    if (UNLIKELY((r = mp3dec_get_info(mpa, &mpainfo, MPADEC_INFO_STREAM)) !=
-                 MP3DEC_RETCODE_OK)) {
-      mp3dec_uninit(mpa);
-      return csound->InitError(csound, "%s", mp3dec_error(r));
+    else {
+      p->mpa = mpa = mp3dec_init();
+      if (UNLIKELY(!mpa)) {
+        return csound->InitError(csound, Str("Not enough memory\n"));
+      }
+      if (UNLIKELY((r = mp3dec_configure(mpa, &config)) != MP3DEC_RETCODE_OK)) {
+        mp3dec_uninit(mpa);
+        p->mpa = NULL;
+        return csound->InitError(csound, "%s", mp3dec_error(r));
+      }
+      if (UNLIKELY(csound->FileOpen2(csound, &fd, CSFILE_FD_R,
+                                     name, "rb", "SFDIR;SSDIR",
+                                     CSFTYPE_OTHER_BINARY, 0) == NULL)) {
+        mp3dec_uninit(mpa);
+        p->mpa = NULL;
+        return
+          csound->InitError(csound, Str("mp3scale: %s: failed to open file"),
+                            name);
+      }
+      if (UNLIKELY((r = mp3dec_init_file(mpa, fd, 0, FALSE)) !=
+                   MP3DEC_RETCODE_OK)) {
+        mp3dec_uninit(mpa);
+        p->mpa = NULL;
+        return csound->InitError(csound, "%s", mp3dec_error(r));
+      }
+      if (UNLIKELY((r = mp3dec_get_info(mpa, &mpainfo, MPADEC_INFO_STREAM)) !=
+                   MP3DEC_RETCODE_OK)) {
+        mp3dec_uninit(mpa);
+        p->mpa = NULL;
+        return csound->InitError(csound, "%s", mp3dec_error(r));
+      }
+      sr = mpainfo.frequency;
     }
 
-    /* {
-       char temp[80];
-       if (mpainfo.frequency < 16000) strcpy(temp, "MPEG-2.5 ");
-       else if (mpainfo.frequency < 32000) strcpy(temp, "MPEG-2 ");
-       else strcpy(temp, "MPEG-1 ");
-       if (mpainfo.layer == 1) strcat(temp, "Layer I");
-       else if (mpainfo.layer == 2) strcat(temp, "Layer II");
-       else strcat(temp, "Layer III");
-       csound->Warning(csound, "Input:  %s, %s, %d kbps, %d Hz  (%d:%02d)\n",
-       temp, ((mpainfo.channels > 1) ? "stereo" : "mono"),
-       mpainfo.bitrate, mpainfo.frequency, mpainfo.duration/60,
-       mpainfo.duration%60);
-       }*/
-
-    if(mpainfo.frequency != CS_ESR)
-      p->resamp = mpainfo.frequency/CS_ESR;
+    if(sr != CS_ESR)
+      p->resamp = sr/CS_ESR;
     else
       p->resamp = 1;
 
-    /*clock_gettime(CLOCK_MONOTONIC, &ts);
-      dtime = ts.tv_sec + 1e-9*ts.tv_nsec - dtime;
-      csound->Message(csound, "MP3 INIT time %f ms", dtime*1000);
-      clock_gettime(CLOCK_MONOTONIC, &ts);
-      dtime = ts.tv_sec + 1e-9*ts.tv_nsec;*/
-
     {
       char *ps;
       sinit(csound, p);
@@ -521,31 +689,25 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
       ps = (char *) p->fdata[1].auxp;
       p->indataR[0] = (MYFLT*) ps;
       p->indataR[1] = (MYFLT*) (ps + size/2);
+      /* interleaved frames of the file for fillbuf */
+      if (p->snd != NULL)
+        size = (p->N*BUFS/2)*nch*sizeof(float);
       if (p->buffer.auxp == NULL || p->buffer.size < size)
         csound->AuxAlloc(csound, size, &p->buffer);
     }
-    /*
-      memset(&(p->fdch), 0, sizeof(FDCH));
-      p->fdch.fd = fd;
-      fdrecord(csound, &(p->fdch));
-    */
-    printf("fftsize = %d\n", p->N);
-    int32_t buffersize = size;
-    buffersize /= mpainfo.decoded_sample_size;
-    int32_t skip = (int32_t)(*p->skip*CS_ESR)*p->resamp;
+    if (p->snd != NULL) {
+      int64_t skip = (int64_t) (*p->skip*sr);
+      p->rdpos = (skip > 0 ? skip : 0);
+    }
+    else {
+      int32_t skip = (int32_t)(*p->skip*CS_ESR)*p->resamp;
+      mp3dec_seek(mpa, skip, MP3DEC_SEEK_SAMPLES);
+    }
     p->bufused = -1;
 
-    /*while (skip > 0) {
-      int32_t xx= skip;
-      if (xx > buffersize) xx = buffersize;
-      skip -= xx;
-      r = mp3dec_decode(mpa, p->buffer.auxp,
-      mpainfo.decoded_sample_size*xx, &p->bufused);
-      }*/
-    mp3dec_seek(mpa, skip, MP3DEC_SEEK_SAMPLES);
-
     // fill buffers
     p->curbuf = 0;
+    p->finished = 0;
     fillbuf(csound,p,p->N*BUFS/2);
     p->pos = p->hsize;
     p->tscale  = 0;
@@ -553,11 +715,10 @@ static int32_t sinit3_(CSOUND *csound, DATASPACE *p)
     p->tab[0] = (MYFLT *) p->fdata[0].auxp;
     p->tab[1] = (MYFLT *) p->fdata[1].auxp;
     p->tstamp = 0;
-    if(p->initDone == -1)
+    if(p->initDone != -1)
       csound->RegisterDeinitCallback(csound, p,
                                      (int32_t (*)(CSOUND*, void*))mp3scale_cleanup);
     p->initDone = -1;
-    p->finished = 0;
     p->init = 1;
 
     /*clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -597,14 +758,14 @@ static int32_t sinit3(CSOUND *csound, DATASPACE *p) {
 */
 void fillbuf(CSOUND *csound, DATASPACE *p, int32_t nsmps){
     IGN(csound);
-    short *buffer= (short *) p->buffer.auxp;
     MYFLT *data[2];
     data[0] =  p->indataL[(int32_t)p->curbuf];
     data[1] =  p->indataR[(int32_t)p->curbuf];
     int32_t i,j, end;
     memset(data[0],0,nsmps*sizeof(MYFLT));
     memset(data[1],0,nsmps*sizeof(MYFLT));
-    if(!p->finished){
+    if(!p->finished && p->snd == NULL){
+      short *buffer= (short *) p->buffer.auxp;
       mp3dec_decode(p->mpa,p->buffer.auxp,
                     MP3_CHNS*nsmps*sizeof(short),
                     &p->bufused);
@@ -617,6 +778,20 @@ void fillbuf(CSOUND *csound, DATASPACE *p, int32_t nsmps){
         }
       }
     }
+    else if(!p->finished){
+      float *buffer= (float *) p->buffer.auxp;
+      int32_t nch = sndstream_info(p->snd)->channels;
+      end = (int32_t) sndstream_read(p->snd, p->rdpos, buffer, nsmps);
+      if(end <= 0) p->finished = 1;
+      else {
+        p->rdpos += end;
+        p->bufused = end;
+        for(i=0; i < end; i++, buffer += nch){
+          data[0][i] = buffer[0];
+          data[1][i] = buffer[nch > 1 ? 1 : 0];
+        }
+      }
+    }
     p->curbuf = p->curbuf ? 0 : 1;
 }
 
@@ -402,23 +402,36 @@ static int32_t oscbnkset(CSOUND *csound, OSCBNK *p)
 
 /* ---------------- oscbnk performance ---------------- */
 
+/* The oscillators are rendered OSCBNK_LANES at a time: the state of a  */
+/* group is copied to arrays indexed by oscillator, and the inner loop  */
+/* advances every oscillator of the group by one sample, so that it can */
+/* run on vector registers. The outputs are mixed in oscillator order. */
+
+#define OSCBNK_LANES    8
+
 static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
 {
-    int32_t osc_cnt, pm_enabled, am_enabled;
+    int32_t osc_cnt, pm_enabled, am_enabled, nl, j;
     FUNC    *ftp;
-    MYFLT   *ft;
-    uint32  n, lobits, mask, ph, f_i;
-    MYFLT   pfrac, pm, a, f, a1, a2, b0, b1, b2;
-    MYFLT   k, a_d = FL(0.0), a1_d = FL(0.0), a2_d = FL(0.0),
-              b0_d = FL(0.0), b1_d = FL(0.0), b2_d = FL(0.0);
-    MYFLT   yn, xnm1 = FL(0.0), xnm2 = FL(0.0), ynm1 = FL(0.0), ynm2 = FL(0.0);
+    MYFLT   *ft, *ar;
+    uint32  n, lobits, mask;
+    MYFLT   pfrac, pm, f, k, yn;
+    uint32  ph[OSCBNK_LANES], f_i[OSCBNK_LANES];
+    MYFLT   a[OSCBNK_LANES], a_d[OSCBNK_LANES], y[OSCBNK_LANES];
+    MYFLT   a1[OSCBNK_LANES], a2[OSCBNK_LANES];
+    MYFLT   b0[OSCBNK_LANES], b1[OSCBNK_LANES], b2[OSCBNK_LANES];
+    MYFLT   a1_d[OSCBNK_LANES], a2_d[OSCBNK_LANES];
+    MYFLT   b0_d[OSCBNK_LANES], b1_d[OSCBNK_LANES], b2_d[OSCBNK_LANES];
+    MYFLT   xnm1[OSCBNK_LANES], xnm2[OSCBNK_LANES];
+    MYFLT   ynm1[OSCBNK_LANES], ynm2[OSCBNK_LANES];
     OSCBNK_OSC      *o;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t nn, nsmps = CS_KSMPS;
 
     /* clear output signal */
-    memset(p->args[0], '\0', nsmps*sizeof(MYFLT));
+    ar = p->args[0];
+    memset(ar, '\0', nsmps*sizeof(MYFLT));
 
     if (p->nr_osc == -1) {
       return OK;         /* nothing to render */
@@ -453,44 +466,34 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
     }
 
     if (UNLIKELY(early)) nsmps -= early;
-    for (osc_cnt = 0, o = p->osc; osc_cnt < p->nr_osc; osc_cnt++, o++) {
-      if (p->init_k) oscbnk_lfo(p, o);
-      ph = o->osc_phs;                        /* phase        */
-      pm = o->osc_phm;                        /* phase mod.   */
-      if ((p->init_k) && (pm_enabled)) {
-        f = pm - (MYFLT) ((int32) pm);
-        ph = (ph + OSCBNK_PHS2INT(f)) & OSCBNK_PHSMSK;
+    for (osc_cnt = 0; osc_cnt < p->nr_osc; osc_cnt += nl) {
+      nl = p->nr_osc - osc_cnt;
+      if (nl > OSCBNK_LANES) nl = OSCBNK_LANES;
+      /* load the state of the group, and set up the ramps; unused */
+      /* lanes run silently on a zero phase                        */
+      for (j = 0; j < OSCBNK_LANES; j++) {
+        ph[j] = f_i[j] = 0UL;
+        a[j] = a_d[j] = FL(0.0);
+        a1[j] = a2[j] = b0[j] = b1[j] = b2[j] = FL(0.0);
+        a1_d[j] = a2_d[j] = b0_d[j] = b1_d[j] = b2_d[j] = FL(0.0);
+        xnm1[j] = xnm2[j] = ynm1[j] = ynm2[j] = FL(0.0);
       }
-      a = o->osc_amp;                         /* amplitude    */
-      f = o->osc_frq;                         /* frequency    */
-      if (p->ieqmode < 0) {           /* EQ disabled */
-        oscbnk_lfo(p, o);
-        /* initialise ramps */
-        f = ((o->osc_frq + f) * FL(0.5) + *(p->args[1])) * p->frq_scl;
-        if (pm_enabled) {
-          f += (MYFLT) ((double) o->osc_phm - (double) pm) / (nsmps-offset);
-          f -= (MYFLT) ((int32) f);
+      for (j = 0, o = p->osc + osc_cnt; j < nl; j++, o++) {
+        if (p->init_k) oscbnk_lfo(p, o);
+        ph[j] = o->osc_phs;                   /* phase        */
+        pm = o->osc_phm;                      /* phase mod.   */
+        if ((p->init_k) && (pm_enabled)) {
+          f = pm - (MYFLT) ((int32) pm);
+          ph[j] = (ph[j] + OSCBNK_PHS2INT(f)) & OSCBNK_PHSMSK;
         }
-        f_i = OSCBNK_PHS2INT(f);
-        if (am_enabled) a_d = (o->osc_amp - a)  / (nsmps-offset);
-        /* oscillator */
-        for (nn = offset; nn < nsmps; nn++) {
-          /* read from table */
-          n = ph >> lobits; k = ft[n++];
-          k += (ft[n] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
-          /* amplitude modulation */
-          if (am_enabled) k *= (a += a_d);
-          /* mix to output */
-          p->args[0][nn] += k;
-          /* update phase */
-          ph = (ph + f_i) & OSCBNK_PHSMSK;
+        a[j] = o->osc_amp;                    /* amplitude    */
+        f = o->osc_frq;                       /* frequency    */
+        if (p->ieqmode >= 0) {
+          a1[j] = o->a1; a2[j] = o->a2;       /* EQ coeffs    */
+          b0[j] = o->b0; b1[j] = o->b1; b2[j] = o->b2;
+          xnm1[j] = o->xnm1; xnm2[j] = o->xnm2;
+          ynm1[j] = o->ynm1; ynm2[j] = o->ynm2;
         }
-      }
-      else {                        /* EQ enabled */
-        a1 = o->a1; a2 = o->a2;         /* EQ coeffs    */
-        b0 = o->b0; b1 = o->b1; b2 = o->b2;
-        xnm1 = o->xnm1; xnm2 = o->xnm2;
-        ynm1 = o->ynm1; ynm2 = o->ynm2;
         oscbnk_lfo(p, o);
         /* initialise ramps */
         f = ((o->osc_frq + f) * FL(0.5) + *(p->args[1])) * p->frq_scl;
@@ -498,71 +501,75 @@ static int32_t oscbnk(CSOUND *csound, OSCBNK *p)
           f += (MYFLT) ((double) o->osc_phm - (double) pm) / (nsmps-offset);
           f -= (MYFLT) ((int32) f);
         }
-        f_i = OSCBNK_PHS2INT(f);
-        if (am_enabled) a_d = (o->osc_amp - a) / (nsmps-offset);
-        if (p->eq_interp) {     /* EQ w/ interpolation */
-          a1_d = (o->a1 - a1) / (nsmps-offset);
-          a2_d = (o->a2 - a2) / (nsmps-offset);
-          b0_d = (o->b0 - b0) / (nsmps-offset);
-          b1_d = (o->b1 - b1) / (nsmps-offset);
-          b2_d = (o->b2 - b2) / (nsmps-offset);
-          /* oscillator */
-          for (nn = offset; nn < nsmps; nn++) {
-            /* update ramps */
-            a1 += a1_d; a2 += a2_d;
-            b0 += b0_d; b1 += b1_d; b2 += b2_d;
+        f_i[j] = OSCBNK_PHS2INT(f);
+        /* without AM the amplitude stays at 1, which leaves k unchanged */
+        if (am_enabled) a_d[j] = (o->osc_amp - a[j]) / (nsmps-offset);
+        else a[j] = FL(1.0);
+        if (p->ieqmode < 0) continue;
+        if (p->eq_interp) {             /* EQ w/ interpolation */
+          a1_d[j] = (o->a1 - a1[j]) / (nsmps-offset);
+          a2_d[j] = (o->a2 - a2[j]) / (nsmps-offset);
+          b0_d[j] = (o->b0 - b0[j]) / (nsmps-offset);
+          b1_d[j] = (o->b1 - b1[j]) / (nsmps-offset);
+          b2_d[j] = (o->b2 - b2[j]) / (nsmps-offset);
+        }
+        else {                          /* EQ w/o interpolation */
+          a1[j] = o->a1; a2[j] = o->a2;
+          b0[j] = o->b0; b1[j] = o->b1; b2[j] = o->b2;
+        }
+      }
+      if (p->ieqmode < 0) {           /* EQ disabled */
+        for (nn = offset; nn < nsmps; nn++) {
+          for (j = 0; j < OSCBNK_LANES; j++) {
             /* read from table */
-            n = ph >> lobits; k = ft[n++];
-            k += (ft[n] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
+            n = ph[j] >> lobits; k = ft[n];
+            k += (ft[n + 1] - k) * (MYFLT) ((int32) (ph[j] & mask)) * pfrac;
             /* amplitude modulation */
-            if (am_enabled) k *= (a += a_d);
-            /* EQ */
-            yn = b2 * xnm2; yn += b1 * (xnm2 = xnm1); yn += b0 * (xnm1 = k);
-            yn -= a2 * ynm2; yn -= a1 * (ynm2 = ynm1); ynm1 = yn;
-            /* mix to output */
-            //if (yn>1) {
-            //  printf("**** (%d) yn = %f\n", __LINE__, yn);
-            // printf("**** a1 = %f a2 = %f; %f\n",
-            //         a1, a2, 0.5*(-a1+ sqrt(a1*a1-4*a2)/a2));
-            //}
-            p->args[0][nn] += yn;
-            //if (p->args[0][nn]>1)
-            //  printf("**** (%d) out%d = %f\n", __LINE__, nn, p->args[0][nn]);
+            y[j] = k * (a[j] += a_d[j]);
             /* update phase */
-            ph = (ph + f_i) & OSCBNK_PHSMSK;
+            ph[j] = (ph[j] + f_i[j]) & OSCBNK_PHSMSK;
           }
-          /* save EQ coeffs */
-          o->a1 = a1; o->a2 = a2;
-          o->b0 = b0; o->b1 = b1; o->b2 = b2;
+          /* mix to output */
+          for (j = 0; j < nl; j++)
+            ar[nn] += y[j];
         }
-        else {                /* EQ w/o interpolation */
-          /* oscillator */
-          a1 = o->a1; a2 = o->a2;         /* EQ coeffs    */
-          b0 = o->b0; b1 = o->b1; b2 = o->b2;
-          for (nn = offset; nn < nsmps; nn++) {
+      }
+      else {                          /* EQ enabled */
+        for (nn = offset; nn < nsmps; nn++) {
+          for (j = 0; j < OSCBNK_LANES; j++) {
+            /* update ramps */
+            a1[j] += a1_d[j]; a2[j] += a2_d[j];
+            b0[j] += b0_d[j]; b1[j] += b1_d[j]; b2[j] += b2_d[j];
             /* read from table */
-            n = ph >> lobits; k = ft[n++];
-            k += (ft[n] - k) * (MYFLT) ((int32) (ph & mask)) * pfrac;
+            n = ph[j] >> lobits; k = ft[n];
+            k += (ft[n + 1] - k) * (MYFLT) ((int32) (ph[j] & mask)) * pfrac;
             /* amplitude modulation */
-            if (am_enabled) k *= (a += a_d);
+            k *= (a[j] += a_d[j]);
             /* EQ */
-            yn = b2 * xnm2; yn += b1 * (xnm2 = xnm1); yn += b0 * (xnm1 = k);
-            yn -= a2 * ynm2; yn -= a1 * (ynm2 = ynm1); ynm1 = yn;
-            /* mix to output */
-            p->args[0][nn] += yn;
+            yn = b2[j] * xnm2[j]; yn += b1[j] * xnm1[j]; yn += b0[j] * k;
+            yn -= a2[j] * ynm2[j]; yn -= a1[j] * ynm1[j];
+            xnm2[j] = xnm1[j]; xnm1[j] = k;
+            ynm2[j] = ynm1[j]; y[j] = ynm1[j] = yn;
             /* update phase */
-            ph = (ph + f_i) & OSCBNK_PHSMSK;
+            ph[j] = (ph[j] + f_i[j]) & OSCBNK_PHSMSK;
           }
-          /* save EQ coeffs */
-          o->a1 = a1; o->a2 = a2;
-          o->b0 = b0; o->b1 = b1; o->b2 = b2;
+          /* mix to output */
+          for (j = 0; j < nl; j++)
+            ar[nn] += y[j];
+        }
+      }
+      /* save the state of the group */
+      for (j = 0, o = p->osc + osc_cnt; j < nl; j++, o++) {
+        if (p->ieqmode >= 0) {
+          o->a1 = a1[j]; o->a2 = a2[j];       /* EQ coeffs    */
+          o->b0 = b0[j]; o->b1 = b1[j]; o->b2 = b2[j];
+          o->xnm1 = xnm1[j]; o->xnm2 = xnm2[j];   /* EQ state */
+          o->ynm1 = ynm1[j]; o->ynm2 = ynm2[j];
         }
+        /* save amplitude and phase */
+        o->osc_amp = a[j];
+        o->osc_phs = ph[j];
       }
-      o->xnm1 = xnm1; o->xnm2 = xnm2; /* save EQ state */
-      o->ynm1 = ynm1; o->ynm2 = ynm2;
-      /* save amplitude and phase */
-      o->osc_amp = a;
-      o->osc_phs = ph;
     }
     p->init_k = 0;
     return OK;
@@ -1520,37 +1527,128 @@ typedef struct {
     MYFLT   *w_fftbuf;          /* FFT of user specified waveform            */
 } VCO2_TABLE_PARAMS;
 
-/* remove table array for the specified waveform */
+/* Table arrays of the built-in waveforms that are not accessible as   */
+/* ftables depend only on the table parameters, so they are generated */
+/* once and shared by all Csound instances in the process. The list is */
+/* protected by the global lock; an array is freed with its last user. */
 
-static void vco2_delete_table_array(CSOUND *csound, int32_t w)
+static VCO2_TABLE_ARRAY *vco2_shared_tables = NULL;
+
+/* allocate zeroed memory for a table array (shared arrays must */
+/* outlive the Csound instance that created them, and may fail)  */
+
+static void *vco2_calloc(CSOUND *csound, size_t size, int32_t shared)
 {
-    STDOPCOD_GLOBALS  *pp = get_oscbnk_globals(csound);
-    int32_t               j;
+    if (shared)
+      return calloc(1, size);
+    return csound->Calloc(csound, size);
+}
 
-    /* table array does not exist: nothing to do */
-    if (pp->vco2_tables == (VCO2_TABLE_ARRAY**) NULL ||
-        w >= pp->vco2_nr_table_arrays ||
-        pp->vco2_tables[w] == (VCO2_TABLE_ARRAY*) NULL)
+/* free all memory used by a table array */
+
+static void vco2_free_table_array(CSOUND *csound,
+                                  VCO2_TABLE_ARRAY *tables, int32_t shared)
+{
+    int32_t j;
+
+    if (shared) {
+      for (j = 0; j < tables->ntabl; j++)
+        free(tables->tables[j].ftable);
+#ifdef VCO2FT_USE_TABLE
+      free(tables->nparts_tabl);
+#else
+      free(tables->nparts);
+#endif
+      free(tables->tables);
+      free(tables);
       return;
+    }
 #ifdef VCO2FT_USE_TABLE
     /* free number of partials -> table list, */
-    csound->Free(csound, pp->vco2_tables[w]->nparts_tabl);
+    csound->Free(csound, tables->nparts_tabl);
 #else
     /* free number of partials list, */
-    csound->Free(csound, pp->vco2_tables[w]->nparts);
+    csound->Free(csound, tables->nparts);
 #endif
     /* table data (only if not shared as standard Csound ftables), */
-    for (j = 0; j < pp->vco2_tables[w]->ntabl; j++) {
-      if (pp->vco2_tables[w]->base_ftnum < 1)
-        csound->Free(csound, pp->vco2_tables[w]->tables[j].ftable);
+    for (j = 0; j < tables->ntabl; j++) {
+      if (tables->base_ftnum < 1)
+        csound->Free(csound, tables->tables[j].ftable);
     }
     /* table list, */
-    csound->Free(csound, pp->vco2_tables[w]->tables);
+    csound->Free(csound, tables->tables);
     /* and table array structure */
-    csound->Free(csound, pp->vco2_tables[w]);
+    csound->Free(csound, tables);
+}
+
+/* find a shared table array generated with the parameters in tp, and */
+/* take a reference to it; the caller must hold the global lock      */
+
+static VCO2_TABLE_ARRAY *vco2_find_shared(VCO2_TABLE_PARAMS *tp)
+{
+    VCO2_TABLE_ARRAY  *tables;
+
+    for (tables = vco2_shared_tables; tables != NULL; tables = tables->nxt) {
+      if (tables->waveform == tp->waveform &&
+          tables->min_size == tp->min_size &&
+          tables->max_size == tp->max_size &&
+          tables->npart_mul == tp->npart_mul) {
+        tables->refcnt++;
+        return tables;
+      }
+    }
+    return NULL;
+}
+
+/* drop a reference to a shared table array */
+
+static void vco2_release_shared(CSOUND *csound, VCO2_TABLE_ARRAY *tables)
+{
+    VCO2_TABLE_ARRAY  **pp;
+    int32_t           last;
+
+    csoundLock();
+    if ((last = (--(tables->refcnt) == 0))) {
+      for (pp = &vco2_shared_tables; *pp != tables; pp = &((*pp)->nxt))
+        ;
+      *pp = tables->nxt;
+    }
+    csoundUnLock();
+    if (last)
+      vco2_free_table_array(csound, tables, 1);
+}
+
+/* remove table array for the specified waveform */
+
+static void vco2_delete_table_array(CSOUND *csound, int32_t w)
+{
+    STDOPCOD_GLOBALS  *pp = get_oscbnk_globals(csound);
+
+    /* table array does not exist: nothing to do */
+    if (pp->vco2_tables == (VCO2_TABLE_ARRAY**) NULL ||
+        w >= pp->vco2_nr_table_arrays ||
+        pp->vco2_tables[w] == (VCO2_TABLE_ARRAY*) NULL)
+      return;
+    if (pp->vco2_tables[w]->refcnt > 0)
+      vco2_release_shared(csound, pp->vco2_tables[w]);
+    else
+      vco2_free_table_array(csound, pp->vco2_tables[w], 0);
     pp->vco2_tables[w] = NULL;
 }
 
+/* release the shared table arrays used by this instance on reset */
+
+static int32_t vco2_reset(CSOUND *csound, void *p)
+{
+    STDOPCOD_GLOBALS  *pp = (STDOPCOD_GLOBALS*) p;
+    int32_t           w;
+
+    for (w = 0; w < pp->vco2_nr_table_arrays; w++) {
+      if (pp->vco2_tables[w] != NULL && pp->vco2_tables[w]->refcnt > 0)
+        vco2_delete_table_array(csound, w);
+    }
+    return OK;
+}
 /* generate a table using the waveform specified in tp */
 
 static void vco2_calculate_table(CSOUND *csound,
@@ -1677,45 +1775,95 @@ static int32_t vco2_table_size(int32_t npart, VCO2_TABLE_PARAMS *tp)
     return n;
 }
 
-/* Generate table array for the specified waveform (< 0: user defined).  */
-/* The tables can be accessed also as standard Csound ftables, starting  */
-/* from table number "base_ftable" if it is greater than zero.           */
-/* The return value is the first ftable number that is not allocated.    */
+/* Calculate all tables of an array. The tables are independent, so     */
+/* with more than one thread (-j) they are shared out between threads.  */
+/* The FFT setup for each table size is created on first use, which is */
+/* not thread-safe, so the first table of each size is calculated      */
+/* before starting the threads.                                         */
 
-static int32_t vco2_tables_create(CSOUND *csound, int32_t waveform,
-                                  int32_t base_ftable,
-                                  VCO2_TABLE_PARAMS *tp)
-{
-    STDOPCOD_GLOBALS  *pp = get_oscbnk_globals(csound);
-    int32_t               i, npart, ntables;
-    double            npart_f;
+typedef struct {
+    CSOUND            *csound;
     VCO2_TABLE_ARRAY  *tables;
-    VCO2_TABLE_PARAMS tp2;
+    VCO2_TABLE_PARAMS *tp;
+    int32_t           first, step;
+} VCO2_TABLE_JOB;
 
-    /* set default table parameters if not specified in tp */
-    if (tp == NULL) {
-      if (waveform < 0) return -1;
-      vco2_default_table_params(waveform, &tp2);
-      tp = &tp2;
+static int32_t vco2_first_of_size(VCO2_TABLE_ARRAY *tables, int32_t i)
+{
+    return (i == 0 || tables->tables[i].size != tables->tables[i - 1].size);
+}
+
+static uintptr_t vco2_calculate_tables_thread(void *p_)
+{
+    VCO2_TABLE_JOB  *p = (VCO2_TABLE_JOB*) p_;
+    int32_t         i;
+
+    for (i = p->first; i < p->tables->ntabl; i += p->step) {
+      if (!vco2_first_of_size(p->tables, i))
+        vco2_calculate_table(p->csound, &(p->tables->tables[i]), p->tp);
     }
-    waveform = (waveform < 0 ? 4 - waveform : waveform);
-    if (waveform >= pp->vco2_nr_table_arrays) {
-      /* extend space for table arrays */
-      ntables = ((waveform >> 4) + 1) << 4;
-      pp->vco2_tables = (VCO2_TABLE_ARRAY**)
-        csound->ReAlloc(csound, pp->vco2_tables, sizeof(VCO2_TABLE_ARRAY*)
-                                                 * ntables);
-      for (i = pp->vco2_nr_table_arrays; i < ntables; i++)
-        pp->vco2_tables[i] = NULL;
-      pp->vco2_nr_table_arrays = ntables;
+    return 0;
+}
+
+#define VCO2_MAX_THREADS    16
+
+static void vco2_calculate_tables(CSOUND *csound,
+                                  VCO2_TABLE_ARRAY *tables,
+                                  VCO2_TABLE_PARAMS *tp)
+{
+    VCO2_TABLE_JOB  job[VCO2_MAX_THREADS];
+    void            *thread[VCO2_MAX_THREADS];
+    int32_t         i, nthreads;
+
+    nthreads = csound->oparms->numThreads;
+    if (nthreads > VCO2_MAX_THREADS) nthreads = VCO2_MAX_THREADS;
+    if (nthreads > tables->ntabl) nthreads = tables->ntabl;
+    for (i = 0; i < tables->ntabl; i++) {
+      if (tables->tables[i].ftable == NULL)
+        nthreads = 1;                   /* report the error serially */
+    }
+    if (nthreads < 2) {
+      for (i = 0; i < tables->ntabl; i++)
+        vco2_calculate_table(csound, &(tables->tables[i]), tp);
+      return;
     }
-    /* clear table array if already initialised */
-    if (pp->vco2_tables[waveform] != NULL) {
-      vco2_delete_table_array(csound, waveform);
-      csound->Warning(csound,
-                      Str("redefined table array for waveform %d\n"),
-                      (waveform > 4 ? 4 - waveform : waveform));
+    for (i = 0; i < tables->ntabl; i++) {
+      if (vco2_first_of_size(tables, i))
+        vco2_calculate_table(csound, &(tables->tables[i]), tp);
+    }
+    for (i = 0; i < nthreads; i++) {
+      job[i].csound = csound;
+      job[i].tables = tables;
+      job[i].tp = tp;
+      job[i].first = i;
+      job[i].step = nthreads;
+      thread[i] = NULL;
+    }
+    for (i = 1; i < nthreads; i++)
+      thread[i] = csound->CreateThread(vco2_calculate_tables_thread,
+                                       (void*) &(job[i]));
+    vco2_calculate_tables_thread((void*) &(job[0]));
+    for (i = 1; i < nthreads; i++) {
+      if (thread[i] != NULL)
+        csound->JoinThread(thread[i]);
+      else                              /* could not start thread */
+        vco2_calculate_tables_thread((void*) &(job[i]));
     }
+}
+
+/* Allocate and calculate a table array using the parameters in tp. */
+/* If base_ftable is greater than zero, the tables are allocated as */
+/* standard Csound ftables starting from that number.               */
+
+static VCO2_TABLE_ARRAY *vco2_table_array_new(CSOUND *csound,
+                                              int32_t base_ftable,
+                                              VCO2_TABLE_PARAMS *tp,
+                                              int32_t shared)
+{
+    int32_t           i, npart, ntables;
+    double            npart_f;
+    VCO2_TABLE_ARRAY  *tables;
+
     /* calculate number of tables */
     i = tp->max_size >> 1;
     if (i > VCO2_MAX_NPART) i = VCO2_MAX_NPART; /* max number of partials */
@@ -1725,26 +1873,38 @@ static int32_t vco2_tables_create(CSOUND *csound, int32_t waveform,
       vco2_next_npart(&npart_f, tp);
     } while (npart_f <= (double) i);
     /* allocate memory for the table array ... */
-    tables = pp->vco2_tables[waveform] =
-      (VCO2_TABLE_ARRAY*) csound->Calloc(csound, sizeof(VCO2_TABLE_ARRAY));
+    tables = (VCO2_TABLE_ARRAY*) vco2_calloc(csound, sizeof(VCO2_TABLE_ARRAY),
+                                             shared);
+    if (UNLIKELY(tables == NULL))
+      return NULL;
     /* ... and all tables */
 #ifdef VCO2FT_USE_TABLE
     tables->nparts_tabl =
-      (VCO2_TABLE**) csound->Malloc(csound, sizeof(VCO2_TABLE*)
-                                            * (VCO2_MAX_NPART + 1));
+      (VCO2_TABLE**) vco2_calloc(csound, sizeof(VCO2_TABLE*)
+                                         * (VCO2_MAX_NPART + 1), shared);
+    if (UNLIKELY(tables->nparts_tabl == NULL))
+      goto err_nomem;
 #else
     tables->nparts =
-        (MYFLT*) csound->Malloc(csound, sizeof(MYFLT) * (ntables * 3));
+      (MYFLT*) vco2_calloc(csound, sizeof(MYFLT) * (ntables * 3), shared);
+    if (UNLIKELY(tables->nparts == NULL))
+      goto err_nomem;
     for (i = 0; i < ntables; i++) {
       tables->nparts[i] = FL(-1.0);     /* padding for number of partials */
       tables->nparts[(ntables << 1) + i] = FL(1.0e24);  /* list */
     }
 #endif
     tables->tables =
-        (VCO2_TABLE*) csound->Calloc(csound, sizeof(VCO2_TABLE) * ntables);
-    /* generate tables */
+      (VCO2_TABLE*) vco2_calloc(csound, sizeof(VCO2_TABLE) * ntables, shared);
+    if (UNLIKELY(tables->tables == NULL))
+      goto err_nomem;
+    /* set up tables */
     tables->ntabl = ntables;            /* store number of tables */
     tables->base_ftnum = base_ftable;   /* and base ftable number */
+    tables->waveform = tp->waveform;    /* and table parameters */
+    tables->min_size = tp->min_size;
+    tables->max_size = tp->max_size;
+    tables->npart_mul = tp->npart_mul;
     npart_f = 0.0; i = 0;
     do {
       /* store number of partials, */
@@ -1765,15 +1925,18 @@ static int32_t vco2_tables_create(CSOUND *csound, int32_t waveform,
         csoundGetTable(csound, &(tables->tables[i].ftable), base_ftable);
         base_ftable++;                /* next table number */
       }
-      else    /* ... else allocate memory (cannot be accessed as a       */
+      else {  /* ... else allocate memory (cannot be accessed as a       */
         tables->tables[i].ftable =      /* standard Csound ftable) */
-          (MYFLT*) csound->Malloc(csound, sizeof(MYFLT)
-                                          * (tables->tables[i].size + 1));
-      /* now calculate the table */
-      vco2_calculate_table(csound, &(tables->tables[i]), tp);
+          (MYFLT*) vco2_calloc(csound, sizeof(MYFLT)
+                                       * (tables->tables[i].size + 1), shared);
+        if (UNLIKELY(tables->tables[i].ftable == NULL))
+          goto err_nomem;
+      }
       /* next table */
       vco2_next_npart(&npart_f, tp);
     } while (++i < ntables);
+    /* now calculate the tables */
+    vco2_calculate_tables(csound, tables, tp);
 #ifdef VCO2FT_USE_TABLE
     /* build table for number of harmonic partials -> table lookup */
     i = npart = 0;
@@ -1783,6 +1946,90 @@ static int32_t vco2_tables_create(CSOUND *csound, int32_t waveform,
     } while (npart <= VCO2_MAX_NPART);
 #endif
 
+    return tables;
+ err_nomem:
+    /* only a shared array can fail: its tables are not ftables, and */
+    /* the ones not allocated yet are NULL                           */
+    vco2_free_table_array(csound, tables, shared);
+    return NULL;
+}
+
+/* Generate table array for the specified waveform (< 0: user defined).  */
+/* The tables can be accessed also as standard Csound ftables, starting  */
+/* from table number "base_ftable" if it is greater than zero.           */
+/* The return value is the first ftable number that is not allocated.    */
+/* If a shared table array cannot be allocated, the table array of the   */
+/* waveform is left NULL.                                                */
+
+static int32_t vco2_tables_create(CSOUND *csound, int32_t waveform,
+                                  int32_t base_ftable,
+                                  VCO2_TABLE_PARAMS *tp)
+{
+    STDOPCOD_GLOBALS  *pp = get_oscbnk_globals(csound);
+    int32_t               i, ntables, registered;
+    VCO2_TABLE_ARRAY  *tables, *tables2;
+    VCO2_TABLE_PARAMS tp2;
+
+    /* set default table parameters if not specified in tp */
+    if (tp == NULL) {
+      if (waveform < 0) return -1;
+      vco2_default_table_params(waveform, &tp2);
+      tp = &tp2;
+    }
+    waveform = (waveform < 0 ? 4 - waveform : waveform);
+    if (waveform >= pp->vco2_nr_table_arrays) {
+      /* extend space for table arrays */
+      ntables = ((waveform >> 4) + 1) << 4;
+      pp->vco2_tables = (VCO2_TABLE_ARRAY**)
+        csound->ReAlloc(csound, pp->vco2_tables, sizeof(VCO2_TABLE_ARRAY*)
+                                                 * ntables);
+      for (i = pp->vco2_nr_table_arrays; i < ntables; i++)
+        pp->vco2_tables[i] = NULL;
+      pp->vco2_nr_table_arrays = ntables;
+    }
+    /* clear table array if already initialised */
+    if (pp->vco2_tables[waveform] != NULL) {
+      vco2_delete_table_array(csound, waveform);
+      csound->Warning(csound,
+                      Str("redefined table array for waveform %d\n"),
+                      (waveform > 4 ? 4 - waveform : waveform));
+    }
+    if (base_ftable > 0 || tp->waveform < 0) {
+      /* private to this instance */
+      tables = vco2_table_array_new(csound, base_ftable, tp, 0);
+      pp->vco2_tables[waveform] = tables;
+      return (base_ftable > 0 ? base_ftable + tables->ntabl : base_ftable);
+    }
+    /* built-in waveform without ftable numbers: use the shared array */
+    registered = 0;
+    for (i = 0; i < pp->vco2_nr_table_arrays; i++)
+      if (pp->vco2_tables[i] != NULL && pp->vco2_tables[i]->refcnt > 0)
+        registered = 1;
+    csoundLock();
+    tables = vco2_find_shared(tp);
+    csoundUnLock();
+    if (tables == NULL) {
+      /* not found: generate it without holding the lock, and add it */
+      /* unless another instance has done the same in the meantime   */
+      tables = vco2_table_array_new(csound, base_ftable, tp, 1);
+      if (UNLIKELY(tables == NULL))
+        return base_ftable;
+      csoundLock();
+      if ((tables2 = vco2_find_shared(tp)) == NULL) {
+        tables->refcnt = 1;
+        tables->nxt = vco2_shared_tables;
+        vco2_shared_tables = tables;
+      }
+      csoundUnLock();
+      if (tables2 != NULL) {
+        vco2_free_table_array(csound, tables, 1);
+        tables = tables2;
+      }
+    }
+    pp->vco2_tables[waveform] = tables;
+    if (!registered)
+      csound->RegisterResetCallback(csound, (void*) pp, vco2_reset);
+
     return base_ftable;
 }
 
@@ -1850,6 +2097,10 @@ static int32_t vco2init(CSOUND *csound, VCO2INIT *p)
           if (UNLIKELY(base_ftable > 0 && ftnum <= 0)) {
             return csound->InitError(csound, Str("ftgen error"));
           }
+          if (UNLIKELY(get_oscbnk_globals(csound)->vco2_tables[w] == NULL)) {
+            return csound->InitError(csound, Str("vco2init: not enough memory "
+                                                 "for table array"));
+          }
         }
       }
       else {                      /* user defined, requires source ftable */
@@ -2017,8 +2268,13 @@ static int32_t vco2set(CSOUND *csound, VCO2 *p)
     /* initialise tables if not done yet */
     if (tnum >= *(p->vco2_nr_table_arrays) ||
         (*(p->vco2_tables))[tnum] == NULL) {
-      if (LIKELY(tnum < 5))
+      if (LIKELY(tnum < 5)) {
         vco2_tables_create(csound, tnum, -1, NULL);
+        if (UNLIKELY((*(p->vco2_tables))[tnum] == NULL)) {
+          return csound->InitError(csound, Str("vco2: not enough memory "
+                                               "for table array"));
+        }
+      }
       else {
         return csound->InitError(csound, Str("vco2: table array not found for "
                                              "user defined waveform"));
@@ -223,6 +223,13 @@ struct VCO2_TABLE_ARRAY_ {
     MYFLT   *nparts;            /* number of partials list                   */
 #endif
     VCO2_TABLE  *tables;        /* array of table structures                 */
+    /* table arrays of built-in waveforms that are not accessible as */
+    /* ftables are shared by all Csound instances in the process     */
+    int32_t     refcnt;             /* number of users (0: not shared)           */
+    int32_t     waveform;           /* parameters the array was generated with   */
+    int32_t     min_size, max_size;
+    double      npart_mul;
+    VCO2_TABLE_ARRAY    *nxt;   /* next array in the shared list             */
 };
 
 typedef struct {
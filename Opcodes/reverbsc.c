@@ -206,14 +206,15 @@ static int32_t sc_reverb_init(CSOUND *csound, SC_REVERB *p)
 
 static int32_t sc_reverb_perf(CSOUND *csound, SC_REVERB *p)
 {
-    double    ainL, ainR, aoutL, aoutR;
-    double    vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+    double    ainL, ainR, aoutL, aoutR, feedBack;
+    double    filterState[8], v[8];
+    MYFLT     *buf[8];
+    int32_t   writePos[8], readPos[8], readPosFrac[8], readPosFrac_inc[8];
+    int32_t   bufferSize[8], randLine_cnt[8];
     delayLine *lp;
-    int32_t       readPos;
     uint32_t offset = p->h.insdshead->ksmps_offset;
     uint32_t early  = p->h.insdshead->ksmps_no_end;
     uint32_t i, n, nsmps = CS_KSMPS;
-    int32_t       bufferSize; /* Local copy */
     double    dampFact = p->dampFact;
 
     if (UNLIKELY(p->initDone <= 0)) goto err1;
@@ -232,73 +233,93 @@ static int32_t sc_reverb_perf(CSOUND *csound, SC_REVERB *p)
       memset(&p->aoutL[nsmps], '\0', early*sizeof(MYFLT));
       memset(&p->aoutR[nsmps], '\0', early*sizeof(MYFLT));
     }
+    feedBack = (double) *(p->kFeedBack);
+    /* copy the state of the delay lines to per-line arrays, so that the */
+    /* loops below run across all eight lines in parallel               */
+    for (n = 0; n < 8; n++) {
+      lp = p->delayLines[n];
+      buf[n] = lp->buf;
+      writePos[n] = lp->writePos;
+      readPos[n] = lp->readPos;
+      readPosFrac[n] = lp->readPosFrac;
+      readPosFrac_inc[n] = lp->readPosFrac_inc;
+      bufferSize[n] = lp->bufferSize;
+      randLine_cnt[n] = lp->randLine_cnt;
+      filterState[n] = lp->filterState;
+    }
     /* update delay lines */
     for (i = offset; i < nsmps; i++) {
       /* calculate "resultant junction pressure" and mix to input signals */
       ainL = aoutL = aoutR = 0.0;
       for (n = 0; n < 8; n++)
-        ainL += p->delayLines[n]->filterState;
+        ainL += filterState[n];
       ainL *= jpScale;
       ainR = ainL + (double) p->ainR[i];
       ainL = ainL + (double) p->ainL[i];
-      /* loop through all delay lines */
+      /* send input signal and feedback to delay lines; each line only */
+      /* touches its own buffer, so all writes can be done before the  */
+      /* reads below                                                   */
       for (n = 0; n < 8; n++) {
-        lp = p->delayLines[n];
-        bufferSize = lp->bufferSize;
-        /* send input signal and feedback to delay line */
-        lp->buf[lp->writePos] = (MYFLT) ((n & 1 ? ainR : ainL)
-                                         - lp->filterState);
-        if (UNLIKELY(++lp->writePos >= bufferSize))
-          lp->writePos -= bufferSize;
-        /* read from delay line with cubic interpolation */
-        if (lp->readPosFrac >= DELAYPOS_SCALE) {
-          lp->readPos += (lp->readPosFrac >> DELAYPOS_SHIFT);
-          lp->readPosFrac &= DELAYPOS_MASK;
-        }
-        if (UNLIKELY(lp->readPos >= bufferSize))
-          lp->readPos -= bufferSize;
-        readPos = lp->readPos;
-        frac = (double) lp->readPosFrac * (1.0 / (double) DELAYPOS_SCALE);
+        buf[n][writePos[n]] = (MYFLT) ((n & 1 ? ainR : ainL) - filterState[n]);
+        writePos[n] = (writePos[n] + 1 >= bufferSize[n] ? 0 : writePos[n] + 1);
+      }
+      /* read from delay lines with cubic interpolation */
+      for (n = 0; n < 8; n++) {
+        double  vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+        int32_t rp, rm1, rp1, rp2, bs = bufferSize[n];
+        rp = readPos[n] + (readPosFrac[n] >> DELAYPOS_SHIFT);
+        readPosFrac[n] &= DELAYPOS_MASK;
+        rp = (rp >= bs ? rp - bs : rp);
+        readPos[n] = rp;
+        frac = (double) readPosFrac[n] * (1.0 / (double) DELAYPOS_SCALE);
         /* calculate interpolation coefficients */
         a2 = frac * frac; a2 -= 1.0; a2 *= (1.0 / 6.0);
         a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
         a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
-        /* read four samples for interpolation */
-        if (LIKELY(readPos > 0 && readPos < (bufferSize - 2))) {
-          vm1 = (double) (lp->buf[readPos - 1]);
-          v0  = (double) (lp->buf[readPos]);
-          v1  = (double) (lp->buf[readPos + 1]);
-          v2  = (double) (lp->buf[readPos + 2]);
-        }
-        else {
-          /* at buffer wrap-around, need to check index */
-          if (--readPos < 0) readPos += bufferSize;
-          vm1 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v0 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v1 = (double) lp->buf[readPos];
-          if (++readPos >= bufferSize) readPos -= bufferSize;
-          v2 = (double) lp->buf[readPos];
-        }
+        /* read four samples for interpolation, wrapping the indices */
+        rm1 = (rp > 0 ? rp - 1 : bs - 1);
+        rp1 = (rp + 1 >= bs ? rp + 1 - bs : rp + 1);
+        rp2 = (rp + 2 >= bs ? rp + 2 - bs : rp + 2);
+        vm1 = (double) buf[n][rm1];
+        v0  = (double) buf[n][rp];
+        v1  = (double) buf[n][rp1];
+        v2  = (double) buf[n][rp2];
         v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
         /* update buffer read position */
-        lp->readPosFrac += lp->readPosFrac_inc;
+        readPosFrac[n] += readPosFrac_inc[n];
         /* apply feedback gain and lowpass filter */
-        v0 *= (double) *(p->kFeedBack);
-        v0 = (lp->filterState - v0) * dampFact + v0;
-        lp->filterState = v0;
-        /* mix to output */
-        if (n & 1)
-          aoutR += v0;
-        else
-          aoutL += v0;
-        /* start next random line segment if current one has reached endpoint */
-        if (--(lp->randLine_cnt) <= 0)
-          next_random_lineseg(p, lp, n);
+        v0 *= feedBack;
+        v0 = (filterState[n] - v0) * dampFact + v0;
+        filterState[n] = v[n] = v0;
+      }
+      /* mix to output */
+      for (n = 0; n < 8; n += 2) {
+        aoutL += v[n];
+        aoutR += v[n + 1];
       }
       p->aoutL[i] = (MYFLT) (aoutL * outputGain);
       p->aoutR[i] = (MYFLT) (aoutR * outputGain);
+      /* start next random line segment if current one has reached endpoint */
+      for (n = 0; n < 8; n++) {
+        if (UNLIKELY(--randLine_cnt[n] <= 0)) {
+          lp = p->delayLines[n];
+          lp->writePos = writePos[n];
+          lp->readPos = readPos[n];
+          lp->readPosFrac = readPosFrac[n];
+          next_random_lineseg(p, lp, n);
+          readPosFrac_inc[n] = lp->readPosFrac_inc;
+          randLine_cnt[n] = lp->randLine_cnt;
+        }
+      }
+    }
+    for (n = 0; n < 8; n++) {
+      lp = p->delayLines[n];
+      lp->writePos = writePos[n];
+      lp->readPos = readPos[n];
+      lp->readPosFrac = readPosFrac[n];
+      lp->readPosFrac_inc = readPosFrac_inc[n];
+      lp->randLine_cnt = randLine_cnt[n];
+      lp->filterState = filterState[n];
     }
 
     return OK;
@@ -0,0 +1,655 @@
+/*
+  sockaudio.c:
+
+  Copyright (C) 2019
+
+  This file is part of Csound.
+
+  The Csound Library is free software; you can redistribute it
+  and/or modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Csound is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/* Multichannel audio over UDP between Csound instances.
+
+   Every packet carries a sequence number and the position of its first
+   frame in the sender's output, so the receiver places samples exactly
+   where they belong, counts lost and late packets, and hides a missing
+   packet as silence without shifting what follows.  All fields are in
+   network byte order:
+
+     0   'N' 'A'
+     2   format: bit 0 set for 16 bit samples, otherwise 32 bit float;
+                 bit 1 set for planar (channel after channel), otherwise
+                 interleaved frames
+     3   number of channels
+     4   sequence number (32 bit)
+     8   position of the first frame (32 bit)
+     12  number of frames (16 bit)
+     14  zero (16 bit)
+     16  samples, scaled to a 0dbfs of 1
+
+   The receiver keeps the frames in a ring indexed by position and plays
+   it a little behind the newest frame received.  That delay follows the
+   measured interarrival jitter (RFC 3550), within the limits given, by
+   dropping or repeating single frames.  Both ends read and write up to
+   NA_BATCH packets a call, with sendmmsg() and recvmmsg() on Linux.    */
+
+#include "csoundCore.h"
+#include <sys/types.h>
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#define SOCKET_ERROR (-1)
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#ifndef WIN32
+extern  int32_t     inet_aton(const char *cp, struct in_addr *inp);
+#endif
+
+#define NA_HEADER      16
+#define NA_MTU         1456     /* packet size when frames are not given */
+#define NA_MAXPACKET   8192
+#define NA_BATCH       32
+#define NA_MAXCHNLS    32
+#define NA_INT16       1
+#define NA_PLANAR      2
+#define NA_NOSTAMP     (-1L)
+#define NA_STAMP(pos)  ((long) ((pos) & 0x7FFFFFFF))
+
+typedef struct {
+  OPDS    h;
+  STRINGDAT *ipaddress;
+  MYFLT   *port, *frames, *format;
+  MYFLT   *asig[VARGMAX];
+  AUXCH   aux;
+  int32_t sock;
+  int32_t chans, pframes, width, fmt;
+  int32_t wp, npk;              /* frames in the packet, full packets */
+  uint32_t seq, pos;
+  size_t  pksize;
+  struct sockaddr_in server_addr;
+} SOCKAUDSEND;
+
+typedef struct sockaudrecv_ {
+  OPDS    h;
+  MYFLT   *ar[NA_MAXCHNLS];
+  MYFLT   *port, *minlat, *maxlat;
+  AUXCH   ring, stamps, pkts;
+  MYFLT   *buf;                 /* frames by position, interleaved */
+  long    *stamp;               /* position held by each frame */
+  int32_t sock, chans;
+  uint32_t mask;
+  volatile int32_t threadon;
+  CSOUND  *cs;
+  void    *thrid;
+  double  sr;
+  RTCLOCK clk;
+  /* written by the network thread */
+  long    started, newest, pframes, jitter16;
+  long    received, lost, late;
+  uint32_t firstseq, maxseq, lastpos;
+  double  lastarr, jitter;
+  /* performance side */
+  long    rpos_pub;
+  uint32_t rpos;
+  int32_t synced;
+  double  depth;
+  long    underruns;
+  struct sockaudrecv_ *next;    /* receivers looked up by sockaudstat */
+  struct sockaddr_in server_addr;
+} SOCKAUDRECV;
+
+typedef struct {
+  OPDS    h;
+  MYFLT   *klatency, *kjitter, *klost, *klate;
+  MYFLT   *port;
+} SOCKAUDSTAT;
+
+static int32_t na_nonblock(int32_t sock)
+{
+#ifndef WIN32
+    return fcntl(sock, F_SETFL, O_NONBLOCK) < 0;
+#else
+    u_long argp = 1;
+    return ioctlsocket(sock, FIONBIO, &argp) != NO_ERROR;
+#endif
+}
+
+static void na_close(int32_t sock)
+{
+#ifndef WIN32
+    close(sock);
+#else
+    closesocket(sock);
+#endif
+}
+
+static inline void na_put32(unsigned char *b, uint32_t v)
+{
+    b[0] = (unsigned char) (v >> 24); b[1] = (unsigned char) (v >> 16);
+    b[2] = (unsigned char) (v >> 8);  b[3] = (unsigned char) v;
+}
+
+static inline uint32_t na_get32(const unsigned char *b)
+{
+    return ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) |
+           ((uint32_t) b[2] << 8) | (uint32_t) b[3];
+}
+
+/* sender */
+
+static int32_t na_flush(CSOUND *csound, SOCKAUDSEND *p)
+{
+    const struct sockaddr *to = (const struct sockaddr *) (&p->server_addr);
+    char    *pk = (char *) p->aux.auxp;
+    int32_t n = p->npk, sent = 0;
+#if defined(LINUX)
+    struct mmsghdr msgs[NA_BATCH];
+    struct iovec iov[NA_BATCH];
+    int32_t i;
+    memset(msgs, 0, sizeof(struct mmsghdr) * n);
+    for (i = 0; i < n; i++) {
+      iov[i].iov_base = pk + p->pksize * i;
+      iov[i].iov_len = p->pksize;
+      msgs[i].msg_hdr.msg_name = (void *) to;
+      msgs[i].msg_hdr.msg_namelen = sizeof(p->server_addr);
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (sent < n) {
+      int32_t r = sendmmsg(p->sock, msgs + sent, n - sent, 0);
+      if (UNLIKELY(r <= 0)) break;
+      sent += r;
+    }
+#else
+    for ( ; sent < n; sent++)
+      if (UNLIKELY(sendto(p->sock, pk + p->pksize * sent, p->pksize, 0, to,
+                          sizeof(p->server_addr)) == SOCKET_ERROR))
+        break;
+#endif
+    /* the packet being filled moves to the front */
+    if (p->wp)
+      memcpy(pk, pk + p->pksize * n, p->pksize);
+    p->npk = 0;
+    if (UNLIKELY(sent < n))
+      return csound->PerfError(csound, &(p->h), Str("sendto failed"));
+    return OK;
+}
+
+static int32_t deinit_audsend(CSOUND *csound, void *pdata)
+{
+    SOCKAUDSEND *p = (SOCKAUDSEND *) pdata;
+    na_close(p->sock);
+    return OK;
+}
+
+static int32_t init_audsend(CSOUND *csound, SOCKAUDSEND *p)
+{
+    int32_t frames, fit;
+#if defined(WIN32) && !defined(__CYGWIN__)
+    WSADATA wsaData = {0};
+    int32_t err;
+    if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0))
+      return csound->InitError(csound, Str("Winsock2 failed to start: %d"), err);
+#endif
+    p->chans = p->INOCOUNT - 4;
+    if (UNLIKELY(p->chans < 1 || p->chans > NA_MAXCHNLS))
+      return csound->InitError(csound, Str("sockaudsend: between 1 and %d "
+                                           "channels can be sent"),
+                               NA_MAXCHNLS);
+    p->fmt = ((int32_t) *p->format) & (NA_INT16 | NA_PLANAR);
+    p->width = (p->fmt & NA_INT16) ? 2 : 4;
+    fit = (NA_MAXPACKET - NA_HEADER) / (p->chans * p->width);
+    frames = (int32_t) *p->frames;
+    if (frames <= 0)
+      frames = (NA_MTU - NA_HEADER) / (p->chans * p->width);
+    if (frames > fit) {
+      csound->Warning(csound, Str("sockaudsend: %d frames a packet at most"),
+                      fit);
+      frames = fit;
+    }
+    if (UNLIKELY(frames < 1))
+      return csound->InitError(csound, Str("sockaudsend: too many channels "
+                                           "for a packet"));
+    p->pframes = frames;
+    p->pksize = NA_HEADER + (size_t) frames * p->chans * p->width;
+    p->wp = p->npk = 0;
+    p->seq = p->pos = 0;
+
+    p->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (UNLIKELY(p->sock < 0)) {
+      return csound->InitError(csound, Str("creating socket"));
+    }
+    /* create server address: where we want to send to and clear it out */
+    memset(&p->server_addr, 0, sizeof(p->server_addr));
+    p->server_addr.sin_family = AF_INET;    /* it is an INET address */
+#if defined(WIN32) && !defined(__CYGWIN__)
+    p->server_addr.sin_addr.S_un.S_addr =
+      inet_addr((const char *) p->ipaddress->data);
+#else
+    inet_aton((const char *) p->ipaddress->data,
+              &p->server_addr.sin_addr);    /* the server IP address */
+#endif
+    p->server_addr.sin_port = htons((int32_t) *p->port);    /* the port */
+
+    if (p->aux.auxp == NULL || p->aux.size < p->pksize * NA_BATCH)
+      csound->AuxAlloc(csound, p->pksize * NA_BATCH, &p->aux);
+    csound->RegisterDeinitCallback(csound, (void *) p, deinit_audsend);
+    return OK;
+}
+
+static int32_t audsend(CSOUND *csound, SOCKAUDSEND *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t i, nsmps = CS_KSMPS;
+    int32_t  c, chans = p->chans, pframes = p->pframes;
+    int32_t  width = p->width, planar = p->fmt & NA_PLANAR;
+    MYFLT    scal = FL(1.0) / csound->e0dbfs;
+
+    /* every k-period sends ksmps frames, so positions stay exact */
+    for (i = 0; i < nsmps; i++) {
+      unsigned char *pk =
+        (unsigned char *) p->aux.auxp + p->pksize * p->npk;
+      unsigned char *data = pk + NA_HEADER;
+      int32_t wp = p->wp;
+      int32_t silent = (i < offset || i >= nsmps - early);
+      for (c = 0; c < chans; c++) {
+        MYFLT v = silent ? FL(0.0) : p->asig[c][i] * scal;
+        size_t k = planar ? (size_t) c * pframes + wp
+                          : (size_t) wp * chans + c;
+        if (width == 2) {
+          int32_t s = (int32_t) lrint(v * FL(32767.0));
+          s = s > 32767 ? 32767 : s < -32768 ? -32768 : s;
+          data[2*k] = (unsigned char) ((uint32_t) s >> 8);
+          data[2*k+1] = (unsigned char) s;
+        }
+        else {
+          union {
+            float f;
+            uint32_t i;
+          } x;
+          x.f = (float) v;
+          na_put32(data + 4*k, x.i);
+        }
+      }
+      if (++p->wp == pframes) {
+        pk[0] = 'N'; pk[1] = 'A';
+        pk[2] = (unsigned char) p->fmt;
+        pk[3] = (unsigned char) chans;
+        na_put32(pk + 4, p->seq++);
+        na_put32(pk + 8, p->pos + i + 1 - pframes);
+        pk[12] = (unsigned char) (pframes >> 8);
+        pk[13] = (unsigned char) pframes;
+        pk[14] = pk[15] = 0;
+        p->wp = 0;
+        if (++p->npk == NA_BATCH && na_flush(csound, p) != OK)
+          return NOTOK;
+      }
+    }
+    p->pos += nsmps;
+    /* what was filled in this k-period goes out together */
+    if (p->npk)
+      return na_flush(csound, p);
+    return OK;
+}
+
+/* receiver */
+
+static void na_packet(SOCKAUDRECV *p, const unsigned char *pk, int32_t len,
+                      double now)
+{
+    int32_t  fmt, ch, width, planar, f, c, chans = p->chans;
+    uint32_t seq, pos, frames;
+    long     lost;
+    MYFLT    *buf = p->buf;
+    MYFLT    scal = p->cs->e0dbfs;
+
+    if (len < NA_HEADER || pk[0] != 'N' || pk[1] != 'A')
+      return;
+    fmt = pk[2];
+    ch = pk[3];
+    seq = na_get32(pk + 4);
+    pos = na_get32(pk + 8);
+    frames = ((uint32_t) pk[12] << 8) | pk[13];
+    width = (fmt & NA_INT16) ? 2 : 4;
+    planar = fmt & NA_PLANAR;
+    if (ch == 0 || frames == 0 ||
+        (size_t) len != NA_HEADER + (size_t) frames * ch * width)
+      return;
+
+    /* loss from the sequence numbers, jitter from the positions */
+    if (p->received == 0)
+      p->firstseq = p->maxseq = seq;
+    else {
+      double d;
+      if ((int32_t) (seq - p->maxseq) > 0)
+        p->maxseq = seq;
+      d = (now - p->lastarr) * p->sr - (double) (int32_t) (pos - p->lastpos);
+      p->jitter += (fabs(d) - p->jitter) / 16.0;
+      ATOMIC_SET(p->jitter16, (long) (p->jitter * 16.0));
+    }
+    p->lastarr = now;
+    p->lastpos = pos;
+    p->received++;
+    lost = (long) (p->maxseq - p->firstseq) + 1 - p->received;
+    ATOMIC_SET(p->lost, lost > 0 ? lost : 0);
+
+    if (ATOMIC_GET(p->started) &&
+        (int32_t) (pos + frames - (uint32_t) ATOMIC_GET(p->rpos_pub)) <= 0) {
+      ATOMIC_INCR(p->late);
+      return;
+    }
+    for (f = 0; f < (int32_t) frames; f++) {
+      uint32_t idx = (pos + f) & p->mask;
+      MYFLT   *out = buf + (size_t) idx * chans;
+      /* the frame is not valid while it is being written */
+      ATOMIC_SET(p->stamp[idx], NA_NOSTAMP);
+      for (c = 0; c < chans; c++) {
+        size_t k = planar ? (size_t) c * frames + f : (size_t) f * ch + c;
+        if (c >= ch)
+          out[c] = FL(0.0);
+        else if (width == 2) {
+          int16_t s = (int16_t) ((pk[NA_HEADER + 2*k] << 8) |
+                                 pk[NA_HEADER + 2*k + 1]);
+          out[c] = (MYFLT) s * scal / FL(32767.0);
+        }
+        else {
+          union {
+            float f;
+            uint32_t i;
+          } x;
+          x.i = na_get32(pk + NA_HEADER + 4*k);
+          out[c] = (MYFLT) x.f * scal;
+        }
+      }
+      ATOMIC_SET(p->stamp[idx], NA_STAMP(pos + f));
+    }
+    ATOMIC_SET(p->pframes, (long) frames);
+    if (!ATOMIC_GET(p->started) ||
+        (int32_t) (pos + frames - (uint32_t) ATOMIC_GET(p->newest)) > 0)
+      ATOMIC_SET(p->newest, (long) (pos + frames));
+    ATOMIC_SET(p->started, 1);
+}
+
+static uintptr_t udpAudRecv(void *pdata)
+{
+    SOCKAUDRECV *p = (SOCKAUDRECV *) pdata;
+    CSOUND  *csound = p->cs;
+    char    *pkts = (char *) p->pkts.auxp;
+#if defined(LINUX)
+    struct mmsghdr msgs[NA_BATCH];
+    struct iovec iov[NA_BATCH];
+    int32_t i;
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < NA_BATCH; i++) {
+      iov[i].iov_base = pkts + (size_t) i * NA_MAXPACKET;
+      iov[i].iov_len = NA_MAXPACKET;
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    while (p->threadon) {
+      fd_set  rd;
+      struct timeval tv;
+      int32_t n;
+      double  now;
+      FD_ZERO(&rd);
+      FD_SET(p->sock, &rd);
+      tv.tv_sec = 0;
+      tv.tv_usec = 10000;       /* so that threadon is seen */
+      if (select(p->sock + 1, &rd, NULL, NULL, &tv) <= 0)
+        continue;
+      now = csound->GetRealTime(&p->clk);
+#if defined(LINUX)
+      do {
+        n = recvmmsg(p->sock, msgs, NA_BATCH, MSG_DONTWAIT, NULL);
+        for (i = 0; i < n; i++)
+          na_packet(p, (unsigned char *) iov[i].iov_base,
+                    (int32_t) msgs[i].msg_len, now);
+      } while (n == NA_BATCH);
+#else
+      {
+        struct sockaddr from;
+        socklen_t clilen;
+        int32_t count;
+        for (count = 0; count < NA_BATCH; count++) {
+          clilen = sizeof(from);
+          if ((n = recvfrom(p->sock, pkts, NA_MAXPACKET, 0,
+                            &from, &clilen)) <= 0)
+            break;
+          na_packet(p, (unsigned char *) pkts, n, now);
+        }
+      }
+#endif
+    }
+    return (uintptr_t) 0;
+}
+
+static SOCKAUDRECV **na_receivers(CSOUND *csound)
+{
+    SOCKAUDRECV **list =
+      (SOCKAUDRECV **) csound->QueryGlobalVariable(csound, "::sockaudrecv");
+    if (list == NULL) {
+      csound->CreateGlobalVariable(csound, "::sockaudrecv",
+                                   sizeof(SOCKAUDRECV *));
+      list = (SOCKAUDRECV **)
+        csound->QueryGlobalVariable(csound, "::sockaudrecv");
+    }
+    return list;
+}
+
+static int32_t deinit_audrecv(CSOUND *csound, void *pdata)
+{
+    SOCKAUDRECV *p = (SOCKAUDRECV *) pdata, **pp = na_receivers(csound);
+
+    p->threadon = 0;
+    csound->JoinThread(p->thrid);
+    na_close(p->sock);
+    while (pp != NULL && *pp != NULL) {
+      if (*pp == p) {
+        *pp = p->next;
+        break;
+      }
+      pp = &(*pp)->next;
+    }
+    return OK;
+}
+
+static int32_t init_audrecv(CSOUND *csound, SOCKAUDRECV *p)
+{
+    MYFLT    maxlat = *p->maxlat > FL(0.0) ? *p->maxlat : FL(0.5);
+    uint32_t frames = 1024, i;
+    SOCKAUDRECV **list;
+#if defined(WIN32) && !defined(__CYGWIN__)
+    WSADATA wsaData = {0};
+    int32_t err;
+    if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0))
+      return csound->InitError(csound, Str("Winsock2 failed to start: %d"), err);
+#endif
+    p->cs = csound;
+    p->chans = p->OUTOCOUNT;
+    p->sr = CS_ESR;
+    p->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (UNLIKELY(p->sock == SOCKET_ERROR)) {
+      return csound->InitError(csound, Str("creating socket"));
+    }
+    if (UNLIKELY(na_nonblock(p->sock))) {
+      na_close(p->sock);
+      return csound->InitError(csound, Str("Cannot set nonblock"));
+    }
+    /* create server address: where we want to send to and clear it out */
+    memset(&p->server_addr, 0, sizeof(p->server_addr));
+    p->server_addr.sin_family = AF_INET;    /* it is an INET address */
+    p->server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    p->server_addr.sin_port = htons((int32_t) *p->port);    /* the port */
+    /* associate the socket with the address and port */
+    if (UNLIKELY(bind(p->sock, (struct sockaddr *) &p->server_addr,
+                      sizeof(p->server_addr)) == SOCKET_ERROR)) {
+      na_close(p->sock);
+      return csound->InitError(csound, Str("bind failed"));
+    }
+
+    /* room for the largest delay and two of the largest packets */
+    while (frames < 2 * ((uint32_t) (maxlat * p->sr) + 2 * NA_MAXPACKET))
+      frames <<= 1;
+    p->mask = frames - 1;
+    csound->AuxAlloc(csound, (size_t) frames * p->chans * sizeof(MYFLT),
+                     &p->ring);
+    csound->AuxAlloc(csound, (size_t) frames * sizeof(long), &p->stamps);
+    csound->AuxAlloc(csound, (size_t) NA_BATCH * NA_MAXPACKET, &p->pkts);
+    p->buf = (MYFLT *) p->ring.auxp;
+    p->stamp = (long *) p->stamps.auxp;
+    for (i = 0; i < frames; i++)
+      p->stamp[i] = NA_NOSTAMP;
+    p->started = p->newest = p->pframes = p->jitter16 = 0;
+    p->received = p->lost = p->late = 0;
+    p->jitter = 0.0;
+    p->rpos_pub = 0;
+    p->rpos = 0;
+    p->synced = 0;
+    p->underruns = 0;
+    csound->InitTimerStruct(&p->clk);
+
+    list = na_receivers(csound);
+    p->next = *list;
+    *list = p;
+    /* create thread */
+    p->threadon = 1;
+    p->thrid = csound->CreateThread(udpAudRecv, (void *) p);
+    csound->RegisterDeinitCallback(csound, (void *) p, deinit_audrecv);
+    return OK;
+}
+
+static int32_t audrecv(CSOUND *csound, SOCKAUDRECV *p)
+{
+    uint32_t offset = p->h.insdshead->ksmps_offset;
+    uint32_t early  = p->h.insdshead->ksmps_no_end;
+    uint32_t i, nsmps = CS_KSMPS;
+    int32_t  c, chans = p->chans;
+    int32_t  pf, depth, target, lo, hi, slack;
+    uint32_t newest, rpos;
+    double   jitter;
+
+    for (c = 0; c < chans; c++)
+      memset(p->ar[c], 0, sizeof(MYFLT)*nsmps);
+    if (!ATOMIC_GET(p->started))
+      return OK;
+
+    /* play the newest frame after about one packet and four times */
+    /* the jitter, within the limits asked for                     */
+    newest = (uint32_t) ATOMIC_GET(p->newest);
+    pf = (int32_t) ATOMIC_GET(p->pframes);
+    jitter = ATOMIC_GET(p->jitter16) / 16.0;
+    lo = (int32_t) (*p->minlat * p->sr);
+    hi = (int32_t) ((*p->maxlat > FL(0.0) ? *p->maxlat : FL(0.5)) * p->sr);
+    target = pf + (int32_t) (4.0 * jitter) + (int32_t) nsmps;
+    target = target < lo ? lo : target > hi ? hi : target;
+    slack = pf/2 > 16 ? pf/2 : 16;
+
+    depth = (int32_t) (newest - p->rpos);
+    if (!p->synced || depth > hi + pf || depth < -hi) {
+      /* start, or the sender stopped or jumped */
+      p->rpos = newest - target;
+      p->depth = target - pf/2;
+      p->synced = 1;
+    }
+    else {
+      /* the depth swings by a packet, so follow its average */
+      p->depth += (depth - p->depth) * 0.01;
+      if (p->depth > target - pf/2 + slack) {
+        p->rpos++;              /* drop a frame */
+        p->depth -= 1.0;
+      }
+      else if (p->depth < target - pf/2 - slack) {
+        p->rpos--;              /* repeat a frame */
+        p->depth += 1.0;
+      }
+    }
+
+    rpos = p->rpos + offset;
+    if (UNLIKELY(early)) nsmps -= early;
+    for (i = offset; i < nsmps; i++, rpos++) {
+      uint32_t idx = rpos & p->mask;
+      long     s = ATOMIC_GET(p->stamp[idx]);
+      if (s == NA_STAMP(rpos)) {
+        const MYFLT *in = p->buf + (size_t) idx * chans;
+        for (c = 0; c < chans; c++)
+          p->ar[c][i] = in[c];
+        /* overwritten while copying: treat as missing */
+        if (UNLIKELY(ATOMIC_GET(p->stamp[idx]) != s)) {
+          for (c = 0; c < chans; c++)
+            p->ar[c][i] = FL(0.0);
+          p->underruns++;
+        }
+      }
+      else p->underruns++;
+    }
+    p->rpos += CS_KSMPS;
+    ATOMIC_SET(p->rpos_pub, (long) p->rpos);
+    return OK;
+}
+
+/* statistics of the receiver on a port */
+
+static int32_t audstat(CSOUND *csound, SOCKAUDSTAT *p)
+{
+    SOCKAUDRECV **list = (SOCKAUDRECV **)
+      csound->QueryGlobalVariable(csound, "::sockaudrecv");
+    SOCKAUDRECV *r = list != NULL ? *list : NULL;
+    int32_t port = (int32_t) *p->port;
+
+    while (r != NULL && ntohs(r->server_addr.sin_port) != port)
+      r = r->next;
+    if (r == NULL || !ATOMIC_GET(r->started)) {
+      *p->klatency = *p->kjitter = *p->klost = *p->klate = FL(0.0);
+      return OK;
+    }
+    *p->klatency = (MYFLT) ((int32_t) ((uint32_t) ATOMIC_GET(r->newest) -
+                                       r->rpos) / r->sr);
+    *p->kjitter = (MYFLT) (ATOMIC_GET(r->jitter16) / 16.0 / r->sr);
+    *p->klost = (MYFLT) ATOMIC_GET(r->lost);
+    *p->klate = (MYFLT) ATOMIC_GET(r->late);
+    return OK;
+}
+
+static int32_t audstat_init(CSOUND *csound, SOCKAUDSTAT *p)
+{
+    return audstat(csound, p);
+}
+
+#define S(x)    sizeof(x)
+
+static OENTRY sockaudio_localops[] = {
+  { "sockaudsend", S(SOCKAUDSEND), 0, 3, "", "Siiiy",
+    (SUBR) init_audsend, (SUBR) audsend, NULL },
+  { "sockaudrecv", S(SOCKAUDRECV), 0, 3, "mmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmm",
+    "ioo", (SUBR) init_audrecv, (SUBR) audrecv, NULL },
+  { "sockaudstat", S(SOCKAUDSTAT), 0, 3, "kkkk", "i",
+    (SUBR) audstat_init, (SUBR) audstat, NULL }
+};
+
+LINKAGE_BUILTIN(sockaudio_localops)
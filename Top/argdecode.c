@@ -308,6 +308,16 @@ static const char *longUsageList[] = {
   Str_noop("--fftlib=N              actual FFT lib to use (FFTLIB=0, "
                                    "PFFFT = 1, vDSP =2)"),
   Str_noop("--udp-echo              echo UDP commands on terminal"),
+  Str_noop("--voice-batch=N         run up to N instances of an instrument in "
+                                   "lockstep (0 = off)"),
+  Str_noop("--write-buffers=N       write sound files from a separate thread "
+                                   "with N spare buffers (0 = off)"),
+  Str_noop("--gen01-threads=N       decode deferred GEN01 sound files on N "
+                                   "threads, with --gen01-cache (0 = off)"),
+  Str_noop("--gen01-cache=N         keep at least N MB of decoded sound "
+                                   "files for reuse (0 = GEN01 reads from disk)"),
+  Str_noop("--mp3-stream            GEN49 and the mp3 opcodes read gapless, "
+                                   "exact lengths through the shared stream cache"),
   Str_noop("--aft-zero              set aftertouch to zero, not 127 (default)"),
   " ",
   Str_noop("--help                  long help"),
@@ -1127,6 +1137,49 @@ static int decode_long(CSOUND *csound, char *s, int argc, char **argv)
       O->fft_lib = atoi(s);
       return 1;
     }
+    else if (!(strncmp(s, "voice-batch=",12))) {
+      s += 12;
+      O->voiceBatch = atoi(s);
+      if (O->voiceBatch < 0) O->voiceBatch = 0;
+      if (O->voiceBatch > MAX_VOICE_BATCH) {
+        csound->Warning(csound, Str("voice-batch limited to %d"),
+                        MAX_VOICE_BATCH);
+        O->voiceBatch = MAX_VOICE_BATCH;
+      }
+      return 1;
+    }
+    else if (!(strncmp(s, "write-buffers=",14))) {
+      s += 14;
+      O->writeBuffers = atoi(s);
+      if (O->writeBuffers < 0) O->writeBuffers = 0;
+      if (O->writeBuffers > MAX_WRITE_BUFFERS) {
+        csound->Warning(csound, Str("write-buffers limited to %d"),
+                        MAX_WRITE_BUFFERS);
+        O->writeBuffers = MAX_WRITE_BUFFERS;
+      }
+      return 1;
+    }
+    else if (!(strncmp(s, "gen01-threads=",14))) {
+      s += 14;
+      O->gen01Threads = atoi(s);
+      if (O->gen01Threads < 0) O->gen01Threads = 0;
+      if (O->gen01Threads > MAX_GEN01_THREADS) {
+        csound->Warning(csound, Str("gen01-threads limited to %d"),
+                        MAX_GEN01_THREADS);
+        O->gen01Threads = MAX_GEN01_THREADS;
+      }
+      return 1;
+    }
+    else if (!(strncmp(s, "gen01-cache=",12))) {
+      s += 12;
+      O->gen01Cache = atoi(s);
+      if (O->gen01Cache < 0) O->gen01Cache = 0;
+      return 1;
+    }
+    else if (!(strcmp(s, "mp3-stream"))) {
+      O->mp3Stream = 1;
+      return 1;
+    }
     else if (!(strncmp(s, "vbr-quality=",12))) {
       s += 12;
       O->quality = atof(s);
@@ -1615,6 +1668,23 @@ PUBLIC void csoundSetParams(CSOUND *csound, CSOUND_PARAMS *p){
     oparms->e0dbfs_override = p->e0dbfs_override;
 
     if (p->ksmps_override > 0) oparms->ksmps_override = p->ksmps_override;
+
+    /* lockstep voice groups; here and below, -1 leaves the option alone */
+    if (p->voice_batch >= 0)
+      oparms->voiceBatch = p->voice_batch > MAX_VOICE_BATCH ?
+        MAX_VOICE_BATCH : p->voice_batch;
+
+    /* sound file writer thread */
+    if (p->write_buffers >= 0)
+      oparms->writeBuffers = p->write_buffers > MAX_WRITE_BUFFERS ?
+        MAX_WRITE_BUFFERS : p->write_buffers;
+
+    /* GEN01 loader threads and decoded file cache */
+    if (p->gen01_threads >= 0)
+      oparms->gen01Threads = p->gen01_threads > MAX_GEN01_THREADS ?
+        MAX_GEN01_THREADS : p->gen01_threads;
+    if (p->gen01_cache >= 0)
+      oparms->gen01Cache = p->gen01_cache;
 }
 
 PUBLIC void csoundGetParams(CSOUND *csound, CSOUND_PARAMS *p){
@@ -1655,6 +1725,10 @@ PUBLIC void csoundGetParams(CSOUND *csound, CSOUND_PARAMS *p){
     p->daemon = oparms->daemon;
     p->ksmps_override = oparms->ksmps_override;
     p->FFT_library = oparms->fft_lib;
+    p->voice_batch = oparms->voiceBatch;
+    p->write_buffers = oparms->writeBuffers;
+    p->gen01_threads = oparms->gen01Threads;
+    p->gen01_cache = oparms->gen01Cache;
 }
 
 
@@ -874,6 +874,7 @@ extern long scnoise_localops_init(CSOUND *, void *);
 extern long socksend_localops_init(CSOUND *, void *);
 extern long mp3in_localops_init(CSOUND *, void *);
 extern long sockrecv_localops_init(CSOUND *, void *);
+extern long sockaudio_localops_init(CSOUND *, void *);
 #endif
 extern long afilts_localops_init(CSOUND *, void *);
 extern long pinker_localops_init(CSOUND *, void *);
@@ -913,6 +914,7 @@ const INITFN staticmodules[] = { hrtfopcodes_localops_init, babo_localops_init,
                                  mp3in_localops_init,
                                  sockrecv_localops_init,
                                  socksend_localops_init,
+                                 sockaudio_localops_init,
 #endif
                                  scnoise_localops_init, afilts_localops_init,
                                  pinker_localops_init, gendy_localops_init,
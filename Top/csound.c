@@ -504,11 +504,12 @@ static const CSOUND cenviron_ = {
     find_opcode_exact,
     csoundGetChannelPtr,
     csoundListChannels,
+    csoundPushMidiMessage,
+    csoundGetMidiTime,
     {
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-      NULL, NULL
+      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
     },
     /* ------- private data (not to be used by hosts or externals) ------- */
     /* callback function pointers */
@@ -823,6 +824,15 @@ static const CSOUND cenviron_ = {
     (char*) NULL,   /*  sstrbuf             */
     1,              /*  enableMsgAttr       */
     0,              /*  sampsNeeded         */
+    0,              /*  renderRem           */
+    0,              /*  hostRender          */
+    0,              /*  ovlPolicy           */
+    0.0,            /*  ovlThreshold        */
+    0.0,            /*  ovlLoad             */
+    0,              /*  ovlState            */
+    0,              /*  ovlCalm             */
+    NULL,           /*  overloadCallback_   */
+    NULL,           /*  overloadUserData    */
     FL(0.0),        /*  csoundScoreOffsetSeconds_   */
     -1,             /*  inChar_             */
     0,              /*  isGraphable_        */
@@ -911,7 +921,12 @@ static const CSOUND cenviron_ = {
       0.4,          /*    vbr quality  */
       0,            /*    ksmps_override */
       0,             /*    fft_lib */
-      0
+      0,             /*    echo */
+      0,             /*    voiceBatch */
+      0,             /*    writeBuffers */
+      0,             /*    gen01Threads */
+      0,             /*    gen01Cache */
+      0              /*    mp3Stream */
     },
 
     {0, 0, {0}}, /* REMOT_BUF */
@@ -1581,6 +1596,79 @@ inline static int nodePerf(CSOUND *csound, int index, int numThreads)
     return played_count;
 }
 
+/*
+ * Runs a group of active instances of one instrument in lockstep: the n-th
+ * opcode of every voice is executed before any voice moves on to the
+ * (n+1)-th.  Where all voices share a perf function that has a batch
+ * kernel, that is called once for the whole group; anything else
+ * (including voices with sample-accurate offsets) falls back to the
+ * ordinary per-voice call.
+ */
+static void batch_perf(CSOUND *csound, INSDS **grp, int nvoices)
+{
+    OPDS  *ops[MAX_VOICE_BATCH];
+    void  *vec[MAX_VOICE_BATCH];
+    int   i, live = nvoices;
+
+    for (i = 0; i < nvoices; i++) {
+      INSDS *ip = grp[i];
+      ip->spin = csound->spin;
+      ip->spout = csound->spraw;
+      ip->kcounter =  csound->kcounter;
+      ops[i] = (OPDS*) ip;
+    }
+    while (live) {
+      OPDS  *lead = NULL;
+      BSUBR batchadr = NULL;
+      int   nvec = 0;
+      live = 0;
+      for (i = 0; i < nvoices; i++) {   /* advance each voice */
+        if (ops[i] == NULL) continue;
+        if ((ops[i] = ops[i]->nxtp) == NULL || !grp[i]->actflg) {
+          ops[i] = NULL;
+          continue;
+        }
+        if (lead == NULL) lead = ops[i];
+        live++;
+      }
+      if (lead == NULL) break;
+      if (lead->opadr == (SUBR) lead->optext->t.oentry->kopadr) {
+        /* kernels were looked up when the instrument was compiled */
+        INSTRTXT *tp = grp[0]->instr;
+        for (i = 0; i < tp->nbatchops; i++)
+          if (tp->batchops[i].opadr == lead->opadr) {
+            batchadr = tp->batchops[i].batchadr;
+            break;
+          }
+      }
+      for (i = 0; i < nvoices; i++) {
+        OPDS *op = ops[i];
+        if (op == NULL) continue;
+        op->insdshead->pds = op;
+        if (batchadr != NULL && op->opadr == lead->opadr &&
+            grp[i]->ksmps_offset == 0 && grp[i]->ksmps_no_end == 0)
+          vec[nvec++] = op;
+        else if ((*op->opadr)(csound, op) != OK)
+          ops[i] = NULL;               /* error: stop this voice */
+        else
+          ops[i] = grp[i]->pds;
+      }
+      if (nvec == 1)
+        (void) (*((OPDS*) vec[0])->opadr)(csound, vec[0]);
+      else if (nvec > 1)
+        (void) batchadr(csound, vec, nvec);
+      /* a batched kernel reports errors per voice through PerfError,
+         which clears actflg; pick up any jump as the scalar path does */
+      for (i = 0; i < nvoices; i++)
+        if (ops[i] != NULL) ops[i] = grp[i]->pds;
+    }
+}
+
+/* csoundPerformFrames() copies spraw to the host buffers, so spout is
+   only interleaved when there is also an audio output to send it to */
+#define SPOUT_NEEDED(csound) \
+    (!(csound)->hostRender || (csound)->libsndStatics.osfopen)
+
 inline static void make_interleave(CSOUND *csound)
 {
     uint32_t nsmps = csound->ksmps, i, j, k=0;
@@ -1601,6 +1689,50 @@ inline static void make_interleave(CSOUND *csound)
 }
 
 
+/* fraction of the overload threshold, and seconds under it, to recover */
+#define OVERLOAD_RECOVER        (0.75)
+#define OVERLOAD_RECOVER_TIME   (1.0)
+
+/* release the active voice of the non-essential instrument with the
+   lowest priority */
+static void overload_steal(CSOUND *csound)
+{
+    INSDS *ip, *victim = NULL;
+    for (ip = csound->actanchor.nxtact; ip != NULL; ip = ip->nxtact) {
+      if (ip->instr->priority < 0 && ip->actflg && !ip->relesing &&
+          ATOMIC_GET(ip->init_done) == 1 &&
+          (victim == NULL || ip->instr->priority < victim->instr->priority))
+        victim = ip;
+    }
+    if (victim != NULL)
+      xturnoff(csound, victim);
+}
+
+/* measure the k-cycle that began at 'start' against its budget, and
+   degrade or recover as set by csoundSetOverloadPolicy() */
+static void overload_check(CSOUND *csound, double start)
+{
+    double load;
+    load = (csoundGetRealTime(csound->csRtClock) - start) * csound->ekr;
+    csound->ovlLoad = load;
+    if (load > csound->ovlThreshold) {
+      csound->ovlState = 1;
+      csound->ovlCalm = 0;
+      if (csound->ovlPolicy & CSOUND_OVERLOAD_STEAL)
+        overload_steal(csound);
+      if (csound->overloadCallback_ != NULL)
+        csound->overloadCallback_(csound, csound->overloadUserData, load, 1);
+    }
+    else if (csound->ovlState &&
+             load < csound->ovlThreshold * OVERLOAD_RECOVER &&
+             ++csound->ovlCalm >= (int) (csound->ekr * OVERLOAD_RECOVER_TIME)) {
+      csound->ovlState = 0;
+      csound->ovlCalm = 0;
+      if (csound->overloadCallback_ != NULL)
+        csound->overloadCallback_(csound, csound->overloadUserData, load, 0);
+    }
+}
+
 unsigned long kperfThread(void * cs)
 {
     //INSDS *start;
@@ -1652,6 +1784,7 @@ unsigned long kperfThread(void * cs)
 int kperf_nodebug(CSOUND *csound)
 {
     INSDS *ip;
+    double start = 0.0;
     /* update orchestra time */
     csound->kcounter = ++(csound->global_kcounter);
     csound->icurTime += csound->ksmps;
@@ -1679,9 +1812,12 @@ int kperf_nodebug(CSOUND *csound)
     /* for one kcnt: */
     if (csound->oparms_.sfread)         /*   if audio_infile open  */
       csound->spinrecv(csound);         /*      fill the spin buf  */
+    if (UNLIKELY(csound->ovlThreshold > 0.0))
+      start = csoundGetRealTime(csound->csRtClock);
     csound->spoutactive = 0;            /*   make spout inactive   */
     /* clear spout */
-    memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+    if (SPOUT_NEEDED(csound))
+      memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
     memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     ip = csound->actanchor.nxtact;
 
@@ -1704,9 +1840,44 @@ int kperf_nodebug(CSOUND *csound)
       else {
         int done;
         double time_end = (csound->ksmps+csound->icurTime)/csound->esr;
+        int skip = (csound->ovlState &&
+                    (csound->ovlPolicy & CSOUND_OVERLOAD_SKIP));
 
         while (ip != NULL) {                /* for each instr active:  */
           INSDS *nxt = ip->nxtact;
+          if (UNLIKELY(skip) && ip->instr->priority < 0) {
+            /* non-essential instrument while overloaded */
+            ip->ksmps_offset = 0;
+            ip->ksmps_no_end = 0;
+            ip = nxt;
+            continue;
+          }
+          if (csound->oparms->voiceBatch > 1 && ip->instr->batchable &&
+              nxt != NULL && nxt->instr == ip->instr) {
+            /* run consecutive voices of one instrument in lockstep */
+            INSDS    *grp[MAX_VOICE_BATCH];
+            INSTRTXT *tp = ip->instr;
+            int      nvoices = 0, j;
+            while (ip != NULL && ip->instr == tp &&
+                   nvoices < csound->oparms->voiceBatch &&
+                   ip->ksmps == csound->ksmps &&
+                   ATOMIC_GET(ip->init_done) == 1) {
+              if (UNLIKELY(csound->oparms->sampleAccurate &&
+                           ip->offtim > 0                 &&
+                           time_end > ip->offtim))
+                ip->ksmps_no_end = ip->no_end;
+              grp[nvoices++] = ip;
+              ip = ip->nxtact;
+            }
+            if (nvoices > 0) {
+              batch_perf(csound, grp, nvoices);
+              for (j = 0; j < nvoices; j++) {
+                grp[j]->ksmps_offset = 0;
+                grp[j]->ksmps_no_end = 0;
+              }
+              continue;
+            }
+          }
           if (UNLIKELY(csound->oparms->sampleAccurate &&
                        ip->offtim > 0                 &&
                        time_end > ip->offtim)) {
@@ -1778,12 +1949,15 @@ int kperf_nodebug(CSOUND *csound)
       }
     }
 
+    if (UNLIKELY(csound->ovlThreshold > 0.0))
+      overload_check(csound, start);      /* before any blocking output */
     if (!csound->spoutactive) { /* results now in spout? */
-      memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
-    make_interleave(csound);
-    csound->spoutran(csound); /* send to audio_out */
+    if (SPOUT_NEEDED(csound)) {
+      make_interleave(csound);
+      csound->spoutran(csound); /* send to audio_out */
+    }
     //#ifdef ANDROID
     //struct timespec ts;
     //clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -1912,7 +2086,8 @@ int kperf_debug(CSOUND *csound)
         csound->spinrecv(csound);         /*      fill the spin buf  */
       csound->spoutactive = 0;            /*   make spout inactive   */
       /* clear spout */
-      memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
+      if (SPOUT_NEEDED(csound))
+        memset(csound->spout, 0, csound->nspout*sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout*sizeof(MYFLT));
     }
 
@@ -2061,12 +2236,12 @@ int kperf_debug(CSOUND *csound)
     if (!data || data->status != CSDEBUG_STATUS_STOPPED)
     {
     if (!csound->spoutactive) {             /*   results now in spout? */
-      memset(csound->spout, 0, csound->nspout * sizeof(MYFLT));
       memset(csound->spraw, 0, csound->nspout * sizeof(MYFLT));
     }
-    else
+    if (SPOUT_NEEDED(csound)) {
       make_interleave(csound);
-    csound->spoutran(csound);               /*      send to audio_out  */
+      csound->spoutran(csound);             /*      send to audio_out  */
+    }
     }
     return 0;
 }
@@ -2209,6 +2384,108 @@ PUBLIC int csoundPerformBuffer(CSOUND *csound)
     return 0;
 }
 
+/* external host's non-interleaved buffers passed in csoundPerformFrames() */
+PUBLIC int csoundPerformFrames(CSOUND *csound, MYFLT **in, MYFLT **out,
+                               uint32_t nframes)
+{
+    uint32_t ksmps = csound->ksmps, pos = 0, n, offs, i, j;
+    int returnValue;
+    int done = 0;
+    /* VL: 1.1.13 if not compiled (csoundStart() not called)  */
+    if (UNLIKELY(!(csound->engineStatus & CS_STATE_COMP))) {
+      csound->Warning(csound,
+                      Str("Csound not ready for performance: csoundStart() "
+                          "has not been called\n"));
+      return CSOUND_ERROR;
+    }
+    /* Setup jmp for return after an exit(). */
+    if (UNLIKELY((returnValue = setjmp(csound->exitjmp)))) {
+#ifndef MACOSX
+      csoundMessage(csound, Str("Early return from csoundPerformFrames().\n"));
+#endif
+      return ((returnValue - CSOUND_EXITJMP_SUCCESS) | CSOUND_EXITJMP_SUCCESS);
+    }
+    csound->hostRender = 1;
+    while (pos < nframes) {
+      if (csound->renderRem == 0) {
+        /* the input of the previous ksmps frames is now in spin */
+        if (!csound->oparms->realtime) // no API lock in realtime mode
+          csoundLockMutex(csound->API_lock);
+        do {
+          if (UNLIKELY((done = sensevents(csound))))
+            break;
+        } while (csound->kperf(csound));
+        if (!csound->oparms->realtime) // no API lock in realtime mode
+          csoundUnlockMutex(csound->API_lock);
+        if (UNLIKELY(done))
+          break;
+        csound->renderRem = ksmps;
+      }
+      offs = ksmps - csound->renderRem;
+      n = (csound->renderRem < nframes - pos ?
+           csound->renderRem : nframes - pos);
+      if (out != NULL) {
+        for (i = 0; i < csound->nchnls; i++)
+          if (out[i] != NULL)
+            memcpy(out[i] + pos, csound->spraw + i*ksmps + offs,
+                   n * sizeof(MYFLT));
+      }
+      if (!csound->oparms->sfread) {
+        MYFLT *spin = csound->spin + offs*csound->inchnls;
+        for (i = 0; i < csound->inchnls; i++) {
+          MYFLT *src = (in != NULL ? in[i] : NULL);
+          for (j = 0; j < n; j++)
+            spin[j*csound->inchnls + i] =
+              (src != NULL ? src[pos + j] : FL(0.0));
+        }
+      }
+      csound->renderRem -= n;
+      pos += n;
+    }
+    if (UNLIKELY(pos < nframes) && out != NULL) {
+      /* end of score: silence for the rest of the buffers */
+      for (i = 0; i < csound->nchnls; i++)
+        if (out[i] != NULL)
+          memset(out[i] + pos, 0, (nframes - pos) * sizeof(MYFLT));
+    }
+    return done;
+}
+
+PUBLIC void csoundSetOverloadPolicy(CSOUND *csound, int policy,
+                                    double threshold)
+{
+    csound->ovlPolicy = policy;
+    csound->ovlThreshold = (threshold > 0.0 ? threshold : 0.0);
+    csound->ovlState = 0;
+    csound->ovlCalm = 0;
+}
+
+PUBLIC void csoundSetOverloadCallback(CSOUND *csound,
+                                      void (*func)(CSOUND *, void *userData,
+                                                   double load,
+                                                   int overloaded),
+                                      void *userData)
+{
+    csound->overloadCallback_ = func;
+    csound->overloadUserData = userData;
+}
+
+PUBLIC int csoundSetInstrumentPriority(CSOUND *csound, int insno,
+                                       int priority)
+{
+    INSTRTXT *tp;
+    if (UNLIKELY(insno < 1 || insno > csound->engineState.maxinsno ||
+                 (tp = csound->engineState.instrtxtp[insno]) == NULL))
+      return CSOUND_ERROR;
+    tp->priority = priority;
+    return CSOUND_SUCCESS;
+}
+
+PUBLIC double csoundGetLoad(CSOUND *csound)
+{
+    return csound->ovlLoad;
+}
+
 /* perform an entire score */
 
 PUBLIC int csoundPerform(CSOUND *csound)
@@ -3165,6 +3442,61 @@ int csoundAppendOpcodes(CSOUND *csound, const OENTRY *opcodeList, int n)
     return retval;
 }
 
+/* multi-voice perf functions: the built-in ones are in entry1.c, and */
+/* others are kept in a list in the "::batchKernels" global variable  */
+
+extern BATCHENTRY batchlst_1[];
+
+typedef struct batchKernel_s {
+    BATCHENTRY  e;
+    struct batchKernel_s *nxt;
+} batchKernel_t;
+
+/**
+ * Registers 'batchadr' as the multi-voice version of the perf function
+ * 'opadr', for instruments compiled from now on. Returns zero on success.
+ */
+
+int csoundRegisterBatchKernel(CSOUND *csound, SUBR opadr, BSUBR batchadr)
+{
+    batchKernel_t **lst, *p;
+
+    lst = (batchKernel_t**) csoundQueryGlobalVariable(csound, "::batchKernels");
+    if (lst == NULL) {
+      if (UNLIKELY(csoundCreateGlobalVariable(csound, "::batchKernels",
+                                              sizeof(batchKernel_t*)) != 0))
+        return CSOUND_MEMORY;
+      lst = (batchKernel_t**)
+        csoundQueryGlobalVariable(csound, "::batchKernels");
+    }
+    p = (batchKernel_t*) csound->Malloc(csound, sizeof(batchKernel_t));
+    p->e.opadr = opadr;
+    p->e.batchadr = batchadr;
+    p->nxt = *lst;
+    *lst = p;
+    return CSOUND_SUCCESS;
+}
+
+/**
+ * Returns the multi-voice version of the perf function 'opadr', or NULL
+ * if there is none.
+ */
+
+BSUBR csoundFindBatchKernel(CSOUND *csound, SUBR opadr)
+{
+    batchKernel_t **lst, *p;
+    BATCHENTRY    *ep;
+
+    lst = (batchKernel_t**) csoundQueryGlobalVariable(csound, "::batchKernels");
+    for (p = (lst != NULL ? *lst : NULL); p != NULL; p = p->nxt)
+      if (p->e.opadr == opadr)
+        return p->e.batchadr;
+    for (ep = &(batchlst_1[0]); ep->opadr != NULL; ep++)
+      if (ep->opadr == opadr)
+        return ep->batchadr;
+    return NULL;
+}
+
 /*
  * MISC FUNCTIONS
  */
@@ -3245,6 +3577,7 @@ static void reset(CSOUND *csound)
     /* delete temporary files created by this Csound instance */
     remove_tmpfiles(csound);
     rlsmemfiles(csound);
+    rlspvxmemfiles(csound);
 
      while (csound->filedir[n])        /* Clear source directory */
        csound->Free(csound,csound->filedir[n++]);
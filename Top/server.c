@@ -33,6 +33,34 @@ typedef unsigned int u_int32_t;
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #endif
+#if defined(LINUX)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#include <ctype.h>
+
+#ifdef USE_DOUBLE
+#  define MYFLT_INT_TYPE int64_t
+#else
+#  define MYFLT_INT_TYPE int32_t
+#endif
+
+/* Datagrams are read in batches: with recvmmsg() on Linux, woken up by */
+/* epoll, and elsewhere by polling each socket until it has nothing     */
+/* more.  Consecutive '&' or '$' messages in a batch are joined into    */
+/* one line event or score, so a burst takes one slot of the engine's   */
+/* message queue rather than one for each datagram.                     */
+
+#define UDP_MAXSOCKS   8        /* ports a server can listen on */
+#define UDP_BATCH      32       /* datagrams read at a time */
+#define UDP_MSGSIZE    65536    /* largest datagram */
+#define UDP_MAXIDS     1024     /* channel ids in binary messages */
+
+typedef struct {
+  int     type;                 /* '&' or '$', 0 if empty */
+  char    *buf;
+  size_t  len, size;
+} UDPLINES;
 
 typedef struct {
   int port;
@@ -42,10 +70,26 @@ typedef struct {
   void  *cb;
   struct sockaddr_in server_addr;
   unsigned char status;
+  int     socks[UDP_MAXSOCKS];
+  int     ports[UDP_MAXSOCKS];
+  int     nsocks;
+  int     efd;                  /* epoll instance and close event, Linux */
+  int     wakefd;
+  char    *bufs;                /* UDP_BATCH datagrams */
+  UDPLINES lines;
+  MYFLT   *ids[UDP_MAXIDS];     /* control channels bound to binary ids */
 } UDPCOM;
 
 #define MAXSTR 1048576 /* 1MB */
 
+static void udp_close(int sock) {
+#ifndef WIN32
+  close(sock);
+#else
+  closesocket(sock);
+#endif
+}
+
 static void udp_socksend(CSOUND *csound, int *sock, const char *addr,
                          int port, const char *msg) {
   struct sockaddr_in server_addr;
@@ -97,183 +141,412 @@ static void udp_socksend(CSOUND *csound, int *sock, const char *addr,
 }
 
 
-static uintptr_t udp_recv(void *pdata){
+/* send the '&' or '$' lines collected so far to the engine */
+
+static void udp_flush_lines(CSOUND *csound, UDPLINES *l) {
+  if (l->type && l->len) {
+    l->buf[l->len] = '\0';
+    if (l->type == '&')
+      csoundInputMessageAsync(csound, l->buf);
+    else
+      csoundReadScoreAsync(csound, l->buf);
+  }
+  l->type = 0;
+  l->len = 0;
+}
+
+static void udp_add_line(CSOUND *csound, UDPLINES *l, int type,
+                         const char *line, size_t len) {
+  if (l->type != type)
+    udp_flush_lines(csound, l);
+  if (l->len + len + 2 > l->size) {
+    size_t size = l->size ? l->size : 4096;
+    while (l->len + len + 2 > size)
+      size <<= 1;
+    l->buf = (char *) csound->ReAlloc(csound, l->buf, size);
+    l->size = size;
+  }
+  l->type = type;
+  memcpy(l->buf + l->len, line, len);
+  l->len += len;
+  l->buf[l->len++] = '\n';
+}
+
+static void udp_set_channel(MYFLT *pval, MYFLT val) {
+#if defined(MSVC) || defined(HAVE_ATOMIC_BUILTIN)
+  union {
+    MYFLT d;
+    MYFLT_INT_TYPE i;
+  } x;
+  x.d = val;
+#endif
+#if defined(MSVC)
+  InterlockedExchange64((MYFLT_INT_TYPE *)pval, x.i);
+#elif defined(HAVE_ATOMIC_BUILTIN)
+  __atomic_store_n((MYFLT_INT_TYPE *)pval, x.i, __ATOMIC_SEQ_CST);
+#else
+  *pval = val;
+#endif
+}
+
+/* Binary control messages start with a zero byte, which text messages */
+/* never do.  In network byte order:                                   */
+/*   0 'b' id(16) name        binds the id to control channel name      */
+/*   0 'v' { id(16) value(float 32) } ...  sets bound channels          */
+
+static void udp_binary(UDPCOM *p, const unsigned char *msg, int len) {
+  CSOUND *csound = p->cs;
+  if (msg[1] == 'b' && len > 4) {
+    int id = (msg[2] << 8) | msg[3];
+    char chn[128];
+    int n = len - 4 < 127 ? len - 4 : 127;
+    memcpy(chn, msg + 4, n);
+    chn[n] = '\0';
+    if (UNLIKELY(id >= UDP_MAXIDS ||
+                 csoundGetChannelPtr(csound, &p->ids[id], chn,
+                                     CSOUND_CONTROL_CHANNEL |
+                                     CSOUND_INPUT_CHANNEL) != CSOUND_SUCCESS)) {
+      if (id < UDP_MAXIDS) p->ids[id] = NULL;
+      csound->Warning(csound, Str("UDP: could not bind channel %s"), chn);
+    }
+  }
+  else if (msg[1] == 'v') {
+    const unsigned char *r;
+    for (r = msg + 2; r + 6 <= msg + len; r += 6) {
+      int id = (r[0] << 8) | r[1];
+      union {
+        uint32_t i;
+        float f;
+      } v;
+      v.i = ((uint32_t) r[2] << 24) | ((uint32_t) r[3] << 16) |
+            ((uint32_t) r[4] << 8) | (uint32_t) r[5];
+      if (LIKELY(id < UDP_MAXIDS && p->ids[id] != NULL))
+        udp_set_channel(p->ids[id], (MYFLT) v.f);
+    }
+  }
+}
+
+/* name and rest of a channel message, without sscanf() */
+
+static int udp_channel_name(const char *s, char *chn, const char **rest) {
+  int n = 0;
+  while (isspace((unsigned char) *s)) s++;
+  while (*s && !isspace((unsigned char) *s) && n < 127)
+    chn[n++] = *s++;
+  chn[n] = '\0';
+  *rest = s;
+  return n;
+}
+
+typedef struct {
+  char  *start;                 /* orchestra code split over datagrams */
+  size_t len;
+  int   cont;
+  int   sock;                   /* for replies to ':' messages */
+} UDPSTATE;
+
+/* handle one datagram; returns non-zero on a close message */
+
+static int udp_dispatch(UDPCOM *p, UDPSTATE *st, char *orchestra,
+                        int received) {
+  CSOUND *csound = p->cs;
+  if (received >= 2 && *orchestra == '\0') {
+    udp_flush_lines(csound, &p->lines);
+    udp_binary(p, (unsigned char *) orchestra, received);
+    return 0;
+  }
+  orchestra[received] = '\0'; // terminate string
+  if(strlen(orchestra) < 2) return 0;
+  if (csound->oparms->echo)
+    csound->Message(csound, "%s", orchestra);
+  if (strncmp("!!close!!",orchestra,9)==0 ||
+      strncmp("##close##",orchestra,9)==0) {
+    udp_flush_lines(csound, &p->lines);
+    csoundInputMessageAsync(csound, "e 0 0");
+    return 1;
+  }
+  if(*orchestra == '&' || *orchestra == '$') {
+    udp_add_line(csound, &p->lines, *orchestra, orchestra+1,
+                 strlen(orchestra+1));
+    return 0;
+  }
+  udp_flush_lines(csound, &p->lines);
+  if(*orchestra == '@') {
+    char chn[128];
+    const char *rest;
+    udp_channel_name(orchestra+1, chn, &rest);
+    csoundSetControlChannel(csound, chn, atof(rest));
+  }
+  else if(*orchestra == '%') {
+    char chn[128];
+    const char *rest;
+    udp_channel_name(orchestra+1, chn, &rest);
+    csoundSetStringChannel(csound, chn, (char *) rest);
+  }
+  else if(*orchestra == ':') {
+    char addr[128], chn[128], *msg;
+    const char *rest;
+    int sport, err = 0;
+    MYFLT val;
+    udp_channel_name(orchestra+2, chn, &rest);
+    udp_channel_name(rest, addr, &rest);
+    sport = atoi(rest);
+    if(*(orchestra+1) == '@') {
+      val = csoundGetControlChannel(csound, chn, &err);
+      msg = (char *) csound->Calloc(csound, strlen(chn) + 32);
+      sprintf(msg, "%s::%f", chn, val);
+    }
+    else if (*(orchestra+1) == '%') {
+      MYFLT  *pstring;
+      if (csoundGetChannelPtr(csound, &pstring, chn,
+                              CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL)
+          == CSOUND_SUCCESS) {
+        STRINGDAT* stringdat = (STRINGDAT*) pstring;
+        int size = stringdat->size;
+        spin_lock_t *lock =
+          (spin_lock_t *) csoundGetChannelLock(csound, (char*) chn);
+        msg = (char *) csound->Calloc(csound, strlen(chn) + size);
+        if (lock != NULL)
+          csoundSpinLock(lock);
+        sprintf(msg, "%s::%s", chn, stringdat->data);
+        if (lock != NULL)
+          csoundSpinUnLock(lock);
+      } else err = -1;
+    }
+    else err = -1;
+    if(!err) {
+      udp_socksend(csound, &st->sock, addr, sport,msg);
+      csound->Free(csound, msg);
+    }
+    else
+      csound->Warning(csound, Str("could not retrieve channel %s"), chn);
+  }
+  else if(*orchestra == '{' || st->cont) {
+    char *cp;
+    size_t len;
+    if((cp = strrchr(orchestra, '}')) != NULL) {
+      if(*(cp-1) != '}') {
+        *cp = '\0';
+        st->cont = 0;
+      }  else {
+        st->cont = 1;
+      }
+    }
+    else {
+      st->cont = 1;
+    }
+    len = strlen(orchestra);
+    if (UNLIKELY(st->len + len >= MAXSTR)) {
+      csound->Warning(csound, Str("UDP: orchestra code too long"));
+      st->len = 0;
+      st->cont = 0;
+      return 0;
+    }
+    memcpy(st->start + st->len, orchestra, len + 1);
+    st->len += len;
+    if(!st->cont) {
+      //csound->Message(csound, "%s\n", st->start+1);
+      csoundCompileOrcAsync(csound, st->start+1);
+      st->len = 0;
+    }
+  }
+  else {
+    //csound->Message(csound, "%s\n", orchestra);
+    csoundCompileOrcAsync(csound, orchestra);
+  }
+  return 0;
+}
+
+/* read and handle what is waiting on a socket; returns the number */
+/* of datagrams read, or -1 on a close message                       */
+
+static int udp_drain(UDPCOM *p, UDPSTATE *st, int sock) {
+  int count = 0;
+#if defined(LINUX)
+  struct mmsghdr msgs[UDP_BATCH];
+  struct iovec iov[UDP_BATCH];
+  int i, n;
+  memset(msgs, 0, sizeof(msgs));
+  for (i = 0; i < UDP_BATCH; i++) {
+    iov[i].iov_base = p->bufs + (size_t) i * UDP_MSGSIZE;
+    iov[i].iov_len = UDP_MSGSIZE - 1;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  do {
+    n = recvmmsg(sock, msgs, UDP_BATCH, MSG_DONTWAIT, NULL);
+    for (i = 0; i < n; i++, count++)
+      if (udp_dispatch(p, st, p->bufs + (size_t) i * UDP_MSGSIZE,
+                       (int) msgs[i].msg_len))
+        return -1;
+  } while (n == UDP_BATCH);
+#else
   struct sockaddr from;
-  socklen_t clilen = sizeof(from);
+  socklen_t clilen;
+  int received;
+  for ( ; count < UDP_BATCH; count++) {
+    clilen = sizeof(from);
+    if ((received = recvfrom(sock, (void *) p->bufs, UDP_MSGSIZE - 1, 0,
+                             &from, &clilen)) <= 0)
+      break;
+    if (udp_dispatch(p, st, p->bufs, received))
+      return -1;
+  }
+#endif
+  return count;
+}
+
+static uintptr_t udp_recv(void *pdata){
   UDPCOM *p = (UDPCOM *) pdata;
   CSOUND *csound = p->cs;
   int port = p->port;
-  char *orchestra = csound->Calloc(csound, MAXSTR);
-  int sock = 0;
-  int received, cont = 0;
-  char *start = orchestra;
+  UDPSTATE st;
+  int done = 0;
+#if defined(LINUX)
+  struct epoll_event events[UDP_MAXSOCKS + 1];
+#else
   size_t timout = (size_t) lround(1000/csound->GetKr(csound));
+#endif
 
+  st.start = csound->Calloc(csound, MAXSTR);
+  st.len = 0;
+  st.cont = 0;
+  st.sock = 0;
   csound->Message(csound, Str("UDP server started on port %d\n"),port);
-  while (p->status) {
-    if ((received =
-         recvfrom(p->sock, (void *)orchestra, MAXSTR, 0, &from, &clilen)) <= 0) {
-      csoundSleep(timout ? timout : 1);
-      continue;
-    }
-    else {
-      orchestra[received] = '\0'; // terminate string
-      if(strlen(orchestra) < 2) continue;
-      if (csound->oparms->echo)
-        csound->Message(csound, "%s", orchestra);
-      if (strncmp("!!close!!",orchestra,9)==0 ||
-          strncmp("##close##",orchestra,9)==0) {
-        csoundInputMessageAsync(csound, "e 0 0");
-        break;
-      }
-      if(*orchestra == '&') {
-        csoundInputMessageAsync(csound, orchestra+1);
-      }
-      else if(*orchestra == '$') {
-        csoundReadScoreAsync(csound, orchestra+1);
-      }
-      else if(*orchestra == '@') {
-        char chn[128];
-        MYFLT val;
-        sscanf(orchestra+1, "%s", chn);
-        val = atof(orchestra+1+strlen(chn));
-        csoundSetControlChannel(csound, chn, val);
-      }
-      else if(*orchestra == '%') {
-        char chn[128];
-        char *str;
-        sscanf(orchestra+1, "%s", chn);
-        str = cs_strdup(csound, orchestra+1+strlen(chn));
-        csoundSetStringChannel(csound, chn, str);
-        csound->Free(csound, str);
-      }
-      else if(*orchestra == ':') {
-        char addr[128], chn[128], *msg;
-        int sport, err = 0;
-        MYFLT val;
-        sscanf(orchestra+2, "%s", chn);
-        sscanf(orchestra+2+strlen(chn), "%s", addr);
-        sport = atoi(orchestra+3+strlen(addr)+strlen(chn));
-        if(*(orchestra+1) == '@') {
-          val = csoundGetControlChannel(csound, chn, &err);
-          msg = (char *) csound->Calloc(csound, strlen(chn) + 32);
-          sprintf(msg, "%s::%f", chn, val);
-        }
-        else if (*(orchestra+1) == '%') {
-          MYFLT  *pstring;
-          if (csoundGetChannelPtr(csound, &pstring, chn,
-                                  CSOUND_STRING_CHANNEL | CSOUND_OUTPUT_CHANNEL)
-              == CSOUND_SUCCESS) {
-            STRINGDAT* stringdat = (STRINGDAT*) pstring;
-            int size = stringdat->size;
-            spin_lock_t *lock =
-              (spin_lock_t *) csoundGetChannelLock(csound, (char*) chn);
-            msg = (char *) csound->Calloc(csound, strlen(chn) + size);
-            if (lock != NULL)
-              csoundSpinLock(lock);
-            sprintf(msg, "%s::%s", chn, stringdat->data);
-            if (lock != NULL)
-              csoundSpinUnLock(lock);
-          } else err = -1;
-        }
-        else err = -1;
-        if(!err) {
-          udp_socksend(csound, &sock, addr, sport,msg);
-          csound->Free(csound, msg);
-        }
-        else
-          csound->Warning(csound, Str("could not retrieve channel %s"), chn);
-      }
-      else if(*orchestra == '{' || cont) {
-        char *cp;
-        if((cp = strrchr(orchestra, '}')) != NULL) {
-          if(*(cp-1) != '}') {
-            *cp = '\0';
-            cont = 0;
-          }  else {
-            orchestra += received;
-            cont = 1;
-          }
-        }
-        else {
-          orchestra += received;
-          cont = 1;
-        }
-        if(!cont) {
-          orchestra = start;
-          //csound->Message(csound, "%s\n", orchestra+1);
-          csoundCompileOrcAsync(csound, orchestra+1);
-        }
-      }
-      else {
-        //csound->Message(csound, "%s\n", orchestra);
-        csoundCompileOrcAsync(csound, orchestra);
-      }
+  while (ATOMIC_GET(p->status) && !done) {
+#if defined(LINUX)
+    int i, n = epoll_wait(p->efd, events, UDP_MAXSOCKS + 1, -1);
+    for (i = 0; i < n && !done; i++)
+      if (events[i].data.fd != p->wakefd)
+        done = udp_drain(p, &st, events[i].data.fd) < 0;
+#else
+    int i, n, count = 0, nsocks = ATOMIC_GET(p->nsocks);
+    for (i = 0; i < nsocks && !done; i++) {
+      if ((n = udp_drain(p, &st, p->socks[i])) < 0) done = 1;
+      else count += n;
     }
+    /* sleep only when nothing came in */
+    if (!count && !done)
+      csoundSleep(timout ? timout : 1);
+#endif
+    udp_flush_lines(csound, &p->lines);
   }
   csound->Message(csound, Str("UDP server on port %d stopped\n"),port);
-  csound->Free(csound, start);
+  csound->Free(csound, st.start);
   // csound->Message(csound, "orchestra dealloc\n");
-  if(sock > 0)
-#ifndef WIN32
-    close(sock);
-#else
-  closesocket(sock);
-#endif
+  if(st.sock > 0)
+    udp_close(st.sock);
   return (uintptr_t) 0;
 
 }
 
-static int udp_start(CSOUND *csound, UDPCOM *p)
+/* open a socket on port and add it to the server */
+
+static int udp_open(CSOUND *csound, UDPCOM *p, int port)
 {
+  int sock, n = p->nsocks;
 #if defined(WIN32) && !defined(__CYGWIN__)
-  WSADATA wsaData = {0};
   int err;
-  if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0)){
-    csound->Warning(csound, Str("Winsock2 failed to start: %d"), err);
+#endif
+  struct sockaddr_in server_addr;
+  if (UNLIKELY(n >= UDP_MAXSOCKS)) {
+    csound->Warning(csound, Str("UDP Server: too many ports"));
+    return CSOUND_ERROR;
+  }
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (UNLIKELY(sock < 0)) {
+    csound->Warning(csound, Str("error creating socket"));
     return CSOUND_ERROR;
   }
-#endif
-  p->cs = csound;
-  p->sock = socket(AF_INET, SOCK_DGRAM, 0);
 #ifndef WIN32
-  if (UNLIKELY(fcntl(p->sock, F_SETFL, O_NONBLOCK)<0)) {
+  if (UNLIKELY(fcntl(sock, F_SETFL, O_NONBLOCK)<0)) {
     csound->Warning(csound, Str("UDP Server: Cannot set nonblock"));
-    if (p->sock>=0) close(p->sock);
+    close(sock);
     return CSOUND_ERROR;
   }
 #else
   {
     u_long argp = 1;
-    err = ioctlsocket(p->sock, FIONBIO, &argp);
+    err = ioctlsocket(sock, FIONBIO, &argp);
     if (UNLIKELY(err != NO_ERROR)) {
       csound->Warning(csound, Str("UDP Server: Cannot set nonblock"));
-      closesocket(p->sock);
+      closesocket(sock);
       return CSOUND_ERROR;
     }
   }
 #endif
-  if (UNLIKELY(p->sock < 0)) {
-    csound->Warning(csound, Str("error creating socket"));
-    return CSOUND_ERROR;
-  }
   /* create server address: where we want to send to and clear it out */
-  memset(&p->server_addr, 0, sizeof(p->server_addr));
-  p->server_addr.sin_family = AF_INET;    /* it is an INET address */
-  p->server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-  p->server_addr.sin_port = htons((int) p->port);    /* the port */
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family = AF_INET;    /* it is an INET address */
+  server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  server_addr.sin_port = htons((int) port);    /* the port */
   /* associate the socket with the address and port */
-  if (UNLIKELY(bind(p->sock, (struct sockaddr *) &p->server_addr,
-                    sizeof(p->server_addr)) < 0)) {
+  if (UNLIKELY(bind(sock, (struct sockaddr *) &server_addr,
+                    sizeof(server_addr)) < 0)) {
     csound->Warning(csound, Str("bind failed"));
+    udp_close(sock);
+    return CSOUND_ERROR;
+  }
+#if defined(LINUX)
+  {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = sock;
+    if (UNLIKELY(epoll_ctl(p->efd, EPOLL_CTL_ADD, sock, &ev) < 0)) {
+      csound->Warning(csound, Str("UDP Server: cannot poll socket"));
+      udp_close(sock);
+      return CSOUND_ERROR;
+    }
+  }
+#endif
+  if (n == 0) {
+    p->sock = sock;
+    p->server_addr = server_addr;
+  }
+  p->socks[n] = sock;
+  p->ports[n] = port;
+  ATOMIC_SET(p->nsocks, n + 1);
+  return CSOUND_SUCCESS;
+}
+
+static int udp_start(CSOUND *csound, UDPCOM *p)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+  WSADATA wsaData = {0};
+  int err;
+  if (UNLIKELY((err=WSAStartup(MAKEWORD(2,2), &wsaData))!= 0)){
+    csound->Warning(csound, Str("Winsock2 failed to start: %d"), err);
+    return CSOUND_ERROR;
+  }
+#endif
+  p->cs = csound;
+  p->nsocks = 0;
+  p->efd = p->wakefd = -1;
+#if defined(LINUX)
+  {
+    struct epoll_event ev;
+    p->efd = epoll_create1(0);
+    p->wakefd = eventfd(0, EFD_NONBLOCK);
+    ev.events = EPOLLIN;
+    ev.data.fd = p->wakefd;
+    if (UNLIKELY(p->efd < 0 || p->wakefd < 0 ||
+                 epoll_ctl(p->efd, EPOLL_CTL_ADD, p->wakefd, &ev) < 0)) {
+      csound->Warning(csound, Str("UDP Server: cannot create epoll instance"));
+      if (p->efd >= 0) close(p->efd);
+      if (p->wakefd >= 0) close(p->wakefd);
+      return CSOUND_ERROR;
+    }
+  }
+#endif
+  if (UNLIKELY(udp_open(csound, p, p->port) != CSOUND_SUCCESS)) {
     p->thrid = NULL;
-#ifndef WIN32
-    close(p->sock);
-#else
-    closesocket(p->sock);
+#if defined(LINUX)
+    close(p->efd);
+    close(p->wakefd);
 #endif
     return CSOUND_ERROR;
   }
+  p->bufs = (char *) csound->Malloc(csound, (size_t) UDP_BATCH * UDP_MSGSIZE);
   /* set status flag */
   p->status = 1;
   /* create thread */
@@ -285,22 +558,47 @@ int csoundUDPServerClose(CSOUND *csound)
 {
   UDPCOM *p = (UDPCOM *) csound->QueryGlobalVariable(csound,"::UDPCOM");
   if (p != NULL) {
+    int i;
     /* unset status flag */
-    p->status = 0;
+    ATOMIC_SET(p->status, 0);
+#if defined(LINUX)
+    {
+      uint64_t one = 1;
+      if (write(p->wakefd, &one, sizeof(one)) < 0)
+        csound->Warning(csound, Str("UDP Server: cannot wake up server"));
+    }
+#endif
     /* wait for server thread to close */
     csoundJoinThread(p->thrid);
-    /* close socket */
-#ifndef WIN32
-    close(p->sock);
-#else
-    closesocket(p->sock);
+    /* close sockets */
+    for (i = 0; i < p->nsocks; i++)
+      udp_close(p->socks[i]);
+#if defined(LINUX)
+    close(p->efd);
+    close(p->wakefd);
 #endif
+    csound->Free(csound, p->bufs);
+    csound->Free(csound, p->lines.buf);
     csound->DestroyGlobalVariable(csound,"::UDPCOM");
     return CSOUND_SUCCESS;
   }
   else return CSOUND_ERROR;
 }
 
+int csoundUDPServerAddPort(CSOUND *csound, unsigned int port)
+{
+  UDPCOM *p = (UDPCOM *) csound->QueryGlobalVariable(csound,"::UDPCOM");
+  if (p == NULL || !p->status) {
+    csound->Warning(csound,  Str("UDP Server: not running"));
+    return CSOUND_ERROR;
+  }
+  if (udp_open(csound, p, (int) port) != CSOUND_SUCCESS)
+    return CSOUND_ERROR;
+  csound->Message(csound, Str("UDP server also listening on port %d\n"),
+                  (int) port);
+  return CSOUND_SUCCESS;
+}
+
 int csoundUDPServerStart(CSOUND *csound, unsigned int port){
   UDPCOM *connection;
   csound->CreateGlobalVariable(csound, "::UDPCOM", sizeof(UDPCOM));
@@ -351,6 +351,13 @@ extern "C" {
 #define CSOUNDINIT_NO_SIGNAL_HANDLER  1
 #define CSOUNDINIT_NO_ATEXIT          2
 
+  /**
+   * Degradation policies for csoundSetOverloadPolicy()
+   */
+
+#define CSOUND_OVERLOAD_STEAL   1
+#define CSOUND_OVERLOAD_SKIP    2
+
   /**
    * Types for keyboard callbacks set in csoundRegisterKeyboardCallback()
    */
@@ -510,6 +517,12 @@ extern "C" {
     int     daemon;  /* daemon mode */
     int     ksmps_override; /* ksmps override */
     int     FFT_library;    /* fft_lib */
+    /* for the fields below, 0 = off (the default), and a negative */
+    /* value leaves the current setting unchanged                   */
+    int     voice_batch;    /* instances run in lockstep */
+    int     write_buffers;  /* sound file writer thread buffers */
+    int     gen01_threads;  /* threads decoding deferred GEN01 files */
+    int     gen01_cache;    /* MB of decoded GEN01 files kept for reuse */
   } CSOUND_PARAMS;
 
   /**
@@ -906,6 +919,67 @@ extern "C" {
    */
   PUBLIC int csoundPerformBuffer(CSOUND *);
 
+  /**
+   * Performs Csound, sensing real-time and score events, for 'nframes'
+   * sample frames of non-interleaved audio, which need not be a multiple
+   * of ksmps. The output is written directly to out[0] .. out[nchnls-1],
+   * and the input read from in[0] .. in[nchnls_i-1]; either array, or any
+   * channel in it, may be NULL for an unused output or a silent input.
+   * A partly used k-period is continued by the next call. The input
+   * reaches the orchestra ksmps frames later, and is ignored if the input
+   * is read from a file or device (-i).
+   * While this is used, unless audio is also written to a file or device
+   * (-o), the buffer of csoundGetSpout() is not updated and no amplitude
+   * statistics are kept.
+   * Returns false during performance, and true when performance is finished,
+   * in which case the rest of the output buffers is cleared.
+   */
+  PUBLIC int csoundPerformFrames(CSOUND *, MYFLT **in, MYFLT **out,
+                                 uint32_t nframes);
+
+  /**
+   * Measures the time taken by each k-cycle as a fraction of its real time
+   * budget of 1/kr seconds. When a k-cycle takes more than 'threshold'
+   * (e.g. 0.8), the engine is overloaded and degrades as set by 'policy',
+   * the sum of any of:
+   *   CSOUND_OVERLOAD_STEAL: on each overloaded k-cycle, release one voice
+   *     of the non-essential instrument with the lowest priority
+   *   CSOUND_OVERLOAD_SKIP: do not perform non-essential instruments
+   *     until the engine has recovered (not with -j)
+   * Non-essential instruments are those given a negative priority with
+   * csoundSetInstrumentPriority(). The engine has recovered after one
+   * second of k-cycles under three quarters of the threshold. Orchestras
+   * can switch to cheaper code while the 'overload' opcode returns 1.
+   * A threshold of zero, the default, turns off the measurement.
+   */
+  PUBLIC void csoundSetOverloadPolicy(CSOUND *, int policy, double threshold);
+
+  /**
+   * Sets a function called by the performance thread after each overloaded
+   * k-cycle with 'overloaded' set to 1, and once more when the engine has
+   * recovered with 'overloaded' set to 0. 'load' is the time taken by the
+   * k-cycle as a fraction of its budget.
+   */
+  PUBLIC void csoundSetOverloadCallback(CSOUND *,
+                                        void (*func)(CSOUND *, void *userData,
+                                                     double load,
+                                                     int overloaded),
+                                        void *userData);
+
+  /**
+   * Sets the priority of instrument 'insno' for csoundSetOverloadPolicy(),
+   * zero by default; negative values mark the instrument as non-essential.
+   * The priority is kept until the instrument is redefined. Returns
+   * CSOUND_ERROR if the instrument does not exist.
+   */
+  PUBLIC int csoundSetInstrumentPriority(CSOUND *, int insno, int priority);
+
+  /**
+   * Returns the time taken by the last k-cycle as a fraction of its real
+   * time budget, if measured (see csoundSetOverloadPolicy()).
+   */
+  PUBLIC double csoundGetLoad(CSOUND *);
+
   /**
    * Stops a csoundPerform() running in another thread. Note that it is
    * not guaranteed that csoundPerform() has already stopped when this
@@ -940,6 +1014,17 @@ extern "C" {
    */
   PUBLIC int csoundUDPServerStart(CSOUND *csound, unsigned int port);
 
+  /**
+   * Makes the running UDP server also listen on port, up to eight
+   * ports in all. Besides the text messages, each port takes binary
+   * control messages, which start with a zero byte: a zero followed
+   * by 'b', a 16-bit id and a channel name binds the id to a control
+   * channel, and a zero followed by 'v' and any number of 16-bit ids
+   * each with a 32-bit float value sets the bound channels. All are
+   * in network byte order. Returns CSOUND_SUCCESS or CSOUND_ERROR.
+   */
+  PUBLIC int csoundUDPServerAddPort(CSOUND *csound, unsigned int port);
+
   /** returns the port number on which the server is running, or
    *  CSOUND_ERROR if the server is not running.
    */
@@ -1042,6 +1127,9 @@ extern "C" {
    *  OPARMS struct that are configurable through command line flags.
    *  The CSOUND_PARAMS structure can be obtained using csoundGetParams().
    *  These options should only be changed before performance has started.
+   *  Set voice_batch, write_buffers, gen01_threads and gen01_cache to -1
+   *  in a structure that was not filled by csoundGetParams() to leave
+   *  them as they are.
    */
   PUBLIC void csoundSetParams(CSOUND *csound, CSOUND_PARAMS *p);
 
@@ -1437,6 +1525,24 @@ extern "C" {
   PUBLIC void csoundSetExternalMidiErrorStringCallback(CSOUND *,
                                                        const char *(*func)(int));
 
+  /**
+   * Queues a complete MIDI message of 'nbytes' (1 to 3) bytes, starting
+   * with its status byte, that was received at 'time' seconds on the
+   * clock returned by csoundGetMidiTime(), or now if 'time' is negative.
+   * The message is read, in the order queued, by the k-period that
+   * plays that moment, and with sample-accurate timing (--sample-accurate)
+   * a note on starts at that sample of the period. May be called from any
+   * thread; MIDI input must be enabled (e.g. -M0 -+rtmidi=null).
+   * Returns CSOUND_ERROR if the message is malformed or the queue is full.
+   */
+  PUBLIC int csoundPushMidiMessage(CSOUND *, const unsigned char *msg,
+                                   int nbytes, double time);
+
+  /**
+   * Returns the current time in seconds on the clock used to timestamp
+   * MIDI messages for csoundPushMidiMessage().
+   */
+  PUBLIC double csoundGetMidiTime(CSOUND *);
 
   /**
    * Sets a function that is called to obtain a list of MIDI devices.
@@ -2509,6 +2615,57 @@ extern "C" {
    */
   PUBLIC int csoundWriteCircularBuffer(CSOUND *csound, void *p,
                                        const void *inp, int items);
+
+  /**
+   * Get direct access to the items that can be read from a circular
+   * buffer, without copying them. Returns a pointer to the next readable
+   * item and stores in *avail the number of items that can be read from
+   * it, which is at most items and does not extend past the end of the
+   * buffer (so a second call may be needed after the wrap point).
+   * Returns NULL, with *avail set to 0, if the buffer is empty.
+   * The items stay in the buffer until they are released with
+   * csoundCommitCircularBufferRead().
+   * @param csound This value is currently ignored.
+   * @param circular_buffer pointer to an existing circular buffer
+   * @param items maximum number of items wanted
+   * @param avail receives the number of items available at the pointer
+   */
+  PUBLIC void *csoundAcquireCircularBufferRead(CSOUND *csound,
+                                               void *circular_buffer,
+                                               int items, int *avail);
+
+  /**
+   * Release items obtained with csoundAcquireCircularBufferRead() after
+   * they have been used; items must not exceed the *avail returned.
+   */
+  PUBLIC void csoundCommitCircularBufferRead(CSOUND *csound,
+                                             void *circular_buffer,
+                                             int items);
+
+  /**
+   * Get direct access to the free space of a circular buffer, so that
+   * data can be produced in place. Returns a pointer to the next free
+   * slot and stores in *avail the number of items that can be stored
+   * there (at most items, not extending past the end of the buffer).
+   * Returns NULL, with *avail set to 0, if the buffer is full.
+   * The items become visible to the reader with
+   * csoundCommitCircularBufferWrite().
+   * @param csound This value is currently ignored.
+   * @param circular_buffer pointer to an existing circular buffer
+   * @param items maximum number of items wanted
+   * @param avail receives the number of items that can be written
+   */
+  PUBLIC void *csoundAcquireCircularBufferWrite(CSOUND *csound,
+                                                void *circular_buffer,
+                                                int items, int *avail);
+
+  /**
+   * Publish items stored through csoundAcquireCircularBufferWrite();
+   * items must not exceed the *avail returned.
+   */
+  PUBLIC void csoundCommitCircularBufferWrite(CSOUND *csound,
+                                              void *circular_buffer,
+                                              int items);
   /**
    * Empty circular buffer of any remaining data. This function should only be
    * used if there is no reader actively getting data from the buffer.
@@ -366,6 +366,28 @@ public:
   {
     return csoundPerformBuffer(csound);
   }
+  virtual int PerformFrames(MYFLT **in, MYFLT **out, uint32_t nframes)
+  {
+    return csoundPerformFrames(csound, in, out, nframes);
+  }
+  virtual void SetOverloadPolicy(int policy, double threshold)
+  {
+    csoundSetOverloadPolicy(csound, policy, threshold);
+  }
+  virtual void SetOverloadCallback(
+      void (*func)(CSOUND *, void *userData, double load, int overloaded),
+      void *userData)
+  {
+    csoundSetOverloadCallback(csound, func, userData);
+  }
+  virtual int SetInstrumentPriority(int insno, int priority)
+  {
+    return csoundSetInstrumentPriority(csound, insno, priority);
+  }
+  virtual double GetLoad()
+  {
+    return csoundGetLoad(csound);
+  }
   virtual void Stop()
   {
     csoundStop(csound);
@@ -263,6 +263,11 @@ typedef struct CORFIL {
     int     ksmps_override;
     int     fft_lib;
     int     echo;
+    int     voiceBatch;     /* max instances run in lockstep, 0 = off */
+    int     writeBuffers;   /* sound file writer thread buffers, 0 = off */
+    int     gen01Threads;   /* threads decoding deferred GEN01 files */
+    int     gen01Cache;     /* MB of decoded GEN01 files kept for reuse */
+    int     mp3Stream;      /* MP3 opcodes and GEN49 use sndstream, 0 or 1 */
   } OPARMS;
 
   typedef struct arglst {
@@ -346,6 +351,10 @@ typedef struct CORFIL {
     int     instcnt;                /* Count number of instances ever */
     int     isNew;                  /* is this a new definition */
     int     nocheckpcnt;            /* Control checks on pcnt */
+    int     batchable;              /* instances may run in lockstep */
+    int     priority;               /* for overloads, < 0: non-essential */
+    struct batchentry *batchops;    /* batch kernels of its perf functions */
+    int     nbatchops;
   } INSTRTXT;
 
   typedef struct namedInstr {
@@ -591,6 +600,23 @@ typedef struct CORFIL {
 #define CS_SPIN      (p->h.insdshead->spin)
 #define CS_SPOUT     (p->h.insdshead->spout)
   typedef int (*SUBR)(CSOUND *, void *);
+  typedef int (*BSUBR)(CSOUND *, void **, int);
+
+  /**
+   * A multi-voice version of a perf function, which runs the same opcode
+   * of n instances of one instrument in lockstep (see --voice-batch).
+   */
+  typedef struct batchentry {
+    SUBR    opadr;
+    BSUBR   batchadr;
+  } BATCHENTRY;
+
+/* largest voice group handed to a batch kernel in one call */
+#define MAX_VOICE_BATCH 64
+/* largest buffer pool of the sound file writer thread */
+#define MAX_WRITE_BUFFERS 64
+/* largest number of threads decoding deferred GEN01 sound files */
+#define MAX_GEN01_THREADS 16
 
   /**
    * This struct holds the info for one opcode in a concrete
@@ -765,6 +791,8 @@ typedef struct CORFIL {
     int         wintype;
     int         chans;
     MYFLT       srate;
+    void        *mapbase;       /* if data is mapped from the file, */
+    size_t      maplen;         /* the region to unmap on reset     */
   } PVOCEX_MEMFILE;
 
 #ifdef __BUILDING_LIBCSOUND
@@ -789,6 +817,8 @@ typedef struct CORFIL {
 #define MBUFSIZ         (4096)
 #define MIDIINBUFMAX    (1024)
 #define MIDIINBUFMSK    (MIDIINBUFMAX-1)
+#define MIDITSBUFMAX    (1024)
+#define MIDITSBUFMSK    (MIDITSBUFMAX-1)
 
 
 
@@ -797,6 +827,16 @@ typedef struct CORFIL {
     unsigned char bData[4];
   } MIDIMESSAGE;
 
+  /* a MIDI message and the real time it was received, queued by */
+  /* csoundPushMidiMessage() and read by sensMidi()                */
+
+  typedef struct {
+    long    seq;                /* see midi_ts_push() */
+    double  time;
+    int     nbytes;
+    unsigned char data[4];
+  } MIDITSMSG;
+
   /* MIDI globals */
 
   typedef struct midiglobals {
@@ -821,6 +861,12 @@ typedef struct CORFIL {
     unsigned char mbuf[MBUFSIZ];
     unsigned char *bufp, *endatp;
     int16   datreq, datcnt;
+    MIDITSMSG tsbuf[MIDITSBUFMAX];
+    long    tswp, tsrp;         /* any number of writers, one reader */
+    int     tsactive;           /* timestamped messages were pushed */
+    int64_t tskcnt;             /* k-period the clock lag was taken in */
+    double  tslag;              /* least real time less score time */
+    int     ksmpsOffset;        /* of the note on being dispatched */
   } MGLOBAL;
 
   typedef struct eventnode {
@@ -1382,12 +1428,14 @@ typedef struct _message_queue_t_ {
                                char* , char*);
     int (*GetChannelPtr)(CSOUND *,MYFLT **, const char *, int);
     int (*ListChannels)(CSOUND *, controlChannelInfo_t **);
+    int (*PushMidiMessage)(CSOUND *, const unsigned char *, int, double);
+    double (*GetMidiTime)(CSOUND *);
     
        /**@}*/
     /** @name Placeholders
         To allow the API to grow while maintining backward binary compatibility. */
     /**@{ */
-    SUBR dummyfn_2[32];
+    SUBR dummyfn_2[30];
     /**@}*/
 #ifdef __BUILDING_LIBCSOUND
     /* ------- private data (not to be used by hosts or externals) ------- */
@@ -1657,7 +1705,8 @@ typedef struct _message_queue_t_ {
       int           pipdevin, pipdevout;  /* 0: file, 1: pipe, 2: rtaudio */
       uint32        nframes               /* = 1UL */;
       FILE          *pin, *pout;
-      int           dither;
+      uint32_t      dither;               /* dither sample counter        */
+      void          *writer;              /* writer thread, if any        */
     } libsndStatics;
 
     int           warped;               /* rdscor.c */
@@ -1665,6 +1714,15 @@ typedef struct _message_queue_t_ {
     char          *sstrbuf;
     int           enableMsgAttr;        /* csound.c */
     int           sampsNeeded;
+    uint32_t      renderRem;            /* frames of spraw not yet copied */
+    int           hostRender;           /* csoundPerformFrames() in use   */
+    int           ovlPolicy;            /* csoundSetOverloadPolicy()      */
+    double        ovlThreshold;
+    double        ovlLoad;              /* of the last k-cycle            */
+    int           ovlState;             /* non-zero while overloaded      */
+    int           ovlCalm;              /* k-cycles since overloaded      */
+    void          (*overloadCallback_)(CSOUND *, void *, double, int);
+    void          *overloadUserData;
     MYFLT         csoundScoreOffsetSeconds_;
     int           inChar_;
     int           isGraphable_;
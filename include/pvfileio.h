@@ -159,6 +159,9 @@ int     pvoc_getframes(CSOUND *,
                        int ifd, float *frames, uint32 nframes);
 int     pvoc_framecount(CSOUND *, int ifd);
 int     pvoc_fseek(CSOUND *, int ifd, int offset);
+float   *pvoc_mapframes(CSOUND *, int ifd, uint32 nframes,
+                        void **base, size_t *len);
+void    pvoc_unmapframes(void *base, size_t len);
 int     pvsys_release(CSOUND *);
 
 #endif  /* CSOUND_CSDL_H */
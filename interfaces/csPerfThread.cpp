@@ -23,11 +23,93 @@
 
 #include <iostream>
 #include <exception>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 #include "csound.hpp"
 #include "csPerfThread.hpp"
 #include <sndfile.h>
 
+// messages that can be sent and not yet destroyed
+#define CSPT_QUEUE_SIZE         1024
+// bytes reserved for each preallocated message
+#define CSPT_SLOT_SIZE          256
+#define CSPT_LATENCY_BUCKETS    32
+
+// ----------------------------------------------------------------------------
+
+/**
+ * Ring of message pointers with one writing and one reading thread.
+ */
+
+struct CsPerfThreadRing {
+    CsoundPerformanceThreadMessage *msgs[CSPT_QUEUE_SIZE];
+    std::atomic<unsigned int> head;     // next message to read
+    std::atomic<unsigned int> tail;     // next free entry
+    CsPerfThreadRing() : head(0), tail(0) {}
+    bool Empty()
+    {
+      return head.load(std::memory_order_relaxed)
+             == tail.load(std::memory_order_acquire);
+    }
+    // the caller makes sure the ring is not full
+    void Push(CsoundPerformanceThreadMessage *msg)
+    {
+      unsigned int t = tail.load(std::memory_order_relaxed);
+      msgs[t % CSPT_QUEUE_SIZE] = msg;
+      tail.store(t + 1, std::memory_order_release);
+    }
+    CsoundPerformanceThreadMessage *Pop()
+    {
+      unsigned int h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire))
+        return (CsoundPerformanceThreadMessage*) 0;
+      CsoundPerformanceThreadMessage *msg = msgs[h % CSPT_QUEUE_SIZE];
+      head.store(h + 1, std::memory_order_release);
+      return msg;
+    }
+};
+
+/**
+ * Messages go to the performance thread through the 'pending' ring, which
+ * the sending threads write with queueLock held. Once run, the performance
+ * thread puts them in the 'done' ring, and the sending threads destroy them
+ * the next time they queue a message, so the performance thread neither
+ * takes a lock nor frees memory. Message objects are allocated from
+ * preallocated slots, or from the heap if they do not fit.
+ */
+
+struct CsPerfThreadMessageQueue {
+    CsPerfThreadRing pending;
+    CsPerfThreadRing done;
+    void          *lock;                // queueLock, for the slots
+    int           outstanding;          // messages in either ring
+    unsigned long sent;
+    std::atomic<unsigned long> received; // messages run or discarded
+    char          *slots;
+    int           freeSlots[CSPT_QUEUE_SIZE];
+    int           nFree;
+    std::atomic<unsigned int> latency[CSPT_LATENCY_BUCKETS];
+    std::atomic<unsigned long> recordOverruns;  // k-periods not recorded
+};
+
+union CsPerfThreadSlotHeader {
+    CsPerfThreadMessageQueue *owner;    // NULL if allocated from the heap
+    std::max_align_t align;
+};
+
+#define CSPT_SLOT_STRIDE (sizeof(CsPerfThreadSlotHeader) + CSPT_SLOT_SIZE)
+
+static inline int64_t csPerfThreadTime()
+{
+    return (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // ----------------------------------------------------------------------------
 
 /**
@@ -45,9 +127,25 @@ class CsoundPerformanceThreadMessage {
     {
       return pt_->paused;
     }
-    recordData_t * getRecordData()
+    CsPerfThreadRecorder *GetRecorder()
     {
-      return &(pt_->recordData);
+      return pt_->recorder;
+    }
+    void SetRecorder(CsPerfThreadRecorder *recorder)
+    {
+      pt_->recorder = recorder;
+    }
+    bool GetRecording()
+    {
+      return pt_->recording;
+    }
+    void SetRecording(bool state)
+    {
+      pt_->recording = state;
+    }
+    std::atomic<unsigned long> *GetRecordOverruns()
+    {
+      return &(pt_->messageQueue->recordOverruns);
     }
     void lockRecord()
     {
@@ -64,16 +162,64 @@ class CsoundPerformanceThreadMessage {
     }
 
  public:
-    CsoundPerformanceThreadMessage *nxt;
+    int64_t queuedAt;           // time sent, in nanoseconds
     virtual int run() = 0;
     CsoundPerformanceThreadMessage(CsoundPerformanceThread *pt)
     {
       pt_ = pt;
-      nxt = (CsoundPerformanceThreadMessage*) 0;
+      queuedAt = 0;
     }
     virtual ~CsoundPerformanceThreadMessage() {}
+    // messages are created with new (pt) and must not be deleted
+    // on the performance thread
+    static void *operator new(size_t size, CsoundPerformanceThread *pt);
+    static void operator delete(void *p);
+    static void operator delete(void *p, CsoundPerformanceThread *pt)
+    {
+      (void) pt;
+      operator delete(p);
+    }
 };
 
+void *CsoundPerformanceThreadMessage::operator new(size_t size,
+                                                   CsoundPerformanceThread *pt)
+{
+    CsPerfThreadMessageQueue *q = pt->messageQueue;
+    CsPerfThreadSlotHeader *h = (CsPerfThreadSlotHeader*) 0;
+    if (q && size <= CSPT_SLOT_SIZE) {
+      csoundLockMutex(q->lock);
+      if (q->nFree > 0) {
+        h = (CsPerfThreadSlotHeader*)
+              (q->slots + q->freeSlots[--q->nFree] * CSPT_SLOT_STRIDE);
+        h->owner = q;
+      }
+      csoundUnlockMutex(q->lock);
+    }
+    if (!h) {
+      h = (CsPerfThreadSlotHeader*) malloc(sizeof(CsPerfThreadSlotHeader)
+                                           + size);
+      if (!h)
+        throw std::bad_alloc();
+      h->owner = (CsPerfThreadMessageQueue*) 0;
+    }
+    return (void*) (h + 1);
+}
+
+void CsoundPerformanceThreadMessage::operator delete(void *p)
+{
+    if (!p)
+      return;
+    CsPerfThreadSlotHeader *h = (CsPerfThreadSlotHeader*) p - 1;
+    CsPerfThreadMessageQueue *q = h->owner;
+    if (!q) {
+      free((void*) h);
+      return;
+    }
+    csoundLockMutex(q->lock);
+    q->freeSlots[q->nFree++] = (int) (((char*) h - q->slots) / CSPT_SLOT_STRIDE);
+    csoundUnlockMutex(q->lock);
+}
+
 /**
  * Unpause performance
  */
@@ -122,133 +268,320 @@ class CsPerfThreadMsg_TogglePause : public CsoundPerformanceThreadMessage {
     ~CsPerfThreadMsg_TogglePause() {}
 };
 
-extern "C" {
-  static uintptr_t recordThread_(void *recordData_)
-  {
-    recordData_t *recordData = (recordData_t *)recordData_;
-    int retval = 0;
-    const int bufsize = 4096;
-    MYFLT buf[bufsize];
-    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
-    while (recordData->running) {
-                csoundLockMutex (recordData->mutex);
-        csoundCondWait(recordData->condvar, recordData->mutex);
-        int sampsread;
-        do {
-            sampsread = csoundReadCircularBuffer(NULL, recordData->cbuf,
-                                                 buf, bufsize);
+/**
+ * Recording runs on a writer thread of its own. The performance thread
+ * copies the output of each k-period into a ring of blocks, unscaled and
+ * without taking a lock, and wakes the writer only when a block is full;
+ * the writer scales the samples to 0dBFS = 1, splits them into one file
+ * per group of channels and has libsndfile convert them to the file
+ * format. When all blocks are waiting to be written, the output of a
+ * k-period is dropped and counted as an overrun.
+ */
+
+struct CsPerfThreadRecorder {
+    int     nchnls;
+    int     ksmps;
+    int     blockFrames;        // a multiple of ksmps
+    int     nblocks;
+    MYFLT   *blocks;
+    int     *blockLength;       // frames in each block handed over
+    std::atomic<unsigned long> written;   // blocks handed to the writer
+    std::atomic<unsigned long> consumed;  // blocks saved by the writer
+    int     fill;               // frames in the block being filled
+    std::atomic<bool> finished;
+    std::atomic<unsigned long> *overruns;
+    void    *wakeup;
+    void    *thread;
+    MYFLT   scale;
+    int     groupChannels;      // channels in each file
+    int     nfiles;
+    SNDFILE **files;
+    MYFLT   *scratch;           // one block of a channel group
+};
+
+static void csPerfThreadSaveBlock(CsPerfThreadRecorder *r, int n)
+{
+    MYFLT *block = r->blocks + (size_t) n * r->blockFrames * r->nchnls;
+    int   frames = r->blockLength[n];
+    for (int f = 0; f < r->nfiles; f++) {
+      int   first = f * r->groupChannels;
+      int   chans = r->nchnls - first;
+      MYFLT *out = r->scratch;
+      if (chans > r->groupChannels)
+        chans = r->groupChannels;
+      if (r->nfiles == 1 && r->scale == FL(1.0))
+        out = block;
+      else {
+        for (int i = 0; i < frames; i++)
+          for (int j = 0; j < chans; j++)
+            out[i * chans + j] = block[i * r->nchnls + first + j] * r->scale;
+      }
 #ifdef USE_DOUBLE
-            sf_write_double((SNDFILE *) recordData->sfile,
-                            buf, sampsread);
+      sf_writef_double(r->files[f], out, frames);
 #else
-            sf_write_float((SNDFILE *) recordData->sfile,
-                           buf, sampsread);
+      sf_writef_float(r->files[f], out, frames);
 #endif
-        } while(sampsread != 0);
-                csoundUnlockMutex (recordData->mutex);
     }
-    return (uintptr_t) ((unsigned int) retval);
+}
+
+extern "C" {
+  static uintptr_t recordThread_(void *recorder)
+  {
+    CsPerfThreadRecorder *r = (CsPerfThreadRecorder*) recorder;
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    for (;;) {
+      // blocks handed over before finishing are saved on this pass
+      bool done = r->finished.load(std::memory_order_acquire);
+      unsigned long w = r->written.load(std::memory_order_acquire);
+      unsigned long c = r->consumed.load(std::memory_order_relaxed);
+      for ( ; c != w; c++) {
+        csPerfThreadSaveBlock(r, (int) (c % r->nblocks));
+        r->consumed.store(c + 1, std::memory_order_release);
+      }
+      if (done)
+        break;
+      csoundWaitThreadLockNoTimeout(r->wakeup);
+    }
+    return (uintptr_t) 0;
   }
 }
 
+/**
+ * Copies one k-period of output to the recording; performance thread only.
+ */
+
+static void csPerfThreadRecord(CsPerfThreadRecorder *r, const MYFLT *spout)
+{
+    unsigned long w = r->written.load(std::memory_order_relaxed);
+    if (!r->fill &&
+        w - r->consumed.load(std::memory_order_acquire)
+          >= (unsigned long) r->nblocks) {
+      r->overruns->fetch_add(1UL, std::memory_order_relaxed);
+      return;
+    }
+    int n = (int) (w % r->nblocks);
+    memcpy(r->blocks + ((size_t) n * r->blockFrames + r->fill) * r->nchnls,
+           spout, sizeof(MYFLT) * r->ksmps * r->nchnls);
+    r->fill += r->ksmps;
+    if (r->fill == r->blockFrames) {
+      r->blockLength[n] = r->fill;
+      r->fill = 0;
+      r->written.store(w + 1, std::memory_order_release);
+      csoundNotifyThreadLock(r->wakeup);
+    }
+}
+
+/**
+ * Hands the block being filled to the writer; called by the thread that
+ * was recording, once it stops.
+ */
+
+static void csPerfThreadRecordFlush(CsPerfThreadRecorder *r)
+{
+    if (r->fill) {
+      unsigned long w = r->written.load(std::memory_order_relaxed);
+      r->blockLength[w % r->nblocks] = r->fill;
+      r->fill = 0;
+      r->written.store(w + 1, std::memory_order_release);
+    }
+}
+
+/**
+ * Waits for the writer to save the blocks handed to it, and closes the
+ * files. Never called on the performance thread.
+ */
+
+static void csPerfThreadRecordClose(CsPerfThreadRecorder *r)
+{
+    if (r->thread) {
+      r->finished.store(true, std::memory_order_release);
+      csoundNotifyThreadLock(r->wakeup);
+      csoundJoinThread(r->thread);
+    }
+    for (int f = 0; f < r->nfiles; f++)
+      if (r->files[f])
+        sf_close(r->files[f]);
+    if (r->wakeup)
+      csoundDestroyThreadLock(r->wakeup);
+    free(r->files);
+    free(r->scratch);
+    free(r->blockLength);
+    free(r->blocks);
+    delete r;
+}
+
+/**
+ * Opens a recording of the output of csound in one file, or in one file
+ * for each group of 'groupChannels' channels if that is non-zero.
+ */
+
+static CsPerfThreadRecorder *
+csPerfThreadRecordOpen(CSOUND *csound, const std::string &filename,
+                       int samplebits, int numbufs, int groupChannels,
+                       std::atomic<unsigned long> *overruns)
+{
+    CsPerfThreadRecorder *r;
+    int nchnls = (int) csoundGetNchnls(csound);
+    int ksmps = (int) csoundGetKsmps(csound);
+    int bufsize = (int) csoundGetOutputBufferSize(csound);
+    try {
+      r = new CsPerfThreadRecorder();
+    }
+    catch (std::bad_alloc&) {
+      return (CsPerfThreadRecorder*) 0;
+    }
+    if (groupChannels <= 0 || groupChannels > nchnls)
+      groupChannels = nchnls;
+    r->nchnls = nchnls;
+    r->ksmps = ksmps;
+    // blocks of one -b buffer, as the circular buffer used to hold
+    // 'numbufs' of these
+    r->blockFrames = ((bufsize > ksmps ? bufsize : ksmps) + ksmps - 1)
+                     / ksmps * ksmps;
+    r->nblocks = (numbufs > 2 ? numbufs : 2);
+    r->written = 0UL;
+    r->consumed = 0UL;
+    r->fill = 0;
+    r->finished = false;
+    r->overruns = overruns;
+    r->wakeup = (void*) 0;
+    r->thread = (void*) 0;
+    r->scale = FL(1.0) / csoundGet0dBFS(csound);
+    r->groupChannels = groupChannels;
+    r->nfiles = (nchnls + groupChannels - 1) / groupChannels;
+    r->blocks = (MYFLT*) malloc(sizeof(MYFLT) * r->nblocks
+                                * r->blockFrames * nchnls);
+    r->blockLength = (int*) calloc(r->nblocks, sizeof(int));
+    r->scratch = (MYFLT*) malloc(sizeof(MYFLT) * r->blockFrames
+                                 * groupChannels);
+    r->files = (SNDFILE**) calloc(r->nfiles, sizeof(SNDFILE*));
+    if (!r->blocks || !r->blockLength || !r->scratch || !r->files) {
+      csoundMessage(csound, "Could not create recording buffer.\n");
+      csPerfThreadRecordClose(r);
+      return (CsPerfThreadRecorder*) 0;
+    }
+
+    for (int f = 0; f < r->nfiles; f++) {
+      SF_INFO sf_info;
+      std::string name = filename;
+      sf_info.samplerate = (int) csoundGetSr(csound);
+      sf_info.channels = (f < r->nfiles - 1 ? groupChannels
+                          : nchnls - f * groupChannels);
+      switch (samplebits) {
+      case 32:
+        sf_info.format = SF_FORMAT_FLOAT;
+        break;
+      case 24:
+        sf_info.format = SF_FORMAT_PCM_24;
+        break;
+      case 16:
+      default:
+        sf_info.format = SF_FORMAT_PCM_16;
+        break;
+      }
+      sf_info.format |= SF_FORMAT_WAV;
+      if (r->nfiles > 1) {
+        // stems.wav -> stems_1.wav, stems_2.wav, ...
+        size_t dot = name.find_last_of('.');
+        size_t sep = name.find_last_of("/\\");
+        if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+          dot = name.size();
+        name.insert(dot, "_" + std::to_string(f + 1));
+      }
+      r->files[f] = sf_open(name.c_str(), SFM_WRITE, &sf_info);
+      if (!r->files[f]) {
+        csoundMessage(csound, "Could not open file %s for recording.\n",
+                      name.c_str());
+        csPerfThreadRecordClose(r);
+        return (CsPerfThreadRecorder*) 0;
+      }
+      sf_command(r->files[f], SFC_SET_CLIPPING, NULL, SF_TRUE);
+    }
+
+    r->wakeup = csoundCreateThreadLock();
+    if (r->wakeup)
+      r->thread = csoundCreateThread(recordThread_, (void*) r);
+    if (!r->thread) {
+      csoundMessage(csound, "Could not start recording thread.\n");
+      csPerfThreadRecordClose(r);
+      return (CsPerfThreadRecorder*) 0;
+    }
+    return r;
+}
+
+/**
+ * Start recording. The files are opened by the sending thread, and the
+ * performance thread only starts copying its output to them.
+ */
+
 class CsPerfThreadMsg_Record: public CsoundPerformanceThreadMessage {
 public:
     CsPerfThreadMsg_Record(CsoundPerformanceThread *pt,
                            std::string filename,
                            int samplebits = 16,
-                           int numbufs = 4)
+                           int numbufs = 4,
+                           int groupChannels = 0)
     : CsoundPerformanceThreadMessage(pt)
     {
-        this->filename = filename;
+        recorder = (CsPerfThreadRecorder*) 0;
         CsoundPerformanceThreadMessage::lockRecord();
-        recordData_t *recordData = CsoundPerformanceThreadMessage::getRecordData();
-        if (recordData->running) {
-            CsoundPerformanceThreadMessage::unlockRecord();
-            return;
-        }
-        CSOUND * csound = pt_->GetCsound();
-        if (!csound) {
-            return;
-        }
-        int bufsize = csoundGetOutputBufferSize(csound)
-                * csoundGetNchnls(csound) * numbufs;
-        recordData->cbuf = csoundCreateCircularBuffer(csound,
-                                                 bufsize,
-                                                 sizeof(MYFLT));
-
-        if (!recordData->cbuf) {
-          csoundMessage(csound, "Could create recording buffer.");
-          return;
-        }
-
-        SF_INFO sf_info;
-        sf_info.samplerate = csoundGetSr(csound);
-        sf_info.channels = csoundGetNchnls(csound);
-        switch (samplebits) {
-        case 32:
-            sf_info.format = SF_FORMAT_FLOAT;
-            break;
-        case 24:
-            sf_info.format = SF_FORMAT_PCM_24;
-            break;
-        case 16:
-        default:
-            sf_info.format = SF_FORMAT_PCM_16;
-            break;
-        }
-
-        sf_info.format |= SF_FORMAT_WAV;
-
-        recordData->sfile = (void *) sf_open(filename.c_str(),
-                                                 SFM_WRITE,
-                                                 &sf_info);
-        if (!recordData->sfile) {
-          csoundMessage(csound, "Could not open file for recording.");
-          csoundDestroyCircularBuffer(csound, recordData->cbuf);
-          return;
+        CSOUND *csound = pt_->GetCsound();
+        if (!GetRecording() && csound) {
+          recorder = csPerfThreadRecordOpen(csound, filename, samplebits,
+                                            numbufs, groupChannels,
+                                            GetRecordOverruns());
+          SetRecording(recorder != 0);
         }
-        sf_command((SNDFILE *) recordData->sfile, SFC_SET_CLIPPING,
-                   NULL, SF_TRUE);
-
-        recordData->running = true;
-        recordData->thread = csoundCreateThread(recordThread_, (void*) recordData);
-
-
         CsoundPerformanceThreadMessage::unlockRecord();
     }
     int run()
     {
+      if (recorder && !GetRecorder()) {
+        SetRecorder(recorder);
+        recorder = (CsPerfThreadRecorder*) 0;
+      }
       return 0;
     }
+    // the files are closed here if the message was never run
     ~CsPerfThreadMsg_Record() {
+      if (recorder)
+        csPerfThreadRecordClose(recorder);
     }
 private:
-    std::string filename;
-
+    CsPerfThreadRecorder *recorder;
 };
 
+/**
+ * Stop recording. The performance thread only hands over the samples it
+ * has not passed on yet; the files are closed when the message is
+ * destroyed by the sending threads.
+ */
+
 class CsPerfThreadMsg_StopRecord: public CsoundPerformanceThreadMessage {
 public:
     CsPerfThreadMsg_StopRecord(CsoundPerformanceThread *pt)
-      : CsoundPerformanceThreadMessage(pt) {}
-    int run()
+      : CsoundPerformanceThreadMessage(pt)
     {
-
+      recorder = (CsPerfThreadRecorder*) 0;
       CsoundPerformanceThreadMessage::lockRecord();
-      recordData_t *recordData = CsoundPerformanceThreadMessage::getRecordData();
-      if (recordData->running) {
-          recordData->running = false;
-          csoundJoinThread(recordData->thread);
-          sf_close((SNDFILE *) recordData->sfile);
-      }
-
+      SetRecording(false);
       CsoundPerformanceThreadMessage::unlockRecord();
-
+    }
+    int run()
+    {
+      recorder = GetRecorder();
+      if (recorder) {
+        SetRecorder((CsPerfThreadRecorder*) 0);
+        csPerfThreadRecordFlush(recorder);
+      }
       return 0;
     }
-    ~CsPerfThreadMsg_StopRecord(){}
+    ~CsPerfThreadMsg_StopRecord() {
+      if (recorder)
+        csPerfThreadRecordClose(recorder);
+    }
 private:
-  //    bool start;
+    CsPerfThreadRecorder *recorder;
 };
 
 
@@ -262,7 +595,7 @@ class CsPerfThreadMsg_Stop : public CsoundPerformanceThreadMessage {
     : CsoundPerformanceThreadMessage(pt)
     {
       CsoundPerformanceThreadMessage::QueueMessage(
-                                         new CsPerfThreadMsg_StopRecord(pt));
+                                         new (pt) CsPerfThreadMsg_StopRecord(pt));
     }
     int run()
     {
@@ -388,6 +721,44 @@ public:
 
 // ----------------------------------------------------------------------------
 
+/**
+ * Runs the messages waiting in the queue, until one returns non-zero (stop
+ * or error), which is returned. Called by the performance thread only.
+ */
+
+int CsoundPerformanceThread::RunMessages()
+{
+    CsPerfThreadMessageQueue *q = messageQueue;
+    CsoundPerformanceThreadMessage *msg;
+    int retval = 0;
+    while (!retval && (msg = q->pending.Pop()) != 0) {
+      // latency, in buckets of powers of two microseconds
+      int64_t usecs = (csPerfThreadTime() - msg->queuedAt) / 1000;
+      int     bucket = 0;
+      while (bucket < CSPT_LATENCY_BUCKETS - 1 && usecs >= ((int64_t) 1 << bucket))
+        bucket++;
+      q->latency[bucket].fetch_add(1, std::memory_order_relaxed);
+      retval = msg->run();
+      // hand over to the sending threads to be destroyed
+      q->done.Push(msg);
+      q->received.fetch_add(1, std::memory_order_release);
+    }
+    return retval;
+}
+
+/**
+ * Destroys the messages that have been run. Called with queueLock held.
+ */
+
+void CsoundPerformanceThread::ReclaimMessages()
+{
+    CsoundPerformanceThreadMessage *msg;
+    while ((msg = messageQueue->done.Pop()) != 0) {
+      messageQueue->outstanding--;
+      delete msg;
+    }
+}
+
 /**
  * Performs the score until end of score, error, or receiving a stop event.
  * Returns a negative value on error.
@@ -397,79 +768,37 @@ int CsoundPerformanceThread::Perform()
 {
     int retval = 0;
     do {
-      while (firstMessage) {
-        csoundLockMutex(queueLock);
-        do {
-          CsoundPerformanceThreadMessage *msg;
-          // get oldest message
-          msg = (CsoundPerformanceThreadMessage*) firstMessage;
-          if (!msg)
-            break;
-          // unlink from FIFO
-          firstMessage = msg->nxt;
-          if (!msg->nxt)
-            lastMessage = (CsoundPerformanceThreadMessage*) 0;
-          // process and destroy message
-          retval = msg->run();
-          delete msg; // TODO: This should be moved out of the Perform function
-        } while (!retval);
-        if (paused)
-          csoundWaitThreadLock(pauseLock, (size_t) 0);
-        // mark queue as empty
+      while (!messageQueue->pending.Empty()) {
+        retval = RunMessages();
+        // wake up FlushMessageQueue()
         csoundNotifyThreadLock(flushLock);
-        csoundUnlockMutex(queueLock);
         // if error or end of score, return now
         if (retval)
           goto endOfPerf;
-        // fprintf(stderr, "Error or end of score, returning now.");
-        // if paused, wait until a new message is received, then loop back
-        if (!paused)
-          break;
-        // VL: if this is paused, then it will double lock.
-        csoundWaitThreadLockNoTimeout(pauseLock);
-        csoundNotifyThreadLock(pauseLock);
+        // if paused, wait until a new message is received, then loop back;
+        // the queue is checked again after each wake up, as a message may
+        // have been run before its notification was seen
+        while (paused && messageQueue->pending.Empty())
+          csoundWaitThreadLockNoTimeout(pauseLock);
       }
       if(processcallback != NULL)
            processcallback(cdata);
       retval = csoundPerformKsmps(csound);
-      if (recordData.running) {
-          MYFLT *spout = csoundGetSpout(csound);
-          int len = csoundGetKsmps(csound) * csoundGetNchnls(csound);
-          if (csoundGet0dBFS(csound) != 1.0) {
-              MYFLT zdbfs = csoundGet0dBFS(csound);
-              MYFLT *modspout = spout;
-              for (int i = 0; i < len; i++) {
-                  *modspout /= zdbfs;
-                  modspout++;
-              }
-          }
-          int written = csoundWriteCircularBuffer(NULL, recordData.cbuf,
-                                                  spout, len);
-          if (written != len) {
-              csoundMessage(csound, "perfThread record buffer overrun.\n");
-          }
-      }
-      csoundCondSignal(recordData.condvar); // Needs to be outside the if
-                              // for the case where stop record was requested
+      if (recorder)
+        csPerfThreadRecord(recorder, csoundGetSpout(csound));
     } while (!retval);
  endOfPerf:
     status = retval;
     csoundCleanup(csound);
-    // delete any pending messages
-    csoundLockMutex(queueLock);
+    // discard any pending messages, they are destroyed by the sending threads
     {
       CsoundPerformanceThreadMessage *msg;
-      msg = (CsoundPerformanceThreadMessage*) firstMessage;
-      firstMessage = (CsoundPerformanceThreadMessage*) 0;
-      lastMessage = (CsoundPerformanceThreadMessage*) 0;
-      while (msg) {
-        CsoundPerformanceThreadMessage *nxt = msg->nxt;
-        delete msg;
-        msg = nxt;
+      while ((msg = messageQueue->pending.Pop()) != 0) {
+        messageQueue->done.Push(msg);
+        messageQueue->received.fetch_add(1, std::memory_order_release);
       }
     }
     csoundNotifyThreadLock(flushLock);
-    csoundUnlockMutex(queueLock);
     //running = 0;
     return retval;
 }
@@ -506,19 +835,21 @@ extern "C" {
 void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
 {
     csound = csound_;
-    firstMessage = (CsoundPerformanceThreadMessage*) 0;
-    lastMessage = (CsoundPerformanceThreadMessage*) 0;
+    messageQueue = (CsPerfThreadMessageQueue*) 0;
     queueLock = (void*) 0;
     pauseLock = (void*) 0;
     flushLock = (void*) 0;
     recordLock = (void *) 0;
+    recorder = (CsPerfThreadRecorder*) 0;
+    recording = false;
     perfThread = (void*) 0;
     paused = 1;
     status = CSOUND_MEMORY;
     cdata = 0;
     processcallback = 0;
     running = 0;
-    queueLock = csoundCreateMutex(0);
+    // recursive, as messages may be destroyed while it is held
+    queueLock = csoundCreateMutex(1);
     if (!queueLock)
       return;
     pauseLock = csoundCreateThreadLock();
@@ -531,20 +862,38 @@ void CsoundPerformanceThread::csPerfThread_constructor(CSOUND *csound_)
     if (!recordLock)
       return;
     try {
-      lastMessage = new CsPerfThreadMsg_Pause(this);
+      messageQueue = new CsPerfThreadMessageQueue();
     }
     catch (std::bad_alloc&) {
       return;
     }
-    firstMessage = lastMessage;
-    recordData.cbuf = NULL;
-    recordData.sfile = NULL;
-    recordData.thread = NULL;
-    recordData.running = false;
-
-        recordData.mutex = csoundCreateMutex (0);
-        recordData.condvar = csoundCreateCondVar();
-
+    messageQueue->lock = queueLock;
+    messageQueue->outstanding = 0;
+    messageQueue->sent = 0UL;
+    messageQueue->received = 0UL;
+    messageQueue->slots = (char*) malloc(CSPT_QUEUE_SIZE * CSPT_SLOT_STRIDE);
+    if (!messageQueue->slots)
+      return;
+    for (int i = 0; i < CSPT_QUEUE_SIZE; i++)
+      messageQueue->freeSlots[i] = CSPT_QUEUE_SIZE - 1 - i;
+    messageQueue->nFree = CSPT_QUEUE_SIZE;
+    for (int i = 0; i < CSPT_LATENCY_BUCKETS; i++)
+      messageQueue->latency[i] = 0U;
+    messageQueue->recordOverruns = 0UL;
+    // start paused
+    {
+      CsoundPerformanceThreadMessage *msg;
+      try {
+        msg = new (this) CsPerfThreadMsg_Pause(this);
+      }
+      catch (std::bad_alloc&) {
+        return;
+      }
+      msg->queuedAt = csPerfThreadTime();
+      messageQueue->outstanding++;
+      messageQueue->sent++;
+      messageQueue->pending.Push(msg);
+    }
     perfThread = csoundCreateThread(csoundPerformanceThread_, (void*) this);
     if (perfThread) {
       status = 0;
@@ -597,6 +946,10 @@ CsoundPerformanceThread::~CsoundPerformanceThread()
         csoundDestroyMutex(recordLock);
 
     }
+    if (messageQueue) {
+        free(messageQueue->slots);
+        delete messageQueue;
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -608,67 +961,91 @@ void CsoundPerformanceThread::QueueMessage(CsoundPerformanceThreadMessage *msg)
       return;
     }
     csoundLockMutex(queueLock);
-    // link message into FIFO
-    if (!lastMessage)
-      firstMessage = msg;
-    else
-      lastMessage->nxt = msg;
-    lastMessage = msg;
-    // mark queue as non-empty
-    csoundWaitThreadLock(flushLock, (size_t) 0);
+    ReclaimMessages();
+    // if the queue is full, wait for the performance thread to catch up
+    while (messageQueue->outstanding >= CSPT_QUEUE_SIZE) {
+      if (status) {
+        csoundUnlockMutex(queueLock);
+        delete msg;
+        return;
+      }
+      csoundSleep(1);
+      ReclaimMessages();
+    }
+    msg->queuedAt = csPerfThreadTime();
+    messageQueue->outstanding++;
+    messageQueue->sent++;
+    messageQueue->pending.Push(msg);
+    csoundUnlockMutex(queueLock);
     // wake up from pause
     csoundNotifyThreadLock(pauseLock);
-    csoundUnlockMutex(queueLock);
 }
 
 void CsoundPerformanceThread::Play()
 {
-    QueueMessage(new CsPerfThreadMsg_Play(this));
+    QueueMessage(new (this) CsPerfThreadMsg_Play(this));
 }
 
 void CsoundPerformanceThread::Pause()
 {
-    QueueMessage(new CsPerfThreadMsg_Pause(this));
+    QueueMessage(new (this) CsPerfThreadMsg_Pause(this));
 }
 
 void CsoundPerformanceThread::TogglePause()
 {
-    QueueMessage(new CsPerfThreadMsg_TogglePause(this));
+    QueueMessage(new (this) CsPerfThreadMsg_TogglePause(this));
 }
 
 void CsoundPerformanceThread::Stop()
 {
-    QueueMessage(new CsPerfThreadMsg_Stop(this));
+    QueueMessage(new (this) CsPerfThreadMsg_Stop(this));
 }
 
 void CsoundPerformanceThread::Record(std::string filename,
                                      int samplebits,
                                      int numbufs)
 {
-    QueueMessage(new CsPerfThreadMsg_Record(this, filename,
-                                            samplebits, numbufs));
+    QueueMessage(new (this) CsPerfThreadMsg_Record(this, filename,
+                                                   samplebits, numbufs));
+}
+
+void CsoundPerformanceThread::RecordStems(std::string filename, int channels,
+                                          int samplebits, int numbufs)
+{
+    QueueMessage(new (this) CsPerfThreadMsg_Record(this, filename,
+                                                   samplebits, numbufs,
+                                                   channels < 1 ? 1 : channels));
 }
 
 void CsoundPerformanceThread::StopRecord()
 {
-    QueueMessage(new CsPerfThreadMsg_StopRecord(this));
+    QueueMessage(new (this) CsPerfThreadMsg_StopRecord(this));
+}
+
+unsigned long CsoundPerformanceThread::GetRecordOverruns()
+{
+    if (!messageQueue)
+      return 0UL;
+    return messageQueue->recordOverruns.load(std::memory_order_relaxed);
 }
 
 void CsoundPerformanceThread::ScoreEvent(int absp2mode, char opcod,
                                          int pcnt, const MYFLT *p)
 {
-    QueueMessage(new CsPerfThreadMsg_ScoreEvent(this,
-                                                absp2mode, opcod, pcnt, p));
+    QueueMessage(new (this) CsPerfThreadMsg_ScoreEvent(this,
+                                                       absp2mode, opcod,
+                                                       pcnt, p));
 }
 
 void CsoundPerformanceThread::InputMessage(const char *s)
 {
-    QueueMessage(new CsPerfThreadMsg_InputMessage(this, s));
+    QueueMessage(new (this) CsPerfThreadMsg_InputMessage(this, s));
 }
 
 void CsoundPerformanceThread::SetScoreOffsetSeconds(double timeVal)
 {
-    QueueMessage(new CsPerfThreadMsg_SetScoreOffsetSeconds(this, timeVal));
+    QueueMessage(new (this) CsPerfThreadMsg_SetScoreOffsetSeconds(this,
+                                                                  timeVal));
 }
 
 int CsoundPerformanceThread::Join()
@@ -676,33 +1053,35 @@ int CsoundPerformanceThread::Join()
     int retval;
     retval = status;
 
-    if (recordData.running) {
-        recordData.running = false;
-        csoundCondSignal(recordData.condvar);
-        csoundJoinThread(recordData.thread);
-    }
     if (perfThread) {
       retval = csoundJoinThread(perfThread);
       perfThread = (void*) 0;
     }
+    // close a recording that was still running when performance ended
+    if (recorder) {
+      csPerfThreadRecordFlush(recorder);
+      csPerfThreadRecordClose(recorder);
+      recorder = (CsPerfThreadRecorder*) 0;
+    }
+    if (recordLock) {
+      csoundLockMutex(recordLock);
+      recording = false;
+      csoundUnlockMutex(recordLock);
+    }
 
-    // delete any pending messages
-    {
+    // delete any pending messages; queueLock is kept for the message slots
+    // and destroyed with the object
+    if (messageQueue) {
       CsoundPerformanceThreadMessage *msg;
-      msg = (CsoundPerformanceThreadMessage*) firstMessage;
-      firstMessage = (CsoundPerformanceThreadMessage*) 0;
-      lastMessage = (CsoundPerformanceThreadMessage*) 0;
-      while (msg) {
-        CsoundPerformanceThreadMessage *nxt = msg->nxt;
+      csoundLockMutex(queueLock);
+      ReclaimMessages();
+      while ((msg = messageQueue->pending.Pop()) != 0) {
+        messageQueue->outstanding--;
         delete msg;
-        msg = nxt;
       }
+      csoundUnlockMutex(queueLock);
     }
-    // delete all thread locks
-    if (queueLock) {
-      csoundDestroyMutex(queueLock);
-      queueLock = (void*) 0;
-    }
+    // delete the thread locks
     if (pauseLock) {
       csoundNotifyThreadLock(pauseLock);
       csoundDestroyThreadLock(pauseLock);
@@ -725,10 +1104,42 @@ int CsoundPerformanceThread::Join()
 
 void CsoundPerformanceThread::FlushMessageQueue()
 {
-    if (firstMessage) {
-      csoundWaitThreadLockNoTimeout(flushLock);
-      csoundNotifyThreadLock(flushLock);
+    unsigned long sent;
+    if (!messageQueue)
+      return;
+    csoundLockMutex(queueLock);
+    sent = messageQueue->sent;
+    csoundUnlockMutex(queueLock);
+    while (!status &&
+           (long) (sent - messageQueue->received.load(std::memory_order_acquire))
+           > 0L)
+      csoundWaitThreadLock(flushLock, (size_t) 10);
+    csoundLockMutex(queueLock);
+    ReclaimMessages();
+    csoundUnlockMutex(queueLock);
+}
+
+long CsoundPerformanceThread::GetMessageLatency(unsigned int *counts, int n)
+{
+    long total = 0L;
+    if (!messageQueue || n <= 0)
+      return 0L;
+    for (int i = 0; i < n; i++)
+      counts[i] = 0U;
+    for (int i = 0; i < CSPT_LATENCY_BUCKETS; i++) {
+      unsigned int c = messageQueue->latency[i].load(std::memory_order_relaxed);
+      counts[i < n ? i : n - 1] += c;
+      total += (long) c;
     }
+    return total;
+}
+
+void CsoundPerformanceThread::ResetMessageLatency()
+{
+    if (!messageQueue)
+      return;
+    for (int i = 0; i < CSPT_LATENCY_BUCKETS; i++)
+      messageQueue->latency[i].store(0U, std::memory_order_relaxed);
 }
 
 
@@ -822,6 +1233,20 @@ PUBLIK void CsoundPTrecord(Cpt pt, const char *filename, int samplebits, int num
   cpt->Record(fname, samplebits, numbufs);
 }
 
+PUBLIK void CsoundPTrecordStems(Cpt pt, const char *filename, int channels,
+                                int samplebits, int numbufs)
+{
+  CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
+  std::string fname(filename);
+  cpt->RecordStems(fname, channels, samplebits, numbufs);
+}
+
+PUBLIK unsigned long CsoundPTgetRecordOverruns(Cpt pt)
+{
+  CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
+  return cpt->GetRecordOverruns();
+}
+
 PUBLIK void CsoundPTstopRecord(Cpt pt)
 {
   CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
@@ -858,5 +1283,17 @@ PUBLIK void CsoundPTflushMessageQueue(Cpt pt)
   cpt->FlushMessageQueue();
 }
 
+PUBLIK long CsoundPTgetMessageLatency(Cpt pt, unsigned int *counts, int n)
+{
+  CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
+  return cpt->GetMessageLatency(counts, n);
+}
+
+PUBLIK void CsoundPTresetMessageLatency(Cpt pt)
+{
+  CsoundPerformanceThread *cpt = (CsoundPerformanceThread *)pt;
+  cpt->ResetMessageLatency();
+}
+
 } // extern "C"
 
@@ -26,6 +26,8 @@
 
 class CsoundPerformanceThreadMessage;
 class CsPerfThread_PerformScore;
+struct CsPerfThreadMessageQueue;
+struct CsPerfThreadRecorder;
 
 #ifdef SWIG
 %include <std_string.i>
@@ -107,21 +109,11 @@ struct PUBLIC pycallbackdata {
 };
 #endif
 
-typedef struct {
-    void *cbuf;
-    void *sfile;
-    void *thread;
-    bool running;
-    void* condvar;
-    void* mutex;
-} recordData_t;
-
 class PUBLIC CsoundPerformanceThread {
  private:
     CSOUND  *csound;
-    volatile CsoundPerformanceThreadMessage *firstMessage;
-    CsoundPerformanceThreadMessage *lastMessage;
-    void    *queueLock;         // this is actually a mutex
+    CsPerfThreadMessageQueue *messageQueue;
+    void    *queueLock;         // only taken by threads sending messages
     void    *pauseLock;
     void    *flushLock;
     void    *recordLock;
@@ -129,10 +121,13 @@ class PUBLIC CsoundPerformanceThread {
     int     paused;
     int     status;
     void    *cdata;
-    recordData_t recordData;
+    CsPerfThreadRecorder *recorder;     // used by the performance thread
+    bool    recording;          // a recording is started, under recordLock
     int  running;
     void (*processcallback)(void *cdata);
     int  Perform();
+    int  RunMessages();
+    void ReclaimMessages();
     void csPerfThread_constructor(CSOUND *);
     void QueueMessage(CsoundPerformanceThreadMessage *);
  public:
@@ -196,9 +191,24 @@ class PUBLIC CsoundPerformanceThread {
      */
     void Record(std::string filename, int samplebits = 16, int numbufs = 4);
     /**
-     * Stops recording and closes audio file.
+     * Starts recording the output from Csound to one file for each group
+     * of 'channels' output channels, numbered from 1 before the extension:
+     * with four channels in pairs, out_1.wav holds channels 1 and 2 and
+     * out_2.wav channels 3 and 4.
+     */
+    void RecordStems(std::string filename, int channels,
+                     int samplebits = 16, int numbufs = 4);
+    /**
+     * Stops recording. The audio files are closed, without blocking the
+     * performance thread, by the next call that sends a message, or by
+     * FlushMessageQueue() or Join().
      */
     void StopRecord();
+    /**
+     * Returns the number of k-periods left out of recordings because
+     * 'numbufs' buffers were already waiting to be written to disk.
+     */
+    unsigned long GetRecordOverruns();
     /**
      * Sends a score event of type 'opcod' (e.g. 'i' for a note event), with
      * 'pcnt' p-fields in array 'p' (p[0] is p1). If absp2mode is non-zero,
@@ -226,6 +236,18 @@ class PUBLIC CsoundPerformanceThread {
      * are actually received by the performance thread.
      */
     void FlushMessageQueue();
+    /**
+     * Copies a histogram of the time from sending a message (pause, score
+     * event, etc.) to the performance thread running it to 'counts', which
+     * has room for 'n' buckets. Bucket 0 counts the messages run within
+     * 1 microsecond, bucket i those run within 2^i microseconds, and the
+     * last bucket all later ones. Returns the number of messages counted.
+     */
+    long GetMessageLatency(unsigned int *counts, int n);
+    /**
+     * Clears the message latency histogram.
+     */
+    void ResetMessageLatency();
     // --------
     CsoundPerformanceThread(Csound *);
     CsoundPerformanceThread(CSOUND *);
@@ -0,0 +1,479 @@
+/*
+    csRuntime.cpp:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "csound.hpp"
+#include "csPerfThread.hpp"     // for _MM_SET_DENORMALS_ZERO_MODE
+#include "csRuntime.hpp"
+
+// k-periods performed for an engine before its worker chooses again
+#define CSRT_BATCH      4
+// longest sleep of an idle worker, in nanoseconds
+#define CSRT_MAX_SLEEP  100000000LL
+
+static inline int64_t csRuntimeTime()
+{
+    return (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ----------------------------------------------------------------------------
+
+struct CsRuntimeEngine {
+    CSOUND  *csound;
+    std::atomic<int> priority;
+    std::atomic<bool> stop;
+    bool    paced;
+    int64_t period;             // nanoseconds per k-period
+    int64_t deadline;           // nanoseconds from release to deadline
+    int64_t start;              // release of the first k-period
+    // only used by the worker performing the engine
+    unsigned long next;         // k-periods performed so far
+    int     worker;             // worker that performed the last k-period
+    // under the runtime lock
+    bool    finished;
+    int     status;
+    int     waiters;            // callers waiting for it to finish
+    // under statsLock
+    std::mutex statsLock;
+    CsoundRuntimeStats stats;
+    double  totalResponse;
+    // release of the next k-period, zero if it is always due
+    int64_t Release()
+    {
+      return (paced ? start + (int64_t) next * period : (int64_t) 0);
+    }
+};
+
+struct CsRuntimeWorker {
+    std::mutex lock;
+    std::vector<CsRuntimeEngine*> queue;    // engines not being performed
+    CsRuntimeShared *shared;
+    void    *thread;
+    int     index;
+};
+
+struct CsRuntimeShared {
+    std::vector<CsRuntimeWorker*> workers;
+    std::vector<CsRuntimeEngine*> engines;  // by identifier, NULL if removed
+    std::mutex lock;                // engines, finished, generation and quit
+    std::condition_variable wakeup;         // idle workers wait on this
+    std::condition_variable done;           // an engine has finished
+    unsigned long generation;       // changed whenever idle workers are woken
+    bool    quit;
+    int     nthreads;               // worker threads actually started
+    unsigned int nextWorker;        // for assigning new engines
+    void Wake()
+    {
+      {
+        std::lock_guard<std::mutex> g(lock);
+        generation++;
+      }
+      wakeup.notify_all();
+    }
+    // called with lock held
+    CsRuntimeEngine *Find(int id)
+    {
+      if (id < 0 || id >= (int) engines.size())
+        return (CsRuntimeEngine*) 0;
+      return engines[id];
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+/**
+ * Returns the index in 'q' of the due engine to perform first, or -1 if none
+ * is due, in which case 'wake' is lowered to the earliest release.
+ * Called with the lock of the queue held.
+ */
+
+static int csRuntimeSelect(std::vector<CsRuntimeEngine*> &q,
+                           int64_t now, int64_t &wake)
+{
+    int     best = -1, bestPriority = 0;
+    int64_t bestDeadline = 0;
+    for (size_t i = 0; i < q.size(); i++) {
+      CsRuntimeEngine *e = q[i];
+      int64_t release = (e->stop.load(std::memory_order_relaxed) ?
+                         (int64_t) 0 : e->Release());
+      if (release > now) {
+        if (release < wake)
+          wake = release;
+        continue;
+      }
+      int     p = e->priority.load(std::memory_order_relaxed);
+      // free running engines come after the paced ones of equal priority
+      int64_t d = (e->paced ? release + e->deadline : INT64_MAX);
+      if (best < 0 || p > bestPriority ||
+          (p == bestPriority && d < bestDeadline)) {
+        best = (int) i;
+        bestPriority = p;
+        bestDeadline = d;
+      }
+    }
+    return best;
+}
+
+/**
+ * Performs up to CSRT_BATCH due k-periods of the engine, and returns
+ * non-zero once it has finished.
+ */
+
+static int csRuntimePerform(CsRuntimeEngine *e, int worker)
+{
+    unsigned long kcycles = 0UL, missed = 0UL;
+    int64_t response = 0, maxResponse = 0, cpuTime = 0;
+    int     retval = 0;
+
+    for (int i = 0; i < CSRT_BATCH; i++) {
+      if (e->stop.load(std::memory_order_relaxed)) {
+        retval = 1;
+        break;
+      }
+      int64_t t0 = csRuntimeTime();
+      int64_t release = (e->paced ? e->Release() : t0);
+      if (release > t0)
+        break;
+      retval = csoundPerformKsmps(e->csound);
+      int64_t t1 = csRuntimeTime();
+      e->next++;
+      kcycles++;
+      cpuTime += t1 - t0;
+      response += t1 - release;
+      if (t1 - release > maxResponse)
+        maxResponse = t1 - release;
+      if (t1 - release > e->deadline)
+        missed++;
+      if (retval)
+        break;
+    }
+    {
+      std::lock_guard<std::mutex> g(e->statsLock);
+      CsoundRuntimeStats *s = &e->stats;
+      if (e->worker != worker && e->worker >= 0)
+        s->migrations++;
+      s->kcycles += kcycles;
+      s->missed += missed;
+      s->cpuTime += (double) cpuTime * 1.0e-9;
+      e->totalResponse += (double) response * 1.0e-9;
+      if ((double) maxResponse * 1.0e-9 > s->maxResponse)
+        s->maxResponse = (double) maxResponse * 1.0e-9;
+      if (s->kcycles)
+        s->meanResponse = e->totalResponse / (double) s->kcycles;
+    }
+    e->worker = worker;
+    return retval;
+}
+
+/**
+ * Takes the engine to perform from the worker's own queue, or else from the
+ * queue of another worker. Returns NULL if no engine is due, with 'wake' set
+ * to the earliest release.
+ */
+
+static CsRuntimeEngine *csRuntimeTake(CsRuntimeWorker *w,
+                                      int64_t now, int64_t &wake)
+{
+    CsRuntimeShared *s = w->shared;
+    int     n = (int) s->workers.size();
+    for (int i = 0; i < n; i++) {
+      CsRuntimeWorker *v = s->workers[(w->index + i) % n];
+      std::lock_guard<std::mutex> g(v->lock);
+      int j = csRuntimeSelect(v->queue, now, wake);
+      if (j >= 0) {
+        CsRuntimeEngine *e = v->queue[j];
+        v->queue[j] = v->queue.back();
+        v->queue.pop_back();
+        return e;
+      }
+    }
+    return (CsRuntimeEngine*) 0;
+}
+
+static void csRuntimeWork(CsRuntimeWorker *w)
+{
+    CsRuntimeShared *s = w->shared;
+    for (;;) {
+      unsigned long generation;
+      {
+        std::lock_guard<std::mutex> g(s->lock);
+        if (s->quit)
+          return;
+        generation = s->generation;
+      }
+      int64_t now = csRuntimeTime();
+      int64_t wake = now + CSRT_MAX_SLEEP;
+      CsRuntimeEngine *e = csRuntimeTake(w, now, wake);
+      if (!e) {
+        std::chrono::steady_clock::time_point t(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(wake)));
+        std::unique_lock<std::mutex> g(s->lock);
+        s->wakeup.wait_until(g, t, [s, generation] {
+          return s->quit || s->generation != generation;
+        });
+        continue;
+      }
+      int retval = csRuntimePerform(e, w->index);
+      if (!retval) {
+        // stays with the worker that performed it last
+        std::lock_guard<std::mutex> g(w->lock);
+        w->queue.push_back(e);
+        continue;
+      }
+      csoundCleanup(e->csound);
+      {
+        std::lock_guard<std::mutex> g(s->lock);
+        e->status = retval;
+        e->finished = true;
+      }
+      s->done.notify_all();
+    }
+}
+
+extern "C" {
+  static uintptr_t csoundRuntimeThread_(void *userData)
+  {
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+    csRuntimeWork((CsRuntimeWorker*) userData);
+    return (uintptr_t) 0;
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+CsoundRuntime::CsoundRuntime(int nthreads)
+{
+    shared = new CsRuntimeShared();
+    shared->generation = 0UL;
+    shared->quit = false;
+    shared->nthreads = 0;
+    shared->nextWorker = 0U;
+    if (nthreads < 1)
+      nthreads = (int) std::thread::hardware_concurrency();
+    if (nthreads < 1)
+      nthreads = 1;
+    // all queues exist before any worker looks for engines to take
+    for (int i = 0; i < nthreads; i++) {
+      CsRuntimeWorker *w = new CsRuntimeWorker();
+      w->shared = shared;
+      w->thread = (void*) 0;
+      w->index = i;
+      shared->workers.push_back(w);
+    }
+    for (int i = 0; i < nthreads; i++) {
+      CsRuntimeWorker *w = shared->workers[i];
+      w->thread = csoundCreateThread(csoundRuntimeThread_, (void*) w);
+      if (!w->thread)
+        break;
+      shared->nthreads++;
+    }
+}
+
+CsoundRuntime::~CsoundRuntime()
+{
+    CsRuntimeShared *s = shared;
+    {
+      std::unique_lock<std::mutex> g(s->lock);
+      for (size_t i = 0; i < s->engines.size(); i++)
+        if (s->engines[i])
+          s->engines[i]->stop = true;
+      s->generation++;
+      s->wakeup.notify_all();
+      // engines are looked up again after each wait, as a concurrent
+      // RemoveEngine() may delete them
+      if (s->nthreads > 0) {
+        for (size_t i = 0; i < s->engines.size(); i++)
+          s->done.wait(g, [s, i] {
+            return !s->engines[i] || s->engines[i]->finished;
+          });
+      }
+      for (size_t i = 0; i < s->engines.size(); i++)
+        s->done.wait(g, [s, i] {
+          return !s->engines[i] || s->engines[i]->waiters == 0;
+        });
+      s->quit = true;
+    }
+    s->wakeup.notify_all();
+    for (size_t i = 0; i < s->workers.size(); i++) {
+      if (s->workers[i]->thread)
+        csoundJoinThread(s->workers[i]->thread);
+      delete s->workers[i];
+    }
+    for (size_t i = 0; i < s->engines.size(); i++)
+      delete s->engines[i];
+    delete s;
+}
+
+int CsoundRuntime::AddEngine(CSOUND *csound, int priority, double deadline,
+                             bool paced)
+{
+    CsRuntimeShared *s = shared;
+    CsRuntimeEngine *e;
+    int     id;
+
+    if (!csound || s->nthreads < 1)
+      return CSOUND_ERROR;
+    try {
+      e = new CsRuntimeEngine();
+    }
+    catch (std::bad_alloc&) {
+      return CSOUND_MEMORY;
+    }
+    double period = (double) csoundGetKsmps(csound)
+                    / (double) csoundGetSr(csound);
+    if (deadline <= 0.0)
+      deadline = period;
+    e->csound = csound;
+    e->priority = priority;
+    e->stop = false;
+    e->paced = paced;
+    e->period = (int64_t) (period * 1.0e9 + 0.5);
+    e->deadline = (int64_t) (deadline * 1.0e9 + 0.5);
+    e->next = 0UL;
+    e->worker = -1;
+    e->finished = false;
+    e->status = 0;
+    e->waiters = 0;
+    e->stats = CsoundRuntimeStats();
+    e->totalResponse = 0.0;
+    e->start = csRuntimeTime();
+    CsRuntimeWorker *w;
+    {
+      std::lock_guard<std::mutex> g(s->lock);
+      id = (int) s->engines.size();
+      s->engines.push_back(e);
+      w = s->workers[s->nextWorker++ % (unsigned int) s->workers.size()];
+    }
+    {
+      std::lock_guard<std::mutex> g(w->lock);
+      w->queue.push_back(e);
+    }
+    s->Wake();
+    return id;
+}
+
+int CsoundRuntime::RemoveEngine(int id)
+{
+    CsRuntimeShared *s = shared;
+    CsRuntimeEngine *e;
+    int     retval;
+    {
+      std::lock_guard<std::mutex> g(s->lock);
+      if (!(e = s->Find(id)))
+        return CSOUND_ERROR;
+      e->stop = true;
+      e->waiters++;
+    }
+    s->Wake();
+    {
+      std::unique_lock<std::mutex> g(s->lock);
+      s->done.wait(g, [e] { return e->finished; });
+      retval = e->status;
+      e->waiters--;
+      if (s->engines[id] != e) {
+        // removed by a concurrent call, which deletes it once no one waits
+        g.unlock();
+        s->done.notify_all();
+        return retval;
+      }
+      s->engines[id] = (CsRuntimeEngine*) 0;
+      s->done.wait(g, [e] { return e->waiters == 0; });
+    }
+    s->done.notify_all();
+    delete e;
+    return retval;
+}
+
+int CsoundRuntime::WaitEngine(int id)
+{
+    CsRuntimeShared *s = shared;
+    int     retval;
+    {
+      std::unique_lock<std::mutex> g(s->lock);
+      CsRuntimeEngine *e = s->Find(id);
+      if (!e)
+        return CSOUND_ERROR;
+      // the engine is not deleted while it has waiters
+      e->waiters++;
+      s->done.wait(g, [e] { return e->finished; });
+      retval = e->status;
+      e->waiters--;
+    }
+    s->done.notify_all();
+    return retval;
+}
+
+int CsoundRuntime::GetStatus(int id)
+{
+    std::lock_guard<std::mutex> g(shared->lock);
+    CsRuntimeEngine *e = shared->Find(id);
+    if (!e)
+      return CSOUND_ERROR;
+    return e->status;
+}
+
+void CsoundRuntime::SetPriority(int id, int priority)
+{
+    std::lock_guard<std::mutex> g(shared->lock);
+    CsRuntimeEngine *e = shared->Find(id);
+    if (e)
+      e->priority.store(priority, std::memory_order_relaxed);
+}
+
+int CsoundRuntime::GetStats(int id, CsoundRuntimeStats *stats)
+{
+    std::lock_guard<std::mutex> g(shared->lock);
+    CsRuntimeEngine *e = shared->Find(id);
+    if (!e || !stats)
+      return CSOUND_ERROR;
+    {
+      std::lock_guard<std::mutex> g2(e->statsLock);
+      *stats = e->stats;
+    }
+    stats->status = e->status;
+    return CSOUND_SUCCESS;
+}
+
+void CsoundRuntime::ResetStats(int id)
+{
+    std::lock_guard<std::mutex> g(shared->lock);
+    CsRuntimeEngine *e = shared->Find(id);
+    if (e) {
+      std::lock_guard<std::mutex> g2(e->statsLock);
+      e->stats = CsoundRuntimeStats();
+      e->totalResponse = 0.0;
+    }
+}
+
+int CsoundRuntime::GetWorkerCount()
+{
+    return shared->nthreads;
+}
@@ -0,0 +1,111 @@
+/*
+    csRuntime.hpp:
+
+    This file is part of Csound.
+
+    The Csound Library is free software; you can redistribute it
+    and/or modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    Csound is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with Csound; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+    02110-1301 USA
+*/
+
+#ifndef CSOUND_CSRUNTIME_HPP
+#define CSOUND_CSRUNTIME_HPP
+
+struct CsRuntimeEngine;
+struct CsRuntimeWorker;
+struct CsRuntimeShared;
+
+/**
+ * Deadline statistics of an engine run by a CsoundRuntime.
+ */
+
+struct PUBLIC CsoundRuntimeStats {
+    unsigned long kcycles;      // k-periods performed
+    unsigned long missed;       // k-periods finished after their deadline
+    unsigned long migrations;   // times the engine was taken by another worker
+    double  meanResponse;       // mean seconds from release to completion
+    double  maxResponse;        // longest time from release to completion
+    double  cpuTime;            // seconds spent in csoundPerformKsmps()
+    int     status;             // as CsoundPerformanceThread::GetStatus()
+};
+
+/**
+ * CsoundRuntime(int nthreads)
+ *
+ * Performs any number of Csound instances on one pool of 'nthreads' worker
+ * threads (the number of processors if zero), instead of a thread for each
+ * instance. Each engine is added after a successful csoundStart(); its
+ * k-periods are released every ksmps/sr seconds of real time and must
+ * complete within 'deadline' seconds of their release (one k-period if
+ * zero). A worker performs the due engine of its own queue with the highest
+ * priority and then the earliest deadline, and takes due engines from the
+ * other workers when it has none. Init passes run within the k-periods.
+ * As in CsoundPerformanceThread, csoundCleanup() is called once an engine
+ * reaches the end of its score, fails, or is removed.
+ *
+ * The pool threads must never block, so engines should not use blocking
+ * real-time audio (render to files, -n, or the host buffers) nor their own
+ * -j threads. Engines added with 'paced' false are not paced by the clock
+ * and are performed as fast as the pool allows; their response time is the
+ * time taken by each k-period.
+ */
+
+class PUBLIC CsoundRuntime {
+ private:
+    CsRuntimeShared *shared;
+ public:
+    /**
+     * Adds an engine and returns its identifier, or a negative error code.
+     * Engines with higher priority values are performed first.
+     */
+    int AddEngine(CSOUND *csound, int priority = 0, double deadline = 0.0,
+                  bool paced = true);
+    /**
+     * Stops the engine, waits until it is no longer performed, and forgets
+     * it. Returns the final status of the engine (see GetStatus()).
+     */
+    int RemoveEngine(int id);
+    /**
+     * Waits until the engine reaches the end of its score, fails, or is
+     * stopped by RemoveEngine(), and returns its status.
+     */
+    int WaitEngine(int id);
+    /**
+     * Returns zero if the engine is still playing, positive if the end of
+     * score was reached or it was stopped, and negative if an error occured.
+     */
+    int GetStatus(int id);
+    /**
+     * Changes the priority of the engine.
+     */
+    void SetPriority(int id, int priority);
+    /**
+     * Copies the deadline statistics of the engine to 'stats'. Returns
+     * CSOUND_SUCCESS, or CSOUND_ERROR if there is no such engine.
+     */
+    int GetStats(int id, CsoundRuntimeStats *stats);
+    /**
+     * Clears the deadline statistics of the engine.
+     */
+    void ResetStats(int id);
+    /**
+     * Returns the number of worker threads.
+     */
+    int GetWorkerCount();
+    // --------
+    CsoundRuntime(int nthreads = 0);
+    ~CsoundRuntime();
+};
+
+#endif  // CSOUND_CSRUNTIME_HPP
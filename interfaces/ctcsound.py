@@ -81,7 +81,11 @@ class CsoundParams(Structure):
                 ("e0dbfs_override", MYFLT),   # overriding 0dbfs
                 ("daemon", c_int),            # daemon mode
                 ("ksmps_override", c_int),    # ksmps override
-                ("FFT_library", c_int)]       # fft_lib
+                ("FFT_library", c_int),       # fft_lib
+                ("voice_batch", c_int),       # instances run in lockstep, 0 = off, -1 = unchanged
+                ("write_buffers", c_int),     # sound file writer thread buffers, 0 = off, -1 = unchanged
+                ("gen01_threads", c_int),     # threads decoding deferred GEN01 files, 0 = off, -1 = unchanged
+                ("gen01_cache", c_int)]       # MB of decoded GEN01 files kept for reuse, 0 = off, -1 = unchanged
 
 string64 = c_char * 64
 
@@ -209,11 +213,20 @@ libcsound.csoundCompileCsdText.argtypes = [c_void_p, c_char_p]
 libcsound.csoundPerform.argtypes = [c_void_p]
 libcsound.csoundPerformKsmps.argtypes = [c_void_p]
 libcsound.csoundPerformBuffer.argtypes = [c_void_p]
+libcsound.csoundPerformFrames.argtypes = [c_void_p, POINTER(POINTER(MYFLT)),
+    POINTER(POINTER(MYFLT)), c_uint32]
+OVERLOADFUNC = CFUNCTYPE(None, c_void_p, py_object, c_double, c_int)
+libcsound.csoundSetOverloadPolicy.argtypes = [c_void_p, c_int, c_double]
+libcsound.csoundSetOverloadCallback.argtypes = [c_void_p, OVERLOADFUNC, py_object]
+libcsound.csoundSetInstrumentPriority.argtypes = [c_void_p, c_int, c_int]
+libcsound.csoundGetLoad.restype = c_double
+libcsound.csoundGetLoad.argtypes = [c_void_p]
 libcsound.csoundStop.argtypes = [c_void_p]
 libcsound.csoundCleanup.argtypes = [c_void_p]
 libcsound.csoundReset.argtypes = [c_void_p]
 
 libcsound.csoundUDPServerStart.argtypes = [c_void_p, c_uint]
+libcsound.csoundUDPServerAddPort.argtypes = [c_void_p, c_uint]
 libcsound.csoundUDPServerStatus.argtypes = [c_void_p]
 libcsound.csoundUDPServerClose.argtypes = [c_void_p]
 libcsound.csoundUDPConsole.argtypes = [c_void_p, c_char_p, c_uint, c_uint]
@@ -317,6 +330,9 @@ MIDIERRORFUNC = CFUNCTYPE(c_char_p, c_int)
 libcsound.csoundSetExternalMidiErrorStringCallback.argtypes = [c_void_p, MIDIERRORFUNC]
 MIDIDEVLISTFUNC = CFUNCTYPE(c_int, c_void_p, POINTER(CsoundMidiDevice), c_int)
 libcsound.csoundSetMIDIDeviceListCallback.argtypes = [c_void_p, MIDIDEVLISTFUNC]
+libcsound.csoundPushMidiMessage.argtypes = [c_void_p, c_char_p, c_int, c_double]
+libcsound.csoundGetMidiTime.restype = c_double
+libcsound.csoundGetMidiTime.argtypes = [c_void_p]
 
 libcsound.csoundReadScore.argtypes = [c_void_p, c_char_p]
 libcsound.csoundReadScoreAsync.argtypes = [c_void_p, c_char_p]
@@ -551,6 +567,10 @@ CSOUND_SIGNAL = -5               # Termination requested by SIGINT or SIGTERM.
 CSOUNDINIT_NO_SIGNAL_HANDLER = 1
 CSOUNDINIT_NO_ATEXIT = 2
 
+# Degradation policies for setOverloadPolicy()
+CSOUND_OVERLOAD_STEAL = 1
+CSOUND_OVERLOAD_SKIP = 2
+
 # Types for keyboard callbacks set in registerKeyboardCallback()
 CSOUND_CALLBACK_KBD_EVENT = 1
 CSOUND_CALLBACK_KBD_TEXT = 2
@@ -892,6 +912,71 @@ class Csound:
         """
         return libcsound.csoundPerformBuffer(self.cs)
     
+    def performFrames(self, inputs, outputs, nframes):
+        """Performs Csound for *nframes* sample frames of non-interleaved audio.
+        
+        *outputs* is a sequence of :py:meth:`nchnls()` ndarrays of MYFLTs,
+        written directly by Csound, and *inputs* a sequence of
+        :py:meth:`nchnlsInput()` ndarrays read as input; each array should
+        hold at least *nframes* MYFLTs. Either sequence may be :code:`None`,
+        and so may any array in it. *nframes* need not be a multiple of
+        :py:meth:`ksmps()`.
+        
+        Returns :code:`False` during performance, and :code:`True` when
+        performance is finished.
+        """
+        def ptrs(arrays):
+            if arrays is None:
+                return None
+            p = (POINTER(MYFLT) * len(arrays))()
+            for i, a in enumerate(arrays):
+                if a is not None:
+                    p[i] = a.ctypes.data_as(POINTER(MYFLT))
+            return p
+        return libcsound.csoundPerformFrames(self.cs, ptrs(inputs),
+            ptrs(outputs), nframes)
+    
+    def setOverloadPolicy(self, policy, threshold):
+        """Degrades the performance when a k-cycle takes too long.
+        
+        The time taken by each k-cycle is measured as a fraction of its real
+        time budget of 1/kr seconds. Above *threshold* (e.g. 0.8), the engine
+        is overloaded and degrades as set by *policy*, the sum of any of
+        :code:`CSOUND_OVERLOAD_STEAL` (release a voice of the non-essential
+        instrument with the lowest priority on each overloaded k-cycle) and
+        :code:`CSOUND_OVERLOAD_SKIP` (do not perform non-essential
+        instruments until the engine has recovered). A *threshold* of zero
+        turns off the measurement.
+        """
+        libcsound.csoundSetOverloadPolicy(self.cs, policy, threshold)
+    
+    def setOverloadCallback(self, function, userData):
+        """Sets a function called after each overloaded k-cycle.
+        
+        The function takes four arguments: the Csound instance pointer, the
+        *userData* as passed to this function, the load of the k-cycle as a
+        fraction of its budget, and 1 if overloaded, or 0 when the engine
+        has recovered.
+        """
+        self.overloadCbRef = OVERLOADFUNC(function)
+        libcsound.csoundSetOverloadCallback(self.cs, self.overloadCbRef,
+            py_object(userData))
+    
+    def setInstrumentPriority(self, insno, priority):
+        """Sets the priority of an instrument for :py:meth:`setOverloadPolicy()`.
+        
+        Negative values mark the instrument as non-essential.
+        Returns :code:`CSOUND_ERROR` if the instrument does not exist.
+        """
+        return libcsound.csoundSetInstrumentPriority(self.cs, insno, priority)
+    
+    def load(self):
+        """Returns the load of the last k-cycle, if measured.
+        
+        The load is the time taken as a fraction of the real time budget.
+        """
+        return libcsound.csoundGetLoad(self.cs)
+    
     def stop(self):
         """Stops a :py:meth:`perform()` running in another thread.
         
@@ -928,6 +1013,14 @@ class Csound:
         """
         return libcsound.csoundUDPServerStart(self.cs, c_uint(port))
 
+    def UDPServerAddPort(self, port):
+        """Makes the running UDP server also listen on port.
+        
+        Returns CSOUND_SUCCESS if the port could be opened,
+        otherwise, CSOUND_ERROR.
+        """
+        return libcsound.csoundUDPServerAddPort(self.cs, c_uint(port))
+
     def UDPServerStatus(self):
         """Returns the port number on which the server is running.
         
@@ -1407,6 +1500,23 @@ class Csound:
         """ Sets a callback for converting MIDI error codes to strings."""
         self.extMidiErrStrCbRef = MIDIERRORFUNC(function)
         libcsound.csoundSetExternalMidiErrorStringCallback(self.cs, self.extMidiErrStrCbRef)
+
+    def pushMidiMessage(self, msg, time=-1.0):
+        """Queues a complete MIDI message received at time.
+        
+        msg holds 1 to 3 bytes, starting with the status byte. time is
+        in seconds on the clock returned by :py:meth:`midiTime()`; if
+        negative, the message is timestamped now. With sample-accurate
+        timing, a note on starts at that sample of its k-period. MIDI
+        input must be enabled. Returns CSOUND_ERROR if the message is
+        malformed or the queue is full.
+        """
+        msg = bytes(bytearray(msg))
+        return libcsound.csoundPushMidiMessage(self.cs, msg, len(msg), c_double(time))
+    
+    def midiTime(self):
+        """Returns the time in seconds used to timestamp MIDI messages."""
+        return libcsound.csoundGetMidiTime(self.cs)
     
     def setMidiDevListCallback(self, function):
         """Sets a callback for obtaining a list of MIDI devices.
@@ -2690,6 +2800,9 @@ libcspt.CsoundPTpause.argtypes = [c_void_p]
 libcspt.CsoundPTtogglePause.argtypes = [c_void_p]
 libcspt.CsoundPTstop.argtypes = [c_void_p]
 libcspt.CsoundPTrecord.argtypes = [c_void_p, c_char_p, c_int, c_int]
+libcspt.CsoundPTrecordStems.argtypes = [c_void_p, c_char_p, c_int, c_int, c_int]
+libcspt.CsoundPTgetRecordOverruns.restype = c_ulong
+libcspt.CsoundPTgetRecordOverruns.argtypes = [c_void_p]
 libcspt.CsoundPTstopRecord.argtypes = [c_void_p]
 libcspt.CsoundPTscoreEvent.argtypes = [c_void_p, c_int, c_char, c_int, POINTER(MYFLT)]
 libcspt.CsoundPTinputMessage.argtypes = [c_void_p, c_char_p]
@@ -2763,10 +2876,26 @@ class CsoundPerformanceThread:
         """
         libcspt.CsoundPTrecord(self.cpt, cstring(filename), samplebits, numbufs)
     
+    def recordStems(self, filename, channels, samplebits, numbufs):
+        """Starts recording the output from Csound to one file per group.
+        
+        Each file holds *channels* output channels, and is named from
+        *filename* with the group number, from 1, before the extension.
+        """
+        libcspt.CsoundPTrecordStems(self.cpt, cstring(filename), channels,
+                                    samplebits, numbufs)
+    
     def stopRecord(self):
         """Stops recording and closes audio file."""
         libcspt.CsoundPTstopRecord(self.cpt)
     
+    def recordOverruns(self):
+        """Returns the number of k-periods left out of recordings.
+        
+        Output is dropped when the file writer falls behind.
+        """
+        return libcspt.CsoundPTgetRecordOverruns(self.cpt)
+    
     def scoreEvent(self, absp2mode, opcod, pFields):
         """Sends a score event.
         
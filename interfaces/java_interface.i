@@ -37,6 +37,7 @@
     #include "csound.hpp"
     #include "cs_glue.hpp"
     #include "csPerfThread.hpp"
+    #include "csRuntime.hpp"
     #include "CsoundFile.hpp"
     #include "CppSound.hpp"
     #include "Soundfile.hpp"
@@ -78,6 +79,7 @@ typedef unsigned int uint32_t;
 
 %include "cs_glue.hpp"
 %include "csPerfThread.hpp"
+%include "csRuntime.hpp"
 %include "CsoundFile.hpp"
 %include "CppSound.hpp"
 %include "Soundfile.hpp"
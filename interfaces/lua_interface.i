@@ -30,6 +30,7 @@
         #include "csound.hpp"
         #include "cs_glue.hpp"
         #include "csPerfThread.hpp"
+        #include "csRuntime.hpp"
         #include "CsoundFile.hpp"
         #include "CppSound.hpp"
         #include "Soundfile.hpp"
@@ -45,6 +46,7 @@ typedef unsigned int uint32_t;
 %include "csound.hpp"
 %include "cs_glue.hpp"
 %include "csPerfThread.hpp"
+%include "csRuntime.hpp"
 %include "CsoundFile.hpp"
 %include "CppSound.hpp"
 %include "Soundfile.hpp"
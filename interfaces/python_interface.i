@@ -57,6 +57,7 @@
     #include "csound.hpp"
     #include "cs_glue.hpp"
     #include "csPerfThread.hpp"
+    #include "csRuntime.hpp"
     #include "CsoundFile.hpp"
     #include "CppSound.hpp"
     #include "filebuilding.h"
@@ -426,6 +427,7 @@ static void PythonCallback(void *p){
 
 %include "cs_glue.hpp"
 %include "csPerfThread.hpp"
+%include "csRuntime.hpp"
 
 %extend CsoundPerformanceThread {
    // Set the Python callback
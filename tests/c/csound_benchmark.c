@@ -0,0 +1,168 @@
+/*
+ * File:   csound_benchmark.c
+ *
+ * Benchmarks for low-level engine routines. They only print timings and
+ * are not run by ctest; the behaviour is checked by the unit tests.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include "csoundCore.h"
+#include "sampconv.h"
+#include "pthread.h"
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1.0e-9;
+}
+
+/* throughput of a writer and a reader thread on a circular buffer, */
+/* using copying bulk transfers or the zero-copy regions            */
+
+#define THROUGHPUT_ITEMS 4000000
+
+typedef struct {
+    CSOUND *csound;
+    void *rb;
+    int zerocopy;
+} throughput_args;
+
+static void *throughput_writer(void *data)
+{
+    throughput_args *args = (throughput_args *) data;
+    int i = 0, j, n, avail;
+    int invals[256];
+    while (i < THROUGHPUT_ITEMS) {
+      if (args->zerocopy) {
+        int *region = csoundAcquireCircularBufferWrite(args->csound, args->rb,
+                                                       THROUGHPUT_ITEMS - i,
+                                                       &avail);
+        for (j = 0; j < avail; j++)
+          region[j] = i + j;
+        csoundCommitCircularBufferWrite(args->csound, args->rb, avail);
+        n = avail;
+      }
+      else {
+        n = THROUGHPUT_ITEMS - i < 256 ? THROUGHPUT_ITEMS - i : 256;
+        for (j = 0; j < n; j++)
+          invals[j] = i + j;
+        n = csoundWriteCircularBuffer(args->csound, args->rb, invals, n);
+      }
+      if (n == 0)
+        csoundSleep(0);
+      i += n;
+    }
+    return NULL;
+}
+
+static int bench_circular_buffer(int zerocopy)
+{
+    int i = 0, j, n, avail, errors = 0;
+    int outvals[256];
+    pthread_t writer;
+    double t;
+    throughput_args args;
+    CSOUND *csound = csoundCreate(NULL);
+    args.csound = csound;
+    args.rb = csoundCreateCircularBuffer(csound, 8192, sizeof(int));
+    args.zerocopy = zerocopy;
+    if (args.rb == NULL) {
+      csoundDestroy(csound);
+      return 1;
+    }
+    t = now();
+    pthread_create(&writer, NULL, throughput_writer, &args);
+    while (i < THROUGHPUT_ITEMS) {
+      if (zerocopy) {
+        int *region = csoundAcquireCircularBufferRead(csound, args.rb,
+                                                      THROUGHPUT_ITEMS - i,
+                                                      &avail);
+        for (j = 0; j < avail; j++)
+          errors += (region[j] != i + j);
+        csoundCommitCircularBufferRead(csound, args.rb, avail);
+        n = avail;
+      }
+      else {
+        n = csoundReadCircularBuffer(csound, args.rb, outvals, 256);
+        for (j = 0; j < n; j++)
+          errors += (outvals[j] != i + j);
+      }
+      if (n == 0)
+        csoundSleep(0);
+      i += n;
+    }
+    pthread_join(writer, NULL);
+    t = now() - t;
+    printf("  circular buffer, %-10s %8.1f Mitems/s\n",
+           zerocopy ? "zero-copy" : "bulk copy", THROUGHPUT_ITEMS * 1e-6 / t);
+    csoundDestroyCircularBuffer(csound, args.rb);
+    csoundDestroy(csound);
+    return (errors != 0);
+}
+
+/* speed of every sample conversion, in millions of samples per */
+/* second, and the share of one core it takes at 64 channels and  */
+/* 192 kHz                                                        */
+
+#define NSMPS      4096
+#define BENCH_SMPS (64 * 192000)
+
+static void report(const char *name, double secs)
+{
+    printf("  %-24s %8.1f Msmps/s  %5.1f%% of a core\n", name,
+           BENCH_SMPS / secs * 1.0e-6, secs * 100.0);
+}
+
+static int bench_sample_conversion(void)
+{
+    static MYFLT   f[NSMPS];
+    static int16_t s[NSMPS];
+    static int32_t l[NSMPS];
+    static float   g[NSMPS];
+    uint32_t count = 0;
+    double t;
+    int i, k, n = BENCH_SMPS / NSMPS;
+    for (i = 0; i < NSMPS; i++)
+      f[i] = (MYFLT) sin(i * 0.01) * FL(0.9);
+
+    /* one input sample is changed between passes, so that the */
+    /* compiler cannot hoist the conversion out of the loop    */
+#define BENCH(name, in, stmt)                                   \
+    t = now();                                                  \
+    for (k = 0; k < n; k++) {                                   \
+      in[k & (NSMPS - 1)] = in[(k + 1) & (NSMPS - 1)];          \
+      stmt;                                                     \
+    }                                                           \
+    report(name, now() - t)
+
+    BENCH("MYFLT -> short", f,
+          sconv_to_short(f, s, NSMPS, SCONV_NO_DITHER, &count));
+    BENCH("MYFLT -> short, TPDF", f,
+          sconv_to_short(f, s, NSMPS, SCONV_TRIANGULAR, &count));
+    BENCH("MYFLT -> short, RPDF", f,
+          sconv_to_short(f, s, NSMPS, SCONV_RECTANGULAR, &count));
+    BENCH("MYFLT -> long", f, sconv_to_long(f, l, NSMPS));
+    BENCH("MYFLT -> float", f, sconv_to_float(f, g, NSMPS));
+    BENCH("short -> MYFLT", s, sconv_from_short(s, f, NSMPS));
+    BENCH("long -> MYFLT", l, sconv_from_long(l, f, NSMPS));
+    BENCH("float -> MYFLT", g, sconv_from_float(g, f, NSMPS));
+    BENCH("MYFLT + TPDF (file)", f,
+          sconv_dither_add(f, NSMPS, FL(1.0) / FL(32767.0),
+                           SCONV_TRIANGULAR, &count));
+#undef BENCH
+    return (count == 0);
+}
+
+int main()
+{
+    int errors = 0;
+    errors += bench_circular_buffer(0);
+    errors += bench_circular_buffer(1);
+    errors += bench_sample_conversion();
+    return (errors != 0);
+}
@@ -8,6 +8,7 @@
 #include "csound.h"
 #include "pthread.h"
 #include "CUnit/Basic.h"
+#include <stdio.h>
 
 
 int init_suite1(void)
@@ -133,6 +134,173 @@ void test_wrap(void) {
 }
 
 
+
+void test_bulk_wrap(void) {
+    int i, j, w = 0, r = 0;
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateCircularBuffer(csound, 10, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    int invals[16], outvals[16], peekvals[16];
+    for (i = 0 ; i < 200; i++) {
+        int n = (i * 7) % 12, m = (i * 5) % 11;
+        for (j = 0; j < n; j++) {
+            invals[j] = w + j;
+        }
+        int written = csoundWriteCircularBuffer(csound, rb, invals, n);
+        CU_ASSERT(written >= 0 && written <= n);
+        CU_ASSERT(w + written - r <= 9);
+        w += written;
+        int peeked = csoundPeekCircularBuffer(csound, rb, peekvals, m);
+        int read = csoundReadCircularBuffer(csound, rb, outvals, m);
+        CU_ASSERT_EQUAL(peeked, read);
+        CU_ASSERT_EQUAL(read, (w - r < m ? w - r : m));
+        for (j = 0; j < read; j++) {
+            CU_ASSERT_EQUAL(peekvals[j], r + j);
+            CU_ASSERT_EQUAL(outvals[j], r + j);
+        }
+        r += read;
+    }
+    csoundDestroyCircularBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+void test_acquire_commit(void) {
+    int i, avail;
+    CSOUND* csound = csoundCreate(NULL);
+    void *rb = csoundCreateCircularBuffer(csound, 16, sizeof(float));
+    CU_ASSERT_PTR_NOT_NULL(rb);
+    float *region;
+    /* empty buffer: nothing to read */
+    region = csoundAcquireCircularBufferRead(csound, rb, 4, &avail);
+    CU_ASSERT_PTR_NULL(region);
+    CU_ASSERT_EQUAL(avail, 0);
+    /* one slot is always kept free */
+    region = csoundAcquireCircularBufferWrite(csound, rb, 100, &avail);
+    CU_ASSERT_PTR_NOT_NULL(region);
+    CU_ASSERT_EQUAL(avail, 15);
+    for (i = 0; i < 12; i++) {
+        region[i] = i;
+    }
+    csoundCommitCircularBufferWrite(csound, rb, 12);
+    region = csoundAcquireCircularBufferRead(csound, rb, 100, &avail);
+    CU_ASSERT_EQUAL(avail, 12);
+    for (i = 0; i < avail; i++) {
+        CU_ASSERT_EQUAL(region[i], i);
+    }
+    csoundCommitCircularBufferRead(csound, rb, 10);
+    /* the free space now wraps: the first region stops at the end */
+    region = csoundAcquireCircularBufferWrite(csound, rb, 100, &avail);
+    CU_ASSERT_EQUAL(avail, 4);
+    for (i = 0; i < avail; i++) {
+        region[i] = 12 + i;
+    }
+    csoundCommitCircularBufferWrite(csound, rb, avail);
+    region = csoundAcquireCircularBufferWrite(csound, rb, 100, &avail);
+    CU_ASSERT_EQUAL(avail, 9);
+    for (i = 0; i < avail; i++) {
+        region[i] = 16 + i;
+    }
+    csoundCommitCircularBufferWrite(csound, rb, avail);
+    region = csoundAcquireCircularBufferWrite(csound, rb, 100, &avail);
+    CU_ASSERT_PTR_NULL(region);
+    /* and so do the readable items */
+    float outvals[16];
+    int read = csoundReadCircularBuffer(csound, rb, outvals, 16);
+    CU_ASSERT_EQUAL(read, 15);
+    for (i = 0; i < read; i++) {
+        CU_ASSERT_EQUAL(outvals[i], 10 + i);
+    }
+    csoundDestroyCircularBuffer(csound, rb);
+    csoundDestroy(csound);
+}
+
+/* a writer and a reader thread, using copying bulk transfers or the */
+/* zero-copy regions: every item must arrive once and in order       */
+
+#define TRANSFER_ITEMS 200000
+
+typedef struct {
+    CSOUND *csound;
+    void *rb;
+    int zerocopy;
+} transfer_args;
+
+static void *transfer_writer(void *data) {
+    transfer_args *args = (transfer_args *) data;
+    int i = 0, j, n, avail;
+    int invals[256];
+    while (i < TRANSFER_ITEMS) {
+        if (args->zerocopy) {
+            int *region = csoundAcquireCircularBufferWrite(args->csound,
+                                                           args->rb,
+                                                           TRANSFER_ITEMS - i,
+                                                           &avail);
+            for (j = 0; j < avail; j++) {
+                region[j] = i + j;
+            }
+            csoundCommitCircularBufferWrite(args->csound, args->rb, avail);
+            n = avail;
+        }
+        else {
+            n = TRANSFER_ITEMS - i < 256 ? TRANSFER_ITEMS - i : 256;
+            for (j = 0; j < n; j++) {
+                invals[j] = i + j;
+            }
+            n = csoundWriteCircularBuffer(args->csound, args->rb, invals, n);
+        }
+        if (n == 0) {
+            csoundSleep(0);
+        }
+        i += n;
+    }
+    return NULL;
+}
+
+static void run_transfer(int zerocopy) {
+    int i = 0, j, n, avail, errors = 0;
+    int outvals[256];
+    pthread_t writer;
+    transfer_args args;
+    CSOUND* csound = csoundCreate(NULL);
+    args.csound = csound;
+    args.rb = csoundCreateCircularBuffer(csound, 8192, sizeof(int));
+    args.zerocopy = zerocopy;
+    CU_ASSERT_PTR_NOT_NULL(args.rb);
+    pthread_create(&writer, NULL, transfer_writer, &args);
+    while (i < TRANSFER_ITEMS) {
+        if (zerocopy) {
+            int *region = csoundAcquireCircularBufferRead(csound, args.rb,
+                                                          TRANSFER_ITEMS - i,
+                                                          &avail);
+            for (j = 0; j < avail; j++) {
+                errors += (region[j] != i + j);
+            }
+            csoundCommitCircularBufferRead(csound, args.rb, avail);
+            n = avail;
+        }
+        else {
+            n = csoundReadCircularBuffer(csound, args.rb, outvals, 256);
+            for (j = 0; j < n; j++) {
+                errors += (outvals[j] != i + j);
+            }
+        }
+        if (n == 0) {
+            csoundSleep(0);
+        }
+        i += n;
+    }
+    pthread_join(writer, NULL);
+    CU_ASSERT_EQUAL(i, TRANSFER_ITEMS);
+    CU_ASSERT_EQUAL(errors, 0);
+    csoundDestroyCircularBuffer(csound, args.rb);
+    csoundDestroy(csound);
+}
+
+void test_threaded_transfer(void) {
+    run_transfer(0);
+    run_transfer(1);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -152,6 +320,9 @@ int main()
             || (NULL == CU_add_test(pSuite, "Test read and write diff sizes", test_read_write_diff_size))
             || (NULL == CU_add_test(pSuite, "Test peek", test_peek))
             || (NULL == CU_add_test(pSuite, "Test wrap", test_wrap))
+            || (NULL == CU_add_test(pSuite, "Test bulk wrap", test_bulk_wrap))
+            || (NULL == CU_add_test(pSuite, "Test acquire and commit", test_acquire_commit))
+            || (NULL == CU_add_test(pSuite, "Test threaded transfer", test_threaded_transfer))
         )
     {
         CU_cleanup_registry();
@@ -1,5 +1,8 @@
-#include "csound.h"
+#define __BUILDING_LIBCSOUND
+
+#include "csoundCore.h"
 #include <stdio.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 
 #include "time.h"
@@ -54,6 +57,276 @@ void test_compile_async(void)
     csoundDestroy(csound);
 }
 
+void test_push_midi(void)
+{
+    CSOUND  *csound;
+    unsigned char noteon[3] = { 0x90, 60, 100 };
+    unsigned char noteoff[3] = { 0x80, 60, 0 };
+    MYFLT   *spout;
+    int i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "-M0");
+    csoundSetOption(csound, "-+rtmidi=null");
+    csoundSetOption(csound, "--sample-accurate");
+    /* one k-period is 100 samples of 1 ms */
+    csoundCompileOrc(csound, "sr = 1000\n"
+                             "ksmps = 100\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "chnset notnum(), \"key\"\n"
+                             "out linseg(1, 1, 1)\n"
+                             "endin\n");
+    csoundReadScore(csound, "f 0 10\n");
+    csoundStart(csound);
+    CU_ASSERT_EQUAL(csoundPushMidiMessage(csound, noteon, 0, -1.0),
+                    CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundPushMidiMessage(csound, noteon + 1, 2, -1.0),
+                    CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundPushMidiMessage(csound, noteon, 3, -1.0),
+                    CSOUND_SUCCESS);
+    for (i = 0; i < 4; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "key", NULL), 60.0);
+
+    /* a note on stamped 40.75 ms from now starts 40 samples into the */
+    /* next k-period (the 0.75 ms leave room for the time taken here) */
+    CU_ASSERT_EQUAL(csoundPushMidiMessage(csound, noteoff, 3, -1.0),
+                    CSOUND_SUCCESS);
+    for (i = 0; i < 2; i++)
+      csoundPerformKsmps(csound);
+    spout = csoundGetSpout(csound);
+    CU_ASSERT_EQUAL(spout[0], 0.0);
+    noteon[1] = 62;
+    CU_ASSERT_EQUAL(csoundPushMidiMessage(csound, noteon, 3,
+                                          csoundGetMidiTime(csound) + 0.04075),
+                    CSOUND_SUCCESS);
+    csoundPerformKsmps(csound);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "key", NULL), 62.0);
+    for (i = 0; i < 100 && spout[i] == 0.0; i++)
+      ;
+    CU_ASSERT_EQUAL(i, 40);
+    CU_ASSERT_EQUAL(spout[99], 1.0);
+    csoundDestroy(csound);
+}
+
+/* a format 1 MIDI file of 480 ticks a beat: track 0 changes the tempo */
+/* from 120 to 60 bpm at tick 480, tracks 1 and 2 play on channels 1  */
+/* and 2, partly with running status                                  */
+static const unsigned char midifile_data[] = {
+    'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 3, 0x01, 0xE0,
+    'M', 'T', 'r', 'k', 0, 0, 0, 19,
+    0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+    0x83, 0x60, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,
+    0x00, 0xFF, 0x2F, 0x00,
+    'M', 'T', 'r', 'k', 0, 0, 0, 22,
+    0x00, 0x90, 60, 100,                /* tick 0      */
+    0x81, 0x70, 0x80, 60, 64,           /* tick 240    */
+    0x85, 0x50, 0x90, 62, 100,          /* tick 960    */
+    0x83, 0x60, 62, 0,                  /* tick 1440   */
+    0x00, 0xFF, 0x2F, 0x00,
+    'M', 'T', 'r', 'k', 0, 0, 0, 21,
+    0x83, 0x60, 0x91, 64, 100,          /* tick 480    */
+    0x85, 0x50, 65, 100,                /* tick 1200   */
+    0x81, 0x70, 0x81, 64, 0,            /* tick 1440   */
+    0x00, 65, 0,
+    0x00, 0xFF, 0x2F, 0x00
+};
+
+/* performs 'n' k-periods, and stores the key and start time of each */
+/* note played from the MIDI file; returns the number of notes       */
+static int play_midifile(CSOUND *csound, int n, MYFLT *keys, MYFLT *times)
+{
+    MYFLT   count = csoundGetControlChannel(csound, "count", NULL), c;
+    int     i, notes = 0;
+    for (i = 0; i < n; i++) {
+      csoundPerformKsmps(csound);
+      c = csoundGetControlChannel(csound, "count", NULL);
+      if (c != count && notes < 8) {
+        keys[notes] = csoundGetControlChannel(csound, "key", NULL);
+        times[notes++] = csoundGetControlChannel(csound, "time", NULL);
+      }
+      count = c;
+    }
+    return notes;
+}
+
+void test_midifile(void)
+{
+    CSOUND  *csound;
+    FILE    *f;
+    MYFLT   keys[8], times[8];
+    const MYFLT expKeys[4] = { 60, 64, 62, 65 };
+    const MYFLT expTimes[4] = { 0.0, 0.5, 1.5, 2.0 };
+    int     i, pass, n;
+
+    f = fopen("engine_test.mid", "wb");
+    CU_ASSERT_PTR_NOT_NULL(f);
+    if (f == NULL)
+      return;
+    fwrite(midifile_data, 1, sizeof(midifile_data), f);
+    fclose(f);
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, "--midifile=engine_test.mid");
+    csoundCompileOrc(csound, "sr = 1000\n"
+                             "ksmps = 10\n"
+                             "chn_k \"count\", 3\n"
+                             "chn_k \"key\", 3\n"
+                             "chn_k \"time\", 3\n"
+                             "instr 1, 2\n"
+                             "chnset notnum(), \"key\"\n"
+                             "chnset times:i(), \"time\"\n"
+                             "chnset chnget:i(\"count\") + 1, \"count\"\n"
+                             "endin\n");
+    csoundReadScore(csound, "f 0 10\n");
+    CU_ASSERT_EQUAL(csoundStart(csound), CSOUND_SUCCESS);
+    /* the whole file, then again from the start after rewinding, */
+    /* then again after rewinding from between two tempo changes  */
+    for (pass = 0; pass < 3; pass++) {
+      if (pass == 2) {
+        n = play_midifile(csound, 100, keys, times);
+        CU_ASSERT_EQUAL(n, 2);
+        csoundRewindScore(csound);
+      }
+      n = play_midifile(csound, 250, keys, times);
+      CU_ASSERT_EQUAL(n, 4);
+      for (i = 0; i < n && i < 4; i++) {
+        CU_ASSERT_EQUAL(keys[i], expKeys[i]);
+        CU_ASSERT_DOUBLE_EQUAL(times[i], expTimes[i], 0.011);
+      }
+      csoundRewindScore(csound);
+    }
+    csoundDestroy(csound);
+    remove("engine_test.mid");
+}
+
+/* batchcount: copies its k-rate input to an audio signal; its batch */
+/* kernel counts the calls and the largest group of voices           */
+typedef struct {
+    OPDS    h;
+    MYFLT   *ar, *kval;
+} BATCHCOUNT;
+
+static int batch_calls, batch_voices;
+
+static int batchcount(CSOUND *csound, void *p_)
+{
+    BATCHCOUNT *p = (BATCHCOUNT *) p_;
+    uint32_t   i, nsmps = CS_KSMPS;
+    (void) csound;
+    for (i = 0; i < nsmps; i++)
+      p->ar[i] = *p->kval;
+    return OK;
+}
+
+static int batchcount_batch(CSOUND *csound, void **p, int n)
+{
+    int i;
+    batch_calls++;
+    if (n > batch_voices)
+      batch_voices = n;
+    for (i = 0; i < n; i++)
+      batchcount(csound, p[i]);
+    return OK;
+}
+
+/* renders 'n' k-periods of 8 voices of each instrument into 'buf' */
+static void render_voices(const char *voiceBatch, MYFLT *buf, int n)
+{
+    CSOUND  *csound;
+    char    score[64];
+    int     i, ksmps;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundSetOption(csound, voiceBatch);
+    csoundAppendOpcode(csound, "batchcount", sizeof(BATCHCOUNT), 0, 2,
+                       "a", "k", NULL, batchcount, NULL);
+    csoundRegisterBatchKernel(csound, batchcount, batchcount_batch);
+    batch_calls = batch_voices = 0;
+    csoundCompileOrc(csound, "ksmps = 32\n"
+                             "nchnls = 1\n"
+                             "0dbfs = 1\n"
+                             "gkcount init 0\n"
+                             "instr 1\n"
+                             "out oscili(0.05, p4) + batchcount(0)\n"
+                             "endin\n"
+                             "instr 2\n"
+                             "gkcount = gkcount + 1\n"
+                             "out oscili(0.05, 100 + gkcount % 50)\n"
+                             "endin\n");
+    for (i = 0; i < 8; i++) {
+      snprintf(score, sizeof(score), "i 1 0 1 %d\ni 2 0 1\n", 220 + 110*i);
+      csoundReadScore(csound, score);
+    }
+    csoundStart(csound);
+    ksmps = (int) csoundGetKsmps(csound);
+    for (i = 0; i < n; i++) {
+      csoundPerformKsmps(csound);
+      memcpy(buf + i*ksmps, csoundGetSpout(csound), ksmps*sizeof(MYFLT));
+    }
+    csoundDestroy(csound);
+}
+
+void test_voice_batch(void)
+{
+    MYFLT   plain[32*100], batched[32*100];
+    int     i, errors = 0;
+    render_voices("--voice-batch=0", plain, 100);
+    CU_ASSERT_EQUAL(batch_calls, 0);
+    render_voices("--voice-batch=8", batched, 100);
+    /* the voices of instr 1 went through the batch kernel together */
+    CU_ASSERT(batch_calls > 0);
+    CU_ASSERT_EQUAL(batch_voices, 8);
+    /* instr 1 runs in lockstep, instr 2 writes a global and must not */
+    for (i = 0; i < 32*100; i++)
+      if (plain[i] != batched[i])
+        errors++;
+    CU_ASSERT_EQUAL(errors, 0);
+}
+
+static void overload_callback(CSOUND *csound, void *userData,
+                              double load, int overloaded)
+{
+    (void) csound;
+    if (overloaded && load > 0.0)
+      (*(int*) userData)++;
+}
+
+void test_overload(void)
+{
+    CSOUND  *csound;
+    int calls = 0, i;
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, "sr = 44100\n"
+                             "ksmps = 4410\n"
+                             "instr 1\n"
+                             "out oscili(0.1, 440)\n"
+                             "endin\n"
+                             "instr 2\n"
+                             "chnset active:k(1), \"active\"\n"
+                             "chnset overload(), \"overload\"\n"
+                             "endin\n");
+    csoundReadScore(csound, "i 1 0 10\ni 2 0 10\n");
+    csoundStart(csound);
+    CU_ASSERT_EQUAL(csoundSetInstrumentPriority(csound, 3, -1), CSOUND_ERROR);
+    CU_ASSERT_EQUAL(csoundSetInstrumentPriority(csound, 1, -1),
+                    CSOUND_SUCCESS);
+    /* every k-cycle takes longer than this */
+    csoundSetOverloadPolicy(csound, CSOUND_OVERLOAD_STEAL, 1.0e-6);
+    csoundSetOverloadCallback(csound, overload_callback, &calls);
+    for (i = 0; i < 3; i++)
+      csoundPerformKsmps(csound);
+    CU_ASSERT(calls > 0);
+    CU_ASSERT(csoundGetLoad(csound) > 1.0e-6);
+    /* the non-essential voice was stolen */
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "active", NULL), 0.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(csound, "overload", NULL), 1.0);
+    csoundDestroy(csound);
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -73,6 +346,10 @@ int main()
     if ((NULL == CU_add_test(pSuite, "Test daemon mode", test_daemon))
         || (NULL == CU_add_test(pSuite, "Test evalcode", test_eval_code))
 	|| (NULL == CU_add_test(pSuite, "Test compileAsync", test_compile_async)) 
+	|| (NULL == CU_add_test(pSuite, "Test pushMidiMessage", test_push_midi))
+	|| (NULL == CU_add_test(pSuite, "Test MIDI file", test_midifile))
+	|| (NULL == CU_add_test(pSuite, "Test overload", test_overload))
+	|| (NULL == CU_add_test(pSuite, "Test voice batch", test_voice_batch))
 	)
     {
         CU_cleanup_registry();
@@ -205,6 +205,46 @@ void test_audio_hostbased(void)
     csoundReset(csound);
 }
 
+void test_audio_frames(void)
+{
+    CSOUND  *csound;
+    csound = csoundCreate(NULL);
+    const char  *instrument =
+            "ksmps = 16\n"
+            "nchnls = 2\n"
+            "nchnls_i = 1\n"
+            "0dbfs = 1\n"
+            "instr 1 \n"
+            "a1 inch 1\n"
+            "outs a1, -a1\n"
+            "endin \n";
+    MYFLT input[100], left[100], right[100];
+    MYFLT *in[1] = { input }, *out[2] = { left, right };
+    int i, errors = 0;
+    csoundSetOption(csound, "-n");
+    csoundCompileOrc(csound, instrument);
+    csoundReadScore(csound, "i 1 0 1\n");
+    int ret = csoundStart(csound);
+    CU_ASSERT(ret == 0);
+    for (i = 0; i < 100; i++)
+      input[i] = (MYFLT) (i + 1) / 100.0;
+    /* not a multiple of ksmps, the input comes out ksmps frames later */
+    ret = csoundPerformFrames(csound, in, out, 37);
+    CU_ASSERT(ret == 0);
+    in[0] = input + 37;
+    out[0] = left + 37;
+    out[1] = right + 37;
+    ret = csoundPerformFrames(csound, in, out, 63);
+    CU_ASSERT(ret == 0);
+    for (i = 0; i < 100; i++) {
+      MYFLT expected = (i < 16 ? 0.0 : input[i - 16]);
+      if (left[i] != expected || right[i] != -expected)
+        errors++;
+    }
+    CU_ASSERT_EQUAL(errors, 0);
+    csoundReset(csound);
+}
+
 void test_audio_realtime_mode(void)
 {
     CSOUND  *csound;
@@ -304,6 +344,7 @@ int main()
             || (NULL == CU_add_test(pSuite, "Keyboard IO\n", test_keyboard_io))
             || (NULL == CU_add_test(pSuite, "Audio Modules\n", test_audio_modules))
             || (NULL == CU_add_test(pSuite, "Audio Hostbased\n", test_audio_hostbased))
+            || (NULL == CU_add_test(pSuite, "Audio frames\n", test_audio_frames))
             || (NULL == CU_add_test(pSuite, "MIDI Modules\n", test_midi_modules))
             || (NULL == CU_add_test(pSuite, "MIDI Hostbased\n", test_midi_hostbased))
             || (NULL == CU_add_test(pSuite, "Audio realtime mode\n", test_audio_realtime_mode))
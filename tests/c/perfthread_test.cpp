@@ -1,6 +1,8 @@
 #include "csound.hpp"
 #include "csPerfThread.hpp"
+#include "csRuntime.hpp"
 #include <stdio.h>
+#include <thread>
 #include <CUnit/Basic.h>
 
 int init_suite1(void)
@@ -79,6 +81,124 @@ void test_record(void)
     csound.Reset();
 }
 
+void test_record_stems(void)
+{
+    const char  *instrument =
+            "0dbfs = 1.0\n"
+            "ksmps = 64\n"
+            "nchnls = 4\n"
+            "instr 1 \n"
+            "a1 line 0, p3, 0.5   \n"
+            "outq  a1, a1, a1, a1   \n"
+            "endin \n";
+    FILE *f;
+
+    Csound csound;
+    CsoundPerformanceThread performanceThread1(csound.GetCsound());
+    csound.SetOption((char*)"-n");
+    csound.CompileOrc(instrument);
+    csound.ReadScore((char*)"i 1 0  3 0.5 5000\n");
+    csound.Start();
+    performanceThread1.Play();
+    performanceThread1.RecordStems("teststems.wav", 2);
+#if !defined(__WINNT__)
+    sleep(1);
+#else
+    Sleep(1000);
+#endif
+    performanceThread1.StopRecord();
+    performanceThread1.Join();
+    // one file for each pair of channels
+    f = fopen("teststems_1.wav", "rb");
+    CU_ASSERT_PTR_NOT_NULL(f);
+    if (f) fclose(f);
+    f = fopen("teststems_2.wav", "rb");
+    CU_ASSERT_PTR_NOT_NULL(f);
+    if (f) fclose(f);
+    csound.Cleanup();
+    csound.Reset();
+}
+
+void test_message_latency(void)
+{
+    const char  *instrument =
+            "instr 1 \n"
+            "endin \n";
+    MYFLT p[3] = { 1.0, 0.0, 0.01 };
+    unsigned int counts[8];
+    long sum = 0;
+
+    Csound csound;
+    csound.SetOption((char*)"-n");
+    csound.CompileOrc(instrument);
+    csound.ReadScore((char*)"f 0 30\n");
+    csound.Start();
+    CsoundPerformanceThread performanceThread1(csound.GetCsound());
+    performanceThread1.Play();
+    // more messages than the queue holds at once
+    for (int i = 0; i < 3000; i++)
+      performanceThread1.ScoreEvent(0, 'i', 3, p);
+    performanceThread1.FlushMessageQueue();
+    // the initial pause, play and the score events
+    long total = performanceThread1.GetMessageLatency(counts, 8);
+    CU_ASSERT_EQUAL(total, 3002);
+    for (int i = 0; i < 8; i++)
+      sum += counts[i];
+    CU_ASSERT_EQUAL(sum, total);
+    performanceThread1.ResetMessageLatency();
+    CU_ASSERT_EQUAL(performanceThread1.GetMessageLatency(counts, 8), 0);
+    performanceThread1.Stop();
+    performanceThread1.Join();
+    csound.Cleanup();
+    csound.Reset();
+}
+
+void test_runtime(void)
+{
+    const char  *instrument =
+            "ksmps = 64\n"
+            "instr 1 \n"
+            "a1 oscils 0.5, 440, 0 \n"
+            "out  a1   \n"
+            "endin \n";
+    CsoundRuntimeStats stats;
+
+    Csound csound1, csound2;
+    csound1.SetOption((char*)"-n");
+    csound1.CompileOrc(instrument);
+    csound1.ReadScore((char*)"i 1 0 0.2\n");
+    csound1.Start();
+    csound2.SetOption((char*)"-n");
+    csound2.CompileOrc(instrument);
+    csound2.ReadScore((char*)"i 1 0 30\n");
+    csound2.Start();
+    CsoundRuntime runtime(2);
+    CU_ASSERT_EQUAL(runtime.GetWorkerCount(), 2);
+    int id1 = runtime.AddEngine(csound1.GetCsound(), 1);
+    int id2 = runtime.AddEngine(csound2.GetCsound());
+    CU_ASSERT(id1 >= 0 && id2 >= 0);
+    // end of score
+    CU_ASSERT(runtime.WaitEngine(id1) > 0);
+    CU_ASSERT_EQUAL(runtime.GetStats(id1, &stats), CSOUND_SUCCESS);
+    CU_ASSERT(stats.kcycles > 0);
+    CU_ASSERT(stats.missed <= stats.kcycles);
+    CU_ASSERT(stats.maxResponse >= stats.meanResponse);
+    CU_ASSERT_EQUAL(runtime.GetStatus(id2), 0);
+    // stopped before the end of score, while another thread waits for it
+    int waited = 0;
+    std::thread waiter([&runtime, &waited, id2] {
+        waited = runtime.WaitEngine(id2);
+    });
+    csoundSleep(200);
+    CU_ASSERT(runtime.RemoveEngine(id2) > 0);
+    waiter.join();
+    CU_ASSERT(waited > 0);
+    CU_ASSERT_EQUAL(runtime.GetStats(id2, &stats), CSOUND_ERROR);
+    CU_ASSERT_EQUAL(runtime.WaitEngine(id2), CSOUND_ERROR);
+    csound1.Reset();
+    csound2.Reset();
+}
+
 int main()
 {
     CU_pSuite pSuite = NULL;
@@ -105,6 +225,9 @@ int main()
 
     /* add the tests to the suite */
     if ((NULL == CU_add_test(pSuite, "Test Performance Thread second run", test_perfthread))
+            || (NULL == CU_add_test(pSuite, "Test message latency", test_message_latency))
+            || (NULL == CU_add_test(pSuite, "Test record stems", test_record_stems))
+            || (NULL == CU_add_test(pSuite, "Test runtime", test_runtime))
 //            || (NULL == CU_add_test(pSuite, "Test reuse", test_reuse))
         )
     {
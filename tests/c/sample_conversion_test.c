@@ -0,0 +1,194 @@
+/*
+ * File:   sample_conversion_test.c
+ *
+ * Tests for the sample format conversion and dither
+ * routines in H/sampconv.h.
+ */
+
+#define __BUILDING_LIBCSOUND
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "csoundCore.h"
+#include "sampconv.h"
+#include "CUnit/Basic.h"
+
+#define NSMPS 4096
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+static MYFLT test_signal(int i)
+{
+    /* full range, with some samples exactly half way between two steps */
+    MYFLT x = (MYFLT) ((i * 7919) % 20001 - 10000) / FL(9000.0);
+    if (i % 3 == 0)
+      x += FL(0.5) / FL(32768.0);
+    return x;
+}
+
+void test_short_exact(void)
+{
+    MYFLT in[NSMPS];
+    int16_t out[NSMPS];
+    uint32_t count = 0;
+    int i, errors = 0;
+    for (i = 0; i < NSMPS; i++)
+      in[i] = test_signal(i);
+    sconv_to_short(in, out, NSMPS, SCONV_NO_DITHER, &count);
+    for (i = 0; i < NSMPS; i++) {
+      long ref = lrint((double) in[i] * 32768.0);
+      ref = (ref < -32768 ? -32768 : (ref > 32767 ? 32767 : ref));
+      errors += (out[i] != ref);
+    }
+    CU_ASSERT_EQUAL(errors, 0);
+    CU_ASSERT_EQUAL(count, 0);
+}
+
+void test_long_exact(void)
+{
+    MYFLT in[NSMPS];
+    int32_t out[NSMPS];
+    int i, errors = 0;
+    for (i = 0; i < NSMPS; i++)
+      in[i] = test_signal(i);
+    sconv_to_long(in, out, NSMPS);
+    for (i = 0; i < NSMPS; i++) {
+      long long ref = llrint((double) in[i] * 2147483648.0);
+      ref = (ref < -2147483648LL ? -2147483648LL :
+             (ref > 2147483647LL ? 2147483647LL : ref));
+      errors += (out[i] != ref);
+    }
+    CU_ASSERT_EQUAL(errors, 0);
+}
+
+void test_clipping(void)
+{
+    MYFLT in[6] = { FL(1.0), FL(-1.0), FL(1e30), FL(-1e30), FL(2.0), FL(0.0) };
+    int16_t s[6];
+    int32_t l[6];
+    uint32_t count = 0;
+    in[5] = (MYFLT) NAN;
+    sconv_to_short(in, s, 6, SCONV_NO_DITHER, &count);
+    sconv_to_long(in, l, 6);
+    CU_ASSERT_EQUAL(s[0], 32767);
+    CU_ASSERT_EQUAL(s[1], -32768);
+    CU_ASSERT_EQUAL(s[2], 32767);
+    CU_ASSERT_EQUAL(s[3], -32768);
+    CU_ASSERT_EQUAL(s[4], 32767);
+    CU_ASSERT_EQUAL(s[5], -32768);
+    CU_ASSERT_EQUAL(l[0], 2147483647);
+    CU_ASSERT_EQUAL(l[1], -2147483647 - 1);
+    CU_ASSERT_EQUAL(l[2], 2147483647);
+    CU_ASSERT_EQUAL(l[3], -2147483647 - 1);
+}
+
+void test_round_trip(void)
+{
+    int16_t s[NSMPS], s2[NSMPS];
+    MYFLT tmp[NSMPS];
+    uint32_t count = 0;
+    int i;
+    for (i = 0; i < NSMPS; i++)
+      s[i] = (int16_t) (i * 16 - 32768);
+    sconv_from_short(s, tmp, NSMPS);
+    sconv_to_short(tmp, s2, NSMPS, SCONV_NO_DITHER, &count);
+    CU_ASSERT(memcmp(s, s2, sizeof(s)) == 0);
+#ifdef USE_DOUBLE
+    {   /* 32 bit samples only survive in double precision */
+      int32_t l[NSMPS], l2[NSMPS];
+      for (i = 0; i < NSMPS; i++)
+        l[i] = (int32_t) ((uint32_t) i * 1048573U);
+      sconv_from_long(l, tmp, NSMPS);
+      sconv_to_long(tmp, l2, NSMPS);
+      CU_ASSERT(memcmp(l, l2, sizeof(l)) == 0);
+    }
+#endif
+}
+
+static void check_dither(int shape, double variance)
+{
+    MYFLT buf[NSMPS];
+    double sum = 0.0, sum2 = 0.0, lo = 0.0, hi = 0.0;
+    uint32_t count = 0;
+    int i, k;
+    for (k = 0; k < 64; k++) {
+      memset(buf, 0, sizeof(buf));
+      sconv_dither_add(buf, NSMPS, FL(1.0), shape, &count);
+      for (i = 0; i < NSMPS; i++) {
+        sum += buf[i];
+        sum2 += buf[i] * buf[i];
+        lo = (buf[i] < lo ? buf[i] : lo);
+        hi = (buf[i] > hi ? buf[i] : hi);
+      }
+    }
+    CU_ASSERT_EQUAL(count, 64 * NSMPS);
+    CU_ASSERT(fabs(sum / (64.0 * NSMPS)) < 0.002);
+    CU_ASSERT(fabs(sum2 / (64.0 * NSMPS) - variance) < 0.002);
+    CU_ASSERT(lo >= -0.5 && hi < 0.5);
+}
+
+void test_dither_distribution(void)
+{
+    check_dither(SCONV_TRIANGULAR, 1.0 / 24.0);
+    check_dither(SCONV_RECTANGULAR, 1.0 / 12.0);
+}
+
+void test_dither_blocks(void)
+{
+    /* the dither depends only on the sample count, not on block sizes */
+    MYFLT in[NSMPS];
+    int16_t a[NSMPS], b[NSMPS];
+    uint32_t ca = 0, cb = 0;
+    int i;
+    for (i = 0; i < NSMPS; i++)
+      in[i] = test_signal(i) * FL(0.001);
+    sconv_to_short(in, a, NSMPS, SCONV_TRIANGULAR, &ca);
+    for (i = 0; i < NSMPS; i += 100)
+      sconv_to_short(&in[i], &b[i], (NSMPS - i < 100 ? NSMPS - i : 100),
+                     SCONV_TRIANGULAR, &cb);
+    CU_ASSERT(memcmp(a, b, sizeof(a)) == 0);
+    CU_ASSERT_EQUAL(ca, cb);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("sample conversion tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test MYFLT to short", test_short_exact))
+            || (NULL == CU_add_test(pSuite, "Test MYFLT to long", test_long_exact))
+            || (NULL == CU_add_test(pSuite, "Test clipping", test_clipping))
+            || (NULL == CU_add_test(pSuite, "Test round trip", test_round_trip))
+            || (NULL == CU_add_test(pSuite, "Test dither distribution", test_dither_distribution))
+            || (NULL == CU_add_test(pSuite, "Test dither across blocks", test_dither_blocks))
+        )
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
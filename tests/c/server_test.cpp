@@ -28,7 +28,7 @@ int clean_suite1(void)
     #include "unistd.h"
 #endif
 
-void udp_send(const char* msg) {
+void udp_sendto(int port, const char* msg, size_t len) {
     struct sockaddr_in server_addr;
     int sock;
 #if defined(WIN32) && !defined(__CYGWIN__)
@@ -62,12 +62,16 @@ void udp_send(const char* msg) {
 #else
   inet_aton("127.0.0.1", &server_addr.sin_addr);  
 #endif
-  server_addr.sin_port = htons((int) 44100);    
-  sendto(sock, (void*) msg, strlen(msg)+1, 0,
+  server_addr.sin_port = htons((int) port);    
+  sendto(sock, (void*) msg, len, 0,
        (const struct sockaddr *) &server_addr,
 	 sizeof(server_addr));
 }
 
+void udp_send(const char* msg) {
+  udp_sendto(44100, msg, strlen(msg)+1);
+}
+
 
 void test_server(void)
 {
@@ -93,6 +97,36 @@ void test_server(void)
     csound.Reset();
 }
 
+void test_server_channels(void)
+{
+    // bind id 3 to "amp", then set it to 0.25 (0x3e800000)
+    const char bind[] = { 0, 'b', 0, 3, 'a', 'm', 'p' };
+    const char value[] = { 0, 'v', 0, 3, 0x3e, (char) 0x80, 0, 0 };
+    int err;
+
+    Csound csound;
+    csound.SetOption((char*)"-n");
+    csound.SetOption((char*)"--port=44100");
+    csound.CompileOrc("chn_k \"amp\", 3\nchn_k \"freq\", 3\n");
+    csound.ReadScore((char*)"f 0 10\n");
+    csound.Start();
+    CU_ASSERT_EQUAL(csoundUDPServerAddPort(csound.GetCsound(), 44101),
+                    CSOUND_SUCCESS);
+    CsoundPerformanceThread performanceThread(csound.GetCsound());
+    performanceThread.Play();
+    udp_send("@freq 440");
+    udp_sendto(44101, bind, sizeof(bind));
+    udp_sendto(44101, value, sizeof(value));
+    csoundSleep(500);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound.GetCsound(),
+                                                   "freq", &err), 440.0, 1e-9);
+    CU_ASSERT_DOUBLE_EQUAL(csoundGetControlChannel(csound.GetCsound(),
+                                                   "amp", &err), 0.25, 1e-9);
+    udp_send("##close##");
+    performanceThread.Join();
+    csound.Cleanup();
+    csound.Reset();
+}
 
 int main()
 {
@@ -111,6 +145,8 @@ int main()
 
     /* add the tests to the suite */
     if ((NULL == CU_add_test(pSuite, "Test server", test_server))
+            || (NULL == CU_add_test(pSuite, "Test server channels",
+                                    test_server_channels))
         )
     {
         CU_cleanup_registry();
@@ -0,0 +1,237 @@
+#include "csound.h"
+#include <stdio.h>
+#include <string.h>
+#include <CUnit/Basic.h>
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+/* sockaudsend / sockaudrecv / sockaudstat on the loopback interface */
+
+int init_suite1(void)
+{
+    return 0;
+}
+
+int clean_suite1(void)
+{
+    return 0;
+}
+
+/* the receiver plays two channels and exports its statistics */
+static CSOUND *create_receiver(int port)
+{
+    CSOUND  *csound;
+    char    orc[512];
+    csound = csoundCreate(NULL);
+    csoundSetOption(csound, "-n");
+    snprintf(orc, sizeof(orc),
+             "sr = 48000\n"
+             "ksmps = 480\n"
+             "nchnls = 2\n"
+             "0dbfs = 1\n"
+             "instr 1\n"
+             "a1, a2 sockaudrecv %d, 0, 0.2\n"
+             "outs a1, a2\n"
+             "klat, kjit, klost, klate sockaudstat %d\n"
+             "chnset klat, \"latency\"\n"
+             "chnset kjit, \"jitter\"\n"
+             "chnset klost, \"lost\"\n"
+             "chnset klate, \"late\"\n"
+             "endin\n", port, port);
+    csoundCompileOrc(csound, orc);
+    csoundReadScore(csound, "i 1 0 10\n");
+    return csound;
+}
+
+#define UNIT      (1.0 / 65536.0)
+#define KPERIODS  100
+
+void test_loopback(void)
+{
+    CSOUND  *sender, *receiver;
+    MYFLT   *spout, last = 0.0, prev = 0.0;
+    int     i, j, ksmps, err;
+    int     frames = 0, played = 0, steps = 0, mirrored = 0;
+
+    /* the sender counts frames: channel 1 is n/65536, channel 2 -n/65536 */
+    sender = csoundCreate(NULL);
+    csoundSetOption(sender, "-n");
+    csoundCompileOrc(sender, "sr = 48000\n"
+                             "ksmps = 480\n"
+                             "nchnls = 2\n"
+                             "0dbfs = 1\n"
+                             "instr 1\n"
+                             "kn init 1\n"
+                             "a1 = 0\n"
+                             "a2 = 0\n"
+                             "ki = 0\n"
+                             "loop:\n"
+                             "vaset kn/65536, ki, a1\n"
+                             "vaset -kn/65536, ki, a2\n"
+                             "kn += 1\n"
+                             "loop_lt ki, 1, ksmps, loop\n"
+                             "sockaudsend \"127.0.0.1\", 47031, 120, 0, a1, a2\n"
+                             "endin\n");
+    csoundReadScore(sender, "i 1 0 10\n");
+    receiver = create_receiver(47031);
+    CU_ASSERT_EQUAL(csoundStart(receiver), CSOUND_SUCCESS);
+    CU_ASSERT_EQUAL(csoundStart(sender), CSOUND_SUCCESS);
+    ksmps = (int) csoundGetKsmps(receiver);
+    /* the first k-period starts the instrument, and binds the port */
+    csoundPerformKsmps(receiver);
+
+    /* one k-period of each every 10 ms, i.e. in real time */
+    for (i = 0; i < KPERIODS; i++) {
+      csoundPerformKsmps(sender);
+      csoundSleep(10);
+      csoundPerformKsmps(receiver);
+      spout = csoundGetSpout(receiver);
+      for (j = 0; j < ksmps; j++) {
+        MYFLT a = spout[2*j], b = spout[2*j + 1];
+        if (played)
+          frames++;
+        if (a != 0.0) {
+          /* drops and repeats of single frames are allowed */
+          if (prev != 0.0) {
+            MYFLT d = (a - last) / UNIT;
+            CU_ASSERT(d >= -0.5 && d <= 2.5);
+            steps += (d > 0.5 && d < 1.5);
+          }
+          played++;
+          last = a;
+        }
+        mirrored += (b == -a);
+        prev = a;
+      }
+    }
+    /* every frame played came from the sender, in order */
+    CU_ASSERT_EQUAL(mirrored, KPERIODS * ksmps);
+    CU_ASSERT(played > frames / 2);
+    CU_ASSERT(steps > (played * 9) / 10);
+    CU_ASSERT(last > 0.0 && last < (KPERIODS * ksmps + 1) * UNIT);
+
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "lost", &err), 0.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "late", &err), 0.0);
+    CU_ASSERT(csoundGetControlChannel(receiver, "latency", &err) > 0.0);
+    CU_ASSERT(csoundGetControlChannel(receiver, "latency", &err) <= 0.2);
+    CU_ASSERT(csoundGetControlChannel(receiver, "jitter", &err) >= 0.0);
+    csoundDestroy(sender);
+    csoundDestroy(receiver);
+}
+
+/* builds a packet of 32 interleaved float frames of two channels, */
+/* all with the value 'v', in the format documented in sockaudio.c */
+static int make_packet(unsigned char *pk, uint32_t seq, uint32_t pos, float v)
+{
+    union {
+      float f;
+      uint32_t i;
+    } x;
+    int i;
+    memset(pk, 0, 16);
+    pk[0] = 'N'; pk[1] = 'A';
+    pk[2] = 0;
+    pk[3] = 2;
+    for (i = 0; i < 4; i++) {
+      pk[4 + i] = (unsigned char) (seq >> (24 - 8*i));
+      pk[8 + i] = (unsigned char) (pos >> (24 - 8*i));
+    }
+    pk[13] = 32;
+    x.f = v;
+    for (i = 0; i < 64; i++) {
+      pk[16 + 4*i] = (unsigned char) (x.i >> 24);
+      pk[17 + 4*i] = (unsigned char) (x.i >> 16);
+      pk[18 + 4*i] = (unsigned char) (x.i >> 8);
+      pk[19 + 4*i] = (unsigned char) x.i;
+    }
+    return 16 + 64*4;
+}
+
+void test_lost_and_late(void)
+{
+    CSOUND  *receiver;
+    struct sockaddr_in addr;
+    unsigned char pk[512];
+    MYFLT   *spout;
+    int     sock, i, j, n, ksmps, err, heard = 0;
+
+    receiver = create_receiver(47032);
+    CU_ASSERT_EQUAL(csoundStart(receiver), CSOUND_SUCCESS);
+    ksmps = (int) csoundGetKsmps(receiver);
+    csoundPerformKsmps(receiver);
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    CU_ASSERT(sock >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(47032);
+
+    /* 64 packets of 32 frames, without sequence number 5 */
+    for (i = 0; i < 64; i++) {
+      if (i == 5)
+        continue;
+      n = make_packet(pk, i, 32*i, 0.25f);
+      sendto(sock, (void *) pk, n, 0, (struct sockaddr *) &addr, sizeof(addr));
+    }
+    csoundSleep(100);
+    csoundPerformKsmps(receiver);
+    spout = csoundGetSpout(receiver);
+    for (j = 0; j < ksmps; j++)
+      heard += (spout[2*j] == 0.25 && spout[2*j + 1] == 0.25);
+    CU_ASSERT(heard > 0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "lost", &err), 1.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "late", &err), 0.0);
+
+    /* a packet behind what has been played already is late */
+    n = make_packet(pk, 64, 0, 0.5f);
+    sendto(sock, (void *) pk, n, 0, (struct sockaddr *) &addr, sizeof(addr));
+    csoundSleep(100);
+    csoundPerformKsmps(receiver);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "lost", &err), 1.0);
+    CU_ASSERT_EQUAL(csoundGetControlChannel(receiver, "late", &err), 1.0);
+#if defined(WIN32) && !defined(__CYGWIN__)
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+    csoundDestroy(receiver);
+}
+
+int main()
+{
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("sockaudio tests", init_suite1, clean_suite1);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "Test loopback", test_loopback))
+        || (NULL == CU_add_test(pSuite, "Test lost and late packets",
+                                test_lost_and_late))
+        )
+    {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}